@@ -36,7 +36,9 @@
 //! `faccessat`, `opendir`, `readdir` (+`readdir64` on Linux),
 //! `readdir_r`, `rewinddir`/`telldir`/`seekdir`, `dirfd`, `closedir`,
 //! `pread`, `read`, `lseek` (additive — stdio fseek on a memfs fd must
-//! stay on the VFS), `close`, `mkdir`, `unlink`, `rename`, `dlopen`, and
+//! stay on the VFS), `readv` (+`preadv`/`preadv2`/`sendfile`/
+//! `copy_file_range` and their LFS aliases, and the `posix_fadvise`/
+//! `readahead` hints, on Linux), `close`, `mkdir`, `unlink`, `rename`, `dlopen`, and
 //! `execve`/`posix_spawn`/`posix_spawnp` (memfs paths materialize through
 //! the `dlmap2file` host cache; roadmap 39). Memfs paths are served by
 //! the engine; host paths pass through, gated by the SAME `host_policy`
@@ -170,15 +170,33 @@ pub fn dir_is_embedded(id: usize) -> bool {
 }
 
 pub fn vfs_read(fd: i32, buf: &mut [u8]) -> Result<usize, i32> {
-    context().write().unwrap().read(fd, buf)
+    context().read().unwrap().read(fd, buf)
 }
 
 pub fn vfs_pread(fd: i32, buf: &mut [u8], offset: i64) -> Result<usize, i32> {
     context().read().unwrap().pread(fd, buf, offset)
 }
 
+pub fn vfs_readv(fd: i32, bufs: &mut [&mut [u8]]) -> Result<usize, i32> {
+    context().read().unwrap().readv(fd, bufs)
+}
+
+pub fn vfs_preadv(fd: i32, bufs: &mut [&mut [u8]], offset: i64) -> Result<usize, i32> {
+    context().read().unwrap().preadv(fd, bufs, offset)
+}
+
+/// The shared host source an mmap of a memfs fd maps (ENOTSUP: fill a
+/// private mapping instead — see `tfs::mapped_files`).
+pub fn vfs_map_source(fd: i32) -> Result<std::sync::Arc<std::fs::File>, i32> {
+    context().read().unwrap().map_source(fd)
+}
+
 pub fn vfs_lseek(fd: i32, offset: i64, whence: i32) -> Result<i64, i32> {
-    context().write().unwrap().lseek(fd, offset, whence)
+    context().read().unwrap().lseek(fd, offset, whence)
+}
+
+pub fn vfs_fadvise(fd: i32, offset: i64, len: i64, advice: i32) -> Result<(), i32> {
+    context().read().unwrap().advise(fd, offset, len, advice)
 }
 
 pub fn vfs_close(fd: i32) -> Result<(), i32> {
@@ -360,7 +378,14 @@ fn init_inner() -> Result<(), String> {
         let decls =
             spec::parse_mounts(&mounts_spec).map_err(|e| format!("TEBAKO_TFS_MOUNTS: {e}"))?;
         for d in &decls {
-            let mount = tfs::mount::build_from_file(&d.image, &d.mount).map_err(|e| {
+            let mount = tfs::mount::build_from_file_with_options(
+                &d.image,
+                &d.mount,
+                tfs::mount::MountMode::ReadOnly,
+                None,
+                &d.options,
+            )
+            .map_err(|e| {
                 format!(
                     "TEBAKO_TFS_MOUNTS: cannot mount {} at {}: {}",
                     d.image,
@@ -609,31 +634,37 @@ mod tests {
         assert_eq!(vfs_telldir(dir_id), Err(libc::EBADF));
 
         // ---- deny policy: host denied, memfs unaffected ----
+        // Through the production seam again: a deny-default decision
+        // stats the path's parent (the verdict memo's revalidation
+        // signal) under the context lock, and that stat re-enters this
+        // binary's own interposed symbols unless IN_ENGINE is set.
         context().write().unwrap().set_host_policy(
             HostPolicy::bind(tfs::policy::PolicyDefault::Deny, vec![], vec![]).unwrap(),
             None,
         );
         assert_eq!(
-            vfs_open("/etc/definitely-host", libc::O_RDONLY),
+            crate::sys::engine_call(|| vfs_open("/etc/definitely-host", libc::O_RDONLY)).unwrap(),
             PathRoute::Denied(libc::EPERM)
         );
         assert_eq!(
-            vfs_stat("/etc/definitely-host"),
+            crate::sys::engine_call(|| vfs_stat("/etc/definitely-host")).unwrap(),
             PathRoute::Denied(libc::EPERM)
         );
         assert_eq!(
-            vfs_opendir("/etc/definitely-host"),
+            crate::sys::engine_call(|| vfs_opendir("/etc/definitely-host")).unwrap(),
             PathRoute::Denied(libc::EPERM)
         );
         assert_eq!(
-            vfs_write_path("/tmp/libtfs-preload-route-write"),
+            crate::sys::engine_call(|| vfs_write_path("/tmp/libtfs-preload-route-write")).unwrap(),
             Err(libc::EPERM)
         );
         assert_eq!(
-            vfs_dlmap("/etc/definitely-host"),
+            crate::sys::engine_call(|| vfs_dlmap("/etc/definitely-host")).unwrap(),
             PathRoute::Denied(libc::EPERM)
         );
-        let PathRoute::Vfs(fd) = vfs_open(&secret, libc::O_RDONLY) else {
+        let PathRoute::Vfs(fd) =
+            crate::sys::engine_call(|| vfs_open(&secret, libc::O_RDONLY)).unwrap()
+        else {
             panic!("memfs is unaffected by a deny jail (spec 08 §3)");
         };
         vfs_close(fd).unwrap();
@@ -641,7 +672,7 @@ mod tests {
         // ---- jail-only mode: no mounts, ENODEV routes through host_check ----
         context().write().unwrap().unmount_handle(handle).unwrap();
         assert_eq!(
-            vfs_open("/etc/definitely-host", libc::O_RDONLY),
+            crate::sys::engine_call(|| vfs_open("/etc/definitely-host", libc::O_RDONLY)).unwrap(),
             PathRoute::Denied(libc::EPERM)
         );
         context()
@@ -33,6 +33,7 @@ mod tests {
         let _ = MountDecl {
             image: "/a".to_string(),
             mount: "/t".to_string(),
+            options: Default::default(),
         };
     }
 
@@ -33,8 +33,12 @@
 //! interposed too (the wrapper lives INSIDE libc and calls the syscall
 //! stub directly, so an interposed `read` never sees a fortified caller
 //! — the debian/temurin JDK's libjli imports exactly it for the jar
-//! END-record read). `__fxstatat64` remains a documented gap, as do
-//! `readv`/`preadv`/`sendfile`/`copy_file_range` and the write-side
+//! END-record read). `posix_fadvise`/`posix_fadvise64`/`readahead` on a
+//! memfs fd are readahead hints to the engine (`tebako_fs_fadvise`).
+//! `readv`/`preadv`/`preadv2` (and their LFS aliases) fill every iovec
+//! under one engine call; `sendfile`/`copy_file_range` from a memfs fd
+//! pump the VFS bytes into the host destination. `__fxstatat64` remains
+//! a documented gap, as does the write-side
 //! `pwrite64`/`ftruncate64`/`statvfs64` family on memfs fds. A
 //! pre-existing landmine OUTSIDE the JDK path: the plain
 //! `stat`/`lstat`/`fstat`/`stat64`/`lstat64`/`fstat64` host passthroughs
@@ -163,6 +167,53 @@ real_fn!(
     c"lseek",
     unsafe extern "C" fn(c_int, libc::off_t, c_int) -> libc::off_t
 );
+real_fn!(
+    real_posix_fadvise,
+    c"posix_fadvise",
+    unsafe extern "C" fn(c_int, libc::off_t, libc::off_t, c_int) -> c_int
+);
+real_fn!(
+    real_posix_fadvise64,
+    c"posix_fadvise64",
+    unsafe extern "C" fn(c_int, libc::off64_t, libc::off64_t, c_int) -> c_int
+);
+real_fn!(
+    real_readahead,
+    c"readahead",
+    unsafe extern "C" fn(c_int, libc::off64_t, usize) -> libc::ssize_t
+);
+real_fn!(
+    real_readv,
+    c"readv",
+    unsafe extern "C" fn(c_int, *const libc::iovec, c_int) -> libc::ssize_t
+);
+real_fn!(
+    real_preadv,
+    c"preadv",
+    unsafe extern "C" fn(c_int, *const libc::iovec, c_int, libc::off_t) -> libc::ssize_t
+);
+real_fn!(
+    real_preadv2,
+    c"preadv2",
+    unsafe extern "C" fn(c_int, *const libc::iovec, c_int, libc::off_t, c_int) -> libc::ssize_t
+);
+real_fn!(
+    real_sendfile,
+    c"sendfile",
+    unsafe extern "C" fn(c_int, c_int, *mut libc::off_t, usize) -> libc::ssize_t
+);
+real_fn!(
+    real_copy_file_range,
+    c"copy_file_range",
+    unsafe extern "C" fn(
+        c_int,
+        *mut libc::loff_t,
+        c_int,
+        *mut libc::loff_t,
+        usize,
+        libc::c_uint,
+    ) -> libc::ssize_t
+);
 real_fn!(real_close, c"close", unsafe extern "C" fn(c_int) -> c_int);
 real_fn!(
     real_mkdir,
@@ -186,6 +186,13 @@ interpose!(
     libc::lseek,
     unsafe extern "C" fn(c_int, libc::off_t, c_int) -> libc::off_t
 );
+interpose!(
+    INTERPOSE_READV,
+    real_readv,
+    super::readv,
+    libc::readv,
+    unsafe extern "C" fn(c_int, *const libc::iovec, c_int) -> libc::ssize_t
+);
 interpose!(
     INTERPOSE_CLOSE,
     real_close,
@@ -37,6 +37,7 @@ use std::path::PathBuf;
 use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::Mutex;
 
+use tfs::c_api::read_iov;
 use tfs::context::TebakoCDirent;
 
 use crate::route::{self, PathRoute};
@@ -235,6 +236,22 @@ fn at_base(dirfd: c_int, p: &str) -> Option<PathBuf> {
     None
 }
 
+/// A memfs read's engine answer as the libc return: the count, or -1
+/// with errno (EIO when the engine could not be entered).
+fn ssize_or_errno(r: Option<Result<usize, i32>>) -> libc::ssize_t {
+    match r {
+        Some(Ok(n)) => n as libc::ssize_t,
+        Some(Err(e)) => {
+            set_errno(e);
+            -1
+        }
+        None => {
+            set_errno(libc::EIO);
+            -1
+        }
+    }
+}
+
 // ---------------------------------------------------------------------
 // ABI translations (stat + dirent)
 // ---------------------------------------------------------------------
@@ -738,6 +755,41 @@ pub unsafe extern "C" fn lseek(fd: c_int, offset: libc::off_t, whence: c_int) ->
     unsafe { plat::real_lseek()(fd, offset, whence) }
 }
 
+/// Interposed `readv`: every iovec filled under one engine call, the fd
+/// position advanced like `read`.
+#[cfg_attr(target_os = "linux", no_mangle)]
+pub unsafe extern "C" fn readv(fd: c_int, iov: *const libc::iovec, iovcnt: c_int) -> libc::ssize_t {
+    if route::is_memfs_fd(fd) {
+        // SAFETY: per the readv contract.
+        return ssize_or_errno(engine_call(|| unsafe {
+            read_iov(iov, iovcnt, libc::EFAULT, |bufs, _| {
+                route::vfs_readv(fd, bufs)
+            })
+        }));
+    }
+    unsafe { plat::real_readv()(fd, iov, iovcnt) }
+}
+
+/// Linux: `preadv` (fd position untouched; see `readv`).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn preadv(
+    fd: c_int,
+    iov: *const libc::iovec,
+    iovcnt: c_int,
+    offset: libc::off_t,
+) -> libc::ssize_t {
+    if route::is_memfs_fd(fd) {
+        // SAFETY: per the preadv contract.
+        return ssize_or_errno(engine_call(|| unsafe {
+            read_iov(iov, iovcnt, libc::EFAULT, |bufs, done| {
+                route::vfs_preadv(fd, bufs, offset.saturating_add(done as i64))
+            })
+        }));
+    }
+    unsafe { plat::real_preadv()(fd, iov, iovcnt, offset) }
+}
+
 // ---------------------------------------------------------------------
 // The LFS *64 family (linux) — Rust std and _FILE_OFFSET_BITS=64 builds
 // call the 64 variants directly (open64/stat64/fstat64/…), which are
@@ -823,6 +875,340 @@ pub unsafe extern "C" fn lseek64(fd: c_int, offset: libc::off_t, whence: c_int)
     unsafe { lseek(fd, offset, whence) }
 }
 
+/// Linux: `preadv64` (the LFS alias of `preadv`).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn preadv64(
+    fd: c_int,
+    iov: *const libc::iovec,
+    iovcnt: c_int,
+    offset: libc::off_t,
+) -> libc::ssize_t {
+    unsafe { preadv(fd, iov, iovcnt, offset) }
+}
+
+/// Linux: `preadv64v2` (the LFS alias of `preadv2`).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn preadv64v2(
+    fd: c_int,
+    iov: *const libc::iovec,
+    iovcnt: c_int,
+    offset: libc::off_t,
+    flags: c_int,
+) -> libc::ssize_t {
+    unsafe { preadv2(fd, iov, iovcnt, offset, flags) }
+}
+
+/// Linux: `sendfile64` (the LFS alias of `sendfile`).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn sendfile64(
+    out_fd: c_int,
+    in_fd: c_int,
+    offset: *mut libc::off_t,
+    count: usize,
+) -> libc::ssize_t {
+    unsafe { sendfile(out_fd, in_fd, offset, count) }
+}
+
+// ---------------------------------------------------------------------
+// posix_fadvise / posix_fadvise64 / readahead (linux) — access-pattern
+// hints. On a memfs fd they feed the engine's per-fd readahead
+// (`tebako_fs_fadvise`): SEQUENTIAL and WILLNEED prefetch on the
+// background worker, RANDOM stops it. `readahead(2)` is WILLNEED for its
+// range. Host fds pass through.
+// ---------------------------------------------------------------------
+
+/// Shared body of the fadvise shims; the errno value, as
+/// `posix_fadvise` reports it (`None`: not a memfs fd).
+#[cfg(target_os = "linux")]
+fn fadvise_memfs(fd: c_int, offset: i64, len: i64, advice: c_int) -> Option<c_int> {
+    if !route::is_memfs_fd(fd) {
+        return None;
+    }
+    Some(
+        match engine_call(|| route::vfs_fadvise(fd, offset, len, advice)) {
+            Some(Ok(())) => 0,
+            Some(Err(e)) => e,
+            None => libc::EIO,
+        },
+    )
+}
+
+/// Linux: `posix_fadvise` (returns the error number; errno untouched).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn posix_fadvise(
+    fd: c_int,
+    offset: libc::off_t,
+    len: libc::off_t,
+    advice: c_int,
+) -> c_int {
+    match fadvise_memfs(fd, offset, len, advice) {
+        Some(rc) => rc,
+        None => unsafe { plat::real_posix_fadvise()(fd, offset, len, advice) },
+    }
+}
+
+/// Linux: `posix_fadvise64` (the LFS alias of `posix_fadvise`).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn posix_fadvise64(
+    fd: c_int,
+    offset: libc::off64_t,
+    len: libc::off64_t,
+    advice: c_int,
+) -> c_int {
+    match fadvise_memfs(fd, offset, len, advice) {
+        Some(rc) => rc,
+        None => unsafe { plat::real_posix_fadvise64()(fd, offset, len, advice) },
+    }
+}
+
+/// Linux: `readahead` — `POSIX_FADV_WILLNEED` for the range on a memfs fd.
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn readahead(
+    fd: c_int,
+    offset: libc::off64_t,
+    count: usize,
+) -> libc::ssize_t {
+    let len = i64::try_from(count).unwrap_or(i64::MAX);
+    match fadvise_memfs(fd, offset, len, libc::POSIX_FADV_WILLNEED) {
+        Some(0) => 0,
+        Some(e) => {
+            set_errno(e);
+            -1
+        }
+        None => unsafe { plat::real_readahead()(fd, offset, count) },
+    }
+}
+
+// ---------------------------------------------------------------------
+// preadv2 / sendfile / copy_file_range (linux) — the remaining read
+// paths a memfs fd can take. preadv2's RWF_* flags are hints the VFS
+// has no use for (its reads never block on IO the way a page-cache miss
+// does). sendfile and copy_file_range FROM a memfs fd pump VFS bytes
+// into the host destination through one reusable buffer per call (what
+// the destination does not take is kept for the next call); a
+// memfs fd is never writable, so one as the destination is EBADF, as
+// the kernel answers for a read-only fd.
+// ---------------------------------------------------------------------
+
+/// Bytes one pump step moves (a static asset of this size goes out in
+/// one read and one write).
+#[cfg(target_os = "linux")]
+const PUMP_CHUNK: usize = 256 * 1024;
+
+/// Linux: `preadv2` (`offset` -1: the fd position, advanced like `readv`).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn preadv2(
+    fd: c_int,
+    iov: *const libc::iovec,
+    iovcnt: c_int,
+    offset: libc::off_t,
+    flags: c_int,
+) -> libc::ssize_t {
+    if route::is_memfs_fd(fd) {
+        // SAFETY: per the preadv2 contract.
+        return ssize_or_errno(engine_call(|| unsafe {
+            read_iov(iov, iovcnt, libc::EFAULT, |bufs, done| match offset {
+                -1 => route::vfs_readv(fd, bufs),
+                _ => route::vfs_preadv(fd, bufs, offset.saturating_add(done as i64)),
+            })
+        }));
+    }
+    unsafe { plat::real_preadv2()(fd, iov, iovcnt, offset, flags) }
+}
+
+/// Per-memfs-fd bytes a pump read but its sink did not take (a full
+/// non-blocking socket), with the file offset they start at: the fd's
+/// next pump from there sends them first instead of reading them again.
+/// At most one [`PUMP_CHUNK`] per fd; dropped at close.
+#[cfg(target_os = "linux")]
+static PUMP_REST: Mutex<Option<HashMap<c_int, Rest>>> = Mutex::new(None);
+
+/// Undelivered pump bytes: (file offset, bytes).
+#[cfg(target_os = "linux")]
+type Rest = (i64, Vec<u8>);
+
+/// Move up to `count` bytes of memfs `fd`, from `offset` (`None`: the fd
+/// position, advanced by what was delivered), into `sink` — a write-like
+/// host call given the bytes and how many were delivered before them,
+/// returning the count it took or -1 with errno. The bytes delivered; an
+/// error only when nothing was (a later failure — a full non-blocking
+/// socket — ends the transfer short, as the kernel's does).
+#[cfg(target_os = "linux")]
+fn pump_memfs(
+    fd: c_int,
+    offset: Option<i64>,
+    count: usize,
+    sink: impl FnMut(&[u8], usize) -> libc::ssize_t,
+) -> Result<usize, i32> {
+    // Through the gate either way: a fork child must not reach PUMP_REST.
+    let start = match offset {
+        Some(at) if at < 0 => return Err(libc::EINVAL),
+        Some(at) => engine_call(|| Ok(at)),
+        None => engine_call(|| route::vfs_lseek(fd, 0, libc::SEEK_CUR)),
+    }
+    .unwrap_or(Err(libc::EIO))?;
+    let read = |buf: &mut [u8], at: i64| {
+        engine_call(|| route::vfs_pread(fd, buf, at)).unwrap_or(Err(libc::EIO))
+    };
+    let (sent, failure) = pump(fd, start, count, read, sink);
+    if offset.is_none() && sent > 0 {
+        let _ = engine_call(|| route::vfs_lseek(fd, start + sent as i64, libc::SEEK_SET));
+    }
+    match failure {
+        Some(e) if sent == 0 => Err(e),
+        _ => Ok(sent),
+    }
+}
+
+/// The body of [`pump_memfs`] from file offset `start`, reading through
+/// `read`: the bytes delivered and the failure that ended the transfer,
+/// if one did. What `sink` leaves of the last read is kept in
+/// [`PUMP_REST`] for the fd's next pump.
+#[cfg(target_os = "linux")]
+fn pump(
+    fd: c_int,
+    start: i64,
+    count: usize,
+    mut read: impl FnMut(&mut [u8], i64) -> Result<usize, i32>,
+    mut sink: impl FnMut(&[u8], usize) -> libc::ssize_t,
+) -> (usize, Option<i32>) {
+    let rest = PUMP_REST
+        .lock()
+        .unwrap()
+        .as_mut()
+        .and_then(|m| m.remove(&fd))
+        .filter(|(at, _)| *at == start);
+    // buf[put..] is read and not yet delivered.
+    let mut buf = rest.map(|(_, bytes)| bytes).unwrap_or_default();
+    let mut put = 0;
+    let mut sent = 0usize;
+    let failure = loop {
+        if sent == count {
+            break None;
+        }
+        if put == buf.len() {
+            buf.resize((count - sent).min(PUMP_CHUNK), 0);
+            put = 0;
+            match read(&mut buf, start + sent as i64) {
+                Ok(0) => {
+                    buf.clear();
+                    break None;
+                }
+                Ok(n) => buf.truncate(n),
+                Err(e) => {
+                    buf.clear();
+                    break Some(e);
+                }
+            }
+        }
+        let end = buf.len().min(put + (count - sent));
+        match sink(&buf[put..end], sent) {
+            n if n > 0 => {
+                put += n as usize;
+                sent += n as usize;
+            }
+            0 => break None,
+            _ => {
+                let e = std::io::Error::last_os_error().raw_os_error();
+                break Some(e.unwrap_or(libc::EIO));
+            }
+        }
+    };
+    if put < buf.len() {
+        buf.drain(..put);
+        let mut rest = PUMP_REST.lock().unwrap();
+        rest.get_or_insert_with(HashMap::new)
+            .insert(fd, (start + sent as i64, buf));
+    }
+    (sent, failure)
+}
+
+/// Linux: `sendfile` — from a memfs fd, the VFS bytes pumped into
+/// `out_fd` (typically a socket serving a static asset).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn sendfile(
+    out_fd: c_int,
+    in_fd: c_int,
+    offset: *mut libc::off_t,
+    count: usize,
+) -> libc::ssize_t {
+    if route::is_memfs_fd(out_fd) {
+        set_errno(libc::EBADF);
+        return -1;
+    }
+    if !route::is_memfs_fd(in_fd) {
+        return unsafe { plat::real_sendfile()(out_fd, in_fd, offset, count) };
+    }
+    // SAFETY: offset is NULL or points to the caller's off_t.
+    let from = unsafe { offset.as_ref() }.copied();
+    let sent = pump_memfs(in_fd, from, count, |bytes, _| {
+        // SAFETY: bytes is a live slice; out_fd is the caller's.
+        unsafe { libc::write(out_fd, bytes.as_ptr().cast(), bytes.len()) }
+    });
+    if let (Ok(n), Some(at)) = (&sent, from) {
+        // SAFETY: non-NULL when `from` is Some.
+        unsafe { *offset = at + *n as i64 };
+    }
+    ssize_or_errno(Some(sent))
+}
+
+/// Linux: `copy_file_range` — from a memfs fd, the VFS bytes pumped into
+/// the host `fd_out` (at `*off_out`, or at its position).
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub unsafe extern "C" fn copy_file_range(
+    fd_in: c_int,
+    off_in: *mut libc::loff_t,
+    fd_out: c_int,
+    off_out: *mut libc::loff_t,
+    len: usize,
+    flags: libc::c_uint,
+) -> libc::ssize_t {
+    if !route::is_memfs_fd(fd_in) && !route::is_memfs_fd(fd_out) {
+        return unsafe { plat::real_copy_file_range()(fd_in, off_in, fd_out, off_out, len, flags) };
+    }
+    if route::is_memfs_fd(fd_out) {
+        set_errno(libc::EBADF);
+        return -1;
+    }
+    if flags != 0 {
+        set_errno(libc::EINVAL);
+        return -1;
+    }
+    // SAFETY: off_in/off_out are NULL or point to the caller's loff_t.
+    let (from, to) = unsafe { (off_in.as_ref().copied(), off_out.as_ref().copied()) };
+    if to.is_some_and(|at| at < 0) {
+        set_errno(libc::EINVAL);
+        return -1;
+    }
+    let sent = pump_memfs(fd_in, from, len, |bytes, done| {
+        let (ptr, n) = (bytes.as_ptr().cast(), bytes.len());
+        // SAFETY: bytes is a live slice; fd_out is the caller's.
+        match to {
+            Some(at) => unsafe { libc::pwrite(fd_out, ptr, n, at + done as i64) },
+            None => unsafe { libc::write(fd_out, ptr, n) },
+        }
+    });
+    if let Ok(n) = sent {
+        // SAFETY: each pointer is non-NULL when its offset is Some.
+        if let Some(at) = from {
+            unsafe { *off_in = at + n as i64 };
+        }
+        if let Some(at) = to {
+            unsafe { *off_out = at + n as i64 };
+        }
+    }
+    ssize_or_errno(Some(sent))
+}
+
 // ---------------------------------------------------------------------
 // mmap / mmap64 (linux) — the JDK's libzip mmaps a jar's central
 // directory at open (`USE_MMAP` is unconditional, `ZIP_Put_In_Cache`
@@ -830,8 +1216,11 @@ pub unsafe extern "C" fn lseek64(fd: c_int, offset: libc::off_t, whence: c_int)
 // an immediate EBADF → MAP_FAILED, and libzip treats that as a hard
 // open failure. Serve a private anonymous mapping pre-filled from the
 // VFS instead; the consumer (the CEN scan, python's mmap module, git's
-// pack windows) only reads. `munmap` needs no interpose: the mapping is
-// a real anonymous one.
+// pack windows) only reads. With TEBAKO_TFS_MMAP_SHARED the mapping is
+// instead the real one of a host copy of the whole file, made once per
+// mount and shared by every mapping (and, through the exec cache, every
+// process). `munmap` needs no interpose either way: the mapping is a
+// real one.
 // ---------------------------------------------------------------------
 
 /// Shared body of the linux mmap/mmap64 shims.
@@ -859,6 +1248,11 @@ unsafe fn mmap_memfs_or_host(
         set_errno(libc::EACCES);
         return libc::MAP_FAILED;
     }
+    // Shared sources (TEBAKO_TFS_MMAP_SHARED): the real mapping of the
+    // file's host copy, so its pages are shared and demand-paged.
+    if let Some(p) = unsafe { mmap_shared_source(addr, len, prot, flags, fd, offset) } {
+        return p;
+    }
     // The anonymous sibling: same address request (MAP_FIXED forwarded),
     // private, fd -1. ALWAYS mapped writable regardless of the caller's
     // prot: the fill below stores the VFS bytes into it, and a backing
@@ -904,6 +1298,37 @@ unsafe fn mmap_memfs_or_host(
     p
 }
 
+/// The caller's own mapping request against the memfs file's shared
+/// host source (a sealed memfd or an exec-cache file — see
+/// `tfs::mapped_files`). None — fill a private mapping instead — when the
+/// mount does not share, or the window reaches past the file's last
+/// page: there a real mapping would SIGBUS where the private fill keeps
+/// its zero-fill.
+#[cfg(target_os = "linux")]
+unsafe fn mmap_shared_source(
+    addr: *mut c_void,
+    len: usize,
+    prot: c_int,
+    flags: c_int,
+    fd: c_int,
+    offset: libc::off_t,
+) -> Option<*mut c_void> {
+    use std::os::unix::io::AsRawFd as _;
+    let source = engine_call(|| route::vfs_map_source(fd))?.ok()?;
+    let size = source.metadata().ok()?.len();
+    // SAFETY: sysconf has no preconditions.
+    let page = unsafe { libc::sysconf(libc::_SC_PAGESIZE) }.max(1) as u64;
+    let end = u64::try_from(offset).ok()?.checked_add(len as u64)?;
+    if end > size.div_ceil(page) * page {
+        return None;
+    }
+    // SAFETY: the caller's arguments, against a host fd the mount holds
+    // open; the kernel validates them (alignment, MAP_FIXED) and the
+    // mapping keeps its own reference to the file.
+    let p = unsafe { plat::real_mmap()(addr, len, prot, flags, source.as_raw_fd(), offset) };
+    (p != libc::MAP_FAILED).then_some(p)
+}
+
 /// Linux: interposed `mmap` (fd-flag dispatch).
 #[cfg(target_os = "linux")]
 #[no_mangle]
@@ -938,7 +1363,13 @@ pub unsafe extern "C" fn mmap64(
 #[cfg_attr(target_os = "linux", no_mangle)]
 pub unsafe extern "C" fn close(fd: c_int) -> c_int {
     if route::is_memfs_fd(fd) {
-        return match engine_call(|| route::vfs_close(fd)) {
+        return match engine_call(|| {
+            #[cfg(target_os = "linux")]
+            if let Some(rest) = PUMP_REST.lock().unwrap().as_mut() {
+                rest.remove(&fd);
+            }
+            route::vfs_close(fd)
+        }) {
             Some(Ok(())) => 0,
             Some(Err(e)) => {
                 set_errno(e);
@@ -1496,6 +1927,13 @@ pub unsafe extern "C" fn posix_spawnp(
 // Initialization (the library constructor's payload)
 // ---------------------------------------------------------------------
 
+/// The engine's readahead worker runs its jobs inside the engine, like
+/// any shim's route call: the backend's own host IO there must pass
+/// straight through, never back into the context lock.
+fn run_readahead_job(job: tfs::readahead::Job) {
+    let _ = engine_call(job);
+}
+
 /// The constructor payload: establish the namespace from the environment.
 /// Misformatted `TEBAKO_TFS_MOUNTS` / `TEBAKO_JAIL`, or an image that will
 /// not mount, is a named configuration error: a clear stderr message
@@ -1505,6 +1943,7 @@ pub fn init() {
     // backend worker pool comes into existence at mount time, and the
     // guard must already be registered before any later fork.
     register_fork_guard();
+    tfs::readahead::run_jobs_through(run_readahead_job);
     if let Err(msg) = route::initialize() {
         eprintln!("libtfs-preload: {msg}");
         // SAFETY: plain libc call.
@@ -1520,6 +1959,92 @@ pub fn init() {
 mod tests {
     use super::*;
 
+    /// The shared iovec helper answers the kernel's EFAULT for NULL
+    /// memory here (the C API's EINVAL is its caller's choice); a bad
+    /// count stays EINVAL either way.
+    #[test]
+    fn vectored_reads_answer_efault_for_null_buffers() {
+        let null = [libc::iovec {
+            iov_base: std::ptr::null_mut(),
+            iov_len: 8,
+        }];
+        let never = |_: &mut [&mut [u8]], _| -> Result<usize, i32> { unreachable!() };
+        // SAFETY: NULL and out-of-range inputs are rejected before any
+        // iovec memory is read as a buffer.
+        unsafe {
+            assert_eq!(
+                read_iov(null.as_ptr(), 1, libc::EFAULT, never).err(),
+                Some(libc::EFAULT)
+            );
+            assert_eq!(
+                read_iov(std::ptr::null(), 1, libc::EFAULT, never).err(),
+                Some(libc::EFAULT)
+            );
+            assert_eq!(
+                read_iov(null.as_ptr(), -1, libc::EFAULT, never).err(),
+                Some(libc::EINVAL)
+            );
+        }
+    }
+
+    /// A sink that stops taking bytes (a full non-blocking socket) leaves
+    /// the rest of the read for the fd's next pump: every byte is read
+    /// from the VFS once, and a pump from elsewhere in the file, or after
+    /// close, never sees it.
+    #[cfg(target_os = "linux")]
+    #[test]
+    fn a_short_sink_leaves_the_rest_for_the_next_pump() {
+        // Never a live fd number: the rest table is process-global.
+        const FD: c_int = -7;
+        let file: Vec<u8> = (0..PUMP_CHUNK + 1000).map(|i| i as u8).collect();
+        let reads = Cell::new(0usize);
+        let read = |buf: &mut [u8], at: i64| {
+            let at = at as usize;
+            let n = buf.len().min(file.len() - at);
+            buf[..n].copy_from_slice(&file[at..at + n]);
+            reads.set(reads.get() + n);
+            Ok(n)
+        };
+        let mut out = Vec::new();
+        // A socket taking 1000 bytes, then EAGAIN.
+        let mut room = 1000;
+        let (sent, failure) = pump(FD, 0, file.len(), read, |bytes, _| {
+            if room == 0 {
+                set_errno(libc::EAGAIN);
+                return -1;
+            }
+            let n = bytes.len().min(room);
+            room -= n;
+            out.extend_from_slice(&bytes[..n]);
+            n as libc::ssize_t
+        });
+        assert_eq!((sent, failure), (1000, Some(libc::EAGAIN)));
+        assert_eq!(reads.get(), PUMP_CHUNK);
+
+        let (sent, failure) = pump(FD, 1000, file.len() - 1000, read, |bytes, _| {
+            out.extend_from_slice(bytes);
+            bytes.len() as libc::ssize_t
+        });
+        assert_eq!((sent, failure), (file.len() - 1000, None));
+        assert_eq!(out, file);
+        assert_eq!(reads.get(), file.len(), "no byte read twice");
+
+        // A rest left at 500 is not served to a pump from 0.
+        let full = Cell::new(false);
+        let (sent, _) = pump(FD, 0, 600, read, |bytes, _| match full.replace(true) {
+            true => 0,
+            false => bytes.len().min(500) as _,
+        });
+        assert_eq!(sent, 500);
+        let mut head = Vec::new();
+        pump(FD, 0, 10, read, |bytes, _| {
+            head.extend_from_slice(bytes);
+            bytes.len() as _
+        });
+        assert_eq!(head, &file[..10]);
+        PUMP_REST.lock().unwrap().as_mut().unwrap().remove(&FD);
+    }
+
     /// The guard gate: a fork child never enters the engine (`None` is
     /// every shim's "pass through to the real libc / fail safe" answer);
     /// a normal thread enters, and re-entrancy still answers `None`. Both
@@ -14,6 +14,11 @@
 //!   probe, __read_chk fortified read, __fxstat64, anonymous mmap with
 //!   the fd -1 bit-test lie, mmap64 CEN window on a flagged memfs fd —
 //!   spec 22 class E),
+//! - the vectored/zero-copy read surface (readv; preadv, sendfile into
+//!   a socket and copy_file_range on linux),
+//! - shared mmap sources (`TEBAKO_TFS_MMAP_SHARED`, linux): memfd- and
+//!   exec-cache-backed mappings, plus the jar-scan and JDK startup
+//!   timings over a large classpath,
 //! - named errors + EX_CONFIG (78) on misformatted env.
 //!
 //! Skip policy (documented in the crate README/spec): tests SKIP (pass
@@ -143,6 +148,8 @@ fn build_fixtures() -> Option<Fixtures> {
         "mmap-probe",
         "close-probe",
         "fork-exec",
+        "vec-probe",
+        "map-share",
     ] {
         let src = src_dir.join(format!("{name}.c"));
         let out = dir.join("bin").join(name);
@@ -836,6 +843,344 @@ fn linux_lseek64_and_mmap64_on_a_memfs_fd() {
     );
 }
 
+/// The vectored and zero-copy reads of a flagged memfs fd: `readv`
+/// fills both iovecs and advances the position; on linux `preadv` leaves
+/// it, `posix_fadvise` takes the hint (and refuses bad advice),
+/// `sendfile` pumps the file into a socket from an offset and from the
+/// position, and `copy_file_range` lands it in a host file — while a
+/// memfs DESTINATION is EBADF.
+#[test]
+fn vectored_and_zero_copy_reads_on_a_memfs_fd() {
+    let Some(f) = fixtures() else { return };
+    let path = format!("{MOUNT}/data/secret.txt");
+    let scratch = f.dir.join("work").join("copied.txt");
+    let r = run(
+        f,
+        "vec-probe",
+        &[path.as_str(), scratch.to_str().unwrap()],
+        None,
+    );
+    assert_eq!(r.rc, 0, "vec-probe failed, stderr: {}", r.stderr);
+    assert!(
+        r.stdout.contains("readv:VFS-|SECRET- pos:11\n"),
+        "stdout: {}",
+        r.stdout
+    );
+    if !cfg!(target_os = "linux") {
+        return;
+    }
+    for line in [
+        "preadv:SECRET|-E2E pos:11\n",
+        "fadvise:0/1\n",
+        "sendfile:15 off:15 VFS-SECRET-E2E\n",
+        "sendfile-pos:4 pos:15 E2E\n",
+        "copy_file_range:15 off:15 VFS-SECRET-E2E\n",
+        "copy-into-memfs:-1/1\n",
+    ] {
+        assert!(r.stdout.contains(line), "{line:?} in stdout: {}", r.stdout);
+    }
+}
+
+/// A classpath image: `n` jars under `cp/`, each a real jar (a zip of
+/// `entries` class-sized entries, its own CEN at the end), plus `extra`
+/// entries. Built once per name under the fixture dir.
+fn jar_image(
+    f: &Fixtures,
+    name: &str,
+    n: usize,
+    entries: usize,
+    extra: &[(&str, &[u8])],
+) -> PathBuf {
+    use std::io::Write as _;
+    let path = f.dir.join(name);
+    let file = std::fs::File::create(&path).unwrap();
+    let mut zw = zip::ZipWriter::new(file);
+    let opts = zip::write::SimpleFileOptions::default()
+        .compression_method(zip::CompressionMethod::Deflated)
+        .unix_permissions(0o644);
+    zw.add_directory("cp/", opts.unix_permissions(0o755))
+        .unwrap();
+    for j in 0..n {
+        let mut jar = zip::ZipWriter::new(std::io::Cursor::new(Vec::new()));
+        for e in 0..entries {
+            jar.start_file(format!("pkg{j}/C{e}.class"), opts).unwrap();
+            // Class-file-like: a magic, then bytes that deflate ~3:1.
+            let body: Vec<u8> = (0..4096u32)
+                .map(|i| ((i * 7 + e as u32 * 13 + j as u32) % 61) as u8)
+                .collect();
+            jar.write_all(&[0xca, 0xfe, 0xba, 0xbe]).unwrap();
+            jar.write_all(&body).unwrap();
+        }
+        let jar = jar.finish().unwrap().into_inner();
+        zw.start_file(format!("cp/j{j:03}.jar"), opts).unwrap();
+        zw.write_all(&jar).unwrap();
+    }
+    for (entry, bytes) in extra {
+        zw.start_file(*entry, opts).unwrap();
+        zw.write_all(bytes).unwrap();
+    }
+    zw.finish().unwrap();
+    path
+}
+
+/// Run `tool` under the shim with `image` mounted at `mount` and the
+/// extra `env`.
+fn run_mounted(
+    f: &Fixtures,
+    tool: &Path,
+    args: &[String],
+    image: &Path,
+    mount: &str,
+    env: &[(&str, &Path)],
+) -> std::process::Output {
+    let mut cmd = Command::new(tool);
+    cmd.args(args)
+        .env(preload_var(), &f.shim)
+        .env("TEBAKO_TFS_MOUNTS", format!("{}:{mount}", image.display()))
+        .env_remove("TEBAKO_TFS_MMAP_SHARED")
+        .env_remove("TEBAKO_EXEC_CACHE")
+        .env_remove("TEBAKO_JAIL")
+        .env_remove("DYLD_PRINT_LIBRARIES");
+    for (k, v) in env {
+        cmd.env(k, v);
+    }
+    cmd.output().unwrap()
+}
+
+/// Shared mmap sources: with `TEBAKO_TFS_MMAP_SHARED=1` an mmap of a
+/// memfs file maps a sealed memfd, or with an exec cache named a file
+/// published there once and mapped again by the next process; without
+/// it, the private fill. Every form maps the file's exact bytes, a
+/// private writable mapping stays private, and a window past EOF keeps
+/// the zero-fill.
+#[test]
+fn shared_mmap_sources_memfd_and_exec_cache() {
+    if !cfg!(target_os = "linux") {
+        eprintln!("skip: shared mmap sources are memfds and exec-cache files (linux only)");
+        return;
+    }
+    let Some(f) = fixtures() else { return };
+    let image = jar_image(f, "share.zip", 1, 64, &[]);
+    let tool = f.dir.join("bin").join("map-share");
+    let args = ["show".to_string(), "/cp/cp/j000.jar".to_string()];
+    let cache = f.dir.join("share-cache");
+    let on = Path::new("1");
+    let show = |env: &[(&str, &Path)], source: &str| {
+        let out = run_mounted(f, &tool, &args, &image, "/cp", env);
+        let stdout = String::from_utf8_lossy(&out.stdout);
+        assert_eq!(
+            out.status.code(),
+            Some(0),
+            "map-share show, stderr: {}",
+            String::from_utf8_lossy(&out.stderr)
+        );
+        for line in [
+            format!("source:{source}\n"),
+            "same:1/1\n".to_string(),
+            "cow:1\n".to_string(),
+            "past-eof:1\n".to_string(),
+        ] {
+            assert!(stdout.contains(&line), "{line:?} in stdout: {stdout}");
+        }
+    };
+    show(&[], "anon");
+    show(&[("TEBAKO_TFS_MMAP_SHARED", on)], "memfd");
+    let shared = [
+        ("TEBAKO_TFS_MMAP_SHARED", on),
+        ("TEBAKO_EXEC_CACHE", &*cache),
+    ];
+    show(&shared, "cache");
+    let published = || {
+        std::fs::read_dir(cache.join("tebako-mmap"))
+            .unwrap()
+            .map(|e| e.unwrap().path())
+            .collect::<Vec<_>>()
+    };
+    let first = published();
+    assert_eq!(first.len(), 1, "one published source: {first:?}");
+    let inode = |p: &Path| std::os::unix::fs::MetadataExt::ino(&std::fs::metadata(p).unwrap());
+    let ino = inode(&first[0]);
+    show(&shared, "cache");
+    assert_eq!(published(), first, "the second process maps the same file");
+    assert_eq!(
+        inode(&first[0]),
+        ino,
+        "never rewritten under a live mapping"
+    );
+}
+
+/// Median wall time of `runs` runs of `go` (each returns its stdout).
+fn timed(runs: usize, mut go: impl FnMut() -> String) -> (std::time::Duration, String) {
+    let mut times = Vec::new();
+    let mut last = String::new();
+    for _ in 0..runs {
+        let start = std::time::Instant::now();
+        last = go();
+        times.push(start.elapsed());
+    }
+    times.sort();
+    (times[times.len() / 2], last)
+}
+
+/// JDK-startup model: each process opens every jar of a large classpath
+/// the way libzip does (END record, then an mmap of the central
+/// directory). Prints the median per-process time with private fills,
+/// memfd sources and exec-cache sources (warm: published by an earlier
+/// process) — `--nocapture` to see it; it asserts only that every mode
+/// walks the same entries. TFS_JARS resizes the classpath (default 200).
+#[test]
+fn jar_scan_with_and_without_shared_mmap_sources() {
+    if !cfg!(target_os = "linux") {
+        eprintln!("skip: shared mmap sources are linux only");
+        return;
+    }
+    let Some(f) = fixtures() else { return };
+    let jars: usize = std::env::var("TFS_JARS")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(200);
+    let image = jar_image(f, "classpath.zip", jars, 32, &[]);
+    let tool = f.dir.join("bin").join("map-share");
+    let mut args = vec!["scan".to_string()];
+    args.extend((0..jars).map(|j| format!("/cp/cp/j{j:03}.jar")));
+    let cache = f.dir.join("scan-cache");
+    let on = Path::new("1");
+    let mut rows = Vec::new();
+    let mut answers = Vec::new();
+    for (label, env) in [
+        ("private", vec![]),
+        ("memfd", vec![("TEBAKO_TFS_MMAP_SHARED", on)]),
+        (
+            "cache",
+            vec![
+                ("TEBAKO_TFS_MMAP_SHARED", on),
+                ("TEBAKO_EXEC_CACHE", &*cache),
+            ],
+        ),
+    ] {
+        let (median, stdout) = timed(5, || {
+            let out = run_mounted(f, &tool, &args, &image, "/cp", &env);
+            assert_eq!(
+                out.status.code(),
+                Some(0),
+                "map-share scan ({label}), stderr: {}",
+                String::from_utf8_lossy(&out.stderr)
+            );
+            String::from_utf8_lossy(&out.stdout).into_owned()
+        });
+        rows.push(format!("{label:>8}: {:8.1} ms", median.as_secs_f64() * 1e3));
+        answers.push(stdout);
+    }
+    assert_eq!(answers[0], format!("jars:{jars} entries:{}\n", jars * 32));
+    assert!(answers.iter().all(|a| *a == answers[0]), "{answers:?}");
+    eprintln!(
+        "[mmap-share] {jars}-jar classpath scan, median of 5 processes:\n{}",
+        rows.join("\n")
+    );
+}
+
+/// JDK startup with a large classpath, when a JDK is on PATH (`java`
+/// and `javac`; skipped otherwise): `Main` lives in the LAST of
+/// TFS_JARS (default 200) memfs jars, so the application class loader
+/// opens every one. Prints the median startup time per mmap mode; it
+/// asserts that each run prints Main's line.
+#[test]
+fn jdk_startup_with_a_large_classpath() {
+    if !cfg!(target_os = "linux") {
+        eprintln!("skip: shared mmap sources are linux only");
+        return;
+    }
+    let Some(f) = fixtures() else { return };
+    let has = |tool: &str| {
+        Command::new(tool)
+            .arg("-version")
+            .output()
+            .map(|o| o.status.success())
+            .unwrap_or(false)
+    };
+    if !has("java") || !has("javac") {
+        eprintln!("skip: no JDK (`java` and `javac`) on PATH");
+        return;
+    }
+    let jars: usize = std::env::var("TFS_JARS")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(200);
+    let src = f.dir.join("jdk-main");
+    std::fs::create_dir_all(&src).unwrap();
+    std::fs::write(
+        src.join("Main.java"),
+        "public class Main { public static void main(String[] a) { System.out.println(\"main:ok\"); } }\n",
+    )
+    .unwrap();
+    let o = Command::new("javac")
+        .arg("-d")
+        .arg(&src)
+        .arg(src.join("Main.java"))
+        .output()
+        .unwrap();
+    assert!(
+        o.status.success(),
+        "javac: {}",
+        String::from_utf8_lossy(&o.stderr)
+    );
+    let main_jar = {
+        use std::io::Write as _;
+        let mut jar = zip::ZipWriter::new(std::io::Cursor::new(Vec::new()));
+        jar.start_file("Main.class", zip::write::SimpleFileOptions::default())
+            .unwrap();
+        jar.write_all(&std::fs::read(src.join("Main.class")).unwrap())
+            .unwrap();
+        jar.finish().unwrap().into_inner()
+    };
+    let image = jar_image(
+        f,
+        "jdk-classpath.zip",
+        jars,
+        32,
+        &[("cp/main.jar", &main_jar)],
+    );
+    let mut classpath: Vec<String> = (0..jars).map(|j| format!("/cp/cp/j{j:03}.jar")).collect();
+    classpath.push("/cp/cp/main.jar".to_string());
+    let args = [
+        "-Xshare:auto".to_string(),
+        "-cp".to_string(),
+        classpath.join(":"),
+        "Main".to_string(),
+    ];
+    let cache = f.dir.join("jdk-cache");
+    let on = Path::new("1");
+    let mut rows = Vec::new();
+    for (label, env) in [
+        ("private", vec![]),
+        ("memfd", vec![("TEBAKO_TFS_MMAP_SHARED", on)]),
+        (
+            "cache",
+            vec![
+                ("TEBAKO_TFS_MMAP_SHARED", on),
+                ("TEBAKO_EXEC_CACHE", &*cache),
+            ],
+        ),
+    ] {
+        let (median, stdout) = timed(5, || {
+            let out = run_mounted(f, Path::new("java"), &args, &image, "/cp", &env);
+            assert_eq!(
+                out.status.code(),
+                Some(0),
+                "java ({label}), stderr: {}",
+                String::from_utf8_lossy(&out.stderr)
+            );
+            String::from_utf8_lossy(&out.stdout).into_owned()
+        });
+        assert_eq!(stdout, "main:ok\n", "{label}");
+        rows.push(format!("{label:>8}: {:8.1} ms", median.as_secs_f64() * 1e3));
+    }
+    eprintln!(
+        "[mmap-share] JDK startup, {jars}-jar memfs classpath, median of 5:\n{}",
+        rows.join("\n")
+    );
+}
+
 /// The darwin plain-`close` surface (spec 22 class E): the JVM's
 /// `FileDescriptor.close0` imports PLAIN `close`, while the libc crate
 /// maps `libc::close` to `close$NOCANCEL` on x86_64 darwin — so the
@@ -0,0 +1,134 @@
+/* Shared mmap sources (TEBAKO_TFS_MMAP_SHARED) on flagged memfs fds.
+ *
+ *   map-share show <file>        two read-only mappings of the whole
+ *       file, a private writable one and one reaching past EOF; prints
+ *       what backs the first mapping (the /proc/self/maps name: a
+ *       tebako memfd, an exec-cache file, or an anonymous fill).
+ *   map-share scan <jar>...      libzip's jar open, per jar: the END
+ *       record through lseek+read, then an mmap of the central
+ *       directory window whose entries are walked and counted — the
+ *       per-classpath-entry work of JDK startup.
+ *
+ * Linux-only body (the shared sources are memfds and /proc names). */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static unsigned le16(const unsigned char *p) { return p[0] | p[1] << 8; }
+static uint32_t le32(const unsigned char *p) {
+    return (uint32_t) le16(p) | (uint32_t) le16(p + 2) << 16;
+}
+
+/* The /proc/self/maps name of the mapping holding `addr`. */
+static const char *backing(void *addr) {
+    static char line[512];
+    FILE *maps = fopen("/proc/self/maps", "r");
+    uintptr_t a = (uintptr_t) addr;
+    if (!maps) return "?";
+    while (fgets(line, sizeof line, maps)) {
+        unsigned long lo, hi;
+        if (sscanf(line, "%lx-%lx", &lo, &hi) == 2 && a >= lo && a < hi) {
+            fclose(maps);
+            if (strstr(line, "memfd:tebako:")) return "memfd";
+            if (strstr(line, "/tebako-mmap/")) return "cache";
+            return "anon";
+        }
+    }
+    fclose(maps);
+    return "?";
+}
+
+static int show(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    unsigned char *a, *b, *w, *past, *want;
+    size_t len, page = (size_t) sysconf(_SC_PAGESIZE), past_len;
+    if (fd < 0) { perror("open"); return 66; }
+    if (fstat(fd, &st) < 0) { perror("fstat"); return 65; }
+    len = (size_t) st.st_size;
+    want = malloc(len);
+    if (!want || pread(fd, want, len, 0) != (ssize_t) len) { perror("pread"); return 65; }
+    a = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    b = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (a == MAP_FAILED || b == MAP_FAILED) { perror("mmap"); return 65; }
+    printf("source:%s\n", backing(a));
+    printf("same:%d/%d\n", memcmp(a, want, len) == 0, memcmp(b, want, len) == 0);
+    /* Private and writable: the store lands in this mapping alone. */
+    w = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (w == MAP_FAILED) { perror("mmap-private"); return 65; }
+    w[0] ^= 0xff;
+    printf("cow:%d\n", a[0] == want[0] && w[0] != want[0]);
+    /* Two pages past EOF: zero-filled, never SIGBUS. */
+    past_len = (len / page + 2) * page;
+    past = mmap(NULL, past_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (past == MAP_FAILED) { perror("mmap-past-eof"); return 65; }
+    printf("past-eof:%d\n", memcmp(past, want, len) == 0 && past[past_len - 1] == 0);
+    munmap(a, len);
+    munmap(b, len);
+    munmap(w, len);
+    munmap(past, past_len);
+    free(want);
+    close(fd);
+    return 0;
+}
+
+static int scan(int n, char **jars) {
+    unsigned long entries = 0;
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    int i;
+    for (i = 0; i < n; i++) {
+        unsigned char end[22], *map, *p;
+        off_t size, cenoff, start;
+        uint32_t cenlen;
+        unsigned count, k;
+        int fd = open(jars[i], O_RDONLY);
+        if (fd < 0) { perror(jars[i]); return 66; }
+        size = lseek(fd, -22, SEEK_END);
+        if (size < 0 || read(fd, end, 22) != 22 || le32(end) != 0x06054b50) {
+            fprintf(stderr, "%s: no END record\n", jars[i]);
+            return 65;
+        }
+        count = le16(end + 10);
+        cenlen = le32(end + 12);
+        cenoff = (off_t) le32(end + 16);
+        start = cenoff - cenoff % (off_t) page;
+        map = mmap(NULL, (size_t) (cenoff - start) + cenlen, PROT_READ, MAP_SHARED, fd, start);
+        if (map == MAP_FAILED) { perror("mmap-cen"); return 65; }
+        p = map + (cenoff - start);
+        for (k = 0; k < count; k++) {
+            if (le32(p) != 0x02014b50) {
+                fprintf(stderr, "%s: bad CEN entry %u\n", jars[i], k);
+                return 65;
+            }
+            p += 46 + le16(p + 28) + le16(p + 30) + le16(p + 32);
+            entries++;
+        }
+        munmap(map, (size_t) (cenoff - start) + cenlen);
+        close(fd);
+    }
+    printf("jars:%d entries:%lu\n", n, entries);
+    return 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+    setvbuf(stdout, NULL, _IONBF, 0);
+#ifdef __linux__
+    if (argc == 3 && strcmp(argv[1], "show") == 0) return show(argv[2]);
+    if (argc >= 3 && strcmp(argv[1], "scan") == 0) return scan(argc - 2, argv + 2);
+    return 64;
+#else
+    (void) argc; (void) argv;
+    puts("unsupported-platform");
+    return 0;
+#endif
+}
@@ -0,0 +1,82 @@
+/* The vectored and zero-copy read surface on a flagged memfs fd: readv
+ * everywhere; preadv, posix_fadvise, sendfile (into a socket — the
+ * static-asset server's path) and copy_file_range on linux. Before the
+ * shim interposed them the flagged (virtual) fd reached the kernel and
+ * every one of them failed EBADF. argv[1] is the memfs file (the e2e
+ * SECRET, "VFS-SECRET-E2E\n"), argv[2] a host scratch path. */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#endif
+
+int main(int argc, char **argv) {
+    int fd;
+    char a[4], b[7];
+    struct iovec iov[2];
+    ssize_t n;
+    if (argc < 3) return 64;
+    setvbuf(stdout, NULL, _IONBF, 0);
+    fd = open(argv[1], O_RDONLY);
+    if (fd < 0) { perror("open"); return 66; }
+
+    iov[0].iov_base = a; iov[0].iov_len = sizeof a;
+    iov[1].iov_base = b; iov[1].iov_len = sizeof b;
+    n = readv(fd, iov, 2);
+    if (n != 11) { perror("readv"); return 65; }
+    printf("readv:%.4s|%.7s pos:%lld\n", a, b, (long long) lseek(fd, 0, SEEK_CUR));
+
+#ifdef __linux__
+    {
+        char c[6], d[4], got[64];
+        int sv[2], out, rc;
+        off_t off = 0;
+        loff_t in_off = 0;
+
+        iov[0].iov_base = c; iov[0].iov_len = sizeof c;
+        iov[1].iov_base = d; iov[1].iov_len = sizeof d;
+        n = preadv(fd, iov, 2, 4);
+        if (n != 10) { perror("preadv"); return 65; }
+        printf("preadv:%.6s|%.4s pos:%lld\n", c, d, (long long) lseek(fd, 0, SEEK_CUR));
+
+        rc = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        printf("fadvise:%d/%d\n", rc, posix_fadvise(fd, 0, 0, 99) == EINVAL);
+
+        /* sendfile at an explicit offset (position untouched), then from
+         * the position (advanced). */
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) { perror("socketpair"); return 65; }
+        n = sendfile(sv[0], fd, &off, 100);
+        if (n < 0) { perror("sendfile"); return 65; }
+        memset(got, 0, sizeof got);
+        if (read(sv[1], got, (size_t) n) != n) { perror("read-socket"); return 65; }
+        printf("sendfile:%zd off:%lld %.14s\n", n, (long long) off, got);
+        n = sendfile(sv[0], fd, NULL, 100);
+        if (n < 0) { perror("sendfile-pos"); return 65; }
+        memset(got, 0, sizeof got);
+        if (read(sv[1], got, (size_t) n) != n) { perror("read-socket"); return 65; }
+        printf("sendfile-pos:%zd pos:%lld %.3s\n", n, (long long) lseek(fd, 0, SEEK_CUR), got);
+
+        out = open(argv[2], O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) { perror("open-host"); return 65; }
+        n = copy_file_range(fd, &in_off, out, NULL, 100, 0);
+        if (n < 0) { perror("copy_file_range"); return 65; }
+        memset(got, 0, sizeof got);
+        if (pread(out, got, sizeof got, 0) != n) { perror("pread-host"); return 65; }
+        printf("copy_file_range:%zd off:%lld %.14s\n", n, (long long) in_off, got);
+        errno = 0;
+        n = copy_file_range(out, NULL, fd, NULL, 1, 0);
+        printf("copy-into-memfs:%zd/%d\n", n, errno == EBADF);
+        close(out);
+    }
+#endif
+    close(fd);
+    return 0;
+}
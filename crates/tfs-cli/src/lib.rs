@@ -7,7 +7,7 @@
 //! them to stderr and returns exit code 1.
 
 use std::ffi::CString;
-use std::io::Write;
+use std::io::{Seek, Write};
 use std::path::{Path, PathBuf};
 
 use tfs::c_api::*;
@@ -989,7 +989,7 @@ pub fn cmd_mkimage(format: &str, source_dir: &Path, output: &Path) -> Result<(),
     let fmt = format.to_lowercase();
     if fmt == "zip" {
         return Err((
-            "mkimage --format zip is not supported: the zip backend is read-only (only 'dwarfs' and 'limnifs' can be written)"
+            "mkimage --format zip is not supported: the zip backend is read-only (only 'dwarfs', 'limnifs', 'tar.zst' and 'tar.gz' can be written)"
                 .to_string(),
             1,
         ));
@@ -1001,9 +1001,11 @@ pub fn cmd_mkimage(format: &str, source_dir: &Path, output: &Path) -> Result<(),
             1,
         ));
     }
-    if fmt != "dwarfs" && fmt != "limnifs" {
+    if !matches!(fmt.as_str(), "dwarfs" | "limnifs" | "tar.zst" | "tar.gz") {
         return Err((
-            format!("unsupported image format '{format}' (supported: dwarfs, limnifs)"),
+            format!(
+                "unsupported image format '{format}' (supported: dwarfs, limnifs, tar.zst, tar.gz)"
+            ),
             1,
         ));
     }
@@ -1048,11 +1050,67 @@ pub fn cmd_mkimage(format: &str, source_dir: &Path, output: &Path) -> Result<(),
                 .map_err(|e| (format!("dwarfs writer: {}: {e}", output.display()), 1))?;
         }
         "limnifs" => write_limnifs_image(source, output)?,
-        _ => unreachable!("the format gate above admits only dwarfs/limnifs"),
+        "tar.zst" => write_tar_zst_image(source, output)?,
+        "tar.gz" => write_tar_gz_image(source, output)?,
+        _ => unreachable!("the format gate above admits only dwarfs/limnifs/tar.zst/tar.gz"),
     }
     Ok(())
 }
 
+/// A ustar/GNU tar of the tree (symlinks stored as links) staged in an
+/// anonymous temp file and rewound, so the compressing writers keep
+/// memory flat however large the tree. `fail` labels the error.
+fn stage_tar(
+    source: &Path,
+    fail: impl Fn(&str, std::io::Error) -> (String, i32),
+) -> Result<std::fs::File, (String, i32)> {
+    let staged = tempfile::tempfile().map_err(|e| fail("staging tar", e))?;
+    let mut builder = tar::Builder::new(staged);
+    builder.follow_symlinks(false);
+    builder
+        .append_dir_all(".", source)
+        .map_err(|e| fail(&format!("scanning {}", source.display()), e))?;
+    let mut staged = builder.into_inner().map_err(|e| fail("staging tar", e))?;
+    staged
+        .seek(std::io::SeekFrom::Start(0))
+        .map_err(|e| fail("staging tar", e))?;
+    Ok(staged)
+}
+
+/// `mkimage --format tar.zst`: the tree's tar compressed as a seekable
+/// zstd stream — independent frames of
+/// [`tfs::zstd_seekable::DEFAULT_FRAME_SIZE`] plus a trailing seek table.
+/// Any zstd decoder still unpacks it front to back; the tar backend finds
+/// the table and serves a random read by decoding just the frame holding
+/// it.
+fn write_tar_zst_image(source: &Path, output: &Path) -> Result<(), (String, i32)> {
+    let fail = |what: &str, e: std::io::Error| (format!("tar.zst writer: {what}: {e}"), 1);
+    let staged = stage_tar(source, fail)?;
+    let out = std::fs::File::create(output).map_err(|e| fail(&output.display().to_string(), e))?;
+    let mut out = std::io::BufWriter::new(out);
+    tfs::zstd_seekable::write_seekable(
+        std::io::BufReader::new(staged),
+        &mut out,
+        tfs::zstd_seekable::DEFAULT_FRAME_SIZE,
+    )
+    .and_then(|_| out.flush())
+    .map_err(|e| fail(&output.display().to_string(), e))
+}
+
+/// `mkimage --format tar.gz`: the tree's tar as BGZF — gzip members of
+/// ≤ 64 KiB that each name their own size ([`tfs::bgzf`]), compressed in
+/// parallel. gzip/tar unpack it like any `.tar.gz`; the tar backend
+/// decodes just the members a read touches, across cores.
+fn write_tar_gz_image(source: &Path, output: &Path) -> Result<(), (String, i32)> {
+    let fail = |what: &str, e: std::io::Error| (format!("tar.gz writer: {what}: {e}"), 1);
+    let staged = stage_tar(source, fail)?;
+    let out = std::fs::File::create(output).map_err(|e| fail(&output.display().to_string(), e))?;
+    let mut out = std::io::BufWriter::new(out);
+    tfs::bgzf::write_bgzf(std::io::BufReader::new(staged), &mut out, 6)
+        .and_then(|_| out.flush())
+        .map_err(|e| fail(&output.display().to_string(), e))
+}
+
 /// `mkimage --format limnifs`: the tebako single-file layout (spec 20
 /// §4) — the writer's manifest bytes verbatim, then every slab appended
 /// in slab-ordinal order. Dictionaries are disabled: a dictionary
@@ -1259,6 +1317,7 @@ pub fn cmd_exec(opts: &ExecOptions) -> Result<(), (String, i32)> {
         decls.push(tfs::mount_spec::MountDecl {
             image: canon.to_string_lossy().into_owned(),
             mount: d.mount,
+            options: d.options,
         });
     }
     // Validate the jail NOW (grant paths must exist at bind time —
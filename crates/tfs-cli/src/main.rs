@@ -10,7 +10,7 @@
 //! tfs stat [-v] <image> <path>
 //! tfs extract [-v] [-q|--quiet] [-d|--dest <dir>] <image> [files...]
 //! tfs find [-v] <image> <pattern>
-//! tfs mkimage [--format dwarfs|limnifs] <srcdir> -o <img> [-v]
+//! tfs mkimage [--format dwarfs|limnifs|tar.zst|tar.gz] <srcdir> -o <img> [-v]
 //! tfs exec <image>[:mount] [--image <image:mount>]...
 //!          [--jail <spec> | --compose <file.yaml>] -- <cmd> [args...]
 //! tfs needs --from-journal <journal.log>
@@ -405,7 +405,7 @@ fn cmd_mkimage_main(rest: &[String]) -> ExitCode {
     if let Err(e) = a.positional_count(
         1,
         1,
-        "tfs mkimage [--format dwarfs|limnifs] <srcdir> --output <img>",
+        "tfs mkimage [--format dwarfs|limnifs|tar.zst|tar.gz] <srcdir> --output <img>",
     ) {
         return fail(&format!("Error: {e}"));
     }
@@ -687,6 +687,8 @@ fn print_help() {
     println!(
         "  mkimage  Create a dwarfs or limnifs (.tfs) image from a directory (in-process writer)"
     );
+    println!("           --format tar.zst writes a seekable zstd tar (random-access reads)");
+    println!("           --format tar.gz writes a BGZF gzip tar (parallel, random-access reads)");
     println!("  exec     Run a dynamic native command with the VFS injected (preload shim;");
     println!("           --compose <file.yaml> takes the whole composition, spec 23 §9)");
     println!("  needs    Draft a payload needs: block from a record-mode journal");
@@ -88,6 +88,14 @@ pub trait Backend: Send + Sync {
         None
     }
 
+    /// The tallies of the mount's read cache — a window cache stacked
+    /// over the image, or a format's own decoded-unit cache — when it has
+    /// one: hits and misses are this mount's, the rest the cache's (its
+    /// pool's, when shared). Default: None.
+    fn cache_stats(&self) -> Option<crate::byte_lru::LruStats> {
+        None
+    }
+
     /// The writable view of this backend, when it is one of the composite
     /// write-capable backends (COW overlay, host directory). Default: None
     /// — every FORMAT backend is read-only forever (spec 00 invariant 5:
@@ -0,0 +1,526 @@
+//! A read-window cache stacked over any image backend: the per-mount
+//! tuning of [`crate::mount::MountOptions`] (cache budget, fill workers),
+//! and the one block cache every format gets under a process-wide
+//! budget.
+//!
+//! File contents are cached as aligned [`WINDOW`]-byte windows in a
+//! [`ByteLru`] keyed by `(cache, path, window)`. A mount naming its own
+//! budget gets a pool of its own; every other mount draws from the
+//! [`process_pool`] when `TEBAKO_TFS_CACHE_MB` sets one, so all mounts
+//! of the process share one budget and one LRU order — a busy mount
+//! evicts an idle one's windows, never more than the budget in total.
+//! Hits and misses are tallied per mount ([`CachedBackend::stats`]) and
+//! logged at Debug when the mount goes away, which also drops its
+//! windows from a shared pool. A read is served from the
+//! windows it spans; the missing ones are fetched from the inner backend
+//! — across `workers` scoped threads when more than one is missing, so
+//! a large read over a compressed image decodes its blocks in parallel.
+//! Fetching ahead of a sequential reader is the per-fd engine's
+//! ([`crate::readahead`]): its worker reads through this cache, so the
+//! windows it prefetches land here, under the budget, and nowhere else.
+//!
+//! With a host-wide segment attached ([`CachedBackend::with_shared_blocks`],
+//! see `shared_blocks`) a window missing here is looked up there next,
+//! keyed by path and window index, and a fetched window is published
+//! there instead of this cache — every process mounting the image then
+//! decompresses it once, and reads it in place from the shared pages.
+//! This cache keeps only what the segment has no room for.
+//!
+//! Metadata (stat, directories, links) passes straight through: the
+//! backends already answer it from their in-memory index. The backend
+//! name is the inner one, so `tebako_get_backend_name` and the contract
+//! tests see the format, not the decorator.
+
+use std::ops::Deref;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, OnceLock};
+
+use crate::backend::{Backend, RawDirEntry, RawStat};
+use crate::bgzf::par_map;
+use crate::byte_lru::{budget_from_env, ByteLru, LruStats};
+use crate::shared_blocks::{block_key, BlockKey, SharedBlocks};
+
+/// Cache granularity: the bytes one window holds (the last window of a
+/// file is short).
+pub const WINDOW: u64 = 64 * 1024;
+
+/// What a pool entry holds for its owner: a read window (path, window
+/// index), or a decoded unit of a format that caches its own (a LimniFS
+/// drop, by id).
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+pub enum PoolEntry {
+    Window(String, u64),
+    Drop([u8; 32]),
+}
+
+/// A key in a pool: (owning cache, what it holds).
+pub type PoolKey = (u64, PoolEntry);
+
+/// Pool keys of caches created so far (the owner half of [`PoolKey`]).
+static NEXT_ID: AtomicU64 = AtomicU64::new(1);
+
+/// A fresh owner id for keys in a pool (the first half of
+/// [`PoolKey`]).
+pub fn pool_owner() -> u64 {
+    NEXT_ID.fetch_add(1, Ordering::Relaxed)
+}
+
+/// The process-wide window pool, when `TEBAKO_TFS_CACHE_MB` names a
+/// budget (MiB; unset or `0`: none — each tuned mount keeps its own).
+/// Read once, at the first mount. A LimniFS mount keeps its drop cache
+/// here instead of stacking windows over it (`mount`).
+pub fn process_pool() -> Option<Arc<ByteLru<PoolKey>>> {
+    static POOL: OnceLock<Option<Arc<ByteLru<PoolKey>>>> = OnceLock::new();
+    POOL.get_or_init(|| match budget_from_env("TEBAKO_TFS_CACHE_MB", 0) {
+        0 => None,
+        budget => Some(Arc::new(ByteLru::new(budget))),
+    })
+    .clone()
+}
+
+/// An image backend behind a read-window cache (see the module docs).
+pub struct CachedBackend {
+    inner: Box<dyn Backend>,
+    id: u64,
+    windows: Arc<ByteLru<PoolKey>>,
+    /// This mount's lookups (the pool's own tallies span every mount).
+    hits: AtomicU64,
+    misses: AtomicU64,
+    workers: usize,
+    /// The host-wide window cache, when attached (module docs).
+    shared: Option<Arc<SharedBlocks>>,
+}
+
+/// One window a read spans: held here, or in the shared segment.
+enum Window<'a> {
+    Private(Arc<Vec<u8>>),
+    Shared(&'a [u8]),
+}
+
+impl Deref for Window<'_> {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        match self {
+            Window::Private(data) => data,
+            Window::Shared(data) => data,
+        }
+    }
+}
+
+impl CachedBackend {
+    /// Stack a cache of `budget` bytes over `inner`, filling misses on up
+    /// to `workers` threads.
+    pub fn new(inner: Box<dyn Backend>, budget: u64, workers: usize) -> Self {
+        let pool = ByteLru::new(usize::try_from(budget).unwrap_or(usize::MAX));
+        Self::in_pool(inner, Arc::new(pool), workers)
+    }
+
+    /// Stack a cache over `inner` that keeps its windows in `pool`,
+    /// sharing its budget with every other cache there.
+    pub fn in_pool(inner: Box<dyn Backend>, pool: Arc<ByteLru<PoolKey>>, workers: usize) -> Self {
+        CachedBackend {
+            inner,
+            id: pool_owner(),
+            windows: pool,
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            workers: workers.max(1),
+            shared: None,
+        }
+    }
+
+    /// Share windows with every process attached to `shared`.
+    pub fn with_shared_blocks(mut self, shared: Arc<SharedBlocks>) -> Self {
+        self.shared = Some(shared);
+        self
+    }
+
+    /// The cache tallies: hits and misses are this mount's; evictions,
+    /// entries and bytes the pool's (every mount's, in a shared pool).
+    pub fn stats(&self) -> LruStats {
+        LruStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            ..self.windows.stats()
+        }
+    }
+
+    fn key(&self, path: &str, index: u64) -> PoolKey {
+        (self.id, PoolEntry::Window(path.to_string(), index))
+    }
+
+    /// The shared-segment key of window `index` of `path`.
+    fn shared_key(path: &str, index: u64) -> BlockKey {
+        block_key(&[path.as_bytes(), &index.to_le_bytes()])
+    }
+
+    /// Window `index` of `path` when it is cached here or shared.
+    fn cached(&self, path: &str, index: u64) -> Option<Window<'_>> {
+        let window = match self.windows.get(&self.key(path, index)) {
+            Some(window) => Some(Window::Private(window)),
+            None => self
+                .shared
+                .as_ref()
+                .and_then(|s| s.get(&Self::shared_key(path, index)))
+                .map(Window::Shared),
+        };
+        let counter = if window.is_some() {
+            &self.hits
+        } else {
+            &self.misses
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+        window
+    }
+
+    /// Admit a fetched window: to the shared segment when it takes it,
+    /// else to this cache. An empty window (the file ended early) is
+    /// used once and never held: it would be charged nothing.
+    fn admit(&self, path: &str, index: u64, window: Arc<Vec<u8>>) -> Window<'_> {
+        if window.is_empty() {
+            return Window::Private(window);
+        }
+        if let Some(shared) = &self.shared {
+            let key = Self::shared_key(path, index);
+            if shared.insert(&key, &window) {
+                if let Some(data) = shared.get(&key) {
+                    return Window::Shared(data);
+                }
+            }
+        }
+        self.windows
+            .insert(self.key(path, index), Arc::clone(&window));
+        Window::Private(window)
+    }
+
+    /// Window `index` of `path` (a `size`-byte file), read whole from
+    /// the inner backend. The buffer is exactly the window's bytes: the
+    /// pool charges `len()`, so capacity beyond it would go unaccounted.
+    fn fetch(&self, path: &str, index: u64, size: u64) -> Result<Arc<Vec<u8>>, i32> {
+        let len = size.saturating_sub(index * WINDOW).min(WINDOW);
+        let mut data = vec![0u8; len as usize];
+        let mut filled = 0;
+        while filled < data.len() {
+            let n = self
+                .inner
+                .pread(path, &mut data[filled..], index * WINDOW + filled as u64)?;
+            if n == 0 {
+                break;
+            }
+            filled += n;
+        }
+        if filled < data.len() {
+            data.truncate(filled);
+            data.shrink_to_fit();
+        }
+        Ok(Arc::new(data))
+    }
+}
+
+impl Drop for CachedBackend {
+    fn drop(&mut self) {
+        let s = self.stats();
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "read cache ({}): {} hits, {} misses ({:.1}% hit); pool: {} evictions, {} of {} bytes held",
+            self.inner.name().to_string_lossy(),
+            s.hits,
+            s.misses,
+            s.hit_percent(),
+            s.evictions,
+            s.bytes,
+            self.windows.budget()
+        );
+        let id = self.id;
+        self.windows.remove_where(|key| key.0 == id);
+    }
+}
+
+impl Backend for CachedBackend {
+    fn name(&self) -> &'static std::ffi::CStr {
+        self.inner.name()
+    }
+
+    fn stat(&self, path: &str) -> Result<RawStat, i32> {
+        self.inner.stat(path)
+    }
+
+    fn has_entry_or_children(&self, path: &str) -> bool {
+        self.inner.has_entry_or_children(path)
+    }
+
+    fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        // Every window a read spans lies inside the file.
+        let size = self.inner.stat(path)?.size.max(0) as u64;
+        if offset >= size {
+            return Ok(0);
+        }
+        let end = offset.saturating_add(buf.len() as u64).min(size);
+        let first = offset / WINDOW;
+        let last = (end - 1) / WINDOW;
+
+        let mut held: Vec<Option<Window<'_>>> = Vec::with_capacity((last - first + 1) as usize);
+        let mut missing = Vec::new();
+        for index in first..=last {
+            let window = self.cached(path, index);
+            if window.is_none() {
+                missing.push(index);
+            }
+            held.push(window);
+        }
+        if !missing.is_empty() {
+            let fetched = par_map(&missing, self.workers, |&index| {
+                self.fetch(path, index, size)
+            })?;
+            for (index, window) in missing.into_iter().zip(fetched) {
+                held[(index - first) as usize] = Some(self.admit(path, index, window));
+            }
+        }
+
+        let mut copied = 0;
+        for (index, window) in (first..).zip(held) {
+            let window = window.expect("every spanned window is held");
+            let start = (offset + copied as u64 - index * WINDOW) as usize;
+            if start >= window.len() {
+                break;
+            }
+            let n = (window.len() - start).min(buf.len() - copied);
+            buf[copied..copied + n].copy_from_slice(&window[start..start + n]);
+            copied += n;
+            if window.len() < WINDOW as usize || copied == buf.len() {
+                break;
+            }
+        }
+        Ok(copied)
+    }
+
+    fn read_link(&self, path: &str) -> Result<String, i32> {
+        self.inner.read_link(path)
+    }
+
+    fn read_dir(&self, path: &str) -> Result<Vec<RawDirEntry>, i32> {
+        self.inner.read_dir(path)
+    }
+
+    fn image_info_json(&self) -> Option<String> {
+        self.inner.image_info_json()
+    }
+
+    fn cache_stats(&self) -> Option<LruStats> {
+        Some(self.stats())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::backend::EntryType;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    /// One file of `len` patterned bytes, counting inner reads.
+    struct Source {
+        data: Vec<u8>,
+        reads: Arc<AtomicUsize>,
+    }
+
+    impl Backend for Source {
+        fn name(&self) -> &'static std::ffi::CStr {
+            c"Source"
+        }
+
+        fn stat(&self, path: &str) -> Result<RawStat, i32> {
+            match path {
+                "/" => Ok(RawStat {
+                    entry_type: EntryType::Directory,
+                    perms: 0o755,
+                    size: 0,
+                    mtime: 0,
+                }),
+                "/f" => Ok(RawStat {
+                    entry_type: EntryType::File,
+                    perms: 0o644,
+                    size: self.data.len() as i64,
+                    mtime: 0,
+                }),
+                _ => Err(libc::ENOENT),
+            }
+        }
+
+        fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
+            if path != "/f" {
+                return Err(libc::ENOENT);
+            }
+            self.reads.fetch_add(1, Ordering::Relaxed);
+            let at = (offset as usize).min(self.data.len());
+            let n = buf.len().min(self.data.len() - at);
+            buf[..n].copy_from_slice(&self.data[at..at + n]);
+            Ok(n)
+        }
+
+        fn read_dir(&self, path: &str) -> Result<Vec<RawDirEntry>, i32> {
+            match path {
+                "/" => Ok(vec![RawDirEntry {
+                    name: "f".to_string(),
+                    is_dir: false,
+                }]),
+                _ => Err(libc::ENOENT),
+            }
+        }
+    }
+
+    fn source(len: usize) -> (Box<dyn Backend>, Vec<u8>, Arc<AtomicUsize>) {
+        let data: Vec<u8> = (0..len)
+            .map(|i| (i % 251) as u8 ^ (i >> 16) as u8)
+            .collect();
+        let reads = Arc::new(AtomicUsize::new(0));
+        let source = Source {
+            data: data.clone(),
+            reads: Arc::clone(&reads),
+        };
+        (Box::new(source), data, reads)
+    }
+
+    fn cached(
+        len: usize,
+        budget: u64,
+        workers: usize,
+    ) -> (CachedBackend, Vec<u8>, Arc<AtomicUsize>) {
+        let (source, data, reads) = source(len);
+        (CachedBackend::new(source, budget, workers), data, reads)
+    }
+
+    #[test]
+    fn reads_match_the_inner_backend_at_every_alignment() {
+        let len = 5 * WINDOW as usize + 123;
+        let (cache, data, _) = cached(len, 1 << 20, 4);
+        for (offset, size) in [
+            (0, 10),
+            (WINDOW - 3, 7),
+            (1, 3 * WINDOW as usize),
+            (4 * WINDOW + 100, 4096),
+            (len as u64 - 5, 100),
+            (len as u64, 10),
+            (len as u64 + 9, 10),
+        ] {
+            let mut buf = vec![0u8; size];
+            let n = cache.pread("/f", &mut buf, offset).unwrap();
+            let at = (offset as usize).min(len);
+            let want = &data[at..(at + size).min(len)];
+            assert_eq!(&buf[..n], want, "read of {size} at {offset}");
+        }
+        assert_eq!(cache.name(), c"Source", "the format's name shows through");
+        assert_eq!(cache.read_dir("/").unwrap().len(), 1);
+        assert_eq!(cache.pread("/nope", &mut [0u8; 4], 0), Err(libc::ENOENT));
+    }
+
+    #[test]
+    fn windows_hold_only_the_file_bytes() {
+        let (cache, data, reads) = cached(100, 1 << 20, 1);
+        let mut buf = vec![0u8; 4096];
+        assert_eq!(cache.pread("/f", &mut buf, 0).unwrap(), 100);
+        assert_eq!(&buf[..100], &data[..]);
+        // The pool charges what the window allocates.
+        let held = cache.windows.get(&cache.key("/f", 0)).unwrap();
+        assert_eq!((held.len(), held.capacity()), (100, 100));
+        assert_eq!(cache.stats().bytes, 100);
+
+        // Past the end (however far): nothing fetched, nothing held.
+        for offset in [100, WINDOW, u64::MAX - 3] {
+            assert_eq!(cache.pread("/f", &mut buf, offset).unwrap(), 0);
+        }
+        assert_eq!(reads.load(Ordering::Relaxed), 1);
+        assert_eq!(cache.stats().entries, 1);
+    }
+
+    #[test]
+    fn repeated_reads_are_served_from_the_cache() {
+        let (cache, _, reads) = cached(4 * WINDOW as usize, 1 << 20, 1);
+        let mut buf = vec![0u8; 2 * WINDOW as usize];
+        cache.pread("/f", &mut buf, WINDOW).unwrap();
+        let cold = reads.load(Ordering::Relaxed);
+        assert_eq!(cold, 2, "one inner read per window");
+        for _ in 0..3 {
+            cache.pread("/f", &mut buf[..100], WINDOW + 5).unwrap();
+        }
+        assert_eq!(reads.load(Ordering::Relaxed), cold);
+        assert_eq!(cache.stats().hits, 3);
+
+        // A budget of one window keeps only the most recent one.
+        let (small, _, reads) = cached(4 * WINDOW as usize, WINDOW, 1);
+        small.pread("/f", &mut buf[..10], 0).unwrap();
+        small.pread("/f", &mut buf[..10], 2 * WINDOW).unwrap();
+        small.pread("/f", &mut buf[..10], 0).unwrap();
+        assert_eq!(reads.load(Ordering::Relaxed), 3);
+        assert_eq!(small.stats().evictions, 2);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn windows_are_shared_across_attachments() {
+        let tmp = tempfile::tempdir().unwrap();
+        let path = tmp.path().join("img.blk");
+        let attach = || {
+            let (cache, data, reads) = cached(3 * WINDOW as usize, 1 << 20, 2);
+            let shared = SharedBlocks::open(&path, 1 << 20).expect("segment");
+            (cache.with_shared_blocks(Arc::new(shared)), data, reads)
+        };
+        let mut buf = vec![0u8; 3 * WINDOW as usize];
+
+        let (first, data, reads) = attach();
+        assert_eq!(first.pread("/f", &mut buf, 0).unwrap(), buf.len());
+        assert_eq!(buf, data);
+        assert_eq!(reads.load(Ordering::Relaxed), 3);
+        assert_eq!(first.stats().entries, 0, "published, not held here");
+
+        let (second, _, reads) = attach();
+        buf.fill(0);
+        let tail = &mut buf[..data.len() - 5];
+        assert_eq!(second.pread("/f", tail, 5).unwrap(), tail.len());
+        assert_eq!(tail, &data[5..]);
+        assert_eq!(reads.load(Ordering::Relaxed), 0, "every window was shared");
+    }
+
+    #[test]
+    fn mounts_in_one_pool_share_its_budget() {
+        let pool = Arc::new(ByteLru::new(4 * WINDOW as usize));
+        let mount = |pool: &Arc<ByteLru<PoolKey>>| {
+            let (source, data, reads) = source(4 * WINDOW as usize);
+            let pooled = CachedBackend::in_pool(source, Arc::clone(pool), 1);
+            (pooled, data, reads)
+        };
+        let (a, data, reads_a) = mount(&pool);
+        let (b, _, reads_b) = mount(&pool);
+        let mut buf = vec![0u8; 4 * WINDOW as usize];
+
+        // A fills the whole budget; B's reads then evict A's windows, so
+        // together they never hold more than the pool's budget.
+        assert_eq!(a.pread("/f", &mut buf, 0).unwrap(), buf.len());
+        assert_eq!(buf, data);
+        assert_eq!(
+            b.pread("/f", &mut buf[..WINDOW as usize], 0).unwrap(),
+            WINDOW as usize
+        );
+        assert_eq!(pool.stats().bytes, 4 * WINDOW as usize);
+        assert_eq!(pool.stats().evictions, 1);
+        a.pread("/f", &mut buf, 0).unwrap();
+        assert_eq!(
+            reads_a.load(Ordering::Relaxed),
+            5,
+            "only the evicted window refetched"
+        );
+        assert_eq!(reads_b.load(Ordering::Relaxed), 1);
+
+        // Per-mount tallies stay apart (A's refetch evicted B's window);
+        // unmounting frees the mount's share.
+        assert_eq!((a.stats().hits, a.stats().misses), (3, 5));
+        assert_eq!((b.stats().hits, b.stats().misses), (0, 1));
+        assert_eq!(pool.stats().evictions, 2);
+        drop(a);
+        assert_eq!(pool.stats().bytes, 0);
+    }
+}
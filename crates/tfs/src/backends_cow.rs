@@ -21,6 +21,13 @@
 //! lives inside it (`.tfs-whiteouts`) keeping the overlay self-contained.
 //! The journal file itself is hidden from the merged view.
 //!
+//! The overlay is usually nearly empty, so the composite keeps an exact
+//! in-memory index of its tree (built by one walk at stack time, kept
+//! current by the write verbs): a path the overlay does not hold falls
+//! through to the base without a host syscall. The overlay directory
+//! belongs to the mount while stacked — entries added behind its back
+//! are seen at the next mount.
+//!
 //! ## The declared write gate (spec 24 §5)
 //!
 //! [`CowBackend::new`] stacks the UNGATED programmatic form: every write
@@ -40,19 +47,60 @@
 //!
 //! ```text
 //! TFS-WHITEOUTS 1\n
-//! W <escaped-path>\n      one per whiteout, sorted, deduplicated
+//! W <escaped-path>\n      one per whiteout
 //! ```
 //!
 //! Escaping: `%` → `%25`, `\n` → `%0A`, `\r` → `%0D`. Parsing is strict:
 //! wrong magic, unknown record tags and bad escapes are EINVAL (a lost
 //! whiteout exposes deleted base content — never tolerated silently).
-//! Rewrites are atomic (temp file + rename).
+//!
+//! The journal is an append-only log: a delete appends its one record
+//! (a single `O_APPEND` write), so a delete-heavy workload costs O(1)
+//! journal I/O per delete instead of a whole-file rewrite. Compaction
+//! rewrites it atomically (temp file + rename) in the canonical sorted,
+//! deduplicated form once the appended records outnumber the compacted
+//! ones (at least [`COMPACT_MIN`]) — amortized linear. Compaction is
+//! housekeeping: a delete whose record was appended succeeds even when
+//! the compaction after it fails (it is retried on a later append).
+//! Both forms are the same v1 text (readers never relied on the
+//! order). A trailing
+//! record without its newline is a torn append (the delete never
+//! returned): the mount drops it and compacts.
+//!
+//! ## Partial copy-up
+//!
+//! Copying up a base file of at least [`PARTIAL_COPY_UP_MIN`] bytes does
+//! not stream its content: the overlay file is created sparse at the base
+//! size, and a block map records which [`COPY_UP_BLOCK`] blocks the
+//! overlay holds. A write copies up only the base bytes of the blocks it
+//! touches but does not cover, and clean blocks keep reading from the base
+//! — appending a line to a 200 MB in-image log or database costs a block,
+//! not the file. `truncate` materializes the rest of the file first (the
+//! whole-file fallback; the write verbs have no rename). Once every base
+//! block is dirty the map is dropped and the file is an ordinary overlay
+//! file.
+//!
+//! Maps live under `.tfs-extents/` (hidden from the merged view like the
+//! journal) as `<in-image path>.map`, and are rewritten atomically
+//! (temp file + rename) when a write dirties new blocks:
+//!
+//! ```text
+//! TFS-EXTENTS 1\n
+//! S <base-size> <block-size>\n
+//! D <first-block> <count>\n   one per run of dirty blocks
+//! ```
+//!
+//! The map is written before the sparse file, so a copy-up torn in
+//! between leaves a map without its file (discarded at mount), never a
+//! file of holes without its map. A malformed map fails the mount with
+//! EINVAL (a lost map exposes holes as content).
 
-use std::collections::BTreeSet;
+use std::collections::{BTreeSet, HashMap};
 use std::ffi::CStr;
-use std::io;
-use std::path::PathBuf;
-use std::sync::RwLock;
+use std::fs::File;
+use std::io::{self, Write};
+use std::path::{Path, PathBuf};
+use std::sync::{Mutex, RwLock};
 
 use crate::backend::{Backend, EntryType, RawDirEntry, RawStat, WritableBackend};
 use crate::backends_hostdir::{io_errno, HostDirBackend};
@@ -61,6 +109,19 @@ use crate::backends_hostdir::{io_errno, HostDirBackend};
 /// merged view).
 pub const JOURNAL_FILE: &str = ".tfs-whiteouts";
 const JOURNAL_MAGIC: &str = "TFS-WHITEOUTS 1";
+/// The partial copy-up block maps, at the overlay root (hidden from the
+/// merged view).
+pub const EXTENTS_DIR: &str = ".tfs-extents";
+/// Block-map magic (format version 1).
+const EXTENTS_MAGIC: &str = "TFS-EXTENTS 1";
+/// Partial copy-up granularity.
+const COPY_UP_BLOCK: u64 = 64 * 1024;
+/// Base files at least this large copy up partially (smaller ones are
+/// cheaper to copy whole than to track).
+const PARTIAL_COPY_UP_MIN: u64 = 1024 * 1024;
+/// Appended records tolerated before compaction, however small the
+/// compacted journal (see the module docs).
+const COMPACT_MIN: usize = 1024;
 
 // ===================================================================
 // Journal (de)serialization
@@ -129,11 +190,25 @@ pub fn parse_whiteouts(text: &str) -> Result<BTreeSet<String>, i32> {
     Ok(set)
 }
 
-/// Load the journal from disk (missing file → empty set).
-fn load_journal(path: &PathBuf) -> Result<BTreeSet<String>, i32> {
+/// Load the journal from disk (missing file → empty set). The flag is
+/// true when the file needs rewriting: it is missing, or it ends in a
+/// torn append (dropped here; see the module docs).
+fn load_journal(path: &PathBuf) -> Result<(BTreeSet<String>, bool), i32> {
     match std::fs::read_to_string(path) {
-        Ok(text) => parse_whiteouts(&text),
-        Err(e) if e.kind() == io::ErrorKind::NotFound => Ok(BTreeSet::new()),
+        Ok(mut text) => {
+            let torn = !text.ends_with('\n') && text.contains('\n');
+            if torn {
+                text.truncate(text.rfind('\n').map_or(0, |i| i + 1));
+                tebako_log::log!(
+                    tebako_log::Level::Warn,
+                    "tfs",
+                    "cow: dropping a torn whiteout record in {}",
+                    path.display()
+                );
+            }
+            Ok((parse_whiteouts(&text)?, torn))
+        }
+        Err(e) if e.kind() == io::ErrorKind::NotFound => Ok((BTreeSet::new(), true)),
         Err(e) => Err(io_errno(&e)),
     }
 }
@@ -145,6 +220,322 @@ fn store_journal(path: &PathBuf, set: &BTreeSet<String>) -> Result<(), i32> {
     std::fs::rename(&tmp, path).map_err(|e| io_errno(&e))
 }
 
+/// The journal's write side: an append handle plus the compaction
+/// bookkeeping (see the module docs).
+struct WhiteoutLog {
+    path: PathBuf,
+    file: File,
+    /// Records appended since the last compaction.
+    appended: usize,
+    /// Appended records tolerated regardless of the journal size.
+    compact_min: usize,
+}
+
+impl WhiteoutLog {
+    fn open(path: PathBuf) -> Result<WhiteoutLog, i32> {
+        let file = std::fs::OpenOptions::new()
+            .append(true)
+            .open(&path)
+            .map_err(|e| io_errno(&e))?;
+        Ok(WhiteoutLog {
+            path,
+            file,
+            appended: 0,
+            compact_min: COMPACT_MIN,
+        })
+    }
+
+    /// Record the whiteout `path`, just added to `set`; compacts when the
+    /// appended tail has outgrown the compacted journal. Once the record
+    /// is written the whiteout stands: a failed compaction is logged and
+    /// retried on the next append (the journal is only longer).
+    fn append(&mut self, path: &str, set: &BTreeSet<String>) -> Result<(), i32> {
+        let record = format!("W {}\n", escape(path));
+        self.file
+            .write_all(record.as_bytes())
+            .map_err(|e| io_errno(&e))?;
+        self.appended += 1;
+        if self.appended
+            > self
+                .compact_min
+                .max(set.len().saturating_sub(self.appended))
+        {
+            if let Err(e) = self.compact(set) {
+                tebako_log::log!(
+                    tebako_log::Level::Warn,
+                    "tfs",
+                    "cow: compacting {} failed (errno {e}); appends continue",
+                    self.path.display()
+                );
+            }
+        }
+        Ok(())
+    }
+
+    /// Rewrite the journal as the sorted `set` and move the append handle
+    /// to the new file. The handle is opened before the rename, so a
+    /// failure anywhere leaves the old journal and handle in place.
+    fn compact(&mut self, set: &BTreeSet<String>) -> Result<(), i32> {
+        let tmp = self.path.with_extension("tmp");
+        let swapped = std::fs::write(&tmp, serialize_whiteouts(set))
+            .and_then(|()| std::fs::OpenOptions::new().append(true).open(&tmp))
+            .and_then(|file| std::fs::rename(&tmp, &self.path).map(|()| file));
+        match swapped {
+            Ok(file) => {
+                self.file = file;
+                self.appended = 0;
+                Ok(())
+            }
+            Err(e) => {
+                let _ = std::fs::remove_file(&tmp);
+                Err(io_errno(&e))
+            }
+        }
+    }
+}
+
+// ===================================================================
+// Partial copy-up block maps
+// ===================================================================
+
+/// The block map of a partially copied-up file (see the module docs).
+#[derive(Debug, Clone, PartialEq, Eq)]
+struct Extents {
+    /// Base file size at copy-up; bytes past it are overlay-only.
+    base_size: u64,
+    /// Per base block: true once the overlay holds it.
+    dirty: Vec<bool>,
+}
+
+impl Extents {
+    fn new(base_size: u64) -> Extents {
+        Extents {
+            base_size,
+            dirty: vec![false; base_size.div_ceil(COPY_UP_BLOCK) as usize],
+        }
+    }
+
+    /// True when the byte at `pos` still reads from the base.
+    fn is_clean(&self, pos: u64) -> bool {
+        pos < self.base_size && !self.dirty[(pos / COPY_UP_BLOCK) as usize]
+    }
+
+    /// End of the run of bytes from `pos` that read from the same layer.
+    fn run_end(&self, pos: u64) -> u64 {
+        let clean = self.is_clean(pos);
+        let mut b = pos / COPY_UP_BLOCK + 1;
+        while b < self.dirty.len() as u64 && self.dirty[b as usize] != clean {
+            b += 1;
+        }
+        if clean {
+            (b * COPY_UP_BLOCK).min(self.base_size)
+        } else if b < self.dirty.len() as u64 {
+            b * COPY_UP_BLOCK
+        } else {
+            u64::MAX
+        }
+    }
+
+    fn is_complete(&self) -> bool {
+        self.dirty.iter().all(|&d| d)
+    }
+
+    fn serialize(&self) -> String {
+        let mut out = format!("{EXTENTS_MAGIC}\nS {} {COPY_UP_BLOCK}\n", self.base_size);
+        let mut b = 0;
+        while b < self.dirty.len() {
+            if !self.dirty[b] {
+                b += 1;
+                continue;
+            }
+            let first = b;
+            while b < self.dirty.len() && self.dirty[b] {
+                b += 1;
+            }
+            out.push_str(&format!("D {first} {}\n", b - first));
+        }
+        out
+    }
+
+    /// Parse a map body (strict: EINVAL on any malformed line, a foreign
+    /// block size, or a run past the base blocks).
+    fn parse(text: &str) -> Result<Extents, i32> {
+        let mut lines = text.lines();
+        if lines.next() != Some(EXTENTS_MAGIC) {
+            return Err(libc::EINVAL);
+        }
+        let size: Vec<&str> = lines.next().ok_or(libc::EINVAL)?.split(' ').collect();
+        let (base_size, block) = match size[..] {
+            ["S", base, block] => (number(base)?, number(block)?),
+            _ => return Err(libc::EINVAL),
+        };
+        if block != COPY_UP_BLOCK {
+            return Err(libc::EINVAL);
+        }
+        let mut ext = Extents::new(base_size);
+        for line in lines {
+            let run: Vec<&str> = line.split(' ').collect();
+            let (first, count) = match run[..] {
+                ["D", first, count] => (number(first)?, number(count)?),
+                _ => return Err(libc::EINVAL),
+            };
+            let end = first.checked_add(count).ok_or(libc::EINVAL)?;
+            if count == 0 || end > ext.dirty.len() as u64 {
+                return Err(libc::EINVAL);
+            }
+            ext.dirty[first as usize..end as usize].fill(true);
+        }
+        Ok(ext)
+    }
+}
+
+fn number(text: &str) -> Result<u64, i32> {
+    text.parse().map_err(|_| libc::EINVAL)
+}
+
+/// Where the block map of `path` lives under the overlay `root`.
+fn extents_path(root: &Path, path: &str) -> PathBuf {
+    root.join(EXTENTS_DIR).join(format!("{path}.map"))
+}
+
+/// Atomically rewrite the block map of `path` (temp file + rename).
+fn store_extents(root: &Path, path: &str, ext: &Extents) -> Result<(), i32> {
+    let file = extents_path(root, path);
+    if let Some(dir) = file.parent() {
+        std::fs::create_dir_all(dir).map_err(|e| io_errno(&e))?;
+    }
+    let mut tmp = file.clone().into_os_string();
+    tmp.push(".tmp");
+    std::fs::write(&tmp, ext.serialize()).map_err(|e| io_errno(&e))?;
+    std::fs::rename(&tmp, &file).map_err(|e| io_errno(&e))
+}
+
+fn drop_extents(root: &Path, path: &str) -> Result<(), i32> {
+    match std::fs::remove_file(extents_path(root, path)) {
+        Err(e) if e.kind() != io::ErrorKind::NotFound => Err(io_errno(&e)),
+        _ => Ok(()),
+    }
+}
+
+/// Load every block map under the overlay (see the module docs): a
+/// leftover temp file or a map whose overlay file never appeared is
+/// discarded; an overlay file a torn copy-up left short is re-extended.
+fn load_extents(overlay: &HostDirBackend) -> Result<HashMap<String, Extents>, i32> {
+    fn walk(dir: &Path, prefix: &str, out: &mut Vec<(String, PathBuf)>) -> Result<(), i32> {
+        let entries = match std::fs::read_dir(dir) {
+            Ok(entries) => entries,
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(()),
+            Err(e) => return Err(io_errno(&e)),
+        };
+        for entry in entries {
+            let entry = entry.map_err(|e| io_errno(&e))?;
+            let name = entry.file_name().to_string_lossy().into_owned();
+            let path = join_path(prefix, &name);
+            if entry.file_type().map_err(|e| io_errno(&e))?.is_dir() {
+                walk(&entry.path(), &path, out)?;
+            } else {
+                out.push((path, entry.path()));
+            }
+        }
+        Ok(())
+    }
+    let mut found = Vec::new();
+    walk(&overlay.root().join(EXTENTS_DIR), "", &mut found)?;
+    let mut maps = HashMap::new();
+    for (name, file) in found {
+        let Some(path) = name.strip_suffix(".map") else {
+            let _ = std::fs::remove_file(&file); // a torn map rewrite
+            continue;
+        };
+        let text = std::fs::read_to_string(&file).map_err(|e| io_errno(&e))?;
+        let ext = Extents::parse(&text)?;
+        match overlay.stat(path) {
+            Ok(st) if st.entry_type == EntryType::File => {
+                if (st.size.max(0) as u64) < ext.base_size {
+                    overlay.truncate(path, ext.base_size)?;
+                }
+                maps.insert(path.to_string(), ext);
+            }
+            _ => drop_extents(overlay.root(), path)?,
+        }
+    }
+    Ok(maps)
+}
+
+/// The overlay index (see the module docs): every overlay path, and
+/// whether it is a directory. The root is implicit.
+#[derive(Default)]
+struct OverlayIndex {
+    entries: HashMap<String, bool>,
+}
+
+impl OverlayIndex {
+    /// Index the overlay tree under `root` (the bookkeeping excluded).
+    fn scan(root: &Path) -> Result<OverlayIndex, i32> {
+        fn walk(dir: &Path, prefix: &str, index: &mut OverlayIndex) -> Result<(), i32> {
+            for entry in std::fs::read_dir(dir).map_err(|e| io_errno(&e))? {
+                let entry = entry.map_err(|e| io_errno(&e))?;
+                let name = entry.file_name().to_string_lossy().into_owned();
+                let path = join_path(prefix, &name);
+                if is_internal(&path) {
+                    continue;
+                }
+                let is_dir = entry.file_type().map_err(|e| io_errno(&e))?.is_dir();
+                if is_dir {
+                    walk(&entry.path(), &path, index)?;
+                }
+                index.entries.insert(path, is_dir);
+            }
+            Ok(())
+        }
+        let mut index = OverlayIndex::default();
+        walk(root, "", &mut index)?;
+        Ok(index)
+    }
+
+    /// `Ok` when the overlay holds `path`; otherwise the errno its host
+    /// lookup would give — ENOTDIR below an overlay non-directory (which
+    /// shadows any base directory of that name), else ENOENT.
+    fn lookup(&self, path: &str) -> Result<(), i32> {
+        if path.is_empty() || self.entries.contains_key(path) {
+            return Ok(());
+        }
+        let mut p = path;
+        while let Some(i) = p.rfind('/') {
+            p = &p[..i];
+            match self.entries.get(p) {
+                Some(false) => return Err(libc::ENOTDIR),
+                Some(true) => break,
+                None => {}
+            }
+        }
+        Err(libc::ENOENT)
+    }
+
+    /// Record `path` (and its parent directories) as present.
+    fn note(&mut self, path: &str, is_dir: bool) {
+        if path.is_empty() {
+            return;
+        }
+        self.entries.insert(path.to_string(), is_dir);
+        let mut p = path;
+        while let Some(i) = p.rfind('/') {
+            p = &p[..i];
+            if self.entries.insert(p.to_string(), true) == Some(true) {
+                break; // the rest of the chain is already indexed
+            }
+        }
+    }
+}
+
+/// True for the overlay's own bookkeeping (the journal and the block
+/// maps): never VFS content.
+fn is_internal(path: &str) -> bool {
+    path == JOURNAL_FILE
+        || path == EXTENTS_DIR
+        || (path.starts_with(EXTENTS_DIR) && path.as_bytes()[EXTENTS_DIR.len()] == b'/')
+}
+
 // ===================================================================
 // The composite backend
 // ===================================================================
@@ -154,9 +545,16 @@ pub struct CowBackend {
     base: Box<dyn Backend>,
     overlay: HostDirBackend,
     /// Hidden base paths (the whiteout set; the journal on disk is the
-    /// persistent form, rewritten atomically on every change).
+    /// persistent form, appended on every change).
     whiteouts: RwLock<BTreeSet<String>>,
-    journal_path: PathBuf,
+    /// The journal's append side (locked under the set's write lock).
+    journal: Mutex<WhiteoutLog>,
+    /// What the overlay holds (see the module docs).
+    present: RwLock<OverlayIndex>,
+    /// Block maps of the partially copied-up files.
+    partial: RwLock<HashMap<String, Extents>>,
+    /// Base files at least this large copy up partially.
+    partial_min: u64,
     /// The declared write areas (spec 24 §5), backend-normalized (`""` =
     /// the mount root, covering everything): `Some` gates every write
     /// verb to the declared set (outside → `EROFS`); `None` is the
@@ -216,17 +614,22 @@ impl CowBackend {
         write_areas: Option<BTreeSet<String>>,
     ) -> Result<CowBackend, i32> {
         let journal_path = overlay.root().join(JOURNAL_FILE);
-        let whiteouts = load_journal(&journal_path)?;
-        if whiteouts.is_empty() {
+        let (whiteouts, rewrite) = load_journal(&journal_path)?;
+        if rewrite {
             // Eagerly create the journal: the change record exists from
             // the first mount even before any delete.
             store_journal(&journal_path, &whiteouts)?;
         }
+        let partial = load_extents(&overlay)?;
+        let present = OverlayIndex::scan(overlay.root())?;
         Ok(CowBackend {
             base,
             overlay,
             whiteouts: RwLock::new(whiteouts),
-            journal_path,
+            journal: Mutex::new(WhiteoutLog::open(journal_path)?),
+            present: RwLock::new(present),
+            partial: RwLock::new(partial),
+            partial_min: PARTIAL_COPY_UP_MIN,
             write_areas,
         })
     }
@@ -288,7 +691,13 @@ impl CowBackend {
     fn add_whiteout(&self, path: &str) -> Result<(), i32> {
         let mut set = self.whiteouts.write().unwrap();
         if set.insert(path.to_string()) {
-            store_journal(&self.journal_path, &set)?;
+            let mut journal = self.journal.lock().unwrap();
+            if let Err(e) = journal.append(path, &set) {
+                // Memory never claims a delete the journal did not record
+                // (an error here means the record was not written).
+                set.remove(path);
+                return Err(e);
+            }
         }
         Ok(())
     }
@@ -306,7 +715,7 @@ impl CowBackend {
                 mtime: 0,
             });
         }
-        match self.overlay.stat(path) {
+        match self.in_overlay(path).and_then(|()| self.overlay.stat(path)) {
             Ok(st) => Ok(st),
             Err(libc::ENOENT) => {
                 if self.is_hidden(path) {
@@ -329,7 +738,7 @@ impl CowBackend {
         let parent = &path[..i];
         match self.stat_merged(parent) {
             Ok(st) if st.entry_type != EntryType::Directory => Err(libc::ENOTDIR),
-            Ok(_) | Err(libc::ENOENT) => self.overlay.mkdir_parents(parent),
+            Ok(_) | Err(libc::ENOENT) => self.overlay_mkdir_parents(parent),
             Err(e) => Err(e),
         }
     }
@@ -343,7 +752,7 @@ impl CowBackend {
         };
         let parent = &path[..i];
         match self.stat_merged(parent) {
-            Ok(st) if st.entry_type == EntryType::Directory => self.overlay.mkdir_parents(parent),
+            Ok(st) if st.entry_type == EntryType::Directory => self.overlay_mkdir_parents(parent),
             Ok(_) => Err(libc::ENOTDIR),
             Err(e) => Err(e),
         }
@@ -351,36 +760,39 @@ impl CowBackend {
 
     /// Copy a base entry into the overlay so a write can land (overlayfs
     /// copy-up). New files only materialize their parents; directories
-    /// materialize shallowly (children copy up on demand).
+    /// materialize shallowly (children copy up on demand); large files
+    /// copy up partially (see the module docs).
     fn copy_up(&self, path: &str) -> Result<(), i32> {
-        if self.overlay.stat(path).is_ok() {
+        if self.in_overlay(path).is_ok() {
             return Ok(());
         }
         match self.base.stat(path) {
             Ok(st) => {
                 self.ensure_overlay_parent(path)?;
                 match st.entry_type {
+                    EntryType::File if st.size.max(0) as u64 >= self.partial_min => {
+                        // Map first: a torn copy-up leaves a map without
+                        // its file, never holes without their map.
+                        let ext = Extents::new(st.size as u64);
+                        store_extents(self.overlay.root(), path, &ext)?;
+                        self.overlay.pwrite(path, &[], 0)?;
+                        self.overlay.truncate(path, ext.base_size)?;
+                        self.present.write().unwrap().note(path, false);
+                        #[cfg(unix)]
+                        self.overlay.set_perms(path, st.perms);
+                        self.partial.write().unwrap().insert(path.to_string(), ext);
+                        Ok(())
+                    }
                     EntryType::File => {
                         // Stream the base content into a fresh overlay file.
                         self.overlay.pwrite(path, &[], 0)?;
-                        let mut off = 0u64;
-                        let mut buf = vec![0u8; 8192];
-                        loop {
-                            let n = self.base.pread(path, &mut buf, off)?;
-                            if n == 0 {
-                                break;
-                            }
-                            let mut w = 0usize;
-                            while w < n {
-                                w += self.overlay.pwrite(path, &buf[w..n], off + w as u64)?;
-                            }
-                            off += n as u64;
-                        }
+                        self.present.write().unwrap().note(path, false);
+                        self.copy_range(path, 0, u64::MAX)?;
                         #[cfg(unix)]
                         self.overlay.set_perms(path, st.perms);
                         Ok(())
                     }
-                    EntryType::Directory => self.overlay.mkdir_parents(path),
+                    EntryType::Directory => self.overlay_mkdir_parents(path),
                     // Symlinks/special files: no copyable content.
                     _ => Err(libc::EINVAL),
                 }
@@ -392,6 +804,136 @@ impl CowBackend {
             Err(e) => Err(e),
         }
     }
+
+    /// `Ok` when the overlay holds `path`, else the errno of the host
+    /// lookup it skips ([`OverlayIndex::lookup`]).
+    fn in_overlay(&self, path: &str) -> Result<(), i32> {
+        self.present.read().unwrap().lookup(path)
+    }
+
+    /// `mkdir -p` in the overlay, indexed.
+    fn overlay_mkdir_parents(&self, path: &str) -> Result<(), i32> {
+        self.overlay.mkdir_parents(path)?;
+        self.present.write().unwrap().note(path, true);
+        Ok(())
+    }
+
+    /// Copy the base bytes `[from, to)` of `path` to the same offsets of
+    /// its overlay file (stopping early at the base EOF).
+    fn copy_range(&self, path: &str, from: u64, to: u64) -> Result<(), i32> {
+        let mut off = from;
+        let mut buf = vec![0u8; 8192];
+        while off < to {
+            let want = (to - off).min(buf.len() as u64) as usize;
+            let n = self.base.pread(path, &mut buf[..want], off)?;
+            if n == 0 {
+                break;
+            }
+            let mut w = 0usize;
+            while w < n {
+                w += self.overlay.pwrite(path, &buf[w..n], off + w as u64)?;
+            }
+            off += n as u64;
+        }
+        Ok(())
+    }
+
+    /// pread of a partially copied-up file: each run of bytes from the
+    /// layer that holds it.
+    fn partial_read(
+        &self,
+        ext: &Extents,
+        path: &str,
+        buf: &mut [u8],
+        offset: u64,
+    ) -> Result<usize, i32> {
+        let mut done = 0usize;
+        while done < buf.len() {
+            let pos = offset + done as u64;
+            let want = (buf.len() - done).min((ext.run_end(pos) - pos) as usize);
+            let chunk = &mut buf[done..done + want];
+            let n = if ext.is_clean(pos) {
+                self.base.pread(path, chunk, pos)?
+            } else {
+                self.overlay.pread(path, chunk, pos)?
+            };
+            done += n;
+            if n < want {
+                break;
+            }
+        }
+        Ok(done)
+    }
+
+    /// pwrite to a partially copied-up file: the base bytes of every
+    /// clean block the write touches but does not cover are copied up
+    /// first, then the map records the blocks (dropped once complete).
+    fn partial_write(
+        &self,
+        ext: &mut Extents,
+        path: &str,
+        data: &[u8],
+        offset: u64,
+    ) -> Result<usize, i32> {
+        let end = offset + data.len() as u64;
+        let mut copied = Vec::new();
+        if !data.is_empty() {
+            let last = ((end - 1) / COPY_UP_BLOCK).min(ext.dirty.len() as u64);
+            for b in offset / COPY_UP_BLOCK..=last {
+                if b >= ext.dirty.len() as u64 || ext.dirty[b as usize] {
+                    continue;
+                }
+                let start = b * COPY_UP_BLOCK;
+                let stop = (start + COPY_UP_BLOCK).min(ext.base_size);
+                self.copy_range(path, start, offset.clamp(start, stop))?;
+                self.copy_range(path, end.clamp(start, stop), stop)?;
+                copied.push(b as usize);
+            }
+        }
+        let mut w = 0usize;
+        while w < data.len() {
+            w += self.overlay.pwrite(path, &data[w..], offset + w as u64)?;
+        }
+        if copied.is_empty() {
+            return Ok(w);
+        }
+        for &b in &copied {
+            ext.dirty[b] = true;
+        }
+        let stored = if ext.is_complete() {
+            drop_extents(self.overlay.root(), path)
+        } else {
+            store_extents(self.overlay.root(), path, ext)
+        };
+        if let Err(e) = stored {
+            // Memory never claims blocks the map did not record.
+            for &b in &copied {
+                ext.dirty[b] = false;
+            }
+            return Err(e);
+        }
+        Ok(w)
+    }
+
+    /// Finish a partial copy-up (the whole-file fallback): copy every
+    /// clean block, then drop the map.
+    fn materialize(&self, path: &str) -> Result<(), i32> {
+        let mut partial = self.partial.write().unwrap();
+        let Some(ext) = partial.get(path) else {
+            return Ok(());
+        };
+        let mut pos = 0;
+        while pos < ext.base_size {
+            let end = ext.run_end(pos).min(ext.base_size);
+            if ext.is_clean(pos) {
+                self.copy_range(path, pos, end)?;
+            }
+            pos = end;
+        }
+        drop_extents(self.overlay.root(), path)?;
+        partial.remove(path);
+        Ok(())
+    }
 }
 
 /// Normalize an in-image path: no leading or trailing `/`, `""` for root.
@@ -415,7 +957,7 @@ impl Backend for CowBackend {
 
     fn stat(&self, path: &str) -> Result<RawStat, i32> {
         let path = normalize(path);
-        if path == JOURNAL_FILE {
+        if is_internal(path) {
             return Err(libc::ENOENT); // the journal is not VFS content
         }
         self.stat_merged(path)
@@ -423,11 +965,20 @@ impl Backend for CowBackend {
 
     fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
         let path = normalize(path);
-        if path == JOURNAL_FILE {
+        if is_internal(path) {
             return Err(libc::ENOENT);
         }
+        {
+            let partial = self.partial.read().unwrap();
+            if let Some(ext) = partial.get(path) {
+                return self.partial_read(ext, path, buf, offset);
+            }
+        }
         // Overlay first; a whiteout hides only the base entry.
-        match self.overlay.pread(path, buf, offset) {
+        match self
+            .in_overlay(path)
+            .and_then(|()| self.overlay.pread(path, buf, offset))
+        {
             Err(libc::ENOENT) => {
                 if self.is_hidden(path) {
                     Err(libc::ENOENT)
@@ -444,7 +995,12 @@ impl Backend for CowBackend {
         if path == JOURNAL_FILE {
             return Err(libc::ENOTDIR);
         }
-        let overlay_entries = self.overlay.read_dir(path);
+        if is_internal(path) {
+            return Err(libc::ENOENT);
+        }
+        let overlay_entries = self
+            .in_overlay(path)
+            .and_then(|()| self.overlay.read_dir(path));
         let base_entries = self.base.read_dir(path);
         let mut out: Vec<RawDirEntry> = match overlay_entries {
             Ok(entries) => entries,
@@ -467,7 +1023,7 @@ impl Backend for CowBackend {
             Err(e) => return Err(e),
         };
         if path.is_empty() {
-            out.retain(|e| e.name != JOURNAL_FILE);
+            out.retain(|e| !is_internal(&e.name));
         }
         match base_entries {
             Ok(entries) => {
@@ -492,7 +1048,10 @@ impl Backend for CowBackend {
     fn read_link(&self, path: &str) -> Result<String, i32> {
         let path = normalize(path);
         // Same shadowing rule as reads: the overlay wins, then the base.
-        match self.overlay.read_link(path) {
+        match self
+            .in_overlay(path)
+            .and_then(|()| self.overlay.read_link(path))
+        {
             Err(libc::ENOENT) => {
                 if self.is_hidden(path) {
                     Err(libc::ENOENT)
@@ -507,6 +1066,11 @@ impl Backend for CowBackend {
     fn writable(&self) -> Option<&dyn WritableBackend> {
         Some(self)
     }
+
+    /// The base image's read cache (the overlay is host files).
+    fn cache_stats(&self) -> Option<crate::byte_lru::LruStats> {
+        self.base.cache_stats()
+    }
 }
 
 impl WritableBackend for CowBackend {
@@ -515,7 +1079,7 @@ impl WritableBackend for CowBackend {
         if path.is_empty() {
             return Err(libc::EISDIR);
         }
-        if path == JOURNAL_FILE {
+        if is_internal(path) {
             return Err(libc::EPERM); // the journal is the audit delta, not content
         }
         if !self.write_permitted(path) {
@@ -528,12 +1092,26 @@ impl WritableBackend for CowBackend {
         } else {
             self.ensure_overlay_parent(path)?;
         }
-        self.overlay.pwrite(path, data, offset)
+        let mut partial = self.partial.write().unwrap();
+        match partial.get_mut(path) {
+            Some(ext) => {
+                let n = self.partial_write(ext, path, data, offset)?;
+                if ext.is_complete() {
+                    partial.remove(path);
+                }
+                Ok(n)
+            }
+            None => {
+                let n = self.overlay.pwrite(path, data, offset)?;
+                self.present.write().unwrap().note(path, false);
+                Ok(n)
+            }
+        }
     }
 
     fn truncate(&self, path: &str, len: u64) -> Result<(), i32> {
         let path = normalize(path);
-        if path.is_empty() || path == JOURNAL_FILE {
+        if path.is_empty() || is_internal(path) {
             return Err(libc::EINVAL);
         }
         if !self.write_permitted(path) {
@@ -545,12 +1123,13 @@ impl WritableBackend for CowBackend {
             return Err(libc::EINVAL);
         }
         self.copy_up(path)?;
+        self.materialize(path)?;
         self.overlay.truncate(path, len)
     }
 
     fn mkdir(&self, path: &str, perms: u32) -> Result<(), i32> {
         let path = normalize(path);
-        if path.is_empty() || path == JOURNAL_FILE {
+        if path.is_empty() || is_internal(path) {
             return Err(libc::EEXIST);
         }
         if !self.write_permitted(path) {
@@ -562,12 +1141,14 @@ impl WritableBackend for CowBackend {
             Err(e) => return Err(e),
         }
         self.require_merged_parent(path)?;
-        self.overlay.mkdir(path, perms)
+        self.overlay.mkdir(path, perms)?;
+        self.present.write().unwrap().note(path, true);
+        Ok(())
     }
 
     fn remove(&self, path: &str) -> Result<(), i32> {
         let path = normalize(path);
-        if path.is_empty() || path == JOURNAL_FILE {
+        if path.is_empty() || is_internal(path) {
             return Err(libc::EINVAL);
         }
         if !self.write_permitted(path) {
@@ -579,8 +1160,12 @@ impl WritableBackend for CowBackend {
         if st.entry_type == EntryType::Directory && !self.read_dir(path)?.is_empty() {
             return Err(libc::ENOTEMPTY);
         }
-        if self.overlay.stat(path).is_ok() {
+        if self.in_overlay(path).is_ok() {
             self.overlay.remove(path)?;
+            self.present.write().unwrap().entries.remove(path);
+            if self.partial.write().unwrap().remove(path).is_some() {
+                drop_extents(self.overlay.root(), path)?;
+            }
         }
         if self.base.stat(path).is_ok() {
             // The delete must hide the base entry too (the name is gone
@@ -844,6 +1429,296 @@ mod tests {
         assert!(cow.whiteouts().contains("todelete.txt"));
     }
 
+    #[test]
+    fn cow_journal_appends_and_compacts() {
+        use std::os::unix::fs::MetadataExt as _;
+        let (dir, cow) = cow();
+        cow.journal.lock().unwrap().compact_min = 2;
+        let path = dir.path().join(JOURNAL_FILE);
+        let inode = || std::fs::metadata(&path).unwrap().ino();
+        let w = cow.writable().unwrap();
+
+        // Deletes append in delete order; the file is never rewritten...
+        let created = inode();
+        w.remove("todelete.txt").unwrap();
+        w.remove("bin/tool").unwrap();
+        assert_eq!(inode(), created);
+        assert_eq!(
+            std::fs::read_to_string(&path).unwrap(),
+            "TFS-WHITEOUTS 1\nW todelete.txt\nW bin/tool\n"
+        );
+        // ...until the appended tail outgrows the compacted journal: the
+        // rewrite is the canonical sorted form, and appends resume on it.
+        w.remove("etc/motd").unwrap();
+        assert_ne!(inode(), created);
+        let compacted = serialize_whiteouts(&cow.whiteouts());
+        assert_eq!(std::fs::read_to_string(&path).unwrap(), compacted);
+        w.remove("delsub/a.txt").unwrap();
+        assert_eq!(
+            std::fs::read_to_string(&path).unwrap(),
+            format!("{compacted}W delsub/a.txt\n")
+        );
+        assert_eq!(
+            parse_whiteouts(&std::fs::read_to_string(&path).unwrap()).unwrap(),
+            cow.whiteouts()
+        );
+    }
+
+    #[test]
+    fn cow_journal_compaction_failure_keeps_the_whiteout() {
+        let (dir, cow) = cow();
+        cow.journal.lock().unwrap().compact_min = 1;
+        let path = dir.path().join(JOURNAL_FILE);
+        // A directory where the compaction's temp file goes: every
+        // rewrite fails (as on a full disk).
+        let tmp = path.with_extension("tmp");
+        std::fs::create_dir(&tmp).unwrap();
+        let w = cow.writable().unwrap();
+        for victim in ["todelete.txt", "bin/tool", "etc/motd"] {
+            w.remove(victim).unwrap();
+            assert_eq!(cow.stat(victim).unwrap_err(), libc::ENOENT);
+        }
+        assert_eq!(
+            std::fs::read_to_string(&path).unwrap(),
+            "TFS-WHITEOUTS 1\nW todelete.txt\nW bin/tool\nW etc/motd\n"
+        );
+        // Room again: the next append compacts.
+        std::fs::remove_dir(&tmp).unwrap();
+        w.remove("delsub/a.txt").unwrap();
+        assert_eq!(
+            std::fs::read_to_string(&path).unwrap(),
+            serialize_whiteouts(&cow.whiteouts())
+        );
+        assert_eq!(cow.journal.lock().unwrap().appended, 0);
+    }
+
+    #[test]
+    fn cow_journal_torn_append_is_dropped_at_mount() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join(JOURNAL_FILE);
+        std::fs::write(&path, "TFS-WHITEOUTS 1\nW todelete.txt\nW bin/to").unwrap();
+        let base =
+            Box::new(TarBackend::from_memory(make_base_tar(), TarCompression::None).unwrap());
+        let overlay = HostDirBackend::new(dir.path()).unwrap();
+        let cow = CowBackend::new(base, overlay).unwrap();
+        assert_eq!(cow.stat("todelete.txt").unwrap_err(), libc::ENOENT);
+        assert_eq!(pread_all(&cow, "bin/tool"), b"tool-binary");
+        // Compacted at mount: the next append starts on a fresh line.
+        cow.writable().unwrap().remove("etc/motd").unwrap();
+        assert_eq!(
+            std::fs::read_to_string(&path).unwrap(),
+            "TFS-WHITEOUTS 1\nW todelete.txt\nW etc/motd\n"
+        );
+    }
+
+    #[test]
+    fn cow_base_only_paths_never_reach_the_overlay_dir() {
+        let dir = tempfile::tempdir().unwrap();
+        std::fs::create_dir_all(dir.path().join("etc")).unwrap();
+        std::fs::write(dir.path().join("etc/motd"), b"pre-existing").unwrap();
+        std::fs::write(dir.path().join("bin"), b"a file over the base dir").unwrap();
+        let base =
+            Box::new(TarBackend::from_memory(make_base_tar(), TarCompression::None).unwrap());
+        let cow = CowBackend::new(base, HostDirBackend::new(dir.path()).unwrap()).unwrap();
+
+        // The stack-time walk indexes what the overlay already holds,
+        // including a file shadowing a base directory.
+        assert_eq!(pread_all(&cow, "etc/motd"), b"pre-existing");
+        assert_eq!(cow.stat("bin/tool").unwrap_err(), libc::ENOTDIR);
+        assert_eq!(cow.read_dir("bin").unwrap_err(), libc::ENOTDIR);
+
+        // A base-only path is answered from the index: an entry dropped
+        // into the overlay directory behind the mount is not consulted.
+        std::fs::write(dir.path().join("todelete.txt"), b"behind").unwrap();
+        assert_eq!(pread_all(&cow, "todelete.txt"), b"delete me");
+
+        // The write verbs keep the index current.
+        let w = cow.writable().unwrap();
+        w.pwrite("etc/deep/nested.txt", b"NEW", 0).unwrap();
+        assert_eq!(pread_all(&cow, "etc/deep/nested.txt"), b"NEWted\n");
+        w.mkdir("etc/deep/sub", 0o755).unwrap();
+        w.pwrite("etc/deep/sub/f", b"f", 0).unwrap();
+        assert_eq!(names(&cow, "etc/deep/sub"), ["f"]);
+        w.remove("etc/deep/sub/f").unwrap();
+        assert_eq!(cow.stat("etc/deep/sub/f").unwrap_err(), libc::ENOENT);
+        assert!(names(&cow, "etc/deep/sub").is_empty());
+    }
+
+    // ---------------------------------------------------------------
+    // Partial copy-up
+    // ---------------------------------------------------------------
+
+    fn big_data(len: usize) -> Vec<u8> {
+        (0..len as u32).map(|i| (i % 251) as u8).collect()
+    }
+
+    /// A COW over a base holding `data/big.db` (`len` pattern bytes) and
+    /// the `small` file, stacked on the overlay directory `dir`.
+    fn big_cow(dir: &Path, len: usize) -> CowBackend {
+        let mut b = tar::Builder::new(Vec::new());
+        append_file(&mut b, "data/big.db", &big_data(len), 0o640);
+        append_file(&mut b, "small", b"small", 0o644);
+        b.finish().unwrap();
+        let base = TarBackend::from_memory(b.into_inner().unwrap(), TarCompression::None);
+        CowBackend::new(Box::new(base.unwrap()), HostDirBackend::new(dir).unwrap()).unwrap()
+    }
+
+    #[test]
+    fn cow_large_file_copies_up_only_touched_blocks() {
+        let dir = tempfile::tempdir().unwrap();
+        let len = 3 * 1024 * 1024 + 100;
+        let mut want = big_data(len);
+        let cow = big_cow(dir.path(), len);
+        let w = cow.writable().unwrap();
+
+        // An append dirties the last block only; the rest stays in the base.
+        w.pwrite("data/big.db", b"appended line\n", len as u64)
+            .unwrap();
+        want.extend_from_slice(b"appended line\n");
+        let map = dir.path().join(EXTENTS_DIR).join("data/big.db.map");
+        assert_eq!(
+            std::fs::read_to_string(&map).unwrap(),
+            format!("TFS-EXTENTS 1\nS {len} 65536\nD 48 1\n")
+        );
+        let host = std::fs::read(dir.path().join("data/big.db")).unwrap();
+        assert_eq!(host.len(), want.len());
+        assert!(host[..48 * 65536].iter().all(|&b| b == 0), "never copied");
+        assert_eq!(host[48 * 65536..], want[48 * 65536..]);
+
+        // An unaligned write straddling two blocks keeps their base bytes.
+        w.pwrite("data/big.db", b"XYZ", 65535).unwrap();
+        want[65535..65538].copy_from_slice(b"XYZ");
+        assert_eq!(pread_all(&cow, "data/big.db"), want);
+        assert_eq!(cow.stat("data/big.db").unwrap().size, want.len() as i64);
+        let mut mid = [0u8; 10];
+        assert_eq!(cow.pread("data/big.db", &mut mid, 65530).unwrap(), 10);
+        assert_eq!(mid, want[65530..65540]);
+        assert_eq!(
+            cow.pread("data/big.db", &mut mid, want.len() as u64 - 4)
+                .unwrap(),
+            4
+        );
+
+        // The map survives a remount; the bookkeeping stays hidden.
+        drop(cow);
+        let cow = big_cow(dir.path(), len);
+        assert_eq!(pread_all(&cow, "data/big.db"), want);
+        assert!(!names(&cow, "").contains(&EXTENTS_DIR.to_string()));
+        assert_eq!(cow.stat(EXTENTS_DIR).unwrap_err(), libc::ENOENT);
+        let w = cow.writable().unwrap();
+        assert_eq!(
+            w.pwrite(".tfs-extents/data/big.db.map", b"x", 0)
+                .unwrap_err(),
+            libc::EPERM
+        );
+
+        // truncate falls back to the whole file, and the map goes.
+        w.truncate("data/big.db", 2 * 65536 + 7).unwrap();
+        want.truncate(2 * 65536 + 7);
+        assert!(!map.exists());
+        assert_eq!(std::fs::read(dir.path().join("data/big.db")).unwrap(), want);
+        assert_eq!(pread_all(&cow, "data/big.db"), want);
+    }
+
+    #[test]
+    fn cow_partial_copy_up_completes_and_removes_cleanly() {
+        let dir = tempfile::tempdir().unwrap();
+        let len = 2 * 65536 + 10;
+        let mut cow = big_cow(dir.path(), len);
+        cow.partial_min = 1;
+        let mut want = big_data(len);
+        let map = dir.path().join(EXTENTS_DIR).join("data/big.db.map");
+        for at in [5u64, 70_000, 131_075] {
+            assert!(map.exists() == (at != 5), "partial until the last block");
+            cow.pwrite("data/big.db", b"!", at).unwrap();
+            want[at as usize] = b'!';
+        }
+        // Every base block dirty: an ordinary overlay file again.
+        assert!(!map.exists());
+        assert!(cow.partial.read().unwrap().is_empty());
+        assert_eq!(std::fs::read(dir.path().join("data/big.db")).unwrap(), want);
+
+        // A small file still copies up whole (below the default minimum).
+        cow.partial_min = PARTIAL_COPY_UP_MIN;
+        cow.pwrite("small", b"S", 0).unwrap();
+        assert!(cow.partial.read().unwrap().is_empty());
+        assert_eq!(std::fs::read(dir.path().join("small")).unwrap(), b"Small");
+
+        // remove drops the map with the file.
+        cow.partial_min = 1;
+        cow.truncate("data/big.db", 0).unwrap();
+        cow.remove("data/big.db").unwrap();
+        cow.pwrite("data/big.db", b"new", 0).unwrap(); // recreated fresh
+        assert_eq!(pread_all(&cow, "data/big.db"), b"new");
+        assert!(!map.exists());
+    }
+
+    #[test]
+    fn cow_torn_partial_copy_up_is_discarded_at_mount() {
+        let dir = tempfile::tempdir().unwrap();
+        let len = 2 * 1024 * 1024;
+        let ext = Extents::new(len as u64);
+        // The map landed, the sparse overlay file did not.
+        store_extents(dir.path(), "data/big.db", &ext).unwrap();
+        std::fs::write(dir.path().join(EXTENTS_DIR).join("stray.map.tmp"), "x").unwrap();
+        let cow = big_cow(dir.path(), len);
+        assert!(cow.partial.read().unwrap().is_empty());
+        assert!(!extents_path(dir.path(), "data/big.db").exists());
+        assert!(!dir.path().join(EXTENTS_DIR).join("stray.map.tmp").exists());
+        assert_eq!(pread_all(&cow, "data/big.db"), big_data(len));
+
+        // A malformed map fails the mount.
+        store_extents(dir.path(), "small", &ext).unwrap();
+        std::fs::write(dir.path().join("small"), "small").unwrap();
+        std::fs::write(
+            extents_path(dir.path(), "small"),
+            "TFS-EXTENTS 1\nS 5 4096\n",
+        )
+        .unwrap();
+        let mut b = tar::Builder::new(Vec::new());
+        append_file(&mut b, "small", b"small", 0o644);
+        b.finish().unwrap();
+        let base = TarBackend::from_memory(b.into_inner().unwrap(), TarCompression::None);
+        let overlay = HostDirBackend::new(dir.path()).unwrap();
+        assert_eq!(
+            CowBackend::new(Box::new(base.unwrap()), overlay).err(),
+            Some(libc::EINVAL)
+        );
+    }
+
+    #[test]
+    fn extents_serialize_parse_roundtrip() {
+        let mut ext = Extents::new(10 * COPY_UP_BLOCK + 1);
+        for b in [0, 1, 2, 5, 10] {
+            ext.dirty[b] = true;
+        }
+        let text = ext.serialize();
+        assert_eq!(
+            text,
+            format!(
+                "TFS-EXTENTS 1\nS {} 65536\nD 0 3\nD 5 1\nD 10 1\n",
+                10 * COPY_UP_BLOCK + 1
+            )
+        );
+        assert_eq!(Extents::parse(&text).unwrap(), ext);
+        for bad in [
+            "TFS-EXTENTS 2\nS 1 65536\n",
+            "TFS-EXTENTS 1\n",
+            "TFS-EXTENTS 1\nS 1 65536\nD 0 2\n",
+            "TFS-EXTENTS 1\nS 1 65536\nD 0 0\n",
+            "TFS-EXTENTS 1\nS 1 65536\nX 0 1\n",
+            "TFS-EXTENTS 1\nS x 65536\n",
+        ] {
+            assert_eq!(Extents::parse(bad).unwrap_err(), libc::EINVAL, "{bad:?}");
+        }
+        // Runs: a clean byte reads from the base up to the next dirty block.
+        assert!(!ext.is_clean(0));
+        assert_eq!(ext.run_end(0), 3 * COPY_UP_BLOCK);
+        assert!(ext.is_clean(3 * COPY_UP_BLOCK));
+        assert_eq!(ext.run_end(3 * COPY_UP_BLOCK + 9), 5 * COPY_UP_BLOCK);
+        assert_eq!(ext.run_end(10 * COPY_UP_BLOCK), u64::MAX);
+    }
+
     // ---------------------------------------------------------------
     // The declared write gate (spec 24 §5)
     // ---------------------------------------------------------------
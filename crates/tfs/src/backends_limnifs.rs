@@ -26,6 +26,27 @@
 //! `LIM1` is a SECTION magic inside the image, never an offset-0 image
 //! magic — detection keys on `LMFS` only (spec 20 §3).
 //!
+//! ## Decompressed-drop cache
+//!
+//! A slab drop is one compression unit: serving any byte of it means
+//! decompressing all of it. Materialized drops are therefore kept in a
+//! byte-budgeted LRU shared by every reader of the mount (see
+//! `byte_lru`), so a sequential reader in 8 KiB steps decompresses each
+//! drop once instead of once per call. The budget is
+//! `TEBAKO_TFS_LIMNIFS_CACHE_MB` (default [`DROP_CACHE_DEFAULT_MIB`] MiB,
+//! `0` disables) or [`LimnifsBackend::with_drop_cache`]; hit rates are
+//! the backend's `cache_stats` and reach the debug log when it goes
+//! away. Under a process-wide cache
+//! budget ([`LimnifsBackend::in_pool`]) the drops are kept in that pool
+//! instead, charged against the one budget every mount shares.
+//!
+//! With a host-wide segment attached ([`LimnifsBackend::with_shared_blocks`],
+//! see `shared_blocks`) a drop is looked up there first — keyed by its
+//! content-addressed drop id — and a freshly decompressed drop is
+//! published there instead of the private cache, so every process on
+//! the host mounting the image decompresses it once. The private cache
+//! keeps only what the segment has no room for.
+//!
 //! ## Error mapping (spec 20 §4, errno-valued, named, never silent)
 //!
 //! `TooShort`/`BadMagic`/`Corrupt` → `EINVAL` at mount-open (not a
@@ -36,6 +57,8 @@
 //! misses → `ENOENT`.
 
 use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
 
 use limnifs_core::{
     parse_feature_flags_section, parse_history, parse_manifest_header, parse_metadata_blob,
@@ -44,11 +67,19 @@ use limnifs_core::{
 };
 
 use crate::backend::{Backend, EntryType, RawDirEntry, RawStat};
+use crate::backends_cache::{pool_owner, PoolEntry, PoolKey};
+use crate::byte_lru::{budget_from_env, ByteLru, LruStats};
+use crate::image_bytes::ImageBytes;
+use crate::shared_blocks::SharedBlocks;
 
 /// The slab section magic (`LIM1`) — a section marker inside the
 /// image, checked at the slab-region boundary (spec 20 §3).
 const SLAB_MAGIC: &[u8; 4] = b"LIM1";
 
+/// The drop cache budget (MiB) when `TEBAKO_TFS_LIMNIFS_CACHE_MB` is
+/// unset.
+pub const DROP_CACHE_DEFAULT_MIB: usize = 32;
+
 /// Nanoseconds per second, for the `mtime_ns` → `RawStat` seconds
 /// truncation (spec 20 §8).
 const NANOS_PER_SEC: u64 = 1_000_000_000;
@@ -56,8 +87,11 @@ const NANOS_PER_SEC: u64 = 1_000_000_000;
 /// A mounted LimniFS image.
 #[derive(Debug)]
 pub struct LimnifsBackend {
-    /// The whole image (manifest + appended slabs), owned.
-    image: Vec<u8>,
+    /// The whole image (manifest + appended slabs): mapped for file and
+    /// region mounts, owned for memory mounts. Drops are decompressed
+    /// straight out of it, so only the slab pages a read touches are
+    /// ever faulted in.
+    image: ImageBytes,
     /// Parsed manifest header (versions for the info surface).
     header: ManifestHeader,
     /// The parsed metadata blob (inodes + directory nodes).
@@ -76,6 +110,76 @@ pub struct LimnifsBackend {
     sections: Vec<(&'static str, usize)>,
     /// Per-slab drop counts (the info surface).
     slab_drop_counts: Vec<usize>,
+    /// Materialized drops, by drop id (module docs).
+    plain: DropCache,
+    /// The host-wide drop cache, when attached (module docs).
+    shared: Option<Arc<SharedBlocks>>,
+}
+
+/// Where materialized drops are kept (module docs).
+#[derive(Debug)]
+enum DropCache {
+    /// The mount's own LRU.
+    Own(ByteLru<[u8; 32]>),
+    /// A shared pool, keyed `(owner, PoolEntry::Drop(id))`.
+    Pool {
+        pool: Arc<ByteLru<PoolKey>>,
+        owner: u64,
+        /// This mount's lookups (the pool's own tallies span every
+        /// mount).
+        hits: AtomicU64,
+        misses: AtomicU64,
+    },
+}
+
+impl DropCache {
+    fn get(&self, drop_id: &[u8; 32]) -> Option<Arc<Vec<u8>>> {
+        match self {
+            DropCache::Own(lru) => lru.get(drop_id),
+            DropCache::Pool {
+                pool,
+                owner,
+                hits,
+                misses,
+            } => {
+                let plain = pool.get(&(*owner, PoolEntry::Drop(*drop_id)));
+                let counter = if plain.is_some() { hits } else { misses };
+                counter.fetch_add(1, Ordering::Relaxed);
+                plain
+            }
+        }
+    }
+
+    fn insert(&self, drop_id: &[u8; 32], plain: Arc<Vec<u8>>) {
+        match self {
+            DropCache::Own(lru) => lru.insert(*drop_id, plain),
+            DropCache::Pool { pool, owner, .. } => {
+                pool.insert((*owner, PoolEntry::Drop(*drop_id)), plain)
+            }
+        }
+    }
+
+    /// The cache tallies: hits and misses are this mount's; evictions,
+    /// entries and bytes the cache's (every mount's, in a pool).
+    fn stats(&self) -> LruStats {
+        match self {
+            DropCache::Own(lru) => lru.stats(),
+            DropCache::Pool {
+                pool, hits, misses, ..
+            } => LruStats {
+                hits: hits.load(Ordering::Relaxed),
+                misses: misses.load(Ordering::Relaxed),
+                ..pool.stats()
+            },
+        }
+    }
+
+    fn budget(&self) -> usize {
+        match self {
+            DropCache::Own(lru) => lru.budget(),
+            DropCache::Pool { pool, .. } => pool.budget(),
+        }
+    }
 }
 
 /// Mount-open mapping (spec 20 §4): `TooShort`/`BadMagic`/`Corrupt` →
@@ -126,10 +230,16 @@ fn normalize(path: &str) -> &str {
 
 impl LimnifsBackend {
     /// Open a self-contained limnifs image (module doc layout) held in
-    /// memory. Every mount source (whole file, file region, memory) is
-    /// read into one owned byte slice and funnels here — spec 11 §5's
-    /// four mount-source kinds all serve one `&[u8]` core.
+    /// memory (owned).
     pub fn from_image(data: Vec<u8>) -> Result<LimnifsBackend, i32> {
+        Self::from_bytes(ImageBytes::from(data))
+    }
+
+    /// Open a self-contained limnifs image over `data` — a file or region
+    /// mapping, or an owned buffer. Every mount source (whole file, file
+    /// region, memory) funnels here: spec 11 §5's four mount-source kinds
+    /// all serve one `&[u8]` core.
+    pub fn from_bytes(data: ImageBytes) -> Result<LimnifsBackend, i32> {
         let mut cursor = ManifestCursor::new(&data);
 
         let header = parse_manifest_header(&mut cursor).map_err(open_error)?;
@@ -280,9 +390,39 @@ impl LimnifsBackend {
             drops,
             sections,
             slab_drop_counts,
+            plain: DropCache::Own(ByteLru::new(budget_from_env(
+                "TEBAKO_TFS_LIMNIFS_CACHE_MB",
+                DROP_CACHE_DEFAULT_MIB,
+            ))),
+            shared: None,
         })
     }
 
+    /// Replace the decompressed-drop cache with one of `budget` bytes
+    /// (`0` disables it) — the per-mount override of the env budget.
+    pub fn with_drop_cache(mut self, budget: usize) -> LimnifsBackend {
+        self.plain = DropCache::Own(ByteLru::new(budget));
+        self
+    }
+
+    /// Keep materialized drops in `pool` (the process-wide window pool)
+    /// instead of a cache of the mount's own; unmounting frees them.
+    pub fn in_pool(mut self, pool: Arc<ByteLru<PoolKey>>) -> LimnifsBackend {
+        self.plain = DropCache::Pool {
+            pool,
+            owner: pool_owner(),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        };
+        self
+    }
+
+    /// Share materialized drops with every process attached to `shared`.
+    pub fn with_shared_blocks(mut self, shared: Arc<SharedBlocks>) -> LimnifsBackend {
+        self.shared = Some(shared);
+        self
+    }
+
     /// The inode for a Backend-convention path, `ENOENT` when missing.
     fn inode_for(&self, path: &str) -> Result<&Inode, i32> {
         let number = if path.is_empty() {
@@ -300,10 +440,36 @@ impl LimnifsBackend {
         })
     }
 
-    /// The materialized plaintext of one drop (on-demand, per-class
-    /// decompression — spec 20 §4; no slab access for inline drops ever
-    /// reaches here).
-    fn drop_plaintext(&self, drop_id: &[u8; 32]) -> Result<Vec<u8>, i32> {
+    /// Run `f` over the materialized plaintext of one drop: from the
+    /// shared segment or the drop cache, else decompressed on demand and
+    /// admitted — to the segment when it takes it (spec 20 §4; no slab
+    /// access for inline drops ever reaches here).
+    fn with_drop_plaintext<R>(
+        &self,
+        drop_id: &[u8; 32],
+        f: impl FnOnce(&[u8]) -> R,
+    ) -> Result<R, i32> {
+        if let Some(plain) = self.shared.as_ref().and_then(|s| s.get(drop_id)) {
+            return Ok(f(plain));
+        }
+        if let Some(plain) = self.plain.get(drop_id) {
+            return Ok(f(&plain));
+        }
+        let plain = self.decompress_drop(drop_id)?;
+        if self
+            .shared
+            .as_ref()
+            .is_some_and(|s| s.insert(drop_id, &plain))
+        {
+            return Ok(f(&plain));
+        }
+        let plain = Arc::new(plain);
+        self.plain.insert(drop_id, Arc::clone(&plain));
+        Ok(f(&plain))
+    }
+
+    /// Decompress one drop out of its slab window.
+    fn decompress_drop(&self, drop_id: &[u8; 32]) -> Result<Vec<u8>, i32> {
         let Some((slab, record)) = self.drops.get(drop_id) else {
             // A slice references a drop no slab carries: a broken
             // cross-reference, i.e. corruption while serving.
@@ -360,6 +526,29 @@ impl LimnifsBackend {
     }
 }
 
+impl Drop for LimnifsBackend {
+    fn drop(&mut self) {
+        let stats = self.plain.stats();
+        if stats.hits + stats.misses > 0 {
+            tebako_log::log!(
+                tebako_log::Level::Debug,
+                "tfs",
+                "limnifs drop cache: {} hits, {} misses ({:.1}% hit), {} evictions, {} drops / {} bytes held (budget {})",
+                stats.hits,
+                stats.misses,
+                stats.hit_percent(),
+                stats.evictions,
+                stats.entries,
+                stats.bytes,
+                self.plain.budget()
+            );
+        }
+        if let DropCache::Pool { pool, owner, .. } = &self.plain {
+            pool.remove_where(|key| key.0 == *owner);
+        }
+    }
+}
+
 impl Backend for LimnifsBackend {
     fn name(&self) -> &'static std::ffi::CStr {
         c"LimniFS"
@@ -429,16 +618,21 @@ impl Backend for LimnifsBackend {
                     if lo >= hi {
                         continue;
                     }
-                    let plain = self.drop_plaintext(slice.drop_id.as_bytes())?;
                     let ds =
                         (u64::from(slice.drop_byte_start) + (lo - slice.file_byte_start)) as usize;
                     let de =
                         (u64::from(slice.drop_byte_start) + (hi - slice.file_byte_start)) as usize;
-                    if de > plain.len() {
-                        return Err(libc::EIO);
-                    }
                     let at = (lo - win_start) as usize;
-                    buf[at..at + (hi - lo) as usize].copy_from_slice(&plain[ds..de]);
+                    let out = &mut buf[at..at + (hi - lo) as usize];
+                    self.with_drop_plaintext(slice.drop_id.as_bytes(), |plain| {
+                        match plain.get(ds..de) {
+                            Some(bytes) => {
+                                out.copy_from_slice(bytes);
+                                Ok(())
+                            }
+                            None => Err(libc::EIO),
+                        }
+                    })??;
                     done += (hi - lo) as usize;
                     pos = hi;
                 }
@@ -476,6 +670,11 @@ impl Backend for LimnifsBackend {
         }
     }
 
+    fn cache_stats(&self) -> Option<LruStats> {
+        // `TEBAKO_TFS_LIMNIFS_CACHE_MB=0`: no drop cache to report.
+        (self.plain.budget() > 0).then(|| self.plain.stats())
+    }
+
     fn image_info_json(&self) -> Option<String> {
         let mut json = format!(
             "{{\"format\":\"limnifs\",\"versions\":{{\"drop_store\":{},\"metadata\":{},\"manifest\":{}}},\"inode_count\":{},\"directory_count\":{},\"slab_count\":{},\"drop_count\":{},\"image_bytes\":{},\"sections\":[",
@@ -877,6 +1076,122 @@ mod tests {
         assert_eq!(&buf[..n], b"hello, limnifs\n");
     }
 
+    #[test]
+    fn sequential_small_reads_decompress_each_drop_once() {
+        let (_tmp, image) = fixture_tree();
+        let read_8k = |backend: &LimnifsBackend| {
+            let mut got = Vec::new();
+            let mut buf = [0u8; 8192];
+            loop {
+                let n = backend
+                    .pread("big.bin", &mut buf, got.len() as u64)
+                    .unwrap();
+                if n == 0 {
+                    return got;
+                }
+                got.extend_from_slice(&buf[..n]);
+            }
+        };
+
+        let cached = LimnifsBackend::from_image(image.clone())
+            .unwrap()
+            .with_drop_cache(1 << 20);
+        assert_eq!(read_8k(&cached), big_payload());
+        let stats = cached.plain.stats();
+        assert!(stats.misses as usize <= cached.drops.len(), "{stats:?}");
+        assert!(stats.hits > stats.misses, "{stats:?}");
+
+        let uncached = LimnifsBackend::from_image(image)
+            .unwrap()
+            .with_drop_cache(0);
+        assert_eq!(read_8k(&uncached), big_payload());
+        assert_eq!(uncached.plain.stats().entries, 0);
+    }
+
+    #[test]
+    fn drops_kept_in_a_shared_pool_are_freed_at_unmount() {
+        let (_tmp, image) = fixture_tree();
+        let pool = Arc::new(ByteLru::new(1 << 20));
+        let pooled = LimnifsBackend::from_image(image)
+            .unwrap()
+            .in_pool(Arc::clone(&pool));
+        let mut buf = vec![0u8; big_payload().len()];
+        let n = pooled.pread("big.bin", &mut buf, 0).unwrap();
+        assert_eq!(&buf[..n], big_payload());
+        let held = pool.stats();
+        assert!(held.entries > 0 && held.bytes <= 1 << 20, "{held:?}");
+        assert_eq!(pooled.pread("big.bin", &mut buf[..10], 0).unwrap(), 10);
+        assert!(pool.stats().hits > held.hits, "served from the pool");
+        let mine = pooled.cache_stats().unwrap();
+        assert_eq!(
+            (mine.hits, mine.misses),
+            (pool.stats().hits, pool.stats().misses)
+        );
+        drop(pooled);
+        assert_eq!(pool.stats().bytes, 0);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn drops_are_decompressed_once_across_attachments() {
+        let (_tmp, image) = fixture_tree();
+        let seg = tempfile::tempdir().unwrap();
+        let path = seg.path().join("img.blk");
+        let attach = || {
+            let shared = SharedBlocks::open(&path, 8 << 20).expect("segment");
+            LimnifsBackend::from_image(image.clone())
+                .unwrap()
+                .with_shared_blocks(Arc::new(shared))
+        };
+        let read_all = |backend: &LimnifsBackend| {
+            let mut buf = vec![0u8; big_payload().len()];
+            let n = backend.pread("big.bin", &mut buf, 0).unwrap();
+            buf.truncate(n);
+            buf
+        };
+
+        // The first process decompresses and publishes; the second only
+        // reads the segment, and neither keeps a private copy.
+        let first = attach();
+        assert_eq!(read_all(&first), big_payload());
+        let published = first.shared.as_ref().unwrap().stats().entries;
+        assert!(published > 0);
+        assert_eq!(first.plain.stats().entries, 0);
+
+        let second = attach();
+        assert_eq!(read_all(&second), big_payload());
+        let s = second.shared.as_ref().unwrap().stats();
+        assert_eq!((s.entries, s.misses), (0, 0), "{s:?}");
+        assert_eq!(s.hits as usize, published);
+        assert_eq!(second.plain.stats().entries, 0);
+    }
+
+    #[test]
+    fn region_mounts_serve_slab_drops_out_of_the_mapping() {
+        let (_tmp, image) = fixture_tree();
+        let tmp = tempfile::tempdir().unwrap();
+        let pkg_path = tmp.path().join("pkg.bin");
+        let mut packaged = vec![0x5Au8; 1000]; // deliberately not page-aligned
+        packaged.extend_from_slice(&image);
+        std::fs::write(&pkg_path, &packaged).unwrap();
+
+        let file = std::fs::File::open(&pkg_path).unwrap();
+        let bytes = ImageBytes::map_file(&file, 1000, image.len() as u64).unwrap();
+        drop(file); // the mapping outlives the fd
+        let backend = LimnifsBackend::from_bytes(bytes).expect("mapped open");
+        assert_eq!(backend.image.is_mapped(), cfg!(unix));
+
+        let want = big_payload();
+        let mut got = vec![0u8; want.len()];
+        let mut at = 0;
+        while at < got.len() {
+            let n = backend.pread("big.bin", &mut got[at..], at as u64).unwrap();
+            assert!(n > 0);
+            at += n;
+        }
+        assert_eq!(got, want);
+    }
+
     // ---------------------------------------------------------------
     // fixture encoders (mirroring limnifs-core's own test encoders)
     // ---------------------------------------------------------------
@@ -5,40 +5,82 @@
 //! → directory reader → root-inode probe), same read path (data reader with
 //! the fragment table loaded), same eager directory reads.
 //!
-//! libsquashfs keeps mutable state in its readers, so all calls are
-//! serialized through one Mutex (the C++ backend locks the same way). The
-//! memory mount owns the image Vec; the memory-backed `sqfs_file_t` borrows
-//! from it.
+//! ## Concurrency
+//!
+//! libsquashfs keeps mutable state in its readers and decompressors (the
+//! gzip one holds a `z_stream`), but the archive file itself is positioned
+//! reads only (`pread` for disk images, a memcpy for memory images). So
+//! the file and superblock are shared, and each call borrows a
+//! [`SqfsReader`] — its own decompressor, directory reader and data reader
+//! — from a small pool, creating one when all are busy. Parallel readers
+//! of a runtime image no longer queue behind one Mutex (the C++ backend's
+//! single lock); at most [`READER_POOL`] idle readers stay parked.
+//!
+//! Resolved inodes are cached by path (at most [`INODE_CACHE_MAX`]; the
+//! table starts over when full), so a hot file's repeated preads skip the
+//! directory walk and the inode re-read. The image is immutable: a cached
+//! inode never goes stale.
+//!
+//! The memory mount owns the image Vec; the memory-backed `sqfs_file_t`
+//! borrows from it.
 
+use std::collections::HashMap;
 use std::ffi::{CStr, CString};
-use std::sync::Mutex;
+use std::sync::{Arc, Mutex, MutexGuard};
 
 use sqfs_sys::*;
 
 use crate::backend::{Backend, EntryType, RawDirEntry, RawStat};
+use crate::image_bytes::ImageBytes;
+
+/// Idle readers kept parked for reuse.
+const READER_POOL: usize = 16;
+/// Resolved inodes kept per mount.
+const INODE_CACHE_MAX: usize = 4096;
 
 /// Mounted SquashFS image.
 pub struct SquashfsBackend {
-    /// Owned memory image (borrowed by the sqfs file; None for file mounts).
-    _image: Option<Vec<u8>>,
-    inner: Mutex<SqfsInner>,
+    /// Idle readers (dropped before the file they read from).
+    readers: Mutex<Vec<SqfsReader>>,
+    /// In-image path → resolved inode.
+    inodes: Mutex<HashMap<String, Arc<SqfsInode>>>,
+    archive: SqfsArchive,
+    /// Memory image — a region mapping or an owned buffer (borrowed by
+    /// the sqfs file; None for file mounts). Declared last: it outlives
+    /// everything reading it.
+    _image: Option<ImageBytes>,
 }
 
-struct SqfsInner {
+/// The shared, read-only part of a mount.
+struct SqfsArchive {
     file: *mut sqfs_file_t,
-    /// Kept alive for ownership: the directory reader and data reader
-    /// reference the superblock for their whole lifetime.
-    #[allow(dead_code)]
+    /// Referenced by every reader for its whole lifetime.
     super_: Box<sqfs_super_t>,
+}
+
+// The file is only used through its positioned `read_at`, which is
+// reentrant for both the disk (`pread`) and memory implementations; the
+// superblock is never written after mount.
+unsafe impl Send for SqfsArchive {}
+unsafe impl Sync for SqfsArchive {}
+
+impl Drop for SqfsArchive {
+    fn drop(&mut self) {
+        unsafe { sqfs_destroy(self.file.cast()) };
+    }
+}
+
+/// One thread's worth of libsquashfs reader state.
+struct SqfsReader {
     cmp: *mut sqfs_compressor_t,
     rd: *mut sqfs_dir_reader_t,
     data: *mut sqfs_data_reader_t,
 }
 
-// The raw pointers are only ever used through the backend's Mutex.
-unsafe impl Send for SqfsInner {}
+// A reader is used by one call at a time (taken out of the pool).
+unsafe impl Send for SqfsReader {}
 
-impl Drop for SqfsInner {
+impl Drop for SqfsReader {
     fn drop(&mut self) {
         unsafe {
             if !self.data.is_null() {
@@ -50,89 +92,118 @@ impl Drop for SqfsInner {
             if !self.cmp.is_null() {
                 sqfs_destroy(self.cmp.cast());
             }
-            if !self.file.is_null() {
-                sqfs_destroy(self.file.cast());
+        }
+    }
+}
+
+/// A resolved inode with its stat precomputed.
+struct SqfsInode {
+    ptr: *mut sqfs_inode_generic_t,
+    stat: RawStat,
+}
+
+// Inodes are read-only once resolved (the readers take them const).
+unsafe impl Send for SqfsInode {}
+unsafe impl Sync for SqfsInode {}
+
+impl Drop for SqfsInode {
+    fn drop(&mut self) {
+        unsafe { sqfs_free(self.ptr.cast()) };
+    }
+}
+
+impl SqfsInode {
+    /// Take ownership of a looked-up inode (freed on every path).
+    unsafe fn new(ptr: *mut sqfs_inode_generic_t) -> Result<SqfsInode, i32> {
+        unsafe {
+            let base = &*(ptr as *const sqfs_inode_t);
+            let entry_type = match base.r#type {
+                SQFS_INODE_DIR | SQFS_INODE_EXT_DIR => EntryType::Directory,
+                SQFS_INODE_FILE | SQFS_INODE_EXT_FILE => EntryType::File,
+                SQFS_INODE_SLINK | SQFS_INODE_EXT_SLINK => EntryType::Symlink,
+                _ => EntryType::Other,
+            };
+            let mut inode = SqfsInode {
+                ptr,
+                stat: RawStat {
+                    entry_type,
+                    perms: u32::from(base.mode),
+                    size: 0,
+                    mtime: i64::from(base.mod_time),
+                },
+            };
+            if entry_type == EntryType::File {
+                let mut size = 0u64;
+                if sqfs_inode_get_file_size(ptr, &mut size) != 0 {
+                    return Err(libc::EIO); // dropping `inode` frees it
+                }
+                inode.stat.size = size as i64;
             }
+            Ok(inode)
         }
     }
 }
 
-impl SqfsInner {
-    /// The C++ mount_common sequence. `file` is consumed on success
-    /// (owned by the returned inner) and destroyed on failure.
-    fn mount_common(file: *mut sqfs_file_t) -> Result<SqfsInner, i32> {
+impl SqfsArchive {
+    /// Read the superblock. `file` is consumed: owned by the returned
+    /// archive on success, destroyed on failure.
+    fn open(file: *mut sqfs_file_t) -> Result<SqfsArchive, i32> {
         unsafe {
-            // Read superblock.
             let mut super_ = Box::new(std::mem::zeroed::<sqfs_super_t>());
             if sqfs_super_read(super_.as_mut(), file) != 0 {
                 sqfs_destroy(file.cast());
                 return Err(libc::EIO); // CorruptedArchive
             }
+            Ok(SqfsArchive { file, super_ })
+        }
+    }
 
-            // Create the decompressor for the archive's compression id
-            // (SQFS_COMP_FLAG_UNCOMPRESS — reader only).
-            let mut cmp: *mut sqfs_compressor_t = std::ptr::null_mut();
-            if sqfs_shim_compressor_create(super_.compression_id, super_.block_size, &mut cmp) != 0
-                || cmp.is_null()
+    /// A fresh reader: decompressor, directory reader, and a data reader
+    /// with the fragment table loaded (required for fragment-packed small
+    /// files). Partial state is released by the reader's Drop.
+    fn reader(&self) -> Result<SqfsReader, i32> {
+        let mut reader = SqfsReader {
+            cmp: std::ptr::null_mut(),
+            rd: std::ptr::null_mut(),
+            data: std::ptr::null_mut(),
+        };
+        unsafe {
+            // SQFS_COMP_FLAG_UNCOMPRESS — reader only.
+            let super_ = self.super_.as_ref();
+            if sqfs_shim_compressor_create(
+                super_.compression_id,
+                super_.block_size,
+                &mut reader.cmp,
+            ) != 0
+                || reader.cmp.is_null()
             {
-                sqfs_destroy(file.cast());
                 return Err(libc::ENOTSUP);
             }
-
-            // Create the directory reader.
-            let rd = sqfs_dir_reader_create(super_.as_ref(), cmp, file, 0);
-            if rd.is_null() {
-                sqfs_destroy(cmp.cast());
-                sqfs_destroy(file.cast());
+            reader.rd = sqfs_dir_reader_create(super_, reader.cmp, self.file, 0);
+            if reader.rd.is_null() {
                 return Err(libc::ENOMEM);
             }
-
-            // Prove the archive metadata is readable by resolving the root
-            // inode (catches corruption past the superblock).
-            let mut root: *mut sqfs_inode_generic_t = std::ptr::null_mut();
-            if sqfs_dir_reader_get_root_inode(rd, &mut root) != 0 {
-                sqfs_destroy(rd.cast());
-                sqfs_destroy(cmp.cast());
-                sqfs_destroy(file.cast());
-                return Err(libc::EIO);
-            }
-            sqfs_free(root.cast());
-
-            // One shared data reader with the fragment table loaded (the
-            // table is required for fragment-packed small files).
-            let data = sqfs_data_reader_create(file, super_.block_size as usize, cmp, 0);
-            if data.is_null() {
-                sqfs_destroy(rd.cast());
-                sqfs_destroy(cmp.cast());
-                sqfs_destroy(file.cast());
+            reader.data =
+                sqfs_data_reader_create(self.file, super_.block_size as usize, reader.cmp, 0);
+            if reader.data.is_null() {
                 return Err(libc::ENOMEM);
             }
-            if sqfs_data_reader_load_fragment_table(data, super_.as_ref()) != 0 {
-                sqfs_destroy(data.cast());
-                sqfs_destroy(rd.cast());
-                sqfs_destroy(cmp.cast());
-                sqfs_destroy(file.cast());
+            if sqfs_data_reader_load_fragment_table(reader.data, super_) != 0 {
                 return Err(libc::EIO);
             }
-
-            Ok(SqfsInner {
-                file,
-                super_,
-                cmp,
-                rd,
-                data,
-            })
         }
+        Ok(reader)
     }
+}
 
-    /// Resolve an inode by in-image path ("" = root). The caller owns the
-    /// result (free with sqfs_free).
-    fn lookup_inode(&self, path: &str) -> Result<*mut sqfs_inode_generic_t, i32> {
+impl SqfsReader {
+    /// Resolve an inode by in-image path ("" = root).
+    fn lookup_inode(&self, path: &str) -> Result<SqfsInode, i32> {
         unsafe {
             let mut inode: *mut sqfs_inode_generic_t = std::ptr::null_mut();
             if path.is_empty() {
                 if sqfs_dir_reader_get_root_inode(self.rd, &mut inode) == 0 {
-                    return Ok(inode);
+                    return SqfsInode::new(inode);
                 }
             } else {
                 let cpath = CString::new(path).map_err(|_| libc::EINVAL)?;
@@ -143,38 +214,12 @@ impl SqfsInner {
                     &mut inode,
                 ) == 0
                 {
-                    return Ok(inode);
+                    return SqfsInode::new(inode);
                 }
             }
             Err(libc::ENOENT)
         }
     }
-
-    /// stat for a looked-up inode (consumes the inode).
-    unsafe fn stat_inode(inode: *mut sqfs_inode_generic_t) -> Result<RawStat, i32> {
-        unsafe {
-            let base = &*(inode as *const sqfs_inode_t);
-            let entry_type = match base.r#type {
-                SQFS_INODE_DIR | SQFS_INODE_EXT_DIR => EntryType::Directory,
-                SQFS_INODE_FILE | SQFS_INODE_EXT_FILE => EntryType::File,
-                SQFS_INODE_SLINK | SQFS_INODE_EXT_SLINK => EntryType::Symlink,
-                _ => EntryType::Other,
-            };
-            let mut size = 0u64;
-            if entry_type == EntryType::File && sqfs_inode_get_file_size(inode, &mut size) != 0 {
-                sqfs_free(inode.cast());
-                return Err(libc::EIO);
-            }
-            let st = RawStat {
-                entry_type,
-                perms: u32::from(base.mode),
-                size: size as i64,
-                mtime: i64::from(base.mod_time),
-            };
-            sqfs_free(inode.cast());
-            Ok(st)
-        }
-    }
 }
 
 /// Normalize an in-image path: no leading or trailing `/`, `""` for root.
@@ -190,16 +235,20 @@ impl SquashfsBackend {
         if file.is_null() {
             return Err(libc::ENOENT);
         }
-        let inner = SqfsInner::mount_common(file)?;
-        Ok(SquashfsBackend {
-            _image: None,
-            inner: Mutex::new(inner),
-        })
+        Self::mount_common(file, None)
     }
 
     /// Open a SquashFS image from memory (the image is OWNED here; the
     /// memory-backed sqfs file borrows from it).
     pub fn from_memory(data: Vec<u8>) -> Result<SquashfsBackend, i32> {
+        Self::from_bytes(ImageBytes::from(data))
+    }
+
+    /// Open a SquashFS image over `data` — a file-region mapping (a
+    /// payload slot, served in place) or an owned buffer. The bytes never
+    /// move: a mapping is fixed and a Vec's heap block stays put when the
+    /// Vec itself is moved into the backend.
+    pub fn from_bytes(data: ImageBytes) -> Result<SquashfsBackend, i32> {
         if data.is_empty() {
             return Err(libc::EINVAL);
         }
@@ -207,12 +256,65 @@ impl SquashfsBackend {
         if file.is_null() {
             return Err(libc::ENOMEM);
         }
-        let inner = SqfsInner::mount_common(file)?;
+        Self::mount_common(file, Some(data))
+    }
+
+    /// The C++ mount_common sequence: superblock, then a first reader,
+    /// which proves the metadata readable by resolving the root inode
+    /// (catches corruption past the superblock) and is parked for reuse.
+    fn mount_common(
+        file: *mut sqfs_file_t,
+        image: Option<ImageBytes>,
+    ) -> Result<SquashfsBackend, i32> {
+        let archive = SqfsArchive::open(file)?;
+        let reader = archive.reader()?;
+        let root = reader.lookup_inode("").map_err(|_| libc::EIO)?;
         Ok(SquashfsBackend {
-            _image: Some(data),
-            inner: Mutex::new(inner),
+            readers: Mutex::new(vec![reader]),
+            inodes: Mutex::new(HashMap::from([(String::new(), Arc::new(root))])),
+            archive,
+            _image: image,
         })
     }
+
+    fn readers(&self) -> MutexGuard<'_, Vec<SqfsReader>> {
+        self.readers.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn inodes(&self) -> MutexGuard<'_, HashMap<String, Arc<SqfsInode>>> {
+        self.inodes.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// Run `f` on a reader of its own: a parked one, or a fresh one when
+    /// every reader is busy. The pool lock is never held across `f`.
+    fn with_reader<T>(&self, f: impl FnOnce(&SqfsReader) -> Result<T, i32>) -> Result<T, i32> {
+        let parked = self.readers().pop();
+        let reader = match parked {
+            Some(reader) => reader,
+            None => self.archive.reader()?,
+        };
+        let result = f(&reader);
+        let mut pool = self.readers();
+        if pool.len() < READER_POOL {
+            pool.push(reader);
+        }
+        result
+    }
+
+    /// The inode at `path` (normalized), from the cache or the directory
+    /// tables.
+    fn inode(&self, path: &str) -> Result<Arc<SqfsInode>, i32> {
+        if let Some(inode) = self.inodes().get(path) {
+            return Ok(Arc::clone(inode));
+        }
+        let inode = Arc::new(self.with_reader(|r| r.lookup_inode(path))?);
+        let mut cache = self.inodes();
+        if cache.len() >= INODE_CACHE_MAX {
+            cache.clear();
+        }
+        cache.insert(path.to_string(), Arc::clone(&inode));
+        Ok(inode)
+    }
 }
 
 impl Backend for SquashfsBackend {
@@ -221,63 +323,49 @@ impl Backend for SquashfsBackend {
     }
 
     fn stat(&self, path: &str) -> Result<RawStat, i32> {
-        let path = normalize(path);
-        let inner = self.inner.lock().map_err(|_| libc::EIO)?;
-        let inode = inner.lookup_inode(path)?;
-        unsafe { SqfsInner::stat_inode(inode) }
+        Ok(self.inode(normalize(path))?.stat)
     }
 
     fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
-        let path = normalize(path);
-        let inner = self.inner.lock().map_err(|_| libc::EIO)?;
-        let inode = inner.lookup_inode(path)?;
-        unsafe {
-            let base = &*(inode as *const sqfs_inode_t);
-            if base.r#type == SQFS_INODE_DIR || base.r#type == SQFS_INODE_EXT_DIR {
-                sqfs_free(inode.cast());
-                return Err(libc::EISDIR);
-            }
-            if base.r#type != SQFS_INODE_FILE && base.r#type != SQFS_INODE_EXT_FILE {
-                sqfs_free(inode.cast());
-                return Err(libc::EINVAL);
-            }
-            let mut size = 0u64;
-            if sqfs_inode_get_file_size(inode, &mut size) != 0 {
-                sqfs_free(inode.cast());
-                return Err(libc::EIO);
-            }
-            if offset >= size || buf.is_empty() {
-                sqfs_free(inode.cast());
-                return Ok(0);
-            }
-            let want = std::cmp::min(buf.len() as u64, size - offset) as sqfs_u32;
-            let n = sqfs_data_reader_read(inner.data, inode, offset, buf.as_mut_ptr().cast(), want);
-            sqfs_free(inode.cast());
-            if n < 0 {
-                return Err(libc::EIO);
-            }
-            Ok(n as usize)
+        let inode = self.inode(normalize(path))?;
+        match inode.stat.entry_type {
+            EntryType::Directory => return Err(libc::EISDIR),
+            EntryType::File => {}
+            _ => return Err(libc::EINVAL),
+        }
+        let size = inode.stat.size as u64;
+        if offset >= size || buf.is_empty() {
+            return Ok(0);
+        }
+        let want = std::cmp::min(buf.len() as u64, size - offset) as sqfs_u32;
+        let n = self.with_reader(|r| unsafe {
+            Ok(sqfs_data_reader_read(
+                r.data,
+                inode.ptr,
+                offset,
+                buf.as_mut_ptr().cast(),
+                want,
+            ))
+        })?;
+        if n < 0 {
+            return Err(libc::EIO);
         }
+        Ok(n as usize)
     }
 
     fn read_dir(&self, path: &str) -> Result<Vec<RawDirEntry>, i32> {
-        let path = normalize(path);
-        let inner = self.inner.lock().map_err(|_| libc::EIO)?;
-        let inode = inner.lookup_inode(path)?;
-        unsafe {
-            let base = &*(inode as *const sqfs_inode_t);
-            if base.r#type != SQFS_INODE_DIR && base.r#type != SQFS_INODE_EXT_DIR {
-                sqfs_free(inode.cast());
-                return Err(libc::ENOTDIR);
-            }
-            if sqfs_dir_reader_open_dir(inner.rd, inode, 0) != 0 {
-                sqfs_free(inode.cast());
+        let inode = self.inode(normalize(path))?;
+        if inode.stat.entry_type != EntryType::Directory {
+            return Err(libc::ENOTDIR);
+        }
+        self.with_reader(|r| unsafe {
+            if sqfs_dir_reader_open_dir(r.rd, inode.ptr, 0) != 0 {
                 return Err(libc::EIO);
             }
             let mut out = Vec::new();
             loop {
                 let mut entry: *mut sqfs_dir_entry_t = std::ptr::null_mut();
-                if sqfs_dir_reader_read(inner.rd, &mut entry) != 0 {
+                if sqfs_dir_reader_read(r.rd, &mut entry) != 0 {
                     break;
                 }
                 let e = &*entry;
@@ -288,8 +376,7 @@ impl Backend for SquashfsBackend {
                 out.push(RawDirEntry { name, is_dir });
                 sqfs_free(entry.cast());
             }
-            sqfs_free(inode.cast());
             Ok(out)
-        }
+        })
     }
 }
@@ -16,6 +16,14 @@
 //! - permissions come from the header (0 when absent → 0644/0755 defaults);
 //!   mtime from the header
 //!
+//! ## Persisted index
+//!
+//! The index pass is the whole mount cost — for tar.gz a full inflate.
+//! Mounts from a file path (`mount::build_from_file*`) save the built
+//! index (entries, stream length, gzip checkpoints) to a stamped sidecar
+//! in the exec cache and load it on the next mount of the same bytes,
+//! skipping the pass entirely (see `index_sidecar`).
+//!
 //! ## Memory profile (the 1 GiB / < 64 MiB RSS budget)
 //!
 //! - **Index**: O(entry count), not archive size — one `TarEntry`
@@ -25,16 +33,28 @@
 //!   entry data is skipped with `seek`, not read.
 //! - **Plain tar**: zero extra state; reads are positioned reads
 //!   (`pread`-style) on the file — RSS does not grow with archive size.
-//! - **tar.gz**: deflate has no random access, so the mount pass snapshots
-//!   the (pure-Rust, cloneable) miniz_oxide `InflateState` every
-//!   [`GZ_CHECKPOINT_SPACING`] uncompressed bytes — the zran pattern.
-//!   Checkpoints cost ~34 KiB each ≈ 0.2 % of the uncompressed size
-//!   (1 GiB → 64 checkpoints ≈ 2.2 MiB, capped at [`GZ_MAX_CHECKPOINTS`]).
+//! - **tar.gz**: deflate has no random access, so the mount pass places a
+//!   checkpoint at the first deflate block boundary after every
+//!   [`GZ_CHECKPOINT_SPACING`] uncompressed bytes — the zran pattern: at a
+//!   boundary the inflater state is the unread bits of one byte plus the
+//!   32 KiB window. Checkpoints cost ~32 KiB each ≈ 0.2 % of the
+//!   uncompressed size (1 GiB → 64 checkpoints ≈ 2 MiB, capped at
+//!   [`GZ_MAX_CHECKPOINTS`]).
 //!   A cold read resumes at the nearest checkpoint and decodes at most one
 //!   spacing; a shared cursor keeps sequential access (extraction) O(n).
-//!   gzip headers are parsed by hand (single-member; trailing members of a
-//!   multi-member stream are ignored); the gzip CRC32 is not verified —
-//!   integrity is anchored in the tar header checksums during the scan.
+//!   gzip headers are parsed by hand; multi-member streams (`cat a.gz
+//!   b.gz`, pigz) are followed member to member, and checkpoints may sit
+//!   in any member. The gzip CRC32 is not verified — integrity is
+//!   anchored in the tar header checksums during the scan.
+//! - **BGZF tar.gz** (every member carries its size in a `BC` extra
+//!   subfield — see `bgzf`; `tfs mkimage --format tar.gz` and bgzip write
+//!   it): the member headers are the random-access index, so no
+//!   checkpoints are built or persisted. Members (≤ 64 KiB compressed)
+//!   decode independently and CRC-checked on `TEBAKO_TFS_GZ_THREADS`
+//!   workers (default: the available cores) — the mount scan decodes
+//!   batches of [`BGZF_SCAN_BATCH`] members per worker in parallel, and a
+//!   sequential read (extraction) decodes one member per worker ahead.
+//!   Decoded members live in a [`BGZF_MEMBER_CACHE`]-byte LRU.
 //! - **tar.zst**: ruzstd exposes no decoder-state snapshots, so random
 //!   access is a shared forward-only cursor: reads at or ahead of the
 //!   cursor decode forward (O(n) total for sequential patterns), a cold
@@ -42,28 +62,54 @@
 //!   the frame's declared window (typically ≤ 8 MiB) plus 64 KiB I/O
 //!   buffers. Plain single-frame `.tar.zst` is fundamentally sequential —
 //!   prefer plain tar or tar.gz for random-access workloads.
+//! - **seekable tar.zst** (a zstd seek table at the stream end — see
+//!   `zstd_seekable`; `tfs mkimage --format tar.zst` writes one): every
+//!   frame decodes on its own, so a cold read at any offset decodes only
+//!   the frame(s) it touches. Decoded frames are kept in a shared
+//!   [`ZST_FRAME_CACHE`]-byte LRU (≈ 8 frames at the writer's 1 MiB
+//!   frame size), so sequential and hot-file reads decode each frame
+//!   once. The index pass walks the frames in order; no cursor state is
+//!   kept after mount.
 
 use std::collections::BTreeMap;
+use std::collections::VecDeque;
 use std::ffi::CStr;
 use std::fs::File;
 use std::io::{self, BufReader, Cursor, Read, Seek, SeekFrom, Take};
+use std::ops::Range;
+use std::path::Path;
 use std::sync::{Arc, Mutex};
 
-use miniz_oxide::inflate::stream::{inflate, InflateState};
-use miniz_oxide::{DataFormat, MZFlush, MZStatus};
+use miniz_oxide::inflate::core::{
+    decompress, inflate_flags, BlockBoundaryState, DecompressorOxide,
+};
+use miniz_oxide::inflate::TINFLStatus;
 use ruzstd::StreamingDecoder;
 
 use crate::backend::{Backend, EntryType, RawDirEntry, RawStat};
+use crate::bgzf;
+use crate::byte_lru::ByteLru;
+use crate::image_bytes::ImageBytes;
+use crate::index_sidecar::{self, Decoder, Encoder};
+use crate::zstd_seekable::{frame_at, parse_seek_table, SeekFrame};
 
 /// Default I/O chunk for decompression pumps and buffered readers.
 const IO_CHUNK: usize = 64 * 1024;
 /// Uncompressed bytes between two gzip checkpoints (see module docs).
 const GZ_CHECKPOINT_SPACING: u64 = 16 * 1024 * 1024;
+/// The deflate back-reference window (and the inflater's output ring).
+const GZ_WINDOW: usize = 32 * 1024;
 /// Hard cap on the gzip checkpoint count (degenerate images stay mountable;
 /// reads just fall back to longer resumes).
 const GZ_MAX_CHECKPOINTS: usize = 4096;
 /// Cap for NUL-terminated gzip header fields (FNAME/FCOMMENT).
 const GZ_HEADER_FIELD_MAX: u64 = 1024 * 1024;
+/// Decoded-frame budget of a seekable tar.zst mount (see module docs).
+const ZST_FRAME_CACHE: usize = 8 * 1024 * 1024;
+/// Decoded-member budget of a BGZF tar.gz mount (≈ 128 bgzip members).
+const BGZF_MEMBER_CACHE: usize = 8 * 1024 * 1024;
+/// Members per worker per batch of the BGZF mount scan (≈ 1 MiB each).
+const BGZF_SCAN_BATCH: usize = 16;
 
 /// Compression envelope around the tar stream.
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -82,7 +128,7 @@ pub enum TarCompression {
 
 /// Owned, `Send + Sync` positioned reader over a memory image.
 struct SliceReader {
-    data: Arc<Vec<u8>>,
+    data: Arc<ImageBytes>,
     pos: usize,
 }
 
@@ -143,7 +189,7 @@ impl FileSource {
 /// The compressed/plain byte source behind a [`TarStream`].
 enum Source {
     File(FileSource),
-    Memory(Arc<Vec<u8>>),
+    Memory(Arc<ImageBytes>),
 }
 
 impl Source {
@@ -198,76 +244,205 @@ impl Source {
 // gzip: header parse, checkpointed cursor, positioned reads
 // ===================================================================
 
-/// A resumable point in the deflate stream: all input consumed, all output
-/// produced (captured at input-buffer boundaries only, so `c_offset` is
-/// exact and `state` is self-consistent).
+/// A resumable point in the deflate stream: a deflate block boundary,
+/// where the inflater's whole state is the unread bits of the last
+/// consumed byte plus the back-reference window — small, plain data
+/// (the zran pattern), so checkpoints persist in the index sidecar.
 struct GzCheckpoint {
     /// Uncompressed offset.
     u_offset: u64,
-    /// Absolute source offset of the next compressed byte.
+    /// Absolute source offset of the next unread compressed byte.
     c_offset: u64,
-    /// Inflater state at (c_offset, u_offset).
-    state: Box<InflateState>,
+    /// Bits of the byte before `c_offset` not yet consumed (0..=7) …
+    num_bits: u8,
+    /// … and their values, in the low bits.
+    bit_buf: u8,
+    /// The last ≤ [`GZ_WINDOW`] uncompressed bytes before `u_offset`.
+    window: Box<[u8]>,
+}
+
+impl GzCheckpoint {
+    /// The stream start (`c0`: the deflate data after the gzip header).
+    fn start(c0: u64) -> GzCheckpoint {
+        GzCheckpoint {
+            u_offset: 0,
+            c_offset: c0,
+            num_bits: 0,
+            bit_buf: 0,
+            window: Box::default(),
+        }
+    }
 }
 
 /// The live decompression cursor (one per reader; shared across preads
 /// under a mutex so sequential scans never re-decode).
 struct GzCursor {
-    state: Box<InflateState>,
+    decomp: Box<DecompressorOxide>,
+    /// The inflater's wrapping output buffer (doubles as the window).
+    dict: Box<[u8]>,
+    /// Where the next decoded byte lands in `dict`.
+    dict_pos: usize,
+    /// Decoded bytes not yet handed out: `dict[avail_at..avail_at + avail]`.
+    avail_at: usize,
+    avail: usize,
     reader: BufReader<Box<dyn Read + Send>>,
     in_buf: Vec<u8>,
     in_pos: usize,
     in_len: usize,
     /// Compressed source exhausted without a StreamEnd (truncated image).
     src_eof: bool,
-    /// Deflate StreamEnd reached.
+    /// Deflate StreamEnd of the last member reached.
     stream_eof: bool,
-    /// Uncompressed bytes produced so far.
+    /// Uncompressed bytes handed out so far.
     u_pos: u64,
+    /// Source offset of the next compressed byte not yet consumed.
+    c_pos: u64,
 }
 
 impl GzCursor {
-    fn new(
-        source: &Source,
-        c_offset: u64,
-        state: Box<InflateState>,
-        u_pos: u64,
-        io_chunk: usize,
-    ) -> Result<GzCursor, i32> {
+    /// A cursor resuming at `cp`.
+    fn new(source: &Source, cp: &GzCheckpoint, io_chunk: usize) -> Result<GzCursor, i32> {
+        let boundary = BlockBoundaryState {
+            num_bits: cp.num_bits,
+            bit_buf: cp.bit_buf,
+            ..BlockBoundaryState::default()
+        };
+        let mut dict = vec![0u8; GZ_WINDOW].into_boxed_slice();
+        dict[..cp.window.len()].copy_from_slice(&cp.window);
         Ok(GzCursor {
-            state,
-            reader: source.reader_at(c_offset)?,
+            decomp: Box::new(DecompressorOxide::from_block_boundary_state(&boundary)),
+            dict,
+            dict_pos: cp.window.len() % GZ_WINDOW,
+            avail_at: 0,
+            avail: 0,
+            reader: source.reader_at(cp.c_offset)?,
             in_buf: vec![0u8; io_chunk.max(512)],
             in_pos: 0,
             in_len: 0,
             src_eof: false,
             stream_eof: false,
-            u_pos,
+            u_pos: cp.u_offset,
+            c_pos: cp.c_offset,
         })
     }
+
+    /// The next unconsumed compressed byte (`None` at the source end).
+    fn next_byte(&mut self) -> Result<Option<u8>, i32> {
+        if self.in_pos == self.in_len {
+            if self.src_eof {
+                return Ok(None);
+            }
+            self.in_len = self.reader.read(&mut self.in_buf).map_err(|_| libc::EIO)?;
+            self.in_pos = 0;
+            if self.in_len == 0 {
+                self.src_eof = true;
+                return Ok(None);
+            }
+        }
+        let b = self.in_buf[self.in_pos];
+        self.in_pos += 1;
+        self.c_pos += 1;
+        Ok(Some(b))
+    }
+
+    /// Consume `n` header bytes (EIO when the source ends first).
+    fn skip_bytes(&mut self, n: u64) -> Result<(), i32> {
+        for _ in 0..n {
+            self.next_byte()?.ok_or(libc::EIO)?;
+        }
+        Ok(())
+    }
+
+    /// At a member's deflate end: step over its trailer and the next
+    /// member's header (gzip streams may concatenate members — `cat
+    /// a.gz b.gz`, pigz, bgzip) and restart the inflater there. `false`
+    /// when the stream ends instead: the source is exhausted, or what
+    /// follows is not a gzip member (trailing padding, which gzip(1)
+    /// ignores too). The trailer is skipped, not verified (module docs).
+    fn next_member(&mut self) -> Result<bool, i32> {
+        for _ in 0..8 {
+            if self.next_byte()?.is_none() {
+                return Ok(false);
+            }
+        }
+        let mut hdr = [0u8; 10];
+        for (i, slot) in hdr.iter_mut().enumerate() {
+            match self.next_byte()? {
+                Some(b) => *slot = b,
+                None if i == 0 => return Ok(false),
+                None => return Err(libc::EIO),
+            }
+            if i < 3 && *slot != [0x1f, 0x8b, 8][i] {
+                return Ok(false);
+            }
+        }
+        if hdr[3] & 0x04 != 0 {
+            let lo = self.next_byte()?.ok_or(libc::EIO)?;
+            let hi = self.next_byte()?.ok_or(libc::EIO)?;
+            self.skip_bytes(u64::from(u16::from_le_bytes([lo, hi])))?;
+        }
+        for flag in [0x08u8, 0x10u8] {
+            if hdr[3] & flag != 0 {
+                let mut scanned = 0u64;
+                while self.next_byte()?.ok_or(libc::EIO)? != 0 {
+                    scanned += 1;
+                    if scanned >= GZ_HEADER_FIELD_MAX {
+                        return Err(libc::EIO);
+                    }
+                }
+            }
+        }
+        if hdr[3] & 0x02 != 0 {
+            self.skip_bytes(2)?; // FHCRC
+        }
+        *self.decomp = DecompressorOxide::new();
+        Ok(true)
+    }
+
+    /// The last `min(decoded, GZ_WINDOW)` decoded bytes, oldest first.
+    fn window(&self) -> Box<[u8]> {
+        let decoded = self.u_pos + self.avail as u64;
+        let len = decoded.min(GZ_WINDOW as u64) as usize;
+        let from = (self.dict_pos + GZ_WINDOW - len) % GZ_WINDOW;
+        let mut window = Vec::with_capacity(len);
+        if from + len <= GZ_WINDOW {
+            window.extend_from_slice(&self.dict[from..from + len]);
+        } else {
+            window.extend_from_slice(&self.dict[from..]);
+            window.extend_from_slice(&self.dict[..from + len - GZ_WINDOW]);
+        }
+        window.into_boxed_slice()
+    }
 }
 
 /// Checkpoint capture during the mount scan.
 struct GzCapture {
-    /// Source offset where the deflate stream starts (after the gzip header).
-    c0: u64,
-    /// Compressed bytes fed to inflate so far (exact at capture points).
-    c_fed: u64,
     spacing: u64,
     last_cp_u: u64,
     cps: Vec<GzCheckpoint>,
 }
 
 impl GzCapture {
-    fn maybe_capture(&mut self, cur: &GzCursor) {
-        if cur.u_pos - self.last_cp_u >= self.spacing && self.cps.len() < GZ_MAX_CHECKPOINTS {
-            self.cps.push(GzCheckpoint {
-                u_offset: cur.u_pos,
-                c_offset: self.c0 + self.c_fed,
-                state: cur.state.clone(),
-            });
-            self.last_cp_u = cur.u_pos;
-        }
+    /// True once a spacing has elapsed: the pump then stops at the next
+    /// block boundary to capture.
+    fn due(&self, cur: &GzCursor) -> bool {
+        let decoded = cur.u_pos + cur.avail as u64;
+        decoded - self.last_cp_u >= self.spacing && self.cps.len() < GZ_MAX_CHECKPOINTS
+    }
+
+    fn capture(&mut self, cur: &GzCursor) {
+        let Some(boundary) = cur.decomp.block_boundary_state() else {
+            return;
+        };
+        let u_offset = cur.u_pos + cur.avail as u64;
+        self.cps.push(GzCheckpoint {
+            u_offset,
+            c_offset: cur.c_pos,
+            num_bits: boundary.num_bits,
+            bit_buf: boundary.bit_buf,
+            window: cur.window(),
+        });
+        self.last_cp_u = u_offset;
     }
 }
 
@@ -280,40 +455,61 @@ fn gz_pump(
     mut cap: Option<&mut GzCapture>,
 ) -> Result<usize, i32> {
     let mut written = 0usize;
-    while !out.is_empty() && !cur.stream_eof {
+    while !out.is_empty() {
+        if cur.avail > 0 {
+            let n = cur.avail.min(out.len());
+            out[..n].copy_from_slice(&cur.dict[cur.avail_at..cur.avail_at + n]);
+            cur.avail_at += n;
+            cur.avail -= n;
+            cur.u_pos += n as u64;
+            written += n;
+            out = &mut out[n..];
+            continue;
+        }
+        if cur.stream_eof {
+            break;
+        }
         if cur.in_pos == cur.in_len {
             if cur.src_eof {
                 return Err(libc::EIO); // truncated: source ended mid-stream
             }
-            // Consistent boundary: every fed byte was consumed by inflate.
-            if let Some(c) = cap.as_mut() {
-                c.maybe_capture(cur);
-            }
             cur.in_len = cur.reader.read(&mut cur.in_buf).map_err(|_| libc::EIO)?;
             cur.in_pos = 0;
             if cur.in_len == 0 {
                 cur.src_eof = true;
-                continue;
             }
+            continue;
         }
-        let res = inflate(
-            &mut cur.state,
+        let mut flags =
+            inflate_flags::TINFL_FLAG_HAS_MORE_INPUT | inflate_flags::TINFL_FLAG_IGNORE_ADLER32;
+        if cap.as_ref().is_some_and(|c| c.due(cur)) {
+            flags |= inflate_flags::TINFL_FLAG_STOP_ON_BLOCK_BOUNDARY;
+        }
+        let (status, consumed, produced) = decompress(
+            &mut cur.decomp,
             &cur.in_buf[cur.in_pos..cur.in_len],
-            out,
-            MZFlush::None,
+            &mut cur.dict,
+            cur.dict_pos,
+            flags,
         );
-        cur.in_pos += res.bytes_consumed;
-        if let Some(c) = cap.as_mut() {
-            c.c_fed += res.bytes_consumed as u64;
-        }
-        let status = res.status.map_err(|_| libc::EIO)?;
-        cur.u_pos += res.bytes_written as u64;
-        written += res.bytes_written;
-        out = &mut out[res.bytes_written..];
-        if status == MZStatus::StreamEnd {
-            cur.stream_eof = true;
-        } else if res.bytes_consumed == 0 && res.bytes_written == 0 && cur.in_pos != cur.in_len {
-            return Err(libc::EIO); // stalled with input left: corrupt stream
+        cur.in_pos += consumed;
+        cur.c_pos += consumed as u64;
+        cur.avail_at = cur.dict_pos;
+        cur.avail = produced;
+        cur.dict_pos = (cur.dict_pos + produced) % GZ_WINDOW;
+        match status {
+            TINFLStatus::Done => cur.stream_eof = !cur.next_member()?,
+            TINFLStatus::BlockBoundary => {
+                if let Some(c) = cap.as_mut() {
+                    c.capture(cur);
+                }
+            }
+            TINFLStatus::NeedsMoreInput | TINFLStatus::HasMoreOutput => {
+                if consumed == 0 && produced == 0 && cur.in_pos != cur.in_len {
+                    return Err(libc::EIO); // stalled with input left: corrupt stream
+                }
+            }
+            _ => return Err(libc::EIO),
         }
     }
     Ok(written)
@@ -331,8 +527,8 @@ impl Read for GzScan {
     }
 }
 
-/// Parse the gzip member header; returns the deflate stream's source
-/// offset. EINVAL when the magic/method is not gzip-deflate.
+/// Parse the first gzip member header; returns the deflate stream's
+/// source offset. EINVAL when the magic/method is not gzip-deflate.
 fn parse_gzip_header(source: &Source) -> Result<u64, i32> {
     let mut hdr = [0u8; 10];
     source
@@ -404,14 +600,7 @@ fn gz_read_at(gz: &GzRandom, target: u64, buf: &mut [u8]) -> Result<(), i32> {
     let keep_cursor =
         !cur.stream_eof && cur.u_pos <= target && (target - cur.u_pos) <= (target - cp.u_offset);
     if !keep_cursor {
-        let fresh = GzCursor::new(
-            &gz.source,
-            cp.c_offset,
-            cp.state.clone(),
-            cp.u_offset,
-            gz.io_chunk,
-        )?;
-        *cur = fresh;
+        *cur = GzCursor::new(&gz.source, cp, gz.io_chunk)?;
     }
     let mut scratch = [0u8; IO_CHUNK];
     let mut remain = target - cur.u_pos;
@@ -492,6 +681,198 @@ fn zst_read_at(zr: &ZstRandom, target: u64, buf: &mut [u8]) -> Result<(), i32> {
     Ok(())
 }
 
+// ===================================================================
+// seekable zstd: per-frame random access (see module docs)
+// ===================================================================
+
+struct ZstSeekable {
+    source: Source,
+    frames: Vec<SeekFrame>,
+    /// Decoded frames, by frame index.
+    decoded: ByteLru<usize>,
+}
+
+/// Decode one frame on its own (EIO when it is corrupt or does not hold
+/// the length the seek table promises).
+fn zst_decode_frame(source: &Source, frame: &SeekFrame) -> Result<Vec<u8>, i32> {
+    let reader = source.reader_at(frame.c_offset)?.take(frame.c_len);
+    let dec = StreamingDecoder::new(reader).map_err(|_| libc::EIO)?;
+    let mut out = Vec::with_capacity(frame.u_len as usize);
+    // One byte of slack catches a frame longer than its table entry
+    // without inflating an unbounded amount.
+    dec.take(frame.u_len + 1)
+        .read_to_end(&mut out)
+        .map_err(|_| libc::EIO)?;
+    if out.len() as u64 != frame.u_len {
+        return Err(libc::EIO);
+    }
+    Ok(out)
+}
+
+/// Frame `index`, decoded: from the frame cache, else decoded and
+/// admitted.
+fn zst_frame(zs: &ZstSeekable, index: usize) -> Result<Arc<Vec<u8>>, i32> {
+    if let Some(plain) = zs.decoded.get(&index) {
+        return Ok(plain);
+    }
+    let plain = Arc::new(zst_decode_frame(&zs.source, &zs.frames[index])?);
+    zs.decoded.insert(index, Arc::clone(&plain));
+    Ok(plain)
+}
+
+/// Read `buf` fully at uncompressed offset `target`, frame by frame.
+fn zst_seekable_read_at(zs: &ZstSeekable, target: u64, buf: &mut [u8]) -> Result<(), i32> {
+    let mut got = 0usize;
+    while got < buf.len() {
+        let at = target + got as u64;
+        let index = frame_at(&zs.frames, at).ok_or(libc::EIO)?;
+        let plain = zst_frame(zs, index)?;
+        let lo = (at - zs.frames[index].u_offset) as usize;
+        let n = (plain.len() - lo).min(buf.len() - got);
+        buf[got..got + n].copy_from_slice(&plain[lo..lo + n]);
+        got += n;
+    }
+    Ok(())
+}
+
+/// The mount scan's view of a seekable stream: every frame in order,
+/// decoded one at a time (bypassing the frame cache).
+struct ZstFrameChain<'a> {
+    zs: &'a ZstSeekable,
+    next: usize,
+    plain: Vec<u8>,
+    pos: usize,
+}
+
+impl Read for ZstFrameChain<'_> {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        while self.pos == self.plain.len() {
+            let Some(frame) = self.zs.frames.get(self.next) else {
+                return Ok(0);
+            };
+            self.plain =
+                zst_decode_frame(&self.zs.source, frame).map_err(io::Error::from_raw_os_error)?;
+            self.pos = 0;
+            self.next += 1;
+        }
+        let n = (self.plain.len() - self.pos).min(buf.len());
+        buf[..n].copy_from_slice(&self.plain[self.pos..self.pos + n]);
+        self.pos += n;
+        Ok(n)
+    }
+}
+
+// ===================================================================
+// BGZF tar.gz: per-member random access, parallel decode (module docs)
+// ===================================================================
+
+struct Bgzf {
+    source: Source,
+    /// The member table (deflate extents; see `bgzf::members`).
+    members: Vec<SeekFrame>,
+    /// Decoded members, by member index.
+    decoded: ByteLru<usize>,
+    /// Decode workers.
+    threads: usize,
+}
+
+/// Decode the members in `range` across the workers: one positioned
+/// read covers their compressed bytes, then every member inflates (and
+/// is length- and CRC-checked) on its own.
+fn bgzf_decode(bg: &Bgzf, range: Range<usize>) -> Result<Vec<Vec<u8>>, i32> {
+    let members = &bg.members[range];
+    let (Some(first), Some(last)) = (members.first(), members.last()) else {
+        return Ok(Vec::new());
+    };
+    let base = first.c_offset;
+    let mut span = vec![0u8; (last.c_offset + last.c_len + 8 - base) as usize];
+    bg.source.read_exact_at(base, &mut span)?;
+    bgzf::par_map(members, bg.threads, |m| {
+        let at = (m.c_offset - base) as usize;
+        let end = at + m.c_len as usize;
+        let trailer: &[u8; 8] = span[end..end + 8].try_into().expect("8 bytes");
+        bgzf::decode_member(&span[at..end], trailer, m.u_len)
+    })
+}
+
+/// Member `index`, decoded: from the member cache, else decoded and
+/// admitted. A miss right behind a cached member is a sequential read
+/// (extraction, a whole-file copy), so it decodes one member per worker
+/// ahead in the same parallel pass.
+fn bgzf_member(bg: &Bgzf, index: usize) -> Result<Arc<Vec<u8>>, i32> {
+    if let Some(plain) = bg.decoded.get(&index) {
+        return Ok(plain);
+    }
+    let ahead = if index > 0 && bg.decoded.contains(&(index - 1)) {
+        bg.threads
+    } else {
+        1
+    };
+    let end = (index + ahead).min(bg.members.len());
+    // A bad member further ahead must not fail a read that never needs it.
+    let decoded = bgzf_decode(bg, index..end).or_else(|_| bgzf_decode(bg, index..index + 1))?;
+    let mut wanted = None;
+    for (i, plain) in (index..).zip(decoded) {
+        let plain = Arc::new(plain);
+        if i == index {
+            wanted = Some(Arc::clone(&plain));
+        }
+        bg.decoded.insert(i, plain);
+    }
+    wanted.ok_or(libc::EIO)
+}
+
+/// Read `buf` fully at uncompressed offset `target`, member by member.
+fn bgzf_read_at(bg: &Bgzf, target: u64, buf: &mut [u8]) -> Result<(), i32> {
+    let mut got = 0usize;
+    while got < buf.len() {
+        let at = target + got as u64;
+        let index = frame_at(&bg.members, at).ok_or(libc::EIO)?;
+        let plain = bgzf_member(bg, index)?;
+        let lo = (at - bg.members[index].u_offset) as usize;
+        let n = (plain.len() - lo).min(buf.len() - got);
+        buf[got..got + n].copy_from_slice(&plain[lo..lo + n]);
+        got += n;
+    }
+    Ok(())
+}
+
+/// The mount scan's view of a BGZF stream: every member in order,
+/// decoded [`BGZF_SCAN_BATCH`] per worker at a time (bypassing the
+/// member cache).
+struct BgzfChain<'a> {
+    bg: &'a Bgzf,
+    next: usize,
+    ready: VecDeque<Vec<u8>>,
+    pos: usize,
+}
+
+impl Read for BgzfChain<'_> {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        loop {
+            if let Some(plain) = self.ready.front() {
+                if self.pos < plain.len() {
+                    let n = (plain.len() - self.pos).min(buf.len());
+                    buf[..n].copy_from_slice(&plain[self.pos..self.pos + n]);
+                    self.pos += n;
+                    return Ok(n);
+                }
+                self.ready.pop_front();
+                self.pos = 0;
+                continue;
+            }
+            if self.next == self.bg.members.len() {
+                return Ok(0);
+            }
+            let end = (self.next + self.bg.threads * BGZF_SCAN_BATCH).min(self.bg.members.len());
+            self.ready = bgzf_decode(self.bg, self.next..end)
+                .map_err(io::Error::from_raw_os_error)?
+                .into();
+            self.next = end;
+        }
+    }
+}
+
 /// Counts bytes for the mount scan (cursor bookkeeping after parsing).
 struct CountingRead<'a, R: Read> {
     inner: &'a mut R,
@@ -677,7 +1058,7 @@ fn index_from_seekable<R: Read + Seek>(reader: R) -> Result<IndexBuild, i32> {
 /// bounded streaming for regions.
 fn index_plain(source: &Source) -> Result<IndexBuild, i32> {
     let build = match source {
-        Source::Memory(data) => index_from_seekable(Cursor::new(data.as_slice())),
+        Source::Memory(data) => index_from_seekable(Cursor::new(&data[..])),
         Source::File(f)
             if f.base == 0 && f.len == f.file.metadata().map_err(|_| libc::EIO)?.len() =>
         {
@@ -706,6 +1087,108 @@ fn index_plain(source: &Source) -> Result<IndexBuild, i32> {
     Ok(build)
 }
 
+// ===================================================================
+// The persisted index (the `index_sidecar` payload)
+// ===================================================================
+
+fn compression_tag(compression: TarCompression) -> u8 {
+    match compression {
+        TarCompression::None => 0,
+        TarCompression::Gzip => 1,
+        TarCompression::Zstd => 2,
+    }
+}
+
+/// Decode a sidecar payload written for `compression`; `None` when it is
+/// malformed or describes an index this source could not have produced.
+fn decode_index(payload: &[u8], compression: TarCompression) -> Option<PersistedIndex> {
+    let mut d = Decoder::new(payload);
+    if d.u8()? != compression_tag(compression) {
+        return None;
+    }
+    let uncompressed_size = d.u64()?;
+    let mut build = IndexBuild::default();
+    for idx in 0..d.u64()? {
+        let name = d.str()?.to_string();
+        let kind = match d.u8()? {
+            0 => {
+                let (data_offset, size) = (d.u64()?, d.u64()?);
+                if data_offset.checked_add(size)? > uncompressed_size {
+                    return None;
+                }
+                TarEntryKind::File {
+                    data_offset,
+                    size,
+                    readable: d.u8()? != 0,
+                }
+            }
+            1 => TarEntryKind::Directory,
+            2 => TarEntryKind::Symlink,
+            3 => TarEntryKind::HardLink {
+                target: d.str()?.to_string(),
+            },
+            4 => TarEntryKind::Other,
+            _ => return None,
+        };
+        let (perms, mtime) = (d.u32()?, d.i64()?);
+        // Names are unique in a built index (duplicates replace in place).
+        if build.by_path.insert(name.clone(), idx as usize).is_some() {
+            return None;
+        }
+        build.entries.push(TarEntry {
+            name,
+            kind,
+            perms,
+            mtime,
+        });
+    }
+    for _ in 0..d.u64()? {
+        let dir = d.str()?.to_string();
+        let mut children = Vec::new();
+        for _ in 0..d.u64()? {
+            let idx = usize::try_from(d.u64()?).ok()?;
+            if idx >= build.entries.len() {
+                return None;
+            }
+            children.push(idx);
+        }
+        build.children.insert(dir, children);
+    }
+    let mut checkpoints: Vec<GzCheckpoint> = Vec::new();
+    for _ in 0..d.u64()? {
+        let (u_offset, c_offset) = (d.u64()?, d.u64()?);
+        let (num_bits, bit_buf) = (d.u8()?, d.u8()?);
+        let window = d.bytes()?;
+        let in_order = checkpoints.last().map_or(u_offset == 0, |prev| {
+            prev.u_offset < u_offset && prev.c_offset <= c_offset
+        });
+        if !in_order
+            || num_bits > 7
+            || u_offset > uncompressed_size
+            || window.len() as u64 != u_offset.min(GZ_WINDOW as u64)
+        {
+            return None;
+        }
+        checkpoints.push(GzCheckpoint {
+            u_offset,
+            c_offset,
+            num_bits,
+            bit_buf,
+            window: window.into(),
+        });
+    }
+    // Plain gzip persists checkpoints; BGZF (also tagged gzip) needs none.
+    if d.is_empty() && (compression == TarCompression::Gzip || checkpoints.is_empty()) {
+        Some(PersistedIndex {
+            build,
+            uncompressed_size,
+            checkpoints,
+        })
+    } else {
+        None
+    }
+}
+
 // ===================================================================
 // The backend
 // ===================================================================
@@ -714,7 +1197,9 @@ fn index_plain(source: &Source) -> Result<IndexBuild, i32> {
 enum TarStream {
     Plain(Source),
     Gz(Box<GzRandom>),
+    Bgzf(Box<Bgzf>),
     Zst(Box<ZstRandom>),
+    ZstSeekable(Box<ZstSeekable>),
 }
 
 /// Mounted tar/tar.gz/tar.zst archive (read-only).
@@ -726,6 +1211,16 @@ pub struct TarBackend {
     format: &'static CStr,
     compression: &'static str,
     uncompressed_size: u64,
+    /// Where the index came from: `"scan"` or `"sidecar"`.
+    index_source: &'static str,
+}
+
+/// A mount index as the sidecar holds it (see `index_sidecar`): the
+/// entry table, the stream length and — for plain gzip — the checkpoints.
+struct PersistedIndex {
+    build: IndexBuild,
+    uncompressed_size: u64,
+    checkpoints: Vec<GzCheckpoint>,
 }
 
 impl TarBackend {
@@ -763,25 +1258,89 @@ impl TarBackend {
 
     /// Mount an in-memory image (owned).
     pub fn from_memory(data: Vec<u8>, compression: TarCompression) -> Result<TarBackend, i32> {
+        Self::from_bytes(ImageBytes::from(data), compression)
+    }
+
+    /// Mount an image held in `data` — an owned buffer or a caller's lent
+    /// one (a borrowed in-memory mount).
+    pub fn from_bytes(data: ImageBytes, compression: TarCompression) -> Result<TarBackend, i32> {
         Self::from_source(Source::Memory(Arc::new(data)), compression)
     }
 
+    /// [`TarBackend::from_file_at`], loading the index from the sidecar
+    /// at `sidecar` when it was written for these bytes, and saving the
+    /// scanned index there when not (see `index_sidecar`; `None`: scan).
+    pub fn from_file_at_indexed(
+        file: File,
+        offset: u64,
+        length: u64,
+        compression: TarCompression,
+        sidecar: Option<&Path>,
+    ) -> Result<TarBackend, i32> {
+        let Some(sidecar) = sidecar else {
+            return Self::from_file_at(file, offset, length, compression);
+        };
+        // An unstampable region (short file) falls through to the scan,
+        // which reports it.
+        let stamp = index_sidecar::file_stamp(&file, offset, length).ok();
+        let persisted = stamp
+            .as_ref()
+            .and_then(|stamp| index_sidecar::load(sidecar, stamp))
+            .and_then(|payload| decode_index(&payload, compression));
+        let source = Source::File(FileSource {
+            file,
+            base: offset,
+            len: length,
+            seek_lock: Mutex::new(()),
+        });
+        let backend = Self::from_source_cfg(
+            source,
+            compression,
+            GZ_CHECKPOINT_SPACING,
+            IO_CHUNK,
+            persisted,
+        )?;
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "tar index: {} entries ({})",
+            backend.entries.len(),
+            backend.index_source
+        );
+        if let (Some(stamp), "scan") = (stamp, backend.index_source) {
+            index_sidecar::store(sidecar, &stamp, &backend.encode_index());
+        }
+        Ok(backend)
+    }
+
     fn from_source(source: Source, compression: TarCompression) -> Result<TarBackend, i32> {
-        Self::from_source_cfg(source, compression, GZ_CHECKPOINT_SPACING, IO_CHUNK)
+        Self::from_source_cfg(source, compression, GZ_CHECKPOINT_SPACING, IO_CHUNK, None)
     }
 
     /// Constructor with tunable gzip checkpoint parameters (tests shrink
-    /// them to exercise the resume machinery on small inputs).
+    /// them to exercise the resume machinery on small inputs). A
+    /// `persisted` index replaces the mount scan; one that does not fit
+    /// the stream found (a stale or corrupt sidecar) is dropped for the
+    /// scan, which the caller then writes back.
     fn from_source_cfg(
         source: Source,
         compression: TarCompression,
         gz_spacing: u64,
         gz_io_chunk: usize,
+        persisted: Option<PersistedIndex>,
     ) -> Result<TarBackend, i32> {
+        let mut index_source = if persisted.is_some() {
+            "sidecar"
+        } else {
+            "scan"
+        };
         let (stream, build, format, comp_name, uncompressed_size) = match compression {
             TarCompression::None => {
                 let uncompressed_size = source.len();
-                let build = index_plain(&source)?;
+                let build = match persisted {
+                    Some(p) => p.build,
+                    None => index_plain(&source)?,
+                };
                 (
                     TarStream::Plain(source),
                     build,
@@ -792,58 +1351,131 @@ impl TarBackend {
             }
             TarCompression::Gzip => {
                 let c0 = parse_gzip_header(&source)?;
-                let state0 = Box::new(InflateState::new(DataFormat::Raw));
-                let cur = GzCursor::new(&source, c0, state0.clone(), 0, gz_io_chunk)?;
-                let cap = GzCapture {
-                    c0,
-                    c_fed: 0,
-                    spacing: gz_spacing,
-                    last_cp_u: 0,
-                    cps: vec![GzCheckpoint {
-                        u_offset: 0,
-                        c_offset: c0,
-                        state: state0,
-                    }],
-                };
-                let mut scan = GzScan { cur, cap };
-                let build = index_from_reader(&mut scan)?;
-                let GzScan { cur, cap } = scan;
-                let uncompressed_size = cur.u_pos;
-                (
-                    TarStream::Gz(Box::new(GzRandom {
+                if let Some(members) =
+                    bgzf::members(source.len(), |at, buf| source.read_exact_at(at, buf))
+                {
+                    let bg = Bgzf {
                         source,
-                        checkpoints: cap.cps,
-                        cursor: Mutex::new(cur),
-                        io_chunk: gz_io_chunk,
-                    })),
-                    build,
-                    c"TAR.GZ",
-                    "gzip",
-                    uncompressed_size,
-                )
+                        members,
+                        decoded: ByteLru::new(BGZF_MEMBER_CACHE),
+                        threads: bgzf::threads(),
+                    };
+                    // BGZF needs no checkpoints: a sidecar carrying some
+                    // was written for another stream.
+                    let persisted = persisted.filter(|p| p.checkpoints.is_empty());
+                    if persisted.is_none() {
+                        index_source = "scan";
+                    }
+                    let build = match persisted {
+                        Some(p) => p.build,
+                        None => index_from_reader(BgzfChain {
+                            bg: &bg,
+                            next: 0,
+                            ready: VecDeque::new(),
+                            pos: 0,
+                        })?,
+                    };
+                    let uncompressed_size = bg.members.last().map_or(0, |m| m.u_offset + m.u_len);
+                    (
+                        TarStream::Bgzf(Box::new(bg)),
+                        build,
+                        c"TAR.GZ",
+                        "gzip-bgzf",
+                        uncompressed_size,
+                    )
+                } else {
+                    let start = GzCheckpoint::start(c0);
+                    // The first checkpoint must sit at this stream's first
+                    // deflate block.
+                    let persisted = persisted
+                        .filter(|p| p.checkpoints.first().is_some_and(|cp| cp.c_offset == c0));
+                    if persisted.is_none() {
+                        index_source = "scan";
+                    }
+                    let (build, checkpoints, cur, uncompressed_size) = match persisted {
+                        Some(p) => {
+                            let cur = GzCursor::new(&source, &start, gz_io_chunk)?;
+                            (p.build, p.checkpoints, cur, p.uncompressed_size)
+                        }
+                        None => {
+                            let cur = GzCursor::new(&source, &start, gz_io_chunk)?;
+                            let cap = GzCapture {
+                                spacing: gz_spacing,
+                                last_cp_u: 0,
+                                cps: vec![start],
+                            };
+                            let mut scan = GzScan { cur, cap };
+                            let build = index_from_reader(&mut scan)?;
+                            let GzScan { cur, cap } = scan;
+                            let uncompressed_size = cur.u_pos;
+                            (build, cap.cps, cur, uncompressed_size)
+                        }
+                    };
+                    (
+                        TarStream::Gz(Box::new(GzRandom {
+                            source,
+                            checkpoints,
+                            cursor: Mutex::new(cur),
+                            io_chunk: gz_io_chunk,
+                        })),
+                        build,
+                        c"TAR.GZ",
+                        "gzip",
+                        uncompressed_size,
+                    )
+                }
             }
             TarCompression::Zstd => {
-                let mut cur = zst_cursor(&source)?;
-                let build = {
-                    let mut cr = CountingRead {
-                        inner: &mut cur.dec,
-                        n: 0,
-                    };
-                    let build = index_from_reader(&mut cr)?;
-                    cur.u_pos = cr.n;
-                    build
-                };
-                let uncompressed_size = cur.u_pos;
-                (
-                    TarStream::Zst(Box::new(ZstRandom {
+                let table =
+                    parse_seek_table(source.len(), |at, buf| source.read_exact_at(at, buf))?;
+                if let Some(frames) = table {
+                    let zs = ZstSeekable {
                         source,
-                        cursor: Mutex::new(cur),
-                    })),
-                    build,
-                    c"TAR.ZST",
-                    "zstd",
-                    uncompressed_size,
-                )
+                        frames,
+                        decoded: ByteLru::new(ZST_FRAME_CACHE),
+                    };
+                    let build = match persisted {
+                        Some(p) => p.build,
+                        None => index_from_reader(ZstFrameChain {
+                            zs: &zs,
+                            next: 0,
+                            plain: Vec::new(),
+                            pos: 0,
+                        })?,
+                    };
+                    let uncompressed_size = zs.frames.last().map_or(0, |f| f.u_offset + f.u_len);
+                    (
+                        TarStream::ZstSeekable(Box::new(zs)),
+                        build,
+                        c"TAR.ZST",
+                        "zstd-seekable",
+                        uncompressed_size,
+                    )
+                } else {
+                    let mut cur = zst_cursor(&source)?;
+                    let (build, uncompressed_size) = match persisted {
+                        Some(p) => (p.build, p.uncompressed_size),
+                        None => {
+                            let mut cr = CountingRead {
+                                inner: &mut cur.dec,
+                                n: 0,
+                            };
+                            let build = index_from_reader(&mut cr)?;
+                            cur.u_pos = cr.n;
+                            (build, cr.n)
+                        }
+                    };
+                    (
+                        TarStream::Zst(Box::new(ZstRandom {
+                            source,
+                            cursor: Mutex::new(cur),
+                        })),
+                        build,
+                        c"TAR.ZST",
+                        "zstd",
+                        uncompressed_size,
+                    )
+                }
             }
         };
         Ok(TarBackend {
@@ -854,9 +1486,65 @@ impl TarBackend {
             format,
             compression: comp_name,
             uncompressed_size,
+            index_source,
         })
     }
 
+    /// The sidecar payload for this mount's index ([`decode_index`]).
+    fn encode_index(&self) -> Vec<u8> {
+        let (compression, checkpoints): (_, &[GzCheckpoint]) = match &self.stream {
+            TarStream::Plain(_) => (TarCompression::None, &[]),
+            TarStream::Gz(gz) => (TarCompression::Gzip, &gz.checkpoints),
+            TarStream::Bgzf(_) => (TarCompression::Gzip, &[]),
+            TarStream::Zst(_) | TarStream::ZstSeekable(_) => (TarCompression::Zstd, &[]),
+        };
+        let mut e = Encoder::default();
+        e.u8(compression_tag(compression));
+        e.u64(self.uncompressed_size);
+        e.u64(self.entries.len() as u64);
+        for entry in &self.entries {
+            e.str(&entry.name);
+            match &entry.kind {
+                TarEntryKind::File {
+                    data_offset,
+                    size,
+                    readable,
+                } => {
+                    e.u8(0);
+                    e.u64(*data_offset);
+                    e.u64(*size);
+                    e.u8(u8::from(*readable));
+                }
+                TarEntryKind::Directory => e.u8(1),
+                TarEntryKind::Symlink => e.u8(2),
+                TarEntryKind::HardLink { target } => {
+                    e.u8(3);
+                    e.str(target);
+                }
+                TarEntryKind::Other => e.u8(4),
+            }
+            e.u32(entry.perms);
+            e.i64(entry.mtime);
+        }
+        e.u64(self.children.len() as u64);
+        for (dir, children) in &self.children {
+            e.str(dir);
+            e.u64(children.len() as u64);
+            for &idx in children {
+                e.u64(idx as u64);
+            }
+        }
+        e.u64(checkpoints.len() as u64);
+        for cp in checkpoints {
+            e.u64(cp.u_offset);
+            e.u64(cp.c_offset);
+            e.u8(cp.num_bits);
+            e.u8(cp.bit_buf);
+            e.bytes(&cp.window);
+        }
+        e.finish()
+    }
+
     /// Resolve a path to (size, data_offset, readable) for regular files,
     /// following hard links one hop (links to links are not chained by tar).
     fn file_entry(&self, path: &str) -> Option<(u64, u64, bool)> {
@@ -945,7 +1633,9 @@ impl Backend for TarBackend {
         match &self.stream {
             TarStream::Plain(source) => source.read_exact_at(at, &mut buf[..want])?,
             TarStream::Gz(gz) => gz_read_at(gz, at, &mut buf[..want])?,
+            TarStream::Bgzf(bg) => bgzf_read_at(bg, at, &mut buf[..want])?,
             TarStream::Zst(zr) => zst_read_at(zr, at, &mut buf[..want])?,
+            TarStream::ZstSeekable(zs) => zst_seekable_read_at(zs, at, &mut buf[..want])?,
         }
         Ok(want)
     }
@@ -975,10 +1665,11 @@ impl Backend for TarBackend {
 
     fn image_info_json(&self) -> Option<String> {
         Some(format!(
-            "{{\"format\":\"tar\",\"compression\":\"{}\",\"entries\":{},\"uncompressed_size\":{}}}",
+            "{{\"format\":\"tar\",\"compression\":\"{}\",\"entries\":{},\"uncompressed_size\":{},\"index\":\"{}\"}}",
             self.compression,
             self.entries.len(),
-            self.uncompressed_size
+            self.uncompressed_size,
+            self.index_source
         ))
     }
 }
@@ -1031,6 +1722,31 @@ mod tests {
         out
     }
 
+    /// Like [`gzip_bytes`], but every `block` input bytes end a deflate
+    /// block (sync flush), so block-boundary checkpoints land densely.
+    fn gzip_blocks(data: &[u8], block: usize) -> Vec<u8> {
+        use miniz_oxide::deflate::core::{
+            compress_to_output, create_comp_flags_from_zip_params, CompressorOxide, TDEFLFlush,
+        };
+        let mut d = CompressorOxide::new(create_comp_flags_from_zip_params(6, -15, 0));
+        let mut out = vec![0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff];
+        let chunks: Vec<&[u8]> = data.chunks(block).collect();
+        for (i, chunk) in chunks.iter().enumerate() {
+            let flush = if i + 1 == chunks.len() {
+                TDEFLFlush::Finish
+            } else {
+                TDEFLFlush::Sync
+            };
+            compress_to_output(&mut d, chunk, flush, |bytes| {
+                out.extend_from_slice(bytes);
+                true
+            });
+        }
+        out.extend(crc32fast::hash(data).to_le_bytes());
+        out.extend((data.len() as u32).to_le_bytes());
+        out
+    }
+
     fn fixture_zst() -> Vec<u8> {
         std::fs::read(concat!(
             env!("CARGO_MANIFEST_DIR"),
@@ -1317,12 +2033,14 @@ mod tests {
             .map(|(p, d)| (p.as_str(), d.as_slice()))
             .collect();
         let tar = make_tar(&refs);
-        let gz = gzip_bytes(&tar);
+        // 1 KiB deflate blocks: checkpoints can only land on boundaries.
+        let gz = gzip_blocks(&tar, 1024);
         let b = TarBackend::from_source_cfg(
-            Source::Memory(Arc::new(gz)),
+            Source::Memory(Arc::new(gz.into())),
             TarCompression::Gzip,
             2048, // 2 KiB spacing
-            512,  // small input chunks → many capture boundaries
+            512,  // small input chunks
+            None,
         )
         .unwrap();
         let TarStream::Gz(g) = &b.stream else {
@@ -1330,10 +2048,14 @@ mod tests {
         };
         let ncps = g.checkpoints.len();
         assert!(ncps > 20, "expected many checkpoints, got {ncps}");
+        assert!(
+            g.checkpoints.iter().any(|cp| cp.num_bits != 0),
+            "some resumes start mid-byte"
+        );
         eprintln!(
-            "[tar-gz] {} checkpoints × ~{} B state for {} B uncompressed",
+            "[tar-gz] {} checkpoints × ≤ {} B window for {} B uncompressed",
             ncps,
-            std::mem::size_of::<InflateState>(),
+            GZ_WINDOW,
             tar.len()
         );
 
@@ -1386,10 +2108,301 @@ mod tests {
         }
     }
 
+    #[test]
+    fn persisted_checkpoints_resume_like_scanned_ones() {
+        let files = noisy_files(8, 20_000);
+        let refs: Vec<(&str, &[u8])> = files
+            .iter()
+            .map(|(p, d)| (p.as_str(), d.as_slice()))
+            .collect();
+        let gz = Arc::new(ImageBytes::from(gzip_blocks(&make_tar(&refs), 1024)));
+        let scanned = TarBackend::from_source_cfg(
+            Source::Memory(Arc::clone(&gz)),
+            TarCompression::Gzip,
+            2048,
+            512,
+            None,
+        )
+        .unwrap();
+        let payload = scanned.encode_index();
+        assert!(decode_index(&payload, TarCompression::Zstd).is_none());
+        assert!(decode_index(&payload[..payload.len() - 1], TarCompression::Gzip).is_none());
+        let persisted = decode_index(&payload, TarCompression::Gzip).unwrap();
+        let loaded = TarBackend::from_source_cfg(
+            Source::Memory(gz),
+            TarCompression::Gzip,
+            2048,
+            512,
+            Some(persisted),
+        )
+        .unwrap();
+        assert_eq!(loaded.encode_index(), payload);
+        assert!(loaded
+            .image_info_json()
+            .unwrap()
+            .contains("\"index\":\"sidecar\""));
+        for (path, want) in files.iter().rev() {
+            let mut buf = vec![0u8; 700];
+            assert_eq!(loaded.pread(path, &mut buf, 19_000).unwrap(), 700);
+            assert_eq!(buf, want[19_000..19_700], "{path}");
+        }
+    }
+
+    #[test]
+    fn a_sidecar_that_does_not_fit_the_stream_costs_only_the_scan() {
+        let files = noisy_files(4, 20_000);
+        let refs: Vec<(&str, &[u8])> = files
+            .iter()
+            .map(|(p, d)| (p.as_str(), d.as_slice()))
+            .collect();
+        let gz = Arc::new(ImageBytes::from(gzip_blocks(&make_tar(&refs), 1024)));
+        let mount = |persisted| {
+            TarBackend::from_source_cfg(
+                Source::Memory(Arc::clone(&gz)),
+                TarCompression::Gzip,
+                2048,
+                512,
+                persisted,
+            )
+            .unwrap()
+        };
+        let payload = mount(None).encode_index();
+        let mut stale = decode_index(&payload, TarCompression::Gzip).unwrap();
+        stale.checkpoints.clear();
+        let b = mount(Some(stale));
+        assert!(b.image_info_json().unwrap().contains("\"index\":\"scan\""));
+        assert_eq!(
+            b.encode_index(),
+            payload,
+            "the scan is what gets written back"
+        );
+        for (path, want) in &files {
+            assert_eq!(pread_all(&b, path), *want, "{path}");
+        }
+    }
+
+    #[test]
+    fn file_mounts_reuse_the_sidecar_until_the_image_changes() {
+        let dir = tempfile::tempdir().unwrap();
+        let image = dir.path().join("app.tar.gz");
+        let sidecar = dir.path().join("cache/tar.idx");
+        let mount = || {
+            let file = File::open(&image).unwrap();
+            let len = file.metadata().unwrap().len();
+            TarBackend::from_file_at_indexed(file, 0, len, TarCompression::Gzip, Some(&sidecar))
+                .unwrap()
+        };
+        let index = |b: &TarBackend| b.image_info_json().unwrap();
+
+        std::fs::write(&image, gzip_bytes(&make_tar(&[("a.txt", b"one")]))).unwrap();
+        let first = mount();
+        assert!(index(&first).contains("\"index\":\"scan\""));
+        assert!(sidecar.is_file());
+        let second = mount();
+        assert!(index(&second).contains("\"index\":\"sidecar\""));
+        assert_eq!(pread_all(&second, "a.txt"), b"one");
+
+        // Same length, new bytes: the stamp no longer matches.
+        std::fs::write(&image, gzip_bytes(&make_tar(&[("a.txt", b"two")]))).unwrap();
+        let third = mount();
+        assert!(index(&third).contains("\"index\":\"scan\""));
+        assert_eq!(pread_all(&third, "a.txt"), b"two");
+        assert!(index(&mount()).contains("\"index\":\"sidecar\""));
+    }
+
+    #[test]
+    fn a_sidecar_for_another_stream_shape_costs_only_the_scan() {
+        let files = noisy_files(4, 20_000);
+        let refs: Vec<(&str, &[u8])> = files
+            .iter()
+            .map(|(p, d)| (p.as_str(), d.as_slice()))
+            .collect();
+        let tar = make_tar(&refs);
+        let plain = Arc::new(ImageBytes::from(gzip_blocks(&tar, 1024)));
+        let mut bgzf_bytes = Vec::new();
+        bgzf::write_bgzf(&tar[..], &mut bgzf_bytes, 6).unwrap();
+        let bgzf = Arc::new(ImageBytes::from(bgzf_bytes));
+        let mount = |bytes: &Arc<ImageBytes>, persisted| {
+            TarBackend::from_source_cfg(
+                Source::Memory(Arc::clone(bytes)),
+                TarCompression::Gzip,
+                2048,
+                512,
+                persisted,
+            )
+            .unwrap()
+        };
+        let plain_index = mount(&plain, None).encode_index();
+        let bgzf_index = mount(&bgzf, None).encode_index();
+
+        // Each stream handed the other's index (checkpoints where BGZF
+        // has none, none where plain gzip needs them) rescans.
+        for (bytes, payload) in [(&bgzf, &plain_index), (&plain, &bgzf_index)] {
+            let stale = decode_index(payload, TarCompression::Gzip).unwrap();
+            let b = mount(bytes, Some(stale));
+            assert!(b.image_info_json().unwrap().contains("\"index\":\"scan\""));
+            for (path, want) in &files {
+                assert_eq!(pread_all(&b, path), *want, "{path}");
+            }
+        }
+    }
+
+    #[test]
+    fn concatenated_gzip_members_are_followed() {
+        let files = noisy_files(8, 20_000);
+        let refs: Vec<(&str, &[u8])> = files
+            .iter()
+            .map(|(p, d)| (p.as_str(), d.as_slice()))
+            .collect();
+        let tar = make_tar(&refs);
+        // Three members split mid-file (`cat a.gz b.gz c.gz`); the middle
+        // one names itself, and zero padding trails the last.
+        let mut gz = gzip_blocks(&tar[..50_000], 1024);
+        let mut named = gzip_blocks(&tar[50_000..100_000], 1024);
+        named[3] = 0x08; // FNAME
+        named.splice(10..10, b"part2.tar\0".iter().copied());
+        gz.extend(named);
+        gz.extend(gzip_bytes(&tar[100_000..]));
+        gz.extend([0u8; 512]);
+        let b = TarBackend::from_source_cfg(
+            Source::Memory(Arc::new(gz.into())),
+            TarCompression::Gzip,
+            2048,
+            512,
+            None,
+        )
+        .unwrap();
+        let TarStream::Gz(g) = &b.stream else {
+            panic!("expected the gzip stream variant")
+        };
+        assert!(g.checkpoints.iter().any(|cp| cp.u_offset > 60_000));
+        for (path, want) in files.iter().rev() {
+            assert_eq!(pread_all(&b, path), *want, "full read of {path}");
+            let mut buf = vec![0u8; 300];
+            assert_eq!(b.pread(path, &mut buf, 9_900).unwrap(), 300);
+            assert_eq!(buf, want[9_900..10_200]);
+        }
+    }
+
+    #[test]
+    fn bgzf_members_are_random_access_points() {
+        let files = noisy_files(12, 100_000);
+        let refs: Vec<(&str, &[u8])> = files
+            .iter()
+            .map(|(p, d)| (p.as_str(), d.as_slice()))
+            .collect();
+        let tar = make_tar(&refs);
+        let mut gz = Vec::new();
+        bgzf::write_bgzf(&tar[..], &mut gz, 6).unwrap();
+        assert_eq!(detect_format(&gz), ImageFormat::TarGz);
+        let b = TarBackend::from_memory(gz.clone(), TarCompression::Gzip).unwrap();
+        let TarStream::Bgzf(bg) = &b.stream else {
+            panic!("expected the BGZF stream variant")
+        };
+        assert!(bg.members.len() > 18);
+        assert!(b
+            .image_info_json()
+            .unwrap()
+            .contains("\"compression\":\"gzip-bgzf\""));
+        for (path, want) in files.iter().rev() {
+            for (off, len) in [(99_000usize, 1000usize), (0, 100), (65_000, 2_000)] {
+                let mut buf = vec![0u8; len];
+                assert_eq!(b.pread(path, &mut buf, off as u64).unwrap(), len);
+                assert_eq!(buf, want[off..off + len], "window {off}+{len} of {path}");
+            }
+        }
+        for (path, want) in &files {
+            assert_eq!(pread_all(&b, path), *want, "sequential read of {path}");
+        }
+
+        // The persisted index carries no checkpoints and mounts as-is.
+        let payload = b.encode_index();
+        let persisted = decode_index(&payload, TarCompression::Gzip).unwrap();
+        assert!(persisted.checkpoints.is_empty());
+        let loaded = TarBackend::from_source_cfg(
+            Source::Memory(Arc::new(gz.into())),
+            TarCompression::Gzip,
+            GZ_CHECKPOINT_SPACING,
+            IO_CHUNK,
+            Some(persisted),
+        )
+        .unwrap();
+        assert_eq!(pread_all(&loaded, &files[7].0), files[7].1);
+    }
+
+    #[test]
+    fn corrupt_bgzf_member_reads_eio() {
+        let files = noisy_files(4, 200_000);
+        let refs: Vec<(&str, &[u8])> = files
+            .iter()
+            .map(|(p, d)| (p.as_str(), d.as_slice()))
+            .collect();
+        let mut gz = Vec::new();
+        bgzf::write_bgzf(&make_tar(&refs)[..], &mut gz, 6).unwrap();
+        let mut image = tempfile::NamedTempFile::new().unwrap();
+        std::io::Write::write_all(&mut image, &gz).unwrap();
+        let b = TarBackend::from_file(image.reopen().unwrap(), TarCompression::Gzip).unwrap();
+
+        // Flip a deflate byte of the member holding the last file's tail.
+        let members = bgzf::members(gz.len() as u64, |at, buf| {
+            buf.copy_from_slice(&gz[at as usize..at as usize + buf.len()]);
+            Ok(())
+        })
+        .unwrap();
+        let (_, data_offset, _) = b.file_entry(&files[3].0).unwrap();
+        let tail = data_offset + 150_000;
+        let m = members[frame_at(&members, tail).unwrap()];
+        let mut file = image.reopen().unwrap();
+        file.seek(SeekFrom::Start(m.c_offset + m.c_len / 2))
+            .unwrap();
+        std::io::Write::write_all(&mut file, &[gz[(m.c_offset + m.c_len / 2) as usize] ^ 0xff])
+            .unwrap();
+
+        let mut buf = vec![0u8; 1000];
+        assert_eq!(b.pread(&files[3].0, &mut buf, 150_000), Err(libc::EIO));
+        assert_eq!(b.pread(&files[0].0, &mut buf, 0).unwrap(), 1000);
+        assert_eq!(buf, files[0].1[..1000]);
+    }
+
     // ---------------------------------------------------------------
     // tar.zst: forward-cursor random access
     // ---------------------------------------------------------------
 
+    #[test]
+    fn seekable_zst_reads_any_offset_from_its_own_frame() {
+        let big: Vec<u8> = (0..300_000u64).map(|i| splitmix(i / 7) as u8).collect();
+        let tar = make_tar(&[("a.txt", b"first"), ("big.bin", &big), ("z.txt", b"last")]);
+        let mut image = Vec::new();
+        let frames = crate::zstd_seekable::write_seekable(&tar[..], &mut image, 16 * 1024).unwrap();
+        assert!(frames > 16);
+        assert_eq!(detect_format(&image), ImageFormat::TarZst);
+
+        let b = TarBackend::from_memory(image.clone(), TarCompression::Zstd).unwrap();
+        let json = b.image_info_json().unwrap();
+        assert!(json.contains("\"compression\":\"zstd-seekable\""), "{json}");
+        // Back to front, unaligned, straddling frame boundaries.
+        for offset in [290_001u64, 150_000, 16_380, 0] {
+            let mut buf = vec![0u8; 9000];
+            let n = b.pread("big.bin", &mut buf, offset).unwrap();
+            let end = (offset as usize + 9000).min(big.len());
+            assert_eq!(&buf[..n], &big[offset as usize..end], "at {offset}");
+        }
+        let mut last = [0u8; 4];
+        assert_eq!(b.pread("z.txt", &mut last, 0).unwrap(), 4);
+        assert_eq!(&last, b"last");
+
+        // A frame that no longer decodes fails the mount scan cleanly.
+        let table = crate::zstd_seekable::parse_seek_table(image.len() as u64, |at, buf| {
+            let at = at as usize;
+            buf.copy_from_slice(&image[at..at + buf.len()]);
+            Ok(())
+        });
+        let frame = table.unwrap().unwrap()[frames / 2];
+        let mut bad = image.clone();
+        bad[frame.c_offset as usize] ^= 0xFF; // the frame's zstd magic
+        assert!(TarBackend::from_memory(bad, TarCompression::Zstd).is_err());
+    }
+
     #[test]
     fn zst_fixture_mounts_and_reads() {
         let path = concat!(env!("CARGO_MANIFEST_DIR"), "/tests/fixtures/small.tar.zst");
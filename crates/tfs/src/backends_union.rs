@@ -10,8 +10,9 @@
 //!   highest member that lists it;
 //! - **file-vs-dir conflicts** resolve like files: the highest member
 //!   holding ANY entry at the path decides its type — a shadowing file
-//!   turns a lower directory's listing into ENOTDIR, a shadowing
-//!   directory merges lower directories beneath it;
+//!   turns a lower directory's listing into ENOTDIR and hides the
+//!   lower subtree (a path below it is ENOENT), a shadowing directory
+//!   merges lower directories beneath it;
 //! - **read-only forever** (spec 17 §1: union members are read-only;
 //!   the transforms law keeps every write in the COW composite — this
 //!   backend exposes no write view).
@@ -19,26 +20,159 @@
 //! Unlike [`crate::backends_cow::CowBackend`] there is no journal and no
 //! overlay: nothing is hidden and nothing is written — the union is a
 //! pure merged view over the members' trees.
+//!
+//! ## The ownership index
+//!
+//! Probing costs a lookup per member on every miss and a merge of N
+//! listings on every readdir. Because the members never change, the union
+//! walks the merged tree once at construction and records each path's
+//! owning member and each directory's merged listing: a lookup then costs
+//! one hash probe plus one call into the owner, a miss costs no member
+//! call at all, and a readdir is a copy of the stored listing. The index
+//! IS the merged tree; the probe reaches the same answers, so no lookup
+//! depends on which of the two a union uses: before asking the members
+//! it skips every member below the highest non-directory that a parent
+//! of the path resolves to (the index walk never descends below one),
+//! and a member answering ENOTDIR (a file of its own on the way) holds
+//! nothing there. The parents' resolutions are memoized — the members
+//! never change — so a warm probe costs what a plain first-answer walk
+//! does.
+//!
+//! `TEBAKO_TFS_UNION_INDEX` caps the merged tree the index may hold
+//! (entries; default [`DEFAULT_INDEX_LIMIT`], `0` disables it). A larger
+//! tree, a member error during the walk, or a non-canonical path falls
+//! back to probing.
 
+use std::collections::{HashMap, HashSet};
 use std::ffi::CStr;
+use std::sync::RwLock;
+
+use crate::backend::{Backend, EntryType, RawDirEntry, RawStat};
+
+/// Merged-tree entries the ownership index holds at most by default
+/// (≈ 100 bytes each).
+pub const DEFAULT_INDEX_LIMIT: usize = 256 * 1024;
+
+/// Directory prefixes the probe remembers the resolution of; past this
+/// the memo starts over.
+const PARENT_MEMO_MAX: usize = 64 * 1024;
+
+/// The ownership index (see the module docs).
+#[derive(Default)]
+struct UnionIndex {
+    /// Every path of the merged tree: its owning member (the highest one
+    /// holding an entry there) and whether that entry is a directory.
+    owners: HashMap<String, (usize, bool)>,
+    /// The merged listing of every directory of the merged tree.
+    dirs: HashMap<String, Vec<RawDirEntry>>,
+}
 
-use crate::backend::{Backend, RawDirEntry, RawStat};
+impl UnionIndex {
+    /// Walk the merged tree of `members` (`None` past `limit` entries or
+    /// on a member error: the union probes instead).
+    fn build(members: &[Box<dyn Backend>], limit: usize) -> Option<UnionIndex> {
+        let mut index = UnionIndex::default();
+        index
+            .owners
+            .insert(String::new(), (members.len() - 1, true));
+        let mut pending = vec![String::new()];
+        let mut entries = 0usize;
+        while let Some(dir) = pending.pop() {
+            // The read_dir merge, highest member first.
+            let mut listing: Vec<RawDirEntry> = Vec::new();
+            let mut seen: HashSet<String> = HashSet::new();
+            for (i, member) in members.iter().enumerate().rev() {
+                let found = match member.read_dir(&dir) {
+                    Ok(found) => found,
+                    Err(libc::ENOENT) | Err(libc::ENOTDIR) => continue,
+                    Err(_) => return None,
+                };
+                for e in found {
+                    if !seen.insert(e.name.clone()) {
+                        continue;
+                    }
+                    let path = if dir.is_empty() {
+                        e.name.clone()
+                    } else {
+                        format!("{dir}/{}", e.name)
+                    };
+                    if e.is_dir {
+                        pending.push(path.clone());
+                    }
+                    index.owners.insert(path, (i, e.is_dir));
+                    listing.push(e);
+                }
+            }
+            entries += listing.len();
+            if entries > limit {
+                return None;
+            }
+            index.dirs.insert(dir, listing);
+        }
+        Some(index)
+    }
+}
+
+/// True for a path in the backend convention the index is keyed by (no
+/// leading, trailing or doubled `/`, no `.`/`..` components).
+fn is_canonical(path: &str) -> bool {
+    path.is_empty()
+        || path
+            .split('/')
+            .all(|c| !c.is_empty() && c != "." && c != "..")
+}
 
 /// `UnionBackend { members }` — stacking, not a format (spec 17 §1).
 /// `members[0]` is the lowest precedence; the last member shadows all
 /// the others.
 pub struct UnionBackend {
     members: Vec<Box<dyn Backend>>,
+    /// The ownership index; `None` probes the members.
+    index: Option<UnionIndex>,
+    /// Probing: each parent prefix's highest holder (member, is a
+    /// directory), `None` when no member holds it.
+    parents: RwLock<HashMap<String, Option<(usize, bool)>>>,
 }
 
 impl UnionBackend {
     /// Stack `members` (lowest precedence first). A union needs at least
     /// two members — a lone image is a plain exclusive mount.
     pub fn new(members: Vec<Box<dyn Backend>>) -> Result<UnionBackend, i32> {
+        let limit = std::env::var("TEBAKO_TFS_UNION_INDEX")
+            .ok()
+            .and_then(|v| v.trim().parse().ok())
+            .unwrap_or(DEFAULT_INDEX_LIMIT);
+        Self::with_index_limit(members, limit)
+    }
+
+    /// [`UnionBackend::new`] with an explicit index cap (`0`: probe).
+    pub fn with_index_limit(
+        members: Vec<Box<dyn Backend>>,
+        limit: usize,
+    ) -> Result<UnionBackend, i32> {
         if members.len() < 2 {
             return Err(libc::EINVAL);
         }
-        Ok(UnionBackend { members })
+        let index = if limit == 0 {
+            None
+        } else {
+            UnionIndex::build(&members, limit)
+        };
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "union: {} members, {}",
+            members.len(),
+            match &index {
+                Some(index) => format!("ownership index of {} paths", index.owners.len()),
+                None => "probing".to_string(),
+            }
+        );
+        Ok(UnionBackend {
+            members,
+            index,
+            parents: RwLock::default(),
+        })
     }
 
     /// The members in precedence order (lowest first).
@@ -46,20 +180,79 @@ impl UnionBackend {
         &self.members
     }
 
-    /// Highest-precedence-first lookup: the first member holding an entry
-    /// at `path` answers for the union.
-    fn first_answer<T>(
+    /// True when lookups go through the ownership index.
+    pub fn is_indexed(&self) -> bool {
+        self.index.is_some()
+    }
+
+    /// The first answer to `op` for `path`: from its owner in the
+    /// ownership index, else (probing) from the highest member that is
+    /// not shadowed there and holds it; ENOENT for a path outside the
+    /// merged tree.
+    fn answer<T>(
         &self,
-        mut probe: impl FnMut(&dyn Backend) -> Result<T, i32>,
+        path: &str,
+        mut op: impl FnMut(&dyn Backend) -> Result<T, i32>,
     ) -> Result<T, i32> {
-        for member in self.members.iter().rev() {
-            match probe(member.as_ref()) {
-                Err(libc::ENOENT) => continue,
+        if let Some(index) = self.index.as_ref().filter(|_| is_canonical(path)) {
+            return match index.owners.get(path) {
+                Some(&(member, _)) => op(self.members[member].as_ref()),
+                None => Err(libc::ENOENT),
+            };
+        }
+        for member in self.unshadowed(path)?.iter().rev() {
+            match op(member.as_ref()) {
+                Err(libc::ENOENT) | Err(libc::ENOTDIR) => continue,
                 answer => return answer,
             }
         }
         Err(libc::ENOENT)
     }
+
+    /// The members that may hold `path` in the merged tree: those above
+    /// the highest member holding a non-directory that one of `path`'s
+    /// parents resolves to (the probe's form of the index walk, which
+    /// never descends below a shadowing file).
+    fn unshadowed(&self, path: &str) -> Result<&[Box<dyn Backend>], i32> {
+        let mut from = 0;
+        for (at, _) in path.match_indices('/') {
+            if let Some((holder, false)) = self.parent(&path[..at])? {
+                from = from.max(holder + 1);
+            }
+        }
+        Ok(&self.members[from..])
+    }
+
+    /// The highest member holding an entry at `parent`, and whether it
+    /// is a directory (memoized in `parents`).
+    fn parent(&self, parent: &str) -> Result<Option<(usize, bool)>, i32> {
+        let known = self
+            .parents
+            .read()
+            .unwrap_or_else(|e| e.into_inner())
+            .get(parent)
+            .copied();
+        if let Some(holder) = known {
+            return Ok(holder);
+        }
+        let mut holder = None;
+        for (i, member) in self.members.iter().enumerate().rev() {
+            match member.stat(parent) {
+                Ok(st) => {
+                    holder = Some((i, st.entry_type == EntryType::Directory));
+                    break;
+                }
+                Err(libc::ENOENT) | Err(libc::ENOTDIR) => continue,
+                Err(e) => return Err(e),
+            }
+        }
+        let mut parents = self.parents.write().unwrap_or_else(|e| e.into_inner());
+        if parents.len() >= PARENT_MEMO_MAX {
+            parents.clear();
+        }
+        parents.insert(parent.to_string(), holder);
+        Ok(holder)
+    }
 }
 
 impl Backend for UnionBackend {
@@ -68,14 +261,21 @@ impl Backend for UnionBackend {
     }
 
     fn stat(&self, path: &str) -> Result<RawStat, i32> {
-        self.first_answer(|m| m.stat(path))
+        self.answer(path, |m| m.stat(path))
     }
 
     fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
-        self.first_answer(|m| m.pread(path, buf, offset))
+        self.answer(path, |m| m.pread(path, buf, offset))
     }
 
     fn read_dir(&self, path: &str) -> Result<Vec<RawDirEntry>, i32> {
+        if let Some(index) = self.index.as_ref().filter(|_| is_canonical(path)) {
+            return match index.dirs.get(path) {
+                Some(listing) => Ok(listing.clone()),
+                None if index.owners.contains_key(path) => Err(libc::ENOTDIR),
+                None => Err(libc::ENOENT),
+            };
+        }
         // The highest member holding ANYTHING at `path` decides the type
         // (the stat rule): a shadowing file there makes the union answer
         // ENOTDIR even when lower members hold a directory. Once the
@@ -83,7 +283,7 @@ impl Backend for UnionBackend {
         // merges beneath it — first-seen (highest) wins a name conflict.
         let mut out: Vec<RawDirEntry> = Vec::new();
         let mut decided = false;
-        for member in self.members.iter().rev() {
+        for member in self.unshadowed(path)?.iter().rev() {
             match member.read_dir(path) {
                 Ok(entries) => {
                     decided = true;
@@ -97,6 +297,9 @@ impl Backend for UnionBackend {
                 // A shadowed non-directory (a lower file beneath a
                 // directory above) contributes nothing.
                 Err(libc::ENOTDIR) if decided => continue,
+                // ENOTDIR for a file on the way (not at `path`): this
+                // member holds nothing here.
+                Err(libc::ENOTDIR) if member.stat(path).is_err() => continue,
                 // The highest answer being a non-directory is definitive
                 // (a shadowing file → ENOTDIR); every other error
                 // propagates — never a silent merge over a bad member.
@@ -114,14 +317,13 @@ impl Backend for UnionBackend {
         // Same shadowing rule as reads: the highest member holding the
         // entry answers (a member without link support answers ENOTSUP —
         // definitive for the entry it holds, exactly like COW).
-        self.first_answer(|m| m.read_link(path))
+        self.answer(path, |m| m.read_link(path))
     }
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::backend::EntryType;
     use crate::backends_tar::{TarBackend, TarCompression};
     use crate::context::context;
     use crate::mount;
@@ -287,6 +489,251 @@ mod tests {
         assert!(union.members()[0].writable().is_none());
     }
 
+    // ---------------------------------------------------------------
+    // The ownership index
+    // ---------------------------------------------------------------
+
+    /// A member counting the lookups that reach it.
+    struct Counted {
+        inner: Box<dyn Backend>,
+        calls: std::sync::Arc<std::sync::atomic::AtomicUsize>,
+    }
+
+    impl Counted {
+        fn tick(&self) {
+            self.calls
+                .fetch_add(1, std::sync::atomic::Ordering::Relaxed);
+        }
+    }
+
+    impl Backend for Counted {
+        fn name(&self) -> &'static CStr {
+            c"COUNTED"
+        }
+
+        fn stat(&self, path: &str) -> Result<RawStat, i32> {
+            self.tick();
+            self.inner.stat(path)
+        }
+
+        fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
+            self.tick();
+            self.inner.pread(path, buf, offset)
+        }
+
+        fn read_dir(&self, path: &str) -> Result<Vec<RawDirEntry>, i32> {
+            self.tick();
+            self.inner.read_dir(path)
+        }
+    }
+
+    /// Four overlapping members: shadowed files, merged directories and
+    /// both file-vs-directory conflicts.
+    fn layered() -> Vec<Box<dyn Backend>> {
+        vec![
+            member(&[
+                ("lib/ruby/a.rb", b"env a\n" as &[u8]),
+                ("lib/ruby/b.rb", b"env b\n"),
+                ("x/inside.rb", b"inside\n"),
+                ("y", b"env file y\n"),
+            ]),
+            member(&[("lib/ruby/b.rb", b"runtime b\n"), ("bin/ruby", b"ELF")]),
+            member(&[("x", b"app file x\n"), ("app/main.rb", b"main\n")]),
+            member(&[("y/dep.rb", b"dep\n"), ("lib/ruby/gems/g.rb", b"g\n")]),
+        ]
+    }
+
+    #[test]
+    fn union_index_answers_like_the_probe() {
+        let indexed = UnionBackend::with_index_limit(layered(), DEFAULT_INDEX_LIMIT).unwrap();
+        let probing = UnionBackend::with_index_limit(layered(), 0).unwrap();
+        assert!(indexed.is_indexed());
+        assert!(!probing.is_indexed());
+        for path in [
+            "",
+            "lib",
+            "lib/ruby",
+            "lib/ruby/a.rb",
+            "lib/ruby/b.rb",
+            "lib/ruby/gems",
+            "lib/ruby/gems/g.rb",
+            "bin/ruby",
+            "x",
+            "x/inside.rb",
+            "x/nope",
+            "y",
+            "y/dep.rb",
+            "app",
+            "app/main.rb",
+            "nope",
+            "lib/nope",
+            "/lib",
+            "lib/",
+            "lib//ruby",
+        ] {
+            assert_eq!(indexed.stat(path), probing.stat(path), "stat {path:?}");
+            let sorted = |b: &UnionBackend| {
+                b.read_dir(path).map(|mut v| {
+                    v.sort_by(|l, r| l.name.cmp(&r.name));
+                    v
+                })
+            };
+            assert_eq!(sorted(&indexed), sorted(&probing), "read_dir {path:?}");
+            let (mut a, mut b) = ([0u8; 32], [0u8; 32]);
+            assert_eq!(
+                indexed.pread(path, &mut a, 0),
+                probing.pread(path, &mut b, 0),
+                "pread {path:?}"
+            );
+            assert_eq!(a, b, "pread {path:?}");
+        }
+        // Nothing below a shadowing file, indexed or probed.
+        for union in [&indexed, &probing] {
+            assert_eq!(union.stat("x/inside.rb").unwrap_err(), libc::ENOENT);
+        }
+    }
+
+    #[test]
+    fn union_index_costs_one_member_lookup() {
+        let calls: Vec<_> = (0..4)
+            .map(|_| std::sync::Arc::new(std::sync::atomic::AtomicUsize::new(0)))
+            .collect();
+        let members = layered()
+            .into_iter()
+            .zip(&calls)
+            .map(|(inner, calls)| {
+                Box::new(Counted {
+                    inner,
+                    calls: calls.clone(),
+                }) as Box<dyn Backend>
+            })
+            .collect();
+        let union = UnionBackend::with_index_limit(members, DEFAULT_INDEX_LIMIT).unwrap();
+        let total = || -> usize {
+            calls
+                .iter()
+                .map(|c| c.swap(0, std::sync::atomic::Ordering::Relaxed))
+                .sum()
+        };
+        total(); // the mount-time walk
+
+        // The lowest member's file: one call, into its owner.
+        assert_eq!(pread_all(&union, "lib/ruby/a.rb"), b"env a\n");
+        assert_eq!(total(), 2, "one stat + one pread");
+        assert_eq!(calls[0].load(std::sync::atomic::Ordering::Relaxed), 0);
+        // A miss and a readdir reach no member.
+        assert_eq!(union.stat("lib/ruby/nope.rb").unwrap_err(), libc::ENOENT);
+        assert_eq!(names(&union, "lib/ruby"), ["a.rb", "b.rb", "gems"]);
+        assert_eq!(total(), 0);
+    }
+
+    #[test]
+    fn a_warm_probe_costs_a_first_answer_walk() {
+        let calls: Vec<_> = (0..4)
+            .map(|_| std::sync::Arc::new(std::sync::atomic::AtomicUsize::new(0)))
+            .collect();
+        let members = layered()
+            .into_iter()
+            .zip(&calls)
+            .map(|(inner, calls)| {
+                Box::new(Counted {
+                    inner,
+                    calls: calls.clone(),
+                }) as Box<dyn Backend>
+            })
+            .collect();
+        let union = UnionBackend::with_index_limit(members, 0).unwrap();
+        let total = || -> usize {
+            calls
+                .iter()
+                .map(|c| c.swap(0, std::sync::atomic::Ordering::Relaxed))
+                .sum()
+        };
+        assert_eq!(pread_all(&union, "lib/ruby/a.rb"), b"env a\n");
+        total(); // the parents' first resolution
+        assert_eq!(pread_all(&union, "lib/ruby/a.rb"), b"env a\n");
+        assert_eq!(
+            total(),
+            8,
+            "four members asked for the stat, four for the pread"
+        );
+        // Below a shadowing file only the members above it are asked.
+        assert_eq!(union.stat("x/inside.rb").unwrap_err(), libc::ENOENT);
+        total();
+        assert_eq!(union.stat("x/inside.rb").unwrap_err(), libc::ENOENT);
+        assert_eq!(total(), 1);
+    }
+
+    /// A member answering ENOTDIR below its own files, as a host
+    /// directory does (the tar members answer ENOENT).
+    struct Strict(Box<dyn Backend>);
+
+    impl Strict {
+        fn check(&self, path: &str) -> Result<(), i32> {
+            for (at, _) in path.match_indices('/') {
+                match self.0.stat(&path[..at]) {
+                    Ok(st) if st.entry_type != EntryType::Directory => return Err(libc::ENOTDIR),
+                    _ => {}
+                }
+            }
+            Ok(())
+        }
+    }
+
+    impl Backend for Strict {
+        fn name(&self) -> &'static CStr {
+            c"STRICT"
+        }
+
+        fn stat(&self, path: &str) -> Result<RawStat, i32> {
+            self.check(path)?;
+            self.0.stat(path)
+        }
+
+        fn pread(&self, path: &str, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
+            self.check(path)?;
+            self.0.pread(path, buf, offset)
+        }
+
+        fn read_dir(&self, path: &str) -> Result<Vec<RawDirEntry>, i32> {
+            self.check(path)?;
+            self.0.read_dir(path)
+        }
+    }
+
+    #[test]
+    fn enotdir_from_a_shadowed_file_is_not_an_answer() {
+        // q: a directory on top, a file in the middle, a directory below.
+        let members = || -> Vec<Box<dyn Backend>> {
+            vec![
+                Box::new(Strict(member(&[("q/low.rb", b"low\n" as &[u8])]))),
+                Box::new(Strict(member(&[("q", b"file q\n")]))),
+                Box::new(Strict(member(&[("q/top.rb", b"top\n")]))),
+            ]
+        };
+        let indexed = UnionBackend::with_index_limit(members(), DEFAULT_INDEX_LIMIT).unwrap();
+        let probing = UnionBackend::with_index_limit(members(), 0).unwrap();
+        assert!(indexed.is_indexed());
+        for union in [&indexed, &probing] {
+            assert_eq!(pread_all(union, "q/low.rb"), b"low\n");
+            assert_eq!(pread_all(union, "q/top.rb"), b"top\n");
+            assert_eq!(names(union, "q"), ["low.rb", "top.rb"]);
+            assert_eq!(union.stat("q/nope").unwrap_err(), libc::ENOENT);
+            assert_eq!(union.read_dir("q/nope").unwrap_err(), libc::ENOENT);
+        }
+    }
+
+    #[test]
+    fn union_index_falls_back_to_probing_past_its_cap() {
+        // 13 entries in the merged tree.
+        let union = UnionBackend::with_index_limit(layered(), 12).unwrap();
+        assert!(!union.is_indexed());
+        assert_eq!(pread_all(&union, "lib/ruby/b.rb"), b"runtime b\n");
+        assert!(UnionBackend::with_index_limit(layered(), 13)
+            .unwrap()
+            .is_indexed());
+    }
+
     // ---------------------------------------------------------------
     // The context wiring (spec 17 §1): a union mount onto an occupied
     // point merges over the incumbent; the incumbent keeps its handle.
@@ -1,5 +1,5 @@
 //! ZIP backend via the pure-Rust `zip` crate (see Cargo.toml for why not
-//! libzip-sys). Read-only, whole-archive name index built at mount time.
+//! libzip-sys). Read-only, whole-archive entry table built at mount time.
 //!
 //! Semantics mirrored from the C++ `ZipBackend` (verified against the
 //! tebakofs oracle):
@@ -12,108 +12,347 @@
 //!   (exactly the C++ behavior; real fixtures carry explicit entries).
 //! - mtime comes from the entry's DOS timestamp (interpreted as UTC — see
 //!   `dos_to_unix`; contract tests do not compare mtimes)
+//!
+//! ## Name index
+//!
+//! Lookups never scan the entry table. One mount-time pass over the
+//! central directory builds a [`NameIndex`]: hashed file-name and
+//! explicit-directory tables, the set of every path that has something
+//! beneath it (`has_entry_or_children`), and each listable directory's
+//! children in archive order, already deduplicated. A jar's classpath
+//! scan (tens of thousands of entries, a stat and a listing per package)
+//! then costs one hash probe per call instead of a pass over every name.
+//!
+//! ## Random access
+//!
+//! The `zip` crate is used at mount only: its central-directory parse
+//! yields each entry's size, method and data offset, and the archive
+//! object is then dropped. Reads go straight to the bytes:
+//! - **STORED** entries are positioned reads of the archive (no lock, no
+//!   copy beyond the caller's buffer). A region mount (a payload slot of
+//!   a packaged executable) reads through a mapping of just that region
+//!   ([`ImageBytes`]), never a heap copy of it.
+//! - **DEFLATE** entries resume from the nearest inflate checkpoint — the
+//!   zran pattern `backends_tar` uses for tar.gz: a cloned miniz_oxide
+//!   `InflateState` snapshotted every [`CHECKPOINT_SPACING`] uncompressed
+//!   bytes, captured lazily as reads first pass that point (≈ 43 KiB
+//!   each, capped at [`MAX_CHECKPOINTS`] per entry). A small pool of
+//!   parked cursors ([`CURSOR_POOL`]) lets a sequential reader (8 KiB
+//!   chunks from `extract_file` or the preload mmap fill) continue where
+//!   its previous call stopped, so a whole-entry read is O(n).
+//! - Any other method (or an encrypted entry) fails pread with EIO, as
+//!   the crate's own reader did.
+//!
+//! Concurrent preads never share a decompressor: a cursor is taken out of
+//! the pool for the duration of one call, and the per-entry checkpoint
+//! lists are locked only to look up or append a snapshot.
 
+use std::collections::{HashMap, HashSet};
 use std::fs::File;
-use std::io::{self, Cursor, Read, Seek};
+use std::io::{Cursor, Read, Seek};
 use std::sync::Mutex;
 
-use zip::ZipArchive;
+use miniz_oxide::inflate::stream::{inflate, InflateState};
+use miniz_oxide::{DataFormat, MZFlush, MZStatus};
+use zip::{CompressionMethod, ZipArchive};
 
 use crate::backend::{Backend, EntryType, RawDirEntry, RawStat};
+use crate::image_bytes::ImageBytes;
+
+/// Compressed bytes fed to inflate per source read.
+const IO_CHUNK: usize = 64 * 1024;
+/// Uncompressed bytes between two inflate checkpoints of one entry.
+const CHECKPOINT_SPACING: u64 = 4 * 1024 * 1024;
+/// Checkpoint cap per entry (a 4 GiB entry at the default spacing).
+const MAX_CHECKPOINTS: usize = 1024;
+/// Parked inflate cursors kept across preads, backend-wide.
+const CURSOR_POOL: usize = 16;
 
-/// Reader source for the archive: a file on disk or an in-memory image.
+/// The archive bytes, addressed by absolute offset.
 enum ZipSource {
-    File(File),
-    Memory(Cursor<Vec<u8>>),
+    File {
+        file: File,
+        /// Serializes seek+read on platforms without positioned reads.
+        #[cfg_attr(unix, allow(dead_code))]
+        seek_lock: Mutex<()>,
+    },
+    /// A file-region mapping or an owned buffer.
+    Image(ImageBytes),
 }
 
-impl Read for ZipSource {
-    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+impl ZipSource {
+    fn read_exact_at(&self, offset: u64, buf: &mut [u8]) -> Result<(), i32> {
         match self {
-            ZipSource::File(f) => f.read(buf),
-            ZipSource::Memory(c) => c.read(buf),
+            ZipSource::Image(data) => {
+                let end = offset.checked_add(buf.len() as u64).ok_or(libc::EINVAL)?;
+                if end > data.len() as u64 {
+                    return Err(libc::EIO);
+                }
+                let start = offset as usize;
+                buf.copy_from_slice(&data[start..start + buf.len()]);
+                Ok(())
+            }
+            #[cfg(unix)]
+            ZipSource::File { file, .. } => {
+                use std::os::unix::fs::FileExt as _;
+                file.read_exact_at(buf, offset).map_err(|_| libc::EIO)
+            }
+            #[cfg(not(unix))]
+            ZipSource::File { file, seek_lock } => {
+                let _guard = seek_lock.lock().map_err(|_| libc::EIO)?;
+                (&*file)
+                    .seek(std::io::SeekFrom::Start(offset))
+                    .map_err(|_| libc::EIO)?;
+                (&*file).read_exact(buf).map_err(|_| libc::EIO)
+            }
         }
     }
 }
 
-impl Seek for ZipSource {
-    fn seek(&mut self, pos: io::SeekFrom) -> io::Result<u64> {
-        match self {
-            ZipSource::File(f) => f.seek(pos),
-            ZipSource::Memory(c) => c.seek(pos),
+/// How an entry's bytes are stored.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Method {
+    Stored,
+    Deflated,
+    /// Anything the backend cannot decode (other methods, encryption).
+    Unreadable,
+}
+
+/// One archive entry, as indexed at mount.
+struct ZipEntry {
+    name: String,
+    /// Uncompressed size.
+    size: u64,
+    /// Compressed size (the extent at `data_start`).
+    compressed_size: u64,
+    /// Absolute archive offset of the entry's data.
+    data_start: u64,
+    method: Method,
+    modified: Option<zip::DateTime>,
+    /// Inflate snapshots (DEFLATE only; sorted by `u_offset`, captured
+    /// lazily — the implicit first checkpoint is the fresh state at 0).
+    checkpoints: Mutex<Vec<Checkpoint>>,
+}
+
+/// A resumable point in an entry's deflate stream, captured at an input
+/// boundary (every fed byte consumed, so `c_offset` is exact).
+struct Checkpoint {
+    u_offset: u64,
+    /// Compressed bytes consumed, relative to `data_start`.
+    c_offset: u64,
+    state: Box<InflateState>,
+}
+
+/// A live inflate cursor over one entry.
+struct Inflater {
+    /// The entry index the cursor decodes.
+    index: usize,
+    state: Box<InflateState>,
+    in_buf: Vec<u8>,
+    in_pos: usize,
+    in_len: usize,
+    /// Compressed bytes loaded into `in_buf` so far (relative).
+    c_read: u64,
+    /// Uncompressed bytes produced so far.
+    u_pos: u64,
+    /// Deflate StreamEnd reached.
+    done: bool,
+}
+
+impl Inflater {
+    fn new(
+        index: usize,
+        state: Box<InflateState>,
+        c_offset: u64,
+        u_offset: u64,
+        io_chunk: usize,
+    ) -> Self {
+        Inflater {
+            index,
+            state,
+            in_buf: vec![0u8; io_chunk],
+            in_pos: 0,
+            in_len: 0,
+            c_read: c_offset,
+            u_pos: u_offset,
+            done: false,
         }
     }
 }
 
+/// The mount-time name tables (see "Name index" in the module docs).
+/// Every rule reproduces what the former linear scans answered, so the
+/// explicit-entry-only semantics are unchanged: the first entry of a
+/// duplicated name wins, and no implicit parent is ever listed.
+#[derive(Default)]
+struct NameIndex {
+    /// File entry name (no trailing `/`) → entry index.
+    files: HashMap<String, usize>,
+    /// Explicit directory entry `name/`, keyed by `name` → entry index.
+    dirs: HashMap<String, usize>,
+    /// Every proper `/`-prefix of an entry name: the paths with content
+    /// below them, explicit or not.
+    parents: HashSet<String>,
+    /// Listable directory ("" = root) → its explicit direct children.
+    children: HashMap<String, Vec<RawDirEntry>>,
+}
+
+impl NameIndex {
+    fn build(entries: &[ZipEntry]) -> NameIndex {
+        let mut index = NameIndex::default();
+        // (parent, child) pairs already listed — a file and a directory
+        // entry of the same name list once, as whichever came first.
+        let mut listed: HashSet<(&str, &str)> = HashSet::new();
+        for (i, entry) in entries.iter().enumerate() {
+            let name = entry.name.as_str();
+            for (at, _) in name.match_indices('/') {
+                if at > 0 && !index.parents.contains(&name[..at]) {
+                    index.parents.insert(name[..at].to_string());
+                }
+            }
+            let (path, is_dir) = match name.strip_suffix('/') {
+                Some(dir) => {
+                    index.dirs.entry(dir.to_string()).or_insert(i);
+                    (dir, true)
+                }
+                None => {
+                    index.files.entry(name.to_string()).or_insert(i);
+                    (name, false)
+                }
+            };
+            // The listing that shows this entry: the root for a bare
+            // name, else the text before the last '/'. An empty parent
+            // behind a slash ("/x", "a//") is no listable directory.
+            let (parent, child) = match path.rfind('/') {
+                None => ("", path),
+                Some(0) => continue,
+                Some(at) => (&path[..at], &path[at + 1..]),
+            };
+            if child.is_empty() || !listed.insert((parent, child)) {
+                continue;
+            }
+            index
+                .children
+                .entry(parent.to_string())
+                .or_default()
+                .push(RawDirEntry {
+                    name: child.to_string(),
+                    is_dir,
+                });
+        }
+        index
+    }
+}
+
 /// Mounted ZIP archive.
 pub struct ZipBackend {
-    archive: Mutex<ZipArchive<ZipSource>>,
-    /// Entry names, in archive order (index built once at mount).
-    names: Vec<String>,
+    source: ZipSource,
+    /// Entries, in archive order (indexed once at mount).
+    entries: Vec<ZipEntry>,
+    names: NameIndex,
+    /// Parked cursors, most recently used last.
+    cursors: Mutex<Vec<Inflater>>,
+    /// Checkpoint spacing and input chunk (tests shrink them to exercise
+    /// the resume machinery on small entries).
+    spacing: u64,
+    io_chunk: usize,
 }
 
 impl ZipBackend {
     /// Open a ZIP archive from a file on disk.
     pub fn from_file(file: File) -> Result<ZipBackend, i32> {
-        Self::open(ZipSource::File(file))
+        let (file, entries) = Self::index(file)?;
+        Ok(Self::with_entries(
+            ZipSource::File {
+                file,
+                seek_lock: Mutex::new(()),
+            },
+            entries,
+        ))
     }
 
     /// Open a ZIP archive from an in-memory image (owned).
     pub fn from_memory(data: Vec<u8>) -> Result<ZipBackend, i32> {
-        Self::open(ZipSource::Memory(Cursor::new(data)))
+        Self::from_bytes(ImageBytes::from(data))
+    }
+
+    /// Open a ZIP archive over `data` — a file-region mapping (a payload
+    /// slot of a packaged executable, served in place) or an owned
+    /// buffer.
+    pub fn from_bytes(data: ImageBytes) -> Result<ZipBackend, i32> {
+        let (_, entries) = Self::index(Cursor::new(&data[..]))?;
+        Ok(Self::with_entries(ZipSource::Image(data), entries))
     }
 
-    fn open(source: ZipSource) -> Result<ZipBackend, i32> {
-        let mut archive = ZipArchive::new(source).map_err(|_| libc::EINVAL)?;
-        let mut names = Vec::with_capacity(archive.len());
+    fn with_entries(source: ZipSource, entries: Vec<ZipEntry>) -> ZipBackend {
+        ZipBackend {
+            source,
+            names: NameIndex::build(&entries),
+            entries,
+            cursors: Mutex::new(Vec::new()),
+            spacing: CHECKPOINT_SPACING,
+            io_chunk: IO_CHUNK,
+        }
+    }
+
+    /// Parse the central directory and resolve every entry's data offset;
+    /// hands the reader back for the positioned-read phase.
+    fn index<R: Read + Seek>(reader: R) -> Result<(R, Vec<ZipEntry>), i32> {
+        let mut archive = ZipArchive::new(reader).map_err(|_| libc::EINVAL)?;
+        let mut entries = Vec::with_capacity(archive.len());
         for i in 0..archive.len() {
-            let entry = archive.by_index(i).map_err(|_| libc::EINVAL)?;
-            names.push(entry.name().to_string());
+            let entry = archive.by_index_raw(i).map_err(|_| libc::EINVAL)?;
+            let method = match entry.compression() {
+                _ if entry.encrypted() => Method::Unreadable,
+                CompressionMethod::Stored => Method::Stored,
+                CompressionMethod::Deflated => Method::Deflated,
+                _ => Method::Unreadable,
+            };
+            entries.push(ZipEntry {
+                name: entry.name().to_string(),
+                size: entry.size(),
+                compressed_size: entry.compressed_size(),
+                data_start: entry.data_start(),
+                method,
+                modified: entry.last_modified(),
+                checkpoints: Mutex::new(Vec::new()),
+            });
         }
-        Ok(ZipBackend {
-            archive: Mutex::new(archive),
-            names,
-        })
+        Ok((archive.into_inner(), entries))
     }
 
     /// The raw entry named `path`, if present.
     fn find_file(&self, path: &str) -> Option<usize> {
-        self.names
-            .iter()
-            .position(|n| n.trim_end_matches('/') == path && !n.ends_with('/'))
+        self.names.files.get(path).copied()
     }
 
     /// The explicit directory entry `path/` (C++ zip semantics: only
     /// explicit entries make a non-root directory addressable through the
     /// C ABI — implicit parents of deeper entries are NOT synthesized).
     fn find_explicit_dir(&self, path: &str) -> Option<usize> {
-        let want = format!("{path}/");
-        self.names.iter().position(|n| *n == want)
+        self.names.dirs.get(path).copied()
     }
 
     /// stat helper for a found file entry.
-    fn stat_file(&self, index: usize) -> Result<RawStat, i32> {
-        let mut archive = self.archive.lock().map_err(|_| libc::EIO)?;
-        let entry = archive.by_index(index).map_err(|_| libc::EIO)?;
-        Ok(RawStat {
+    fn stat_file(&self, index: usize) -> RawStat {
+        let entry = &self.entries[index];
+        RawStat {
             entry_type: EntryType::File,
             perms: 0o644,
-            size: entry.size() as i64,
-            mtime: entry.last_modified().map(dos_to_unix).unwrap_or(0),
-        })
+            size: entry.size as i64,
+            mtime: entry.modified.map(dos_to_unix).unwrap_or(0),
+        }
     }
 
     /// stat helper for an explicit directory entry (the dir entry carries
     /// its own DOS timestamp, like the C++ zip iterator reports).
-    fn stat_explicit_dir(&self, index: usize) -> Result<RawStat, i32> {
-        let mut archive = self.archive.lock().map_err(|_| libc::EIO)?;
-        let entry = archive.by_index(index).map_err(|_| libc::EIO)?;
-        Ok(RawStat {
+    fn stat_explicit_dir(&self, index: usize) -> RawStat {
+        RawStat {
             entry_type: EntryType::Directory,
             perms: 0o755,
             size: 0,
-            mtime: entry.last_modified().map(dos_to_unix).unwrap_or(0),
-        })
+            mtime: self.entries[index].modified.map(dos_to_unix).unwrap_or(0),
+        }
     }
 
     fn stat_root() -> RawStat {
@@ -124,6 +363,119 @@ impl ZipBackend {
             mtime: 0,
         }
     }
+
+    /// Read `buf` fully at uncompressed offset `target` of DEFLATE entry
+    /// `index`: continue a parked cursor when it sits at or before the
+    /// target and no checkpoint is closer, else resume at the nearest
+    /// checkpoint (or the entry start).
+    fn inflate_at(&self, index: usize, target: u64, buf: &mut [u8]) -> Result<(), i32> {
+        let entry = &self.entries[index];
+        let parked = {
+            let mut pool = self.cursors.lock().map_err(|_| libc::EIO)?;
+            pool.iter()
+                .rposition(|c| c.index == index && !c.done && c.u_pos <= target)
+                .map(|i| pool.remove(i))
+        };
+        let nearest = {
+            let cps = entry.checkpoints.lock().map_err(|_| libc::EIO)?;
+            let idx = cps.partition_point(|cp| cp.u_offset <= target);
+            idx.checked_sub(1)
+                .map(|i| (cps[i].u_offset, cps[i].c_offset, cps[i].state.clone()))
+        };
+        let from = nearest.as_ref().map_or(0, |n| n.0);
+        let mut cur = match parked {
+            Some(cur) if cur.u_pos >= from => cur,
+            _ => match nearest {
+                Some((u, c, state)) => Inflater::new(index, state, c, u, self.io_chunk),
+                None => Inflater::new(
+                    index,
+                    InflateState::new_boxed(DataFormat::Raw),
+                    0,
+                    0,
+                    self.io_chunk,
+                ),
+            },
+        };
+        let mut scratch = [0u8; 16 * 1024];
+        while cur.u_pos < target {
+            let want = ((target - cur.u_pos) as usize).min(scratch.len());
+            if self.pump(entry, &mut cur, &mut scratch[..want])? == 0 {
+                return Err(libc::EIO);
+            }
+        }
+        let mut got = 0usize;
+        while got < buf.len() {
+            let n = self.pump(entry, &mut cur, &mut buf[got..])?;
+            if n == 0 {
+                return Err(libc::EIO);
+            }
+            got += n;
+        }
+        if !cur.done && cur.u_pos < entry.size {
+            let mut pool = self.cursors.lock().map_err(|_| libc::EIO)?;
+            if pool.len() >= CURSOR_POOL {
+                pool.remove(0);
+            }
+            pool.push(cur);
+        }
+        Ok(())
+    }
+
+    /// Inflate into `out`, returning the bytes written (< `out.len()`
+    /// only at stream end); snapshots a checkpoint at each input boundary
+    /// a spacing past the entry's last one. EIO on a corrupt or truncated
+    /// stream.
+    fn pump(&self, entry: &ZipEntry, cur: &mut Inflater, mut out: &mut [u8]) -> Result<usize, i32> {
+        let mut written = 0usize;
+        while !out.is_empty() && !cur.done {
+            let left = entry.compressed_size.saturating_sub(cur.c_read);
+            if cur.in_pos == cur.in_len && left > 0 {
+                self.maybe_checkpoint(entry, cur)?;
+                let n = (left as usize).min(cur.in_buf.len());
+                self.source
+                    .read_exact_at(entry.data_start + cur.c_read, &mut cur.in_buf[..n])?;
+                cur.c_read += n as u64;
+                cur.in_pos = 0;
+                cur.in_len = n;
+            }
+            // With the input exhausted, inflate still drains the output
+            // the state holds (a checkpoint near the end resumes there);
+            // no progress then means the data ended before StreamEnd.
+            let res = inflate(
+                &mut cur.state,
+                &cur.in_buf[cur.in_pos..cur.in_len],
+                out,
+                MZFlush::None,
+            );
+            cur.in_pos += res.bytes_consumed;
+            let status = res.status.map_err(|_| libc::EIO)?;
+            cur.u_pos += res.bytes_written as u64;
+            written += res.bytes_written;
+            out = &mut out[res.bytes_written..];
+            if status == MZStatus::StreamEnd {
+                cur.done = true;
+            } else if res.bytes_consumed == 0 && res.bytes_written == 0 {
+                return Err(libc::EIO); // stalled: corrupt or truncated
+            }
+        }
+        Ok(written)
+    }
+
+    fn maybe_checkpoint(&self, entry: &ZipEntry, cur: &Inflater) -> Result<(), i32> {
+        if cur.u_pos < self.spacing {
+            return Ok(());
+        }
+        let mut cps = entry.checkpoints.lock().map_err(|_| libc::EIO)?;
+        let last = cps.last().map_or(0, |cp| cp.u_offset);
+        if cur.u_pos >= last + self.spacing && cps.len() < MAX_CHECKPOINTS {
+            cps.push(Checkpoint {
+                u_offset: cur.u_pos,
+                c_offset: cur.c_read,
+                state: cur.state.clone(),
+            });
+        }
+        Ok(())
+    }
 }
 
 /// Normalize an in-image path: no leading or trailing `/`, `""` for root.
@@ -141,10 +493,9 @@ impl Backend for ZipBackend {
         if path.is_empty() {
             return true; // the root always holds
         }
-        let prefix = format!("{path}/");
-        self.names
-            .iter()
-            .any(|n| n.trim_end_matches('/') == path || n.starts_with(&prefix))
+        self.names.files.contains_key(path)
+            || self.names.dirs.contains_key(path)
+            || self.names.parents.contains(path)
     }
 
     fn stat(&self, path: &str) -> Result<RawStat, i32> {
@@ -153,12 +504,12 @@ impl Backend for ZipBackend {
             return Ok(Self::stat_root());
         }
         if let Some(index) = self.find_file(path) {
-            return self.stat_file(index);
+            return Ok(self.stat_file(index));
         }
         // C++ semantics: a directory stats only via its explicit "path/"
         // entry (exists() is explicit-only through the C ABI).
         if let Some(index) = self.find_explicit_dir(path) {
-            return self.stat_explicit_dir(index);
+            return Ok(self.stat_explicit_dir(index));
         }
         Err(libc::ENOENT)
     }
@@ -172,20 +523,23 @@ impl Backend for ZipBackend {
                 libc::ENOENT
             });
         };
-        let mut archive = self.archive.lock().map_err(|_| libc::EIO)?;
-        let mut entry = archive.by_index(index).map_err(|_| libc::EIO)?;
-
-        let size = entry.size();
+        let entry = &self.entries[index];
+        let size = entry.size;
         if offset >= size || buf.is_empty() {
             return Ok(0);
         }
-        // v1: read through the entry sequentially up to the wanted window
-        // (zip entries are deflate streams; random access needs decompressing
-        // the prefix anyway).
         let want = std::cmp::min(buf.len() as u64, size - offset) as usize;
-        let mut skip = vec![0u8; offset as usize];
-        entry.read_exact(&mut skip).map_err(|_| libc::EIO)?;
-        entry.read_exact(&mut buf[..want]).map_err(|_| libc::EIO)?;
+        match entry.method {
+            Method::Stored => {
+                if offset + want as u64 > entry.compressed_size {
+                    return Err(libc::EIO); // sizes disagree: corrupt entry
+                }
+                self.source
+                    .read_exact_at(entry.data_start + offset, &mut buf[..want])?;
+            }
+            Method::Deflated => self.inflate_at(index, offset, &mut buf[..want])?,
+            Method::Unreadable => return Err(libc::EIO),
+        }
         Ok(want)
     }
 
@@ -200,45 +554,10 @@ impl Backend for ZipBackend {
                 libc::ENOENT
             });
         }
-        let prefix = if path.is_empty() {
-            String::new()
-        } else {
-            format!("{path}/")
-        };
-        let mut out: Vec<RawDirEntry> = Vec::new();
-        for name in &self.names {
-            let Some(rest) = name.strip_prefix(&prefix) else {
-                continue;
-            };
-            if rest.is_empty() {
-                continue; // the directory's own entry
-            }
-            // C++ zip iterator semantics: yield only EXPLICIT entries at
-            // this level — files (no '/'), and directories only via their
-            // trailing-slash entry ("name/"). Deeper content is skipped;
-            // implicit parents are never synthesized.
-            match rest.find('/') {
-                None => {
-                    if !out.iter().any(|e| e.name == rest) {
-                        out.push(RawDirEntry {
-                            name: rest.to_string(),
-                            is_dir: false,
-                        });
-                    }
-                }
-                Some(i) if i == rest.len() - 1 => {
-                    let child = &rest[..i];
-                    if !child.is_empty() && !out.iter().any(|e| e.name == child) {
-                        out.push(RawDirEntry {
-                            name: child.to_string(),
-                            is_dir: true,
-                        });
-                    }
-                }
-                _ => continue,
-            }
-        }
-        Ok(out)
+        // C++ zip iterator semantics: only EXPLICIT entries at this level
+        // — files, and directories via their trailing-slash entry. Deeper
+        // content is skipped; implicit parents are never synthesized.
+        Ok(self.names.children.get(path).cloned().unwrap_or_default())
     }
 }
 
@@ -289,6 +608,189 @@ fn dos_to_unix(dt: zip::DateTime) -> i64 {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use std::io::Write as _;
+
+    /// Half text (real deflate blocks), half noise (stored-style blocks),
+    /// interleaved every 4 KiB so both block kinds straddle checkpoints.
+    fn mixed_bytes(seed: u64, size: usize) -> Vec<u8> {
+        let mut out = Vec::with_capacity(size + 8);
+        let mut s = seed.wrapping_mul(0x9E37_79B9_7F4A_7C15).wrapping_add(1);
+        while out.len() < size {
+            if (out.len() / 4096) % 2 == 0 {
+                out.extend_from_slice(format!("line {} of entry {seed}\n", out.len()).as_bytes());
+            } else {
+                s ^= s << 13;
+                s ^= s >> 7;
+                s ^= s << 17;
+                out.extend_from_slice(&s.to_le_bytes());
+            }
+        }
+        out.truncate(size);
+        out
+    }
+
+    fn fixture(files: &[(String, Vec<u8>, CompressionMethod)]) -> Vec<u8> {
+        let mut w = zip::ZipWriter::new(Cursor::new(Vec::new()));
+        w.add_directory("d/", zip::write::SimpleFileOptions::default())
+            .unwrap();
+        for (name, data, method) in files {
+            let options = zip::write::SimpleFileOptions::default().compression_method(*method);
+            w.start_file(name.as_str(), options).unwrap();
+            w.write_all(data).unwrap();
+        }
+        w.finish().unwrap().into_inner()
+    }
+
+    fn files() -> Vec<(String, Vec<u8>, CompressionMethod)> {
+        (0..4u64)
+            .map(|i| {
+                let method = if i % 2 == 0 {
+                    CompressionMethod::Deflated
+                } else {
+                    CompressionMethod::Stored
+                };
+                (format!("d/f{i}.bin"), mixed_bytes(i, 300_000), method)
+            })
+            .collect()
+    }
+
+    fn read_all(b: &ZipBackend, path: &str, chunk: usize) -> Vec<u8> {
+        let mut out = Vec::new();
+        let mut buf = vec![0u8; chunk];
+        loop {
+            let n = b.pread(path, &mut buf, out.len() as u64).unwrap();
+            if n == 0 {
+                return out;
+            }
+            out.extend_from_slice(&buf[..n]);
+        }
+    }
+
+    #[test]
+    fn name_index_keeps_explicit_entry_only_semantics() {
+        let mut w = zip::ZipWriter::new(Cursor::new(Vec::new()));
+        let options = zip::write::SimpleFileOptions::default();
+        for name in ["top.txt", "a/", "a/x", "a/deep/y", "b/z"] {
+            if name.ends_with('/') {
+                w.add_directory(name, options).unwrap();
+            } else {
+                w.start_file(name, options).unwrap();
+                w.write_all(name.as_bytes()).unwrap();
+            }
+        }
+        let b = ZipBackend::from_memory(w.finish().unwrap().into_inner()).unwrap();
+        let names = |path: &str| -> Vec<(String, bool)> {
+            b.read_dir(path)
+                .unwrap()
+                .into_iter()
+                .map(|e| (e.name, e.is_dir))
+                .collect()
+        };
+        // Archive order, explicit entries only: "b/" and "a/deep/" have
+        // no entry of their own, so no listing shows them.
+        assert_eq!(names(""), [("top.txt".into(), false), ("a".into(), true)]);
+        assert_eq!(names("/a/"), [("x".into(), false)]);
+        assert_eq!(b.stat("a/deep").err(), Some(libc::ENOENT));
+        assert_eq!(b.read_dir("b").err(), Some(libc::ENOENT));
+        assert_eq!(b.read_dir("top.txt").err(), Some(libc::ENOTDIR));
+        assert_eq!(b.pread("a", &mut [0u8; 4], 0), Err(libc::EISDIR));
+        // ...but the paths holding content still hold.
+        for held in ["", "a", "a/deep", "a/deep/y", "b", "b/z", "top.txt"] {
+            assert!(b.has_entry_or_children(held), "{held}");
+        }
+        for absent in ["a/de", "top", "c", "b/z/w"] {
+            assert!(!b.has_entry_or_children(absent), "{absent}");
+        }
+    }
+
+    #[test]
+    fn region_mounts_read_through_a_mapping_of_the_slot() {
+        let files = files();
+        let image = fixture(&files);
+        let tmp = tempfile::tempdir().unwrap();
+        let path = tmp.path().join("pkg.bin");
+        let mut packaged = vec![0x5Au8; 1000]; // deliberately not page-aligned
+        packaged.extend_from_slice(&image);
+        packaged.extend_from_slice(&[0xA5; 333]); // a trailing slot
+        std::fs::write(&path, &packaged).unwrap();
+
+        let file = File::open(&path).unwrap();
+        let bytes = ImageBytes::map_file(&file, 1000, image.len() as u64).unwrap();
+        drop(file); // the mapping outlives the fd
+        let b = ZipBackend::from_bytes(bytes).expect("mapped open");
+        assert!(matches!(&b.source, ZipSource::Image(img) if img.is_mapped() == cfg!(unix)));
+        for (name, want, _) in &files {
+            assert_eq!(read_all(&b, name, 8192), *want, "{name}");
+        }
+    }
+
+    #[test]
+    fn random_access_over_stored_and_deflated_entries() {
+        let files = files();
+        let mut b = ZipBackend::from_memory(fixture(&files)).unwrap();
+        b.spacing = 16 * 1024; // many checkpoints on a small entry
+        b.io_chunk = 512; // ... at many input boundaries
+        assert_eq!(b.entries[1].method, Method::Deflated);
+        assert_eq!(b.entries[2].method, Method::Stored);
+
+        for (name, want, _) in &files {
+            assert_eq!(b.stat(name).unwrap().size as usize, want.len());
+            assert_eq!(read_all(&b, name, 8192), *want, "sequential read of {name}");
+        }
+        let cps = b.entries[1].checkpoints.lock().unwrap().len();
+        assert!(cps > 10, "expected lazily captured checkpoints, got {cps}");
+        assert!(b.entries[2].checkpoints.lock().unwrap().is_empty());
+
+        // Scattered windows, backwards through every entry: resumes from
+        // checkpoints (and from the entry start) in both directions.
+        for (name, want, _) in files.iter().rev() {
+            for (off, len) in [
+                (299_000usize, 1000usize),
+                (150_001, 777),
+                (5, 40_000),
+                (0, 1),
+            ] {
+                let mut buf = vec![0u8; len];
+                assert_eq!(b.pread(name, &mut buf, off as u64).unwrap(), len);
+                assert_eq!(buf, want[off..off + len], "window {off}+{len} of {name}");
+            }
+            // A read straddling EOF is clamped; at EOF it is empty.
+            let mut buf = vec![0u8; 64];
+            assert_eq!(b.pread(name, &mut buf, 299_990).unwrap(), 10);
+            assert_eq!(b.pread(name, &mut buf, 300_000).unwrap(), 0);
+        }
+        assert_eq!(b.pread("d", &mut [0u8; 4], 0).unwrap_err(), libc::EISDIR);
+    }
+
+    #[test]
+    fn concurrent_readers_of_different_entries_see_their_own_bytes() {
+        let files = files();
+        let b = ZipBackend::from_memory(fixture(&files)).unwrap();
+        std::thread::scope(|s| {
+            for (name, want, _) in &files {
+                let b = &b;
+                s.spawn(move || {
+                    for _ in 0..3 {
+                        assert_eq!(read_all(b, name, 8192), *want, "{name}");
+                    }
+                });
+            }
+        });
+    }
+
+    #[test]
+    fn a_corrupt_deflate_stream_is_eio_never_a_panic() {
+        let files = files();
+        let mut image = fixture(&files);
+        let b = ZipBackend::from_memory(image.clone()).unwrap();
+        let start = b.entries[1].data_start as usize;
+        for byte in &mut image[start..start + 64] {
+            *byte = 0xff;
+        }
+        let b = ZipBackend::from_memory(image).unwrap();
+        let mut buf = vec![0u8; 8192];
+        assert_eq!(b.pread("d/f0.bin", &mut buf, 0).unwrap_err(), libc::EIO);
+    }
 
     /// The platform's mktime reference for the oracle comparison.
     #[cfg(unix)]
@@ -0,0 +1,279 @@
+//! BGZF (the blocked gzip of the SAM/BAM spec §4.1, `bgzip`): a gzip
+//! stream cut into independent members of ≤ 64 KiB, each carrying its own
+//! compressed size in a `BC` extra subfield. Any gzip reader still
+//! decodes it front to back (concatenated members are plain gzip), but a
+//! reader that knows the layout finds every member — and, from each
+//! trailer's ISIZE, its uncompressed extent — from headers alone, then
+//! decodes members independently: random access without checkpoints, and
+//! a decode that spreads across cores.
+//!
+//! ```text
+//! member: [1f 8b 08 04][mtime u32][xfl][os][XLEN u16]
+//!         [42 43][02 00][BSIZE u16]      BC subfield: member size - 1
+//!         [raw deflate][CRC32 u32][ISIZE u32]
+//! ```
+//!
+//! Read side: [`members`] (the tar backend's `tar.gz` mount).
+//! Write side: [`write_bgzf`] (`tfs mkimage --format tar.gz`).
+
+use std::io::{self, Read, Write};
+
+use crate::zstd_seekable::SeekFrame;
+
+/// Largest member the format can describe (BSIZE is a u16 of size - 1).
+const MAX_MEMBER: u64 = 64 * 1024;
+/// Uncompressed bytes per written member: the bgzip value, small enough
+/// that even a stored (incompressible) member fits [`MAX_MEMBER`].
+pub const BLOCK_SIZE: usize = 0xff00;
+/// Fixed header of a written member (the BC subfield is the only extra).
+const HEADER_LEN: usize = 18;
+/// CRC32 + ISIZE.
+const TRAILER_LEN: u64 = 8;
+/// The empty member bgzip appends as an end-of-file marker.
+const EOF_MEMBER: [u8; 28] = [
+    0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, b'B', b'C', 2, 0, 0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0,
+    0, 0,
+];
+
+/// The member table of a `len`-byte BGZF stream read through `read_at`:
+/// each member's raw deflate data located in both address spaces
+/// (`c_offset`/`c_len` span the deflate bytes, not the gzip framing).
+/// `None` when the stream is not BGZF throughout — the first member
+/// lacks a `BC` subfield, or a later one does not tile the stream.
+pub fn members(
+    len: u64,
+    read_at: impl Fn(u64, &mut [u8]) -> Result<(), i32>,
+) -> Option<Vec<SeekFrame>> {
+    let mut frames = Vec::new();
+    let (mut c, mut u) = (0u64, 0u64);
+    while c < len {
+        let mut fixed = [0u8; 12];
+        read_at(c, &mut fixed).ok()?;
+        if fixed[..3] != [0x1f, 0x8b, 8] || fixed[3] & 0x04 == 0 {
+            return None;
+        }
+        let xlen = u64::from(u16::from_le_bytes([fixed[10], fixed[11]]));
+        let mut extra = vec![0u8; xlen as usize];
+        read_at(c + 12, &mut extra).ok()?;
+        let size = bc_subfield(&extra)? + 1;
+        let mut data_at = c + 12 + xlen;
+        // FNAME / FCOMMENT / FHCRC are legal in a member; bgzip never
+        // writes them, so they cost a byte-at-a-time walk only here.
+        for flag in [0x08u8, 0x10] {
+            if fixed[3] & flag != 0 {
+                let mut b = [0xffu8];
+                while b[0] != 0 {
+                    if data_at >= c + size {
+                        return None;
+                    }
+                    read_at(data_at, &mut b).ok()?;
+                    data_at += 1;
+                }
+            }
+        }
+        if fixed[3] & 0x02 != 0 {
+            data_at += 2;
+        }
+        let end = c.checked_add(size)?;
+        if end > len || data_at + TRAILER_LEN > end {
+            return None;
+        }
+        let mut isize = [0u8; 4];
+        read_at(end - 4, &mut isize).ok()?;
+        let u_len = u64::from(u32::from_le_bytes(isize));
+        frames.push(SeekFrame {
+            c_offset: data_at,
+            c_len: end - TRAILER_LEN - data_at,
+            u_offset: u,
+            u_len,
+        });
+        c = end;
+        u += u_len;
+    }
+    Some(frames)
+}
+
+/// The member size - 1 from a gzip extra field's `BC` subfield.
+fn bc_subfield(mut extra: &[u8]) -> Option<u64> {
+    while extra.len() >= 4 {
+        let slen = usize::from(u16::from_le_bytes([extra[2], extra[3]]));
+        let body = extra.get(4..4 + slen)?;
+        if extra[..2] == *b"BC" && slen == 2 {
+            let size = u64::from(u16::from_le_bytes([body[0], body[1]]));
+            return (size < MAX_MEMBER).then_some(size);
+        }
+        extra = &extra[4 + slen..];
+    }
+    None
+}
+
+/// Inflate one member's deflate bytes and check them against the
+/// trailer (`EIO` on a corrupt member, a length or a CRC mismatch).
+pub fn decode_member(deflate: &[u8], trailer: &[u8; 8], u_len: u64) -> Result<Vec<u8>, i32> {
+    let limit = usize::try_from(u_len).map_err(|_| libc::EIO)?;
+    let plain = miniz_oxide::inflate::decompress_to_vec_with_limit(deflate, limit)
+        .map_err(|_| libc::EIO)?;
+    let crc = u32::from_le_bytes(trailer[..4].try_into().expect("4 bytes"));
+    if plain.len() != limit || crc32fast::hash(&plain) != crc {
+        return Err(libc::EIO);
+    }
+    Ok(plain)
+}
+
+/// Worker threads for parallel member coding: `TEBAKO_TFS_GZ_THREADS`
+/// when set (`1` keeps everything on the caller's thread), else the
+/// available parallelism.
+pub fn threads() -> usize {
+    std::env::var("TEBAKO_TFS_GZ_THREADS")
+        .ok()
+        .and_then(|v| v.trim().parse::<usize>().ok())
+        .unwrap_or_else(|| std::thread::available_parallelism().map_or(1, |n| n.get()))
+        .max(1)
+}
+
+/// Map `items` through `f` on up to `threads` scoped threads, keeping
+/// order (contiguous chunks per thread; the first error wins).
+pub fn par_map<T: Sync, R: Send>(
+    items: &[T],
+    threads: usize,
+    f: impl Fn(&T) -> Result<R, i32> + Sync,
+) -> Result<Vec<R>, i32> {
+    let threads = threads.min(items.len()).max(1);
+    if threads == 1 {
+        return items.iter().map(&f).collect();
+    }
+    let per = items.len().div_ceil(threads);
+    std::thread::scope(|s| {
+        let f = &f;
+        let workers: Vec<_> = items
+            .chunks(per)
+            .map(|chunk| s.spawn(move || chunk.iter().map(f).collect::<Result<Vec<R>, i32>>()))
+            .collect();
+        let mut out = Vec::with_capacity(items.len());
+        for worker in workers {
+            out.extend(worker.join().map_err(|_| libc::EIO)??);
+        }
+        Ok(out)
+    })
+}
+
+/// One complete member for `block` (deflate at `level`, falling back to
+/// stored when compression would overflow a member).
+fn encode_member(block: &[u8], level: u8) -> Vec<u8> {
+    let mut deflate = miniz_oxide::deflate::compress_to_vec(block, level);
+    if HEADER_LEN + deflate.len() + TRAILER_LEN as usize > MAX_MEMBER as usize {
+        deflate = miniz_oxide::deflate::compress_to_vec(block, 0);
+    }
+    let size = HEADER_LEN + deflate.len() + TRAILER_LEN as usize;
+    let mut member = Vec::with_capacity(size);
+    member.extend_from_slice(&EOF_MEMBER[..16]);
+    member.extend_from_slice(&((size - 1) as u16).to_le_bytes());
+    member.extend_from_slice(&deflate);
+    member.extend_from_slice(&crc32fast::hash(block).to_le_bytes());
+    member.extend_from_slice(&(block.len() as u32).to_le_bytes());
+    member
+}
+
+/// Compress `input` into `out` as BGZF — [`BLOCK_SIZE`] members at
+/// deflate `level` (0–10), coded [`threads`]-wide, then the EOF marker
+/// member. Returns the data member count.
+pub fn write_bgzf<R: Read, W: Write>(mut input: R, mut out: W, level: u8) -> io::Result<usize> {
+    let threads = threads();
+    // Blocks per batch: enough to keep every thread busy, small enough
+    // to bound the staging memory (≈ 4 MiB per thread).
+    let batch = threads * 64;
+    let mut count = 0;
+    loop {
+        let mut blocks: Vec<Vec<u8>> = Vec::with_capacity(batch);
+        let mut eof = false;
+        while blocks.len() < batch && !eof {
+            let mut block = vec![0u8; BLOCK_SIZE];
+            let mut filled = 0;
+            while filled < BLOCK_SIZE {
+                match input.read(&mut block[filled..]) {
+                    Ok(0) => {
+                        eof = true;
+                        break;
+                    }
+                    Ok(n) => filled += n,
+                    Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                    Err(e) => return Err(e),
+                }
+            }
+            if filled > 0 {
+                block.truncate(filled);
+                blocks.push(block);
+            }
+        }
+        let members = par_map(&blocks, threads, |block| Ok(encode_member(block, level)))
+            .map_err(io::Error::from_raw_os_error)?;
+        for member in &members {
+            out.write_all(member)?;
+        }
+        count += members.len();
+        if eof {
+            break;
+        }
+    }
+    out.write_all(&EOF_MEMBER)?;
+    Ok(count)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn table(stream: &[u8]) -> Option<Vec<SeekFrame>> {
+        members(stream.len() as u64, |at, buf| {
+            let at = at as usize;
+            buf.copy_from_slice(stream.get(at..at + buf.len()).ok_or(libc::EIO)?);
+            Ok(())
+        })
+    }
+
+    #[test]
+    fn written_members_are_gzip_and_decode_alone() {
+        let data: Vec<u8> = (0..200_000u32)
+            .map(|i| (i % 251) as u8 ^ (i >> 11) as u8)
+            .collect();
+        let mut stream = Vec::new();
+        assert_eq!(write_bgzf(&data[..], &mut stream, 6).unwrap(), 4);
+
+        let frames = table(&stream).expect("a BGZF member table");
+        let u: Vec<(u64, u64)> = frames.iter().map(|f| (f.u_offset, f.u_len)).collect();
+        assert_eq!(
+            u,
+            [
+                (0, 0xff00),
+                (0xff00, 0xff00),
+                (0x1fe00, 0xff00),
+                (0x2fd00, 4160),
+                (200_000, 0)
+            ]
+        );
+        let f = frames[2];
+        let deflate = &stream[f.c_offset as usize..(f.c_offset + f.c_len) as usize];
+        let end = (f.c_offset + f.c_len) as usize;
+        let trailer: [u8; 8] = stream[end..end + 8].try_into().unwrap();
+        assert_eq!(
+            decode_member(deflate, &trailer, f.u_len).unwrap(),
+            &data[0x1fe00..0x2fd00]
+        );
+        let mut bad = trailer;
+        bad[0] ^= 1;
+        assert_eq!(decode_member(deflate, &bad, f.u_len), Err(libc::EIO));
+    }
+
+    #[test]
+    fn plain_gzip_and_torn_streams_have_no_member_table() {
+        let mut plain = vec![0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff];
+        plain.extend(miniz_oxide::deflate::compress_to_vec(b"hello", 6));
+        plain.extend([0u8; 8]);
+        assert!(table(&plain).is_none());
+
+        let mut stream = Vec::new();
+        write_bgzf(&[7u8; 100_000][..], &mut stream, 6).unwrap();
+        assert!(table(&stream[..stream.len() - 1]).is_none());
+        assert_eq!(table(&stream).unwrap().len(), 3);
+    }
+}
@@ -0,0 +1,255 @@
+//! A byte-budgeted, thread-shared LRU of decompressed blocks: the cache
+//! a backend keeps when one logical read would otherwise re-materialize
+//! a whole compressed unit (a LimniFS drop) to serve a few KiB of it.
+//!
+//! Values are `Arc<Vec<u8>>` so a hit hands the bytes out without a copy
+//! and without holding the lock while the caller slices them. The budget
+//! counts value bytes only; a value larger than the whole budget is
+//! never admitted (it would evict everything and still not fit). Hit,
+//! miss and eviction counters are the observable savings — owners log
+//! them at Debug when they go away.
+
+use std::collections::{BTreeMap, HashMap};
+use std::hash::Hash;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+
+/// The tallies of one cache.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct LruStats {
+    /// Lookups answered from the cache.
+    pub hits: u64,
+    /// Lookups the caller had to materialize.
+    pub misses: u64,
+    /// Values dropped to make room.
+    pub evictions: u64,
+    /// Values currently held.
+    pub entries: usize,
+    /// Value bytes currently held.
+    pub bytes: usize,
+}
+
+impl LruStats {
+    /// Hits over lookups, in percent (0 when nothing was looked up).
+    pub fn hit_percent(&self) -> f64 {
+        let lookups = self.hits + self.misses;
+        if lookups == 0 {
+            0.0
+        } else {
+            self.hits as f64 * 100.0 / lookups as f64
+        }
+    }
+}
+
+struct Slot {
+    value: Arc<Vec<u8>>,
+    stamp: u64,
+}
+
+struct Table<K> {
+    slots: HashMap<K, Slot>,
+    /// Recency stamp → key, oldest first.
+    order: BTreeMap<u64, K>,
+    bytes: usize,
+    clock: u64,
+}
+
+/// A byte-budgeted LRU (see the module docs).
+pub struct ByteLru<K> {
+    budget: usize,
+    table: Mutex<Table<K>>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl<K> std::fmt::Debug for ByteLru<K> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ByteLru")
+            .field("budget", &self.budget)
+            .finish_non_exhaustive()
+    }
+}
+
+impl<K: Hash + Eq + Clone> ByteLru<K> {
+    /// A cache holding at most `budget` value bytes (`0`: always empty).
+    pub fn new(budget: usize) -> Self {
+        ByteLru {
+            budget,
+            table: Mutex::new(Table {
+                slots: HashMap::new(),
+                order: BTreeMap::new(),
+                bytes: 0,
+                clock: 0,
+            }),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    fn table(&self) -> std::sync::MutexGuard<'_, Table<K>> {
+        self.table.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// The byte budget.
+    pub fn budget(&self) -> usize {
+        self.budget
+    }
+
+    /// The value for `key`, marked most recently used (counted as a hit;
+    /// `None` counts a miss).
+    pub fn get(&self, key: &K) -> Option<Arc<Vec<u8>>> {
+        if self.budget == 0 {
+            return None;
+        }
+        let mut guard = self.table();
+        let table = &mut *guard;
+        table.clock += 1;
+        let stamp = table.clock;
+        let Some(slot) = table.slots.get_mut(key) else {
+            self.misses.fetch_add(1, Ordering::Relaxed);
+            return None;
+        };
+        let old = std::mem::replace(&mut slot.stamp, stamp);
+        let value = Arc::clone(&slot.value);
+        if let Some(key) = table.order.remove(&old) {
+            table.order.insert(stamp, key);
+        }
+        self.hits.fetch_add(1, Ordering::Relaxed);
+        Some(value)
+    }
+
+    /// True when `key` is cached (no recency update, no hit or miss
+    /// counted — for readahead decisions, not reads).
+    pub fn contains(&self, key: &K) -> bool {
+        self.budget != 0 && self.table().slots.contains_key(key)
+    }
+
+    /// Admit `value` under `key`, evicting least recently used values
+    /// until it fits. A value over the whole budget is not admitted.
+    pub fn insert(&self, key: K, value: Arc<Vec<u8>>) {
+        let len = value.len();
+        if self.budget == 0 || len > self.budget {
+            return;
+        }
+        let mut guard = self.table();
+        let table = &mut *guard;
+        if let Some(old) = table.slots.remove(&key) {
+            table.order.remove(&old.stamp);
+            table.bytes -= old.value.len();
+        }
+        while table.bytes + len > self.budget {
+            let Some((_, oldest)) = table.order.pop_first() else {
+                break;
+            };
+            if let Some(slot) = table.slots.remove(&oldest) {
+                table.bytes -= slot.value.len();
+                self.evictions.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+        table.clock += 1;
+        let stamp = table.clock;
+        table.order.insert(stamp, key.clone());
+        table.slots.insert(key, Slot { value, stamp });
+        table.bytes += len;
+    }
+
+    /// Drop every value whose key matches `doomed` (not counted as
+    /// evictions) — an owner leaving a shared cache takes its values along.
+    pub fn remove_where(&self, doomed: impl Fn(&K) -> bool) {
+        let mut guard = self.table();
+        let table = &mut *guard;
+        let Table {
+            slots,
+            order,
+            bytes,
+            ..
+        } = table;
+        slots.retain(|key, slot| {
+            if !doomed(key) {
+                return true;
+            }
+            order.remove(&slot.stamp);
+            *bytes -= slot.value.len();
+            false
+        });
+    }
+
+    /// The current tallies.
+    pub fn stats(&self) -> LruStats {
+        let table = self.table();
+        LruStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            entries: table.slots.len(),
+            bytes: table.bytes,
+        }
+    }
+}
+
+/// A cache budget from the env var `name`, in MiB (`default_mib` when
+/// unset or unparsable; `0` disables).
+pub fn budget_from_env(name: &str, default_mib: usize) -> usize {
+    std::env::var(name)
+        .ok()
+        .and_then(|v| v.trim().parse::<usize>().ok())
+        .unwrap_or(default_mib)
+        .saturating_mul(1024 * 1024)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn value(len: usize, fill: u8) -> Arc<Vec<u8>> {
+        Arc::new(vec![fill; len])
+    }
+
+    #[test]
+    fn least_recently_used_goes_first_within_the_byte_budget() {
+        let lru = ByteLru::new(300);
+        lru.insert(1u32, value(100, 1));
+        lru.insert(2, value(100, 2));
+        lru.insert(3, value(100, 3));
+        assert!(lru.get(&1).is_some(), "touch 1: now 2 is the oldest");
+        lru.insert(4, value(150, 4));
+        assert!(lru.get(&2).is_none());
+        assert!(lru.get(&3).is_none(), "150 bytes needed two evictions");
+        assert_eq!(lru.get(&1).unwrap()[0], 1);
+        assert_eq!(lru.get(&4).unwrap()[0], 4);
+        let stats = lru.stats();
+        assert_eq!((stats.hits, stats.misses, stats.evictions), (3, 2, 2));
+        assert_eq!((stats.entries, stats.bytes), (2, 250));
+        assert!((stats.hit_percent() - 60.0).abs() < 1e-9);
+    }
+
+    #[test]
+    fn oversized_values_and_a_zero_budget_are_never_admitted() {
+        let lru = ByteLru::new(64);
+        lru.insert("big", value(65, 0));
+        assert!(lru.get(&"big").is_none());
+        lru.insert("small", value(64, 0));
+        lru.insert("small", value(32, 1)); // replacement re-accounts
+        assert_eq!(lru.stats().bytes, 32);
+
+        let off = ByteLru::new(0);
+        off.insert("a", value(0, 0));
+        assert!(off.get(&"a").is_none());
+        assert_eq!(off.stats(), LruStats::default());
+    }
+
+    #[test]
+    fn removed_values_free_their_bytes_without_counting_evictions() {
+        let lru = ByteLru::new(300);
+        lru.insert((1u32, 'a'), value(100, 1));
+        lru.insert((2, 'a'), value(100, 2));
+        lru.insert((1, 'b'), value(50, 3));
+        lru.remove_where(|&(owner, _)| owner == 1);
+        assert_eq!((lru.stats().entries, lru.stats().bytes), (1, 100));
+        assert_eq!(lru.stats().evictions, 0);
+        lru.insert((3, 'a'), value(200, 4));
+        assert!(lru.get(&(2, 'a')).is_some(), "the freed bytes made room");
+    }
+}
@@ -213,7 +213,7 @@ pub unsafe extern "C" fn tebako_fs_read(
     }
     // SAFETY: caller guarantees buf/count validity.
     let buf = unsafe { std::slice::from_raw_parts_mut(buf.cast::<u8>(), count) };
-    match context().write().unwrap().read(fd, buf) {
+    match context().read().unwrap().read(fd, buf) {
         Ok(n) => {
             set_errno(0);
             n as libc::ssize_t
@@ -242,7 +242,112 @@ pub unsafe extern "C" fn tebako_fs_pread(
     let buf = unsafe { std::slice::from_raw_parts_mut(buf.cast::<u8>(), nbyte) };
     // the engine works in i64 offsets; the ABI's off_t is platform-sized
     // (i32 in the mingw CRT).
-    match context().write().unwrap().pread(fd, buf, i64::from(offset)) {
+    match context().read().unwrap().pread(fd, buf, i64::from(offset)) {
+        Ok(n) => {
+            set_errno(0);
+            n as libc::ssize_t
+        }
+        Err(e) => fail(e) as libc::ssize_t,
+    }
+}
+
+/// `struct tebako_iovec`: the platform's `struct iovec` on POSIX; the
+/// same two-field layout pinned on Windows (the CRT declares none).
+#[cfg(windows)]
+#[repr(C)]
+pub struct TebakoIovec {
+    pub iov_base: *mut c_void,
+    pub iov_len: usize,
+}
+
+/// POSIX: the platform's own `struct iovec`.
+#[cfg(not(windows))]
+pub type TebakoIovec = libc::iovec;
+
+/// Most iovecs one `tebako_fs_preadv` call takes (POSIX `IOV_MAX`).
+pub const TEBAKO_IOV_MAX: libc::c_int = 1024;
+
+/// Read into the caller's iovecs through `read` (given the buffers and
+/// the bytes read before them; the count it read): `EINVAL` for a count
+/// outside `0..=TEBAKO_IOV_MAX`, `null` for a NULL array or a NULL
+/// non-empty buffer. `tebako_fs_preadv` answers `EINVAL` there (its
+/// documented contract); the preload shim's `readv` family answers the
+/// kernel's `EFAULT`.
+///
+/// Disjoint iovecs, the usual case, are read in one call. Overlapping
+/// ones are legal (the later buffer's bytes win) but may never be live
+/// `&mut` slices at once: each is then read by a call of its own, in
+/// order, up to the first short one.
+///
+/// # Safety
+/// `iov` must point to `iovcnt` iovecs, each writable for its length.
+pub unsafe fn read_iov(
+    iov: *const TebakoIovec,
+    iovcnt: libc::c_int,
+    null: i32,
+    mut read: impl FnMut(&mut [&mut [u8]], usize) -> Result<usize, i32>,
+) -> Result<usize, i32> {
+    if !(0..=TEBAKO_IOV_MAX).contains(&iovcnt) {
+        return Err(libc::EINVAL);
+    }
+    if iovcnt == 0 {
+        return read(&mut [], 0);
+    }
+    if iov.is_null() {
+        return Err(null);
+    }
+    let iov = unsafe { std::slice::from_raw_parts(iov, iovcnt as usize) };
+    if iov.iter().any(|v| v.iov_base.is_null() && v.iov_len > 0) {
+        return Err(null);
+    }
+    let slice = |v: &TebakoIovec| -> &mut [u8] {
+        match v.iov_len {
+            0 => &mut [],
+            len => unsafe { std::slice::from_raw_parts_mut(v.iov_base.cast::<u8>(), len) },
+        }
+    };
+    let mut spans: Vec<(usize, usize)> = iov
+        .iter()
+        .filter(|v| v.iov_len > 0)
+        .map(|v| (v.iov_base as usize, v.iov_len))
+        .collect();
+    spans.sort_unstable();
+    if spans.windows(2).all(|w| w[0].0 + w[0].1 <= w[1].0) {
+        return read(&mut iov.iter().map(slice).collect::<Vec<_>>(), 0);
+    }
+    let mut done = 0;
+    for v in iov.iter().filter(|v| v.iov_len > 0) {
+        let n = match read(&mut [slice(v)], done) {
+            Ok(n) => n,
+            Err(_) if done > 0 => break,
+            Err(e) => return Err(e),
+        };
+        done += n;
+        if n < v.iov_len {
+            break;
+        }
+    }
+    Ok(done)
+}
+
+/// `tebako_fs_preadv` (fd position untouched).
+///
+/// # Safety
+/// `iov` must point to `iovcnt` iovecs, each writable for its length.
+// i64::from(off_t): see tebako_fs_pread — platform-lint noise, not dead code.
+#[allow(clippy::useless_conversion)]
+#[no_mangle]
+pub unsafe extern "C" fn tebako_fs_preadv(
+    fd: libc::c_int,
+    iov: *const TebakoIovec,
+    iovcnt: libc::c_int,
+    offset: libc::off_t,
+) -> libc::ssize_t {
+    let ctx = context().read().unwrap();
+    let read = |bufs: &mut [&mut [u8]], done: usize| {
+        ctx.preadv(fd, bufs, i64::from(offset).saturating_add(done as i64))
+    };
+    match unsafe { read_iov(iov, iovcnt, libc::EINVAL, read) } {
         Ok(n) => {
             set_errno(0);
             n as libc::ssize_t
@@ -264,7 +369,7 @@ pub unsafe extern "C" fn tebako_fs_lseek(
     whence: libc::c_int,
 ) -> libc::off_t {
     match context()
-        .write()
+        .read()
         .unwrap()
         .lseek(fd, i64::from(offset), whence)
     {
@@ -276,6 +381,26 @@ pub unsafe extern "C" fn tebako_fs_lseek(
     }
 }
 
+/// `tebako_fs_fadvise` (`posix_fadvise` advice as a readahead hint).
+///
+/// # Safety
+/// C ABI entry point.
+#[no_mangle]
+pub unsafe extern "C" fn tebako_fs_fadvise(
+    fd: libc::c_int,
+    offset: i64,
+    len: i64,
+    advice: libc::c_int,
+) -> libc::c_int {
+    match context().read().unwrap().advise(fd, offset, len, advice) {
+        Ok(()) => {
+            set_errno(0);
+            0
+        }
+        Err(e) => fail(e),
+    }
+}
+
 /// `tebako_fs_close`.
 ///
 /// # Safety
@@ -785,6 +910,84 @@ pub unsafe extern "C" fn tebako_fs_mount_from_file_at_with_mode(
     )
 }
 
+/// `struct tebako_mount_opts` (include/tebako/fs/c_api.h — keep the two
+/// in lockstep): per-mount read tuning for
+/// [`tebako_fs_mount_from_file_opts`]. A zero field keeps its default.
+#[repr(C)]
+pub struct TebakoMountOpts {
+    /// Read-cache budget in bytes.
+    pub cache_bytes: u64,
+    /// The per-fd readahead window.
+    pub readahead: u64,
+    /// Threads filling cache misses.
+    pub workers: u32,
+    /// Must be 0 (room for a later field without an ABI break).
+    pub reserved: u32,
+}
+
+const _: () = {
+    assert!(std::mem::size_of::<TebakoMountOpts>() == 24);
+    assert!(std::mem::offset_of!(TebakoMountOpts, workers) == 16);
+};
+
+/// `tebako_fs_mount_from_file_opts`: [`tebako_fs_mount_from_file_at`]
+/// with per-mount read tuning (`opts` may be NULL: the untuned mount).
+///
+/// # Safety
+/// C ABI entry point: pointer arguments must follow the C contract;
+/// `opts`, when non-NULL, points to a valid `tebako_mount_opts`.
+#[no_mangle]
+pub unsafe extern "C" fn tebako_fs_mount_from_file_opts(
+    archive_path: *const c_char,
+    offset: u64,
+    length: u64,
+    mount_point: *const c_char,
+    opts: *const TebakoMountOpts,
+    out_handle: *mut libc::c_int,
+) -> libc::c_int {
+    if out_handle.is_null() {
+        return fail(libc::EINVAL);
+    }
+    let (archive_path, mount_point) = match (unsafe { path_arg(archive_path) }, unsafe {
+        path_arg(mount_point)
+    }) {
+        (Ok(a), Ok(m)) => (a, m),
+        _ => return fail(libc::EINVAL),
+    };
+    if mount_point.is_empty() {
+        return fail(libc::EINVAL);
+    }
+    let options = match unsafe { opts.as_ref() } {
+        None => mount::MountOptions::default(),
+        Some(o) if o.reserved != 0 => return fail(libc::EINVAL),
+        Some(o) => mount::MountOptions {
+            cache_bytes: o.cache_bytes,
+            workers: o.workers,
+            readahead: o.readahead,
+        },
+    };
+    // Reading the image off the host is a host-passthrough decision (spec 08).
+    if let Err(e) = context()
+        .read()
+        .unwrap()
+        .host_check(archive_path, HostAccess::Ro)
+    {
+        return fail(e);
+    }
+    finish_mount(
+        mount::build_from_file_at_with_options(
+            archive_path,
+            offset,
+            length,
+            mount_point,
+            mount::MountMode::ReadOnly,
+            None,
+            &options,
+        ),
+        out_handle,
+    )
+}
+
 /// `tebako_fs_mount_from_memory`.
 ///
 /// # Safety
@@ -848,6 +1051,75 @@ pub unsafe extern "C" fn tebako_fs_mount_from_memory_with_mode(
     )
 }
 
+/// `tebako_release_fn` and its context: handed back exactly once, when
+/// dropped (the engine drops it when nothing reads the lent buffer any
+/// more, or at once when the mount fails).
+struct Release {
+    release: Option<unsafe extern "C" fn(*mut c_void)>,
+    ctx: *mut c_void,
+}
+
+// The context is the caller's: the header requires `release` to be
+// callable from any thread.
+unsafe impl Send for Release {}
+unsafe impl Sync for Release {}
+
+impl Drop for Release {
+    fn drop(&mut self) {
+        if let Some(release) = self.release.take() {
+            unsafe { release(self.ctx) };
+        }
+    }
+}
+
+/// `tebako_fs_mount_from_memory_borrowed`: mount `size` bytes at `data`
+/// WITHOUT copying them. The buffer is lent until the mount goes away;
+/// `release` (optional) is then called once with `release_ctx` — also
+/// before the call returns when the mount fails.
+///
+/// # Safety
+/// `data` must point to `size` readable bytes that stay valid and
+/// unchanged until `release` runs (without one: until unmount).
+#[no_mangle]
+pub unsafe extern "C" fn tebako_fs_mount_from_memory_borrowed(
+    data: *const c_void,
+    size: usize,
+    mount_point: *const c_char,
+    release: Option<unsafe extern "C" fn(*mut c_void)>,
+    release_ctx: *mut c_void,
+    out_handle: *mut libc::c_int,
+) -> libc::c_int {
+    let release = Release {
+        release,
+        ctx: release_ctx,
+    };
+    if out_handle.is_null() || data.is_null() || size == 0 {
+        return fail(libc::EINVAL);
+    }
+    let mount_point = match unsafe { path_arg(mount_point) } {
+        Ok(m) if !m.is_empty() => m,
+        Ok(_) => return fail(libc::EINVAL),
+        Err(e) => return fail(e),
+    };
+    let bytes = unsafe {
+        crate::image_bytes::ImageBytes::borrowed(
+            data.cast::<u8>(),
+            size,
+            Some(Box::new(move || drop(release))),
+        )
+    };
+    finish_mount(
+        mount::build_from_bytes_with_options(
+            bytes,
+            mount_point,
+            mount::MountMode::ReadOnly,
+            None,
+            &mount::MountOptions::default(),
+        ),
+        out_handle,
+    )
+}
+
 /// `tebako_fs_unmount_handle`.
 ///
 /// # Safety
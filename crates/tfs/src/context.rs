@@ -6,15 +6,20 @@
 //! (`src/c_api/fs_context.cpp`) semantics exactly; see each function's
 //! comments for the errno contract.
 
+use std::borrow::Cow;
 use std::collections::{BTreeMap, BTreeSet};
-use std::sync::RwLock;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, RwLock, TryLockError};
 
 use tebako_json::Value;
 
 use crate::backend::{Backend, EntryType, RawDirEntry, RawStat, WritableBackend};
+use crate::byte_lru::LruStats;
 use crate::exec_closure;
+use crate::miss_cache::{MissCache, MissStats};
 use crate::mount::MountMode;
 use crate::policy::{HostAccess, HostPolicy};
+use crate::readahead::{self, Readahead};
 use crate::trace;
 
 /// Flag bit distinguishing libtfs FDs from host OS FDs.
@@ -82,18 +87,49 @@ pub struct Mount {
     pub backend: Box<dyn Backend>,
     /// Mount mode (spec 11 §3; writes on RO mounts fail with EROFS).
     pub mode: MountMode,
+    /// The negative-lookup cache (in-image misses and their held
+    /// verdicts); consulted only where [`FsContext::miss_cache`] allows.
+    pub misses: MissCache,
+    /// The read tuning the mount was built with (carried into the
+    /// exec'd child's `TEBAKO_TFS_MOUNTS`).
+    pub options: crate::mount::MountOptions,
+    /// Host sources the preload maps memfs files from, when the mount
+    /// shares mapped pages ([`crate::mapped_files`]).
+    pub mapped: crate::mapped_files::MappedFiles,
 }
 
 /// One open file descriptor.
+///
+/// Everything but the position is fixed at open time, so the read family
+/// (`read`/`pread`/`lseek`/`fstat`) runs under the SHARED context lock:
+/// the position is the fd's only mutable state and it is an atomic —
+/// threads reading different fds never serialize on the global guard,
+/// and no per-call allocation is needed (the mount-relative path is
+/// precomputed here, not re-derived from a cloned path).
 pub struct FdEntry {
-    /// In-image path (for fstat re-dispatch, like the C++ implementation).
+    /// Normalized VFS path (for fstat re-dispatch, like the C++
+    /// implementation).
     pub path: String,
+    /// Byte length of the mount point prefix in `path`: the in-image
+    /// path is `path[rel_start..]` (the owner's mount point never moves
+    /// while the fd lives — unmount closes its fds).
+    pub rel_start: usize,
     /// File size at open time.
     pub size: u64,
-    /// Current position.
-    pub pos: u64,
+    /// Current position (see [`FsContext::read`] for the advance rule).
+    pub pos: AtomicU64,
     /// Owning mount handle.
     pub owner: i32,
+    /// Sequential-read detection and the windows prefetched for this fd
+    /// (shared with the readahead worker while a window is in flight).
+    pub readahead: Arc<Readahead>,
+}
+
+impl FdEntry {
+    /// The in-image path (relative to the owner's mount root).
+    fn rel(&self) -> &str {
+        &self.path[self.rel_start..]
+    }
 }
 
 /// One open directory handle.
@@ -134,6 +170,9 @@ enum DlSurface {
 /// The process-global context state (behind a lock; see [`context`]).
 pub struct FsContext {
     mounts: BTreeMap<i32, Mount>,
+    /// The compiled longest-prefix dispatch over `mounts`' points,
+    /// rebuilt whenever the mount table changes (see [`MountTrie`]).
+    dispatch: MountTrie,
     fd_table: BTreeMap<i32, FdEntry>,
     dir_table: BTreeMap<usize, DirState>,
     next_handle: i32,
@@ -182,6 +221,7 @@ impl FsContext {
     const fn new() -> Self {
         FsContext {
             mounts: BTreeMap::new(),
+            dispatch: MountTrie::new(),
             fd_table: BTreeMap::new(),
             dir_table: BTreeMap::new(),
             next_handle: 0,
@@ -322,6 +362,7 @@ impl FsContext {
         self.next_handle += 1;
         let mount = Mount { handle, ..mount };
         self.mounts.insert(mount.handle, mount);
+        self.rebuild_dispatch();
         handle
     }
 
@@ -413,7 +454,10 @@ impl FsContext {
             }
         };
         incumbent.backend = Box::new(union);
+        // The new member may hold what the incumbent missed.
+        incumbent.misses.clear();
         self.mounts.insert(handle, incumbent);
+        self.rebuild_dispatch();
         if let Some((point, image)) = &subject {
             trace_mount(trace_start, "union", point, image.as_deref(), &Ok(handle));
         }
@@ -438,7 +482,10 @@ impl FsContext {
         let result = if self.mounts.contains_key(&handle) {
             self.fd_table.retain(|_, e| e.owner != handle);
             self.dir_table.retain(|_, e| e.owner != handle);
-            self.mounts.remove(&handle);
+            if let Some(mount) = self.mounts.remove(&handle) {
+                log_miss_stats(&mount);
+            }
+            self.rebuild_dispatch();
             if self.compat_handle == Some(handle) {
                 self.compat_handle = None;
             }
@@ -474,7 +521,11 @@ impl FsContext {
                     .dur(start),
             );
         }
+        for mount in self.mounts.values() {
+            log_miss_stats(mount);
+        }
         self.mounts.clear();
+        self.dispatch = MountTrie::new();
         self.fd_table.clear();
         self.dir_table.clear();
         self.next_fd = 1;
@@ -492,12 +543,20 @@ impl FsContext {
         self.mounts.values().any(|m| m.mount_point == mount_point)
     }
 
-    /// Longest-prefix dispatch: the mount owning `path`, if any.
+    /// Longest-prefix dispatch: the mount owning `path`, if any. One
+    /// walk of the compiled trie — no per-mount scan, no allocation.
     fn find_mount(&self, path: &str) -> Option<&Mount> {
-        self.mounts
-            .values()
-            .filter(|m| path_is_in_mount(path, &m.mount_point))
-            .max_by_key(|m| m.mount_point.len())
+        self.mounts.get(&self.dispatch.lookup(path)?)
+    }
+
+    /// Recompile the dispatch trie from the mount table (mount, union
+    /// and unmount are rare; dispatch runs on every path call).
+    fn rebuild_dispatch(&mut self) {
+        let mut trie = MountTrie::new();
+        for mount in self.mounts.values() {
+            trie.insert(&mount.mount_point, mount.handle);
+        }
+        self.dispatch = trie;
     }
 
     /// Strip the mount point: the in-image path for `path` under `mount`
@@ -507,12 +566,67 @@ impl FsContext {
         rest.trim_start_matches('/')
     }
 
+    /// The mount's negative-lookup cache, when its namespace changes only
+    /// through this context: a format backend (an immutable image) or a
+    /// COW composite (every write verb flushes, see `write_gated`). A
+    /// writable backend mounted any other way — a host directory — can
+    /// change behind the context's back and is never cached.
+    fn miss_cache(mount: &Mount) -> Option<&MissCache> {
+        (mount.mode == MountMode::Cow || mount.backend.writable().is_none())
+            .then_some(&mount.misses)
+    }
+
+    /// `mount.backend.stat(rel)`, with ENOENT answered from — and
+    /// recorded in — the mount's miss cache.
+    fn backend_stat(mount: &Mount, rel: &str) -> Result<RawStat, i32> {
+        let cache = Self::miss_cache(mount);
+        if cache.is_some_and(|c| c.is_absent(rel)) {
+            return Err(libc::ENOENT);
+        }
+        let result = mount.backend.stat(rel);
+        if let (Err(libc::ENOENT), Some(cache)) = (result, cache) {
+            cache.record_absent(rel);
+        }
+        result
+    }
+
+    /// The miss-cache tallies per mount point (the savings on a
+    /// probe-heavy boot; also logged at Debug on unmount).
+    pub fn miss_stats(&self) -> Vec<(String, MissStats)> {
+        self.mounts
+            .values()
+            .filter_map(|m| Some((m.mount_point.clone(), Self::miss_cache(m)?.stats())))
+            .collect()
+    }
+
+    /// The read-cache tallies per mount point, for mounts with a read
+    /// cache (see [`Backend::cache_stats`]; also logged at Debug on
+    /// unmount).
+    pub fn cache_stats(&self) -> Vec<(String, LruStats)> {
+        self.mounts
+            .values()
+            .filter_map(|m| Some((m.mount_point.clone(), m.backend.cache_stats()?)))
+            .collect()
+    }
+
     /// Lexical normalization of a VFS path: `.` components dropped,
     /// `a/../` resolved (no symlink semantics — an image backend keys
     /// its entries by clean path), `..` at the root clamped. The host
     /// resolves `..` at the syscall layer; the mounts must see the same
     /// answer (ruby passes literal `lib/../x.yaml` paths through).
-    fn normalize(path: &str) -> String {
+    ///
+    /// Borrows: an already-clean path (the overwhelming majority — every
+    /// `$LOAD_PATH` probe) comes back as itself; only a `.`/`..`/empty
+    /// component pays the rebuild.
+    fn normalize(path: &str) -> Cow<'_, str> {
+        let body = path.strip_prefix('/').unwrap_or(path);
+        if body.is_empty()
+            || body
+                .split('/')
+                .all(|component| !matches!(component, "" | "." | ".."))
+        {
+            return Cow::Borrowed(path);
+        }
         let absolute = path.starts_with('/');
         let mut out: Vec<&str> = Vec::new();
         for component in path.split('/') {
@@ -525,11 +639,11 @@ impl FsContext {
             }
         }
         let joined = out.join("/");
-        if absolute {
+        Cow::Owned(if absolute {
             format!("/{joined}")
         } else {
             joined
-        }
+        })
     }
 
     /// The memfs tail of a dlmap-cache path. `dlmap2file` materializes a
@@ -538,17 +652,23 @@ impl FsContext {
     /// (dyld's @rpath probes, a dlopen'd library's own dependencies)
     /// presents paths under the marker directory. Strip it: the
     /// remainder, normalized, is the memfs original. None when no
-    /// marker component is present or nothing follows it.
-    fn dlmap_tail(path: &str) -> Option<String> {
-        let mut components = path.split('/');
-        while let Some(component) = components.next() {
+    /// marker component is present or nothing follows it. The tail is
+    /// a slice of `path` (from the `/` after the marker), so the common
+    /// no-marker answer costs one substring scan and nothing allocates.
+    fn dlmap_tail(path: &str) -> Option<Cow<'_, str>> {
+        if !path.contains(DLMAP_MARKER_PREFIX) {
+            return None;
+        }
+        let mut start = 0;
+        for component in path.split('/') {
+            let end = start + component.len();
             if is_dlmap_marker(component) {
-                let tail: Vec<&str> = components.collect();
-                if tail.is_empty() {
+                if end == path.len() {
                     return None;
                 }
-                return Some(Self::normalize(&format!("/{}", tail.join("/"))));
+                return Some(Self::normalize(&path[end..]));
             }
+            start = end + 1;
         }
         None
     }
@@ -601,7 +721,7 @@ impl FsContext {
     /// signal), `host` (passthrough), `denied:<rule>` (jail source or
     /// the spec 24 §5 write gate), or `error:<errno>`.
     pub fn open(&mut self, path: &str, flags: i32) -> Result<i32, i32> {
-        let path = &Self::normalize(path);
+        let path = &*Self::normalize(path);
         let trace_start = trace::Start::now();
         if std::env::var_os("TEBAKO_DEBUG_TFS").is_some() {
             eprintln!("[tfs] open: {path}");
@@ -635,7 +755,7 @@ impl FsContext {
                         if let Some(start) = trace_start {
                             trace::emit(
                                 trace::Event::new(trace::Op::Open, path, format!("error:{e}"))
-                                    .detail("dlmap_redirect", Value::String(tail.clone()))
+                                    .detail("dlmap_redirect", Value::String(tail.to_string()))
                                     .with_errno(e)
                                     .dur(start),
                             );
@@ -652,7 +772,7 @@ impl FsContext {
                                 .unwrap_or_default();
                             trace::emit(
                                 trace::Event::new(trace::Op::Open, path, format!("image:{point}"))
-                                    .detail("dlmap_redirect", Value::String(tail))
+                                    .detail("dlmap_redirect", Value::String(tail.into_owned()))
                                     .detail(
                                         "materialized",
                                         Value::String(host.to_string_lossy().into_owned()),
@@ -666,7 +786,7 @@ impl FsContext {
                         if let Some(start) = trace_start {
                             trace::emit(
                                 trace::Event::new(trace::Op::Open, path, format!("error:{e}"))
-                                    .detail("dlmap_redirect", Value::String(tail))
+                                    .detail("dlmap_redirect", Value::String(tail.into_owned()))
                                     .with_errno(e)
                                     .dur(start),
                             );
@@ -712,7 +832,7 @@ impl FsContext {
             return Err(libc::ENOENT);
         };
         let rel = Self::relative_path(mount, path);
-        let st = match mount.backend.stat(rel) {
+        let st = match Self::backend_stat(mount, rel) {
             Ok(st) => st,
             // A write naming a file the image does not hold: the held-tree
             // rule decides. An ancestor the image DOES hold means the write
@@ -809,6 +929,13 @@ impl FsContext {
             }
         }
         let owner = mount.handle;
+        // Prefetch only where the bytes cannot change under a held
+        // window: a COW mount's path writes would make one stale.
+        let readahead = match (mount.mode, mount.options.readahead) {
+            (MountMode::ReadOnly, 0) => Readahead::new(readahead::window_from_env()),
+            (MountMode::ReadOnly, n) => Readahead::new(n),
+            _ => Readahead::disabled(),
+        };
         let trace_point = trace_start.map(|_| mount.mount_point.clone());
         let fd = self.next_fd;
         if fd > TEBAKO_FD_MAX {
@@ -822,13 +949,16 @@ impl FsContext {
             return Err(libc::EMFILE);
         }
         self.next_fd += 1;
+        let rel_start = path.len() - rel.len();
         self.fd_table.insert(
             fd,
             FdEntry {
                 path: path.to_string(),
+                rel_start,
                 size: st.size.max(0) as u64,
-                pos: 0,
+                pos: AtomicU64::new(0),
                 owner,
+                readahead: Arc::new(readahead),
             },
         );
         if let (Some(start), Some(point)) = (trace_start, trace_point) {
@@ -839,44 +969,42 @@ impl FsContext {
         Ok(fd | TEBAKO_FD_FLAG)
     }
 
-    fn lookup_fd(&self, fd: i32) -> Option<(i32, &FdEntry)> {
-        if (fd & TEBAKO_FD_FLAG) == 0 {
-            return None;
-        }
-        let internal = fd & !TEBAKO_FD_FLAG;
-        self.fd_table.get(&internal).map(|e| (internal, e))
-    }
-
-    fn lookup_fd_mut(&mut self, fd: i32) -> Option<(i32, &mut FdEntry)> {
+    fn lookup_fd(&self, fd: i32) -> Option<&FdEntry> {
         if (fd & TEBAKO_FD_FLAG) == 0 {
             return None;
         }
-        let internal = fd & !TEBAKO_FD_FLAG;
-        self.fd_table.get_mut(&internal).map(|e| (internal, e))
+        self.fd_table.get(&(fd & !TEBAKO_FD_FLAG))
     }
 
-    /// tebako_fs_read.
-    pub fn read(&mut self, fd: i32, buf: &mut [u8]) -> Result<usize, i32> {
-        let (internal, path, owner, pos, size) = {
-            let (internal, entry) = self.lookup_fd(fd).ok_or(libc::EBADF)?;
-            (
-                internal,
-                entry.path.clone(),
-                entry.owner,
-                entry.pos,
-                entry.size,
-            )
-        };
-        let mount = self.mounts.get(&owner).ok_or(libc::EBADF)?;
-        let rel = Self::relative_path(mount, &path).to_string();
-        if pos >= size || buf.is_empty() {
-            return Ok(0);
+    /// tebako_fs_read. Runs under the shared context lock: the fd's
+    /// position advances by compare-and-swap from the offset the read
+    /// was served at, so concurrent readers of ONE fd each consume a
+    /// distinct byte range (a racing `lseek` or read makes the loser
+    /// re-serve from the new position) — the kernel's per-file
+    /// position-lock guarantee, without a lock.
+    pub fn read(&self, fd: i32, buf: &mut [u8]) -> Result<usize, i32> {
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        let mount = self.mounts.get(&entry.owner).ok_or(libc::EBADF)?;
+        let mut pos = entry.pos.load(Ordering::Acquire);
+        loop {
+            if pos >= entry.size || buf.is_empty() {
+                return Ok(0);
+            }
+            let want = std::cmp::min(buf.len() as u64, entry.size - pos) as usize;
+            let n = Self::read_at(mount, entry, &mut buf[..want], pos)?;
+            match entry.pos.compare_exchange(
+                pos,
+                pos + n as u64,
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => {
+                    Self::read_ahead(fd, entry, pos, n);
+                    return Ok(n);
+                }
+                Err(moved) => pos = moved,
+            }
         }
-        let want = std::cmp::min(buf.len() as u64, size - pos) as usize;
-        let n = mount.backend.pread(&rel, &mut buf[..want], pos)?;
-        let entry = self.fd_table.get_mut(&internal).ok_or(libc::EBADF)?;
-        entry.pos += n as u64;
-        Ok(n)
     }
 
     /// tebako_fs_pread (position untouched).
@@ -884,32 +1012,232 @@ impl FsContext {
         if offset < 0 {
             return Err(libc::EINVAL);
         }
-        let (_, entry) = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
         let mount = self.mounts.get(&entry.owner).ok_or(libc::EBADF)?;
-        let rel = Self::relative_path(mount, &entry.path);
         let offset = offset as u64;
         if offset >= entry.size || buf.is_empty() {
             return Ok(0);
         }
         let want = std::cmp::min(buf.len() as u64, entry.size - offset) as usize;
-        mount.backend.pread(rel, &mut buf[..want], offset)
+        let n = Self::read_at(mount, entry, &mut buf[..want], offset)?;
+        Self::read_ahead(fd, entry, offset, n);
+        Ok(n)
     }
 
-    /// tebako_fs_lseek.
-    pub fn lseek(&mut self, fd: i32, offset: i64, whence: i32) -> Result<i64, i32> {
-        let (_, entry) = self.lookup_fd_mut(fd).ok_or(libc::EBADF)?;
-        let size = entry.size as i64;
-        let target = match whence {
-            libc::SEEK_SET => offset,
-            libc::SEEK_CUR => entry.pos as i64 + offset,
-            libc::SEEK_END => size + offset,
-            _ => return Err(libc::EINVAL),
+    /// tebako_fs_preadv: fill `bufs` in order from `offset` under one fd
+    /// lookup (position untouched). Short only at EOF — or at an error
+    /// after some bytes landed, which reports the bytes instead.
+    pub fn preadv(&self, fd: i32, bufs: &mut [&mut [u8]], offset: i64) -> Result<usize, i32> {
+        if offset < 0 {
+            return Err(libc::EINVAL);
+        }
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        let mount = self.mounts.get(&entry.owner).ok_or(libc::EBADF)?;
+        let n = Self::fill_at(mount, entry, bufs, offset as u64)?;
+        Self::read_ahead(fd, entry, offset as u64, n);
+        Ok(n)
+    }
+
+    /// readv: [`Self::preadv`] at the fd's position, advanced like
+    /// [`Self::read`].
+    pub fn readv(&self, fd: i32, bufs: &mut [&mut [u8]]) -> Result<usize, i32> {
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        let mount = self.mounts.get(&entry.owner).ok_or(libc::EBADF)?;
+        let mut pos = entry.pos.load(Ordering::Acquire);
+        loop {
+            let n = Self::fill_at(mount, entry, bufs, pos)?;
+            match entry.pos.compare_exchange(
+                pos,
+                pos + n as u64,
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => {
+                    Self::read_ahead(fd, entry, pos, n);
+                    return Ok(n);
+                }
+                Err(moved) => pos = moved,
+            }
+        }
+    }
+
+    /// The vectored body: each buffer filled whole before the next.
+    fn fill_at(
+        mount: &Mount,
+        entry: &FdEntry,
+        bufs: &mut [&mut [u8]],
+        offset: u64,
+    ) -> Result<usize, i32> {
+        let mut at = offset;
+        for buf in bufs.iter_mut() {
+            let mut got = 0;
+            while got < buf.len() && at < entry.size {
+                let want = std::cmp::min((buf.len() - got) as u64, entry.size - at) as usize;
+                match Self::read_at(mount, entry, &mut buf[got..got + want], at) {
+                    Ok(0) => break,
+                    Ok(n) => {
+                        got += n;
+                        at += n as u64;
+                    }
+                    Err(e) if at == offset => return Err(e),
+                    Err(_) => return Ok((at - offset) as usize),
+                }
+            }
+            if got < buf.len() {
+                break;
+            }
+        }
+        Ok((at - offset) as usize)
+    }
+
+    /// Serve `buf` at `offset` from the fd's prefetched windows, the rest
+    /// from the backend (a window never shortens a read the backend
+    /// would have served whole).
+    fn read_at(mount: &Mount, entry: &FdEntry, buf: &mut [u8], offset: u64) -> Result<usize, i32> {
+        let held = entry.readahead.serve(offset, buf);
+        if held == buf.len() {
+            return Ok(held);
+        }
+        match mount
+            .backend
+            .pread(entry.rel(), &mut buf[held..], offset + held as u64)
+        {
+            Ok(n) => Ok(held + n),
+            Err(_) if held > 0 => Ok(held),
+            Err(e) => Err(e),
+        }
+    }
+
+    /// Feed a served read to the fd's detector; schedule the window it
+    /// asks for.
+    fn read_ahead(fd: i32, entry: &FdEntry, offset: u64, n: usize) {
+        if let Some(window) = entry.readahead.observe(offset, n, entry.size) {
+            Self::prefetch(fd, &entry.readahead, window);
+        }
+    }
+
+    /// Read `len` bytes at `from` of `fd` on the readahead worker. The
+    /// job runs against the process-global context and only while `fd`
+    /// still names the same open file (`ra`); anything else abandons the
+    /// window. It never queues on the context lock: a reader of `fd` may
+    /// be waiting for this window under the shared lock, and a writer
+    /// queued between them would otherwise wedge all three.
+    fn prefetch(fd: i32, ra: &Arc<Readahead>, (from, len): (u64, u64)) {
+        let job_ra = Arc::clone(ra);
+        let job = move || {
+            let ctx = match context().try_read() {
+                Ok(ctx) => ctx,
+                Err(TryLockError::Poisoned(e)) => e.into_inner(),
+                Err(TryLockError::WouldBlock) => {
+                    job_ra.abandon();
+                    return;
+                }
+            };
+            let target = ctx
+                .lookup_fd(fd)
+                .filter(|entry| Arc::ptr_eq(&entry.readahead, &job_ra))
+                .and_then(|entry| Some((entry, ctx.mounts.get(&entry.owner)?)));
+            let Some((entry, mount)) = target else {
+                job_ra.abandon();
+                return;
+            };
+            let mut data = vec![0u8; len as usize];
+            let mut got = 0;
+            while got < data.len() {
+                match mount
+                    .backend
+                    .pread(entry.rel(), &mut data[got..], from + got as u64)
+                {
+                    Ok(n) if n > 0 => got += n,
+                    _ => break,
+                }
+            }
+            // A mount keeping a read cache now holds the window there.
+            match mount.backend.cache_stats() {
+                Some(_) => job_ra.warmed(from, got as u64),
+                None => {
+                    data.truncate(got);
+                    job_ra.fill(from, data);
+                }
+            }
         };
-        if !(0..=size).contains(&target) {
+        if !readahead::submit(Box::new(job)) {
+            ra.abandon();
+        }
+    }
+
+    /// tebako_fs_fadvise: `posix_fadvise` advice for `len` bytes at
+    /// `offset` of `fd` (`len` 0: to the end). A hint: `WILLNEED` and
+    /// `SEQUENTIAL` schedule a prefetch, `RANDOM` stops the detector,
+    /// `DONTNEED` drops what was prefetched (see [`crate::readahead`]).
+    pub fn advise(&self, fd: i32, offset: i64, len: i64, advice: i32) -> Result<(), i32> {
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        if offset < 0 || len < 0 {
             return Err(libc::EINVAL);
         }
-        entry.pos = target as u64;
-        Ok(target)
+        let pos = entry.pos.load(Ordering::Acquire);
+        let window = entry
+            .readahead
+            .advise(advice, offset as u64, len as u64, pos, entry.size)?;
+        if let Some(window) = window {
+            Self::prefetch(fd, &entry.readahead, window);
+        }
+        Ok(())
+    }
+
+    /// The host file an mmap of `fd` is served from when its mount shares
+    /// mapped pages ([`crate::mapped_files`]): the whole file, materialized
+    /// by the first call per mount. ENOTSUP when the mount does not share
+    /// (sharing off, or a COW mount whose bytes may change); on any error
+    /// the caller fills a private mapping as before, so only a first
+    /// materialization emits a `materialize` trace event (dest `mmap`).
+    pub fn map_source(&self, fd: i32) -> Result<Arc<std::fs::File>, i32> {
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        let mount = self.mounts.get(&entry.owner).ok_or(libc::EBADF)?;
+        if mount.mode != MountMode::ReadOnly || !mount.mapped.is_enabled() {
+            return Err(libc::ENOTSUP);
+        }
+        let trace_start = trace::Start::now();
+        let (file, opened) = mount.mapped.source(entry.rel(), entry.size, |buf, at| {
+            mount.backend.pread(entry.rel(), buf, at)
+        })?;
+        if let (Some(start), true) = (trace_start, opened) {
+            trace::emit(
+                trace::Event::new(trace::Op::Materialize, &entry.path, "ok:mmap-source")
+                    .detail("dest", Value::String("mmap".to_string()))
+                    .detail("bytes", trace::num(entry.size))
+                    .dur(start),
+            );
+        }
+        Ok(file)
+    }
+
+    /// tebako_fs_lseek (shared lock, like read: the position is atomic).
+    pub fn lseek(&self, fd: i32, offset: i64, whence: i32) -> Result<i64, i32> {
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        let size = entry.size as i64;
+        let mut result = Err(libc::EINVAL);
+        // fetch_update: SEEK_CUR is relative to the position at the swap
+        // (the closure re-runs on a lost race; `result` tracks the last run).
+        let _ = entry
+            .pos
+            .fetch_update(Ordering::AcqRel, Ordering::Acquire, |pos| {
+                result = match whence {
+                    libc::SEEK_SET => Ok(offset),
+                    libc::SEEK_CUR => Ok(pos as i64 + offset),
+                    libc::SEEK_END => Ok(size + offset),
+                    _ => Err(libc::EINVAL),
+                }
+                .and_then(|target| {
+                    if (0..=size).contains(&target) {
+                        Ok(target)
+                    } else {
+                        Err(libc::EINVAL)
+                    }
+                });
+                result.ok().map(|target| target as u64)
+            });
+        result
     }
 
     /// tebako_fs_close.
@@ -929,7 +1257,7 @@ impl FsContext {
 
     /// tebako_fs_opendir. Returns the raw dir-handle id.
     pub fn opendir(&mut self, path: &str) -> Result<usize, i32> {
-        let path = &Self::normalize(path);
+        let path = &*Self::normalize(path);
         if self.mounts.is_empty() {
             return Err(libc::ENODEV);
         }
@@ -1034,7 +1362,11 @@ impl FsContext {
 
     /// tebako_fs_stat.
     pub fn stat(&self, path: &str) -> Result<RawStat, i32> {
-        let path = &Self::normalize(path);
+        self.stat_normalized(&Self::normalize(path))
+    }
+
+    /// tebako_fs_stat's body over an already-normalized path.
+    fn stat_normalized(&self, path: &str) -> Result<RawStat, i32> {
         let trace_start = trace::Start::now();
         if self.mounts.is_empty() {
             if let Some(start) = trace_start {
@@ -1052,7 +1384,7 @@ impl FsContext {
         if let Some(tail) = Self::dlmap_tail(path) {
             if let Some(mount) = self.find_mount(&tail) {
                 let rel = Self::relative_path(mount, &tail);
-                if let Ok(st) = mount.backend.stat(rel) {
+                if let Ok(st) = Self::backend_stat(mount, rel) {
                     if let Some(start) = trace_start {
                         trace::emit(
                             trace::Event::new(
@@ -1060,7 +1392,7 @@ impl FsContext {
                                 path,
                                 format!("image:{}", mount.mount_point),
                             )
-                            .detail("dlmap_redirect", Value::String(tail))
+                            .detail("dlmap_redirect", Value::String(tail.to_string()))
                             .dur(start),
                         );
                     }
@@ -1090,7 +1422,7 @@ impl FsContext {
             return Err(libc::ENOENT);
         };
         let rel = Self::relative_path(mount, path);
-        match mount.backend.stat(rel) {
+        match Self::backend_stat(mount, rel) {
             // Covered but not held: a host path (see open()).
             Err(e) if e == libc::ENOENT => {
                 if let Err(e) = self.host_check(path, HostAccess::Ro) {
@@ -1140,9 +1472,9 @@ impl FsContext {
 
     /// tebako_fs_fstat (re-dispatched by the fd's path, like C++).
     pub fn fstat(&self, fd: i32) -> Result<RawStat, i32> {
-        let (_, entry) = self.lookup_fd(fd).ok_or(libc::EBADF)?;
-        let path = entry.path.clone();
-        self.stat(&path)
+        let entry = self.lookup_fd(fd).ok_or(libc::EBADF)?;
+        // The fd's path was normalized at open: no re-normalization.
+        self.stat_normalized(&entry.path)
     }
 
     // ---------------------------------------------------------------
@@ -1177,7 +1509,7 @@ impl FsContext {
     /// The writable backend owning `path`, with its mount and the
     /// in-image path.
     fn writable_for(&self, path: &str) -> Result<(&Mount, &dyn WritableBackend, String), i32> {
-        let path = &Self::normalize(path);
+        let path = &*Self::normalize(path);
         if self.mounts.is_empty() {
             return Err(libc::ENODEV);
         }
@@ -1201,7 +1533,12 @@ impl FsContext {
     /// out-of-area EROFS (spec 24 §5 — on a COW mount EROFS comes only
     /// from the declared-area gate; the overlay's own host failures
     /// surface as their own errnos).
+    ///
+    /// Any write verb may change the namespace (pwrite creates parents,
+    /// remove whiteouts a held tree): the mount's miss cache is flushed
+    /// whatever the outcome.
     fn write_gated<T>(&self, mount: &Mount, path: &str, result: Result<T, i32>) -> Result<T, i32> {
+        mount.misses.clear();
         match result {
             Err(e) if e == libc::EROFS && mount.mode == MountMode::Cow => {
                 self.journal_write_denial(path, &mount.mount_point);
@@ -1263,52 +1600,66 @@ impl FsContext {
     /// host passthrough with the wrong errno). A covered path with NO
     /// existing in-image ancestor is a host path (the spec 08
     /// passthrough, same as open/stat): with a `/` mount in play, this
-    /// is what keeps host writes legal.
+    /// is what keeps host writes legal. The verdict for a path the image
+    /// does not hold itself is memoized in the mount's miss cache.
     pub fn path_is_held(&self, path: &str) -> bool {
-        let path = &Self::normalize(path);
+        let path = &*Self::normalize(path);
         let Some(mount) = self.find_mount(path) else {
             return false;
         };
-        let mut relative = Self::relative_path(mount, path).to_string();
+        let rel = Self::relative_path(mount, path);
+        let cache = Self::miss_cache(mount);
+        if let Some(held) = cache.and_then(|c| c.held(rel)) {
+            return held;
+        }
+        let mut relative = rel;
         loop {
-            let held_here = mount.backend.has_entry_or_children(&relative);
+            let held_here = mount.backend.has_entry_or_children(relative);
             tebako_log::log!(
                 tebako_log::Level::Trace,
                 "tfs",
                 "path_is_held path={path} probe={relative} held_here={held_here}"
             );
             if held_here {
+                // A held path itself answers in one probe: only a miss
+                // (the walk went past `rel`) is worth remembering.
+                if let (true, Some(cache)) = (relative.len() < rel.len(), cache) {
+                    cache.record_held(rel, true);
+                }
                 return true;
             }
             let Some((parent, _)) = relative.rsplit_once('/') else {
+                if let Some(cache) = cache {
+                    cache.record_held(rel, false);
+                }
                 return false;
             };
-            relative = parent.to_string();
+            relative = parent;
         }
     }
 
     /// The mount table in the `TEBAKO_TFS_MOUNTS` grammar
-    /// ("image:mount,image:mount,…") — the env a spawned child needs to
+    /// ("image:mount[?options],…", each mount's read tuning included)
+    /// — the env a spawned child needs to
     /// re-establish this namespace through the preload shim. Only
     /// file-backed mounts serialize; memory mounts have no image path
     /// and are skipped (a child cannot remount them anyway).
     pub fn mounts_env(&self) -> Option<std::ffi::CString> {
-        let mut out = String::new();
-        for mount in self.mounts.values() {
-            let Some(archive) = &mount.archive_path else {
-                continue;
-            };
-            if !out.is_empty() {
-                out.push(',');
-            }
-            out.push_str(&archive.to_string_lossy());
-            out.push(':');
-            out.push_str(&mount.mount_point);
-        }
-        if out.is_empty() {
+        let decls: Vec<crate::mount_spec::MountDecl> = self
+            .mounts
+            .values()
+            .filter_map(|mount| {
+                Some(crate::mount_spec::MountDecl {
+                    image: mount.archive_path.as_ref()?.to_string_lossy().into_owned(),
+                    mount: mount.mount_point.clone(),
+                    options: mount.options,
+                })
+            })
+            .collect();
+        if decls.is_empty() {
             None
         } else {
-            std::ffi::CString::new(out).ok()
+            std::ffi::CString::new(crate::mount_spec::to_env_spec(&decls)).ok()
         }
     }
 
@@ -1503,7 +1854,7 @@ impl FsContext {
         path: &str,
         surface: DlSurface,
     ) -> Result<std::ffi::CString, i32> {
-        let path = &Self::normalize(path);
+        let path = &*Self::normalize(path);
         let trace_start = trace::Start::now();
         // The closure walk's trace record, filled by the top
         // extract_for_exec frame only (recursion passes None).
@@ -1568,7 +1919,7 @@ impl FsContext {
                 ),
             };
             if let Some(event) = event {
-                let event = if effective == path.as_str() {
+                let event = if effective == path {
                     event
                 } else {
                     event.detail("effective", Value::String(effective.to_string()))
@@ -1617,7 +1968,7 @@ impl FsContext {
     /// The shared exec/spawn routing: one decision, the op naming the
     /// syscall surface it serves (the §2 table's single exec/spawn row).
     fn exec_materialize_op(&mut self, path: &str, op: trace::Op) -> Result<std::ffi::CString, i32> {
-        let normalized = Self::normalize(path);
+        let normalized = Self::normalize(path).into_owned();
         let trace_start = trace::Start::now();
         if std::env::var_os("TEBAKO_DEBUG_TFS").is_some() {
             eprintln!("[tfs] exec_materialize: path={path} normalized={normalized}");
@@ -1844,7 +2195,7 @@ impl FsContext {
         visited: &mut std::collections::HashSet<String>,
         mut closure_trace: Option<&mut trace::ClosureTrace>,
     ) -> Result<std::path::PathBuf, i32> {
-        let path = &Self::normalize(path);
+        let path = &*Self::normalize(path);
         let trace_start = trace::Start::now();
         let dest_token = match dest {
             ClosureDest::Dlcache => "dlcache",
@@ -2154,25 +2505,27 @@ impl FsContext {
         };
         if let Some(rest) = name.strip_prefix("@rpath/") {
             for rp in own_rpaths.iter().chain(chain_rpaths) {
-                push(Self::normalize(&format!(
-                    "{}/{rest}",
-                    expand_loader_vars(rp, referrer_dir, exe_dir)
-                )));
+                push(
+                    Self::normalize(&format!(
+                        "{}/{rest}",
+                        expand_loader_vars(rp, referrer_dir, exe_dir)
+                    ))
+                    .into_owned(),
+                );
             }
         } else if name.starts_with('@') || name.contains('$') {
-            push(Self::normalize(&expand_loader_vars(
-                name,
-                referrer_dir,
-                exe_dir,
-            )));
+            push(Self::normalize(&expand_loader_vars(name, referrer_dir, exe_dir)).into_owned());
         } else if name.starts_with('/') {
-            push(Self::normalize(name));
+            push(Self::normalize(name).into_owned());
         } else {
             for rp in own_rpaths.iter().chain(chain_rpaths) {
-                push(Self::normalize(&format!(
-                    "{}/{name}",
-                    expand_loader_vars(rp, referrer_dir, exe_dir)
-                )));
+                push(
+                    Self::normalize(&format!(
+                        "{}/{name}",
+                        expand_loader_vars(rp, referrer_dir, exe_dir)
+                    ))
+                    .into_owned(),
+                );
             }
         }
         candidates.into_iter().find(|c| self.held_file(c))
@@ -2209,11 +2562,11 @@ impl FsContext {
                 && name.as_bytes()[1] == b':'
                 && name.as_bytes()[2] == b'/');
         let candidate = if rooted {
-            Self::normalize(name)
+            Self::normalize(name).into_owned()
         } else {
             // Bare and relative names alike anchor at the importer's
             // own directory — the one and only PE candidate.
-            Self::normalize(&format!("{referrer_dir}/{name}"))
+            Self::normalize(&format!("{referrer_dir}/{name}")).into_owned()
         };
         self.held_file(&candidate).then_some(candidate)
     }
@@ -2247,8 +2600,27 @@ impl FsContext {
     }
 }
 
+/// Debug-log one mount's miss-cache tallies as it goes away.
+fn log_miss_stats(mount: &Mount) {
+    if let Some(cache) = FsContext::miss_cache(mount) {
+        let MissStats {
+            hits,
+            misses,
+            entries,
+        } = cache.stats();
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "miss cache mount={} hits={hits} misses={misses} entries={entries}",
+            mount.mount_point
+        );
+    }
+}
+
 /// Mount-point membership with path-component boundaries
-/// (mirrors the C++ `path_is_in_mount`).
+/// (mirrors the C++ `path_is_in_mount`). The reference semantics
+/// [`MountTrie`] compiles; dispatch itself never scans with it.
+#[cfg(test)]
 fn path_is_in_mount(path: &str, mount: &str) -> bool {
     if mount.is_empty() || path.len() < mount.len() || !path.starts_with(mount) {
         return false;
@@ -2262,6 +2634,73 @@ fn path_is_in_mount(path: &str, mount: &str) -> bool {
     path.as_bytes()[mount.len()] == b'/'
 }
 
+/// The compiled longest-prefix dispatch: a trie over mount-point
+/// components (`/`-split, so `"/__tebako__"` is `["", "__tebako__"]`),
+/// answering exactly what [`path_is_in_mount`] + longest-point would.
+/// A point without a trailing slash owns its node's path and everything
+/// below it; a point WITH one (`"/"`, `"/a/"`) is recorded on the node of
+/// its slash-stripped spelling and owns only paths that continue past
+/// it. Deeper always wins (a deeper point is the longer string), and
+/// on one node the slashed point beats the bare one for the same reason.
+struct MountTrie {
+    /// Handle of the point spelled exactly as this node's path.
+    bare: Option<i32>,
+    /// Handle of the point spelled as this node's path plus `/`.
+    slashed: Option<i32>,
+    children: BTreeMap<String, MountTrie>,
+}
+
+impl MountTrie {
+    const fn new() -> Self {
+        MountTrie {
+            bare: None,
+            slashed: None,
+            children: BTreeMap::new(),
+        }
+    }
+
+    fn insert(&mut self, mount_point: &str, handle: i32) {
+        if mount_point.is_empty() {
+            return; // path_is_in_mount: an empty point owns nothing
+        }
+        let (spelling, slashed) = match mount_point.strip_suffix('/') {
+            Some(stripped) => (stripped, true),
+            None => (mount_point, false),
+        };
+        let mut node = self;
+        for component in spelling.split('/') {
+            node = node
+                .children
+                .entry(component.to_string())
+                .or_insert_with(MountTrie::new);
+        }
+        if slashed {
+            node.slashed = Some(handle);
+        } else {
+            node.bare = Some(handle);
+        }
+    }
+
+    fn lookup(&self, path: &str) -> Option<i32> {
+        let mut best = None;
+        let mut node = self;
+        let mut components = path.split('/').peekable();
+        while let Some(component) = components.next() {
+            let Some(child) = node.children.get(component) else {
+                break;
+            };
+            node = child;
+            if node.bare.is_some() {
+                best = node.bare;
+            }
+            if node.slashed.is_some() && components.peek().is_some() {
+                best = node.slashed;
+            }
+        }
+        best
+    }
+}
+
 /// Basename of a mount point for per-mount extraction subtrees
 /// (mirrors the C++ `mount_point_basename`): strips trailing slashes and
 /// takes the last component; "root" when nothing usable remains.
@@ -2275,9 +2714,12 @@ fn mount_point_basename(mount_point: &str) -> &str {
     }
 }
 
+/// The create_dl_tmpdir marker component's fixed prefix.
+const DLMAP_MARKER_PREFIX: &str = "tebako-dl-";
+
 /// A `tebako-dl-<hex>` path component (the create_dl_tmpdir marker).
 fn is_dlmap_marker(component: &str) -> bool {
-    let Some(hex) = component.strip_prefix("tebako-dl-") else {
+    let Some(hex) = component.strip_prefix(DLMAP_MARKER_PREFIX) else {
         return false;
     };
     !hex.is_empty() && hex.bytes().all(|b| b.is_ascii_hexdigit())
@@ -2602,6 +3044,178 @@ mod tests {
         let _ = std::fs::remove_dir_all(&dir);
     }
 
+    #[test]
+    fn tuned_mounts_report_their_read_cache() {
+        let dir = std::env::temp_dir().join(format!("tfs-cache-stats-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(&dir).unwrap();
+        let image = fixture_zip(&dir);
+        let image = image.to_str().unwrap();
+        let mut ctx = FsContext::new();
+        let options = crate::mount::MountOptions {
+            cache_bytes: 1 << 20,
+            ..Default::default()
+        };
+        let tuned = crate::mount::build_from_file_with_options(
+            image,
+            "/tuned",
+            MountMode::ReadOnly,
+            None,
+            &options,
+        )
+        .unwrap();
+        ctx.mount_checked(tuned).unwrap();
+        ctx.mount_checked(crate::mount::build_from_file(image, "/plain").unwrap())
+            .unwrap();
+
+        let fd = ctx.open("/tuned/data/secret.txt", libc::O_RDONLY).unwrap();
+        let mut buf = [0u8; 4];
+        for _ in 0..2 {
+            assert_eq!(ctx.pread(fd, &mut buf, 0).unwrap(), 4);
+        }
+        ctx.close(fd).unwrap();
+        let stats = ctx.cache_stats();
+        assert_eq!(stats.len(), 1, "the untuned mount has no read cache");
+        assert_eq!(stats[0].0, "/tuned");
+        assert_eq!((stats[0].1.hits, stats[0].1.misses), (1, 1));
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn repeated_misses_are_served_from_the_mount_miss_cache() {
+        let dir = std::env::temp_dir().join(format!("tfs-misses-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(&dir).unwrap();
+        let image = fixture_zip(&dir);
+        let mut ctx = FsContext::new();
+        let mount = crate::mount::build_from_file(image.to_str().unwrap(), "/tfs").unwrap();
+        ctx.mount_checked(mount).unwrap();
+        let stats = |ctx: &FsContext| ctx.miss_stats()[0].1;
+
+        for _ in 0..3 {
+            assert_eq!(ctx.stat("/tfs/lib/nope.rb").unwrap_err(), libc::ENOENT);
+        }
+        let s = stats(&ctx);
+        assert_eq!((s.hits, s.misses, s.entries), (2, 1, 1));
+        // A held entry is never cached; its answer is unchanged.
+        assert_eq!(ctx.stat("/tfs/data/secret.txt").unwrap().size, 4);
+        assert_eq!(stats(&ctx).entries, 1);
+
+        // The held verdict rides the same entry, both ways.
+        for _ in 0..2 {
+            assert!(ctx.path_is_held("/tfs/data/new.txt"));
+            assert!(!ctx.path_is_held("/tfs/lib/nope.rb"));
+        }
+        let s = stats(&ctx);
+        assert_eq!((s.hits, s.entries), (4, 2));
+
+        // COW: a write flushes, so the next stat sees the new file.
+        let overlay = dir.join("ov");
+        let cow = crate::mount::build_from_file_with_mode(
+            image.to_str().unwrap(),
+            "/cow",
+            MountMode::Cow,
+            Some(&crate::mount::Overlay::new(overlay.to_str().unwrap())),
+        )
+        .unwrap();
+        ctx.mount_checked(cow).unwrap();
+        assert_eq!(ctx.stat("/cow/made.txt").unwrap_err(), libc::ENOENT);
+        assert_eq!(ctx.stat("/cow/made.txt").unwrap_err(), libc::ENOENT);
+        assert_eq!(ctx.pwrite_path("/cow/made.txt", b"abc", 0), Ok(3));
+        assert_eq!(ctx.stat("/cow/made.txt").unwrap().size, 3);
+        assert_eq!(ctx.remove_path("/cow/made.txt"), Ok(()));
+        assert_eq!(ctx.stat("/cow/made.txt").unwrap_err(), libc::ENOENT);
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn mount_trie_agrees_with_the_longest_prefix_scan() {
+        let points = [
+            "/",
+            "/a",
+            "/a/",
+            "/a/b",
+            "/a//",
+            "/ab",
+            "A:/t",
+            "/__tebako__",
+            "/x/y/z",
+        ];
+        let paths = [
+            "",
+            "/",
+            "//",
+            "/a",
+            "/a/",
+            "/a/b",
+            "/a/bc",
+            "/a/b/c",
+            "/a//",
+            "/a//x",
+            "/ab",
+            "/ab/c",
+            "/abc",
+            "A:/t",
+            "A:/t/x",
+            "A:/tx",
+            "A:",
+            "a",
+            "/__tebako__",
+            "/__tebako__/lib/x.rb",
+            "/x/y",
+            "/x/y/z/w",
+        ];
+        // Every subset of the points is a mount table worth checking.
+        for mask in 0u32..(1 << points.len()) {
+            let table: Vec<(i32, &str)> = points
+                .iter()
+                .enumerate()
+                .filter(|(i, _)| mask & (1 << i) != 0)
+                .map(|(i, p)| (i as i32, *p))
+                .collect();
+            let mut trie = MountTrie::new();
+            for (handle, point) in &table {
+                trie.insert(point, *handle);
+            }
+            for path in paths {
+                let scan = table
+                    .iter()
+                    .filter(|(_, point)| path_is_in_mount(path, point))
+                    .max_by_key(|(_, point)| point.len())
+                    .map(|(handle, _)| *handle);
+                assert_eq!(trie.lookup(path), scan, "path {path:?} over {table:?}");
+            }
+        }
+    }
+
+    #[test]
+    fn normalize_borrows_clean_paths_and_rebuilds_the_rest() {
+        for clean in ["", "/", "/a/b.rb", "rel/x", "A:/t/lib"] {
+            assert!(matches!(FsContext::normalize(clean), Cow::Borrowed(p) if p == clean));
+        }
+        for (raw, want) in [
+            ("/a/./b", "/a/b"),
+            ("/a/../b", "/b"),
+            ("/../a", "/a"),
+            ("/a//b/", "/a/b"),
+            ("//", "/"),
+            ("lib/../x.yaml", "x.yaml"),
+        ] {
+            assert_eq!(FsContext::normalize(raw), want);
+        }
+        assert_eq!(FsContext::dlmap_tail("/tmp/x/plain/lib.so"), None);
+        assert_eq!(FsContext::dlmap_tail("/tmp/tebako-dl-1f"), None);
+        assert_eq!(
+            FsContext::dlmap_tail("/tmp/tebako-dl-1f/__tebako__/a/../lib.so").as_deref(),
+            Some("/__tebako__/lib.so")
+        );
+        assert!(matches!(
+            FsContext::dlmap_tail("/tmp/tebako-dl-1f/__tebako__/lib.so"),
+            Some(Cow::Borrowed("/__tebako__/lib.so"))
+        ));
+    }
+
     #[test]
     fn write_gate_denials_journal_vfs_deny() {
         // Spec 24 §5: writes into held trees are EROFS and journaled
@@ -2709,6 +3323,9 @@ mod tests {
             archive_path: None,
             backend: Box::new(backend),
             mode: crate::mount::MountMode::ReadOnly,
+            misses: MissCache::default(),
+            options: Default::default(),
+            mapped: Default::default(),
         };
         ctx.mount_checked(mount).unwrap();
         let skipped = ctx.extract_all(&dest).unwrap();
@@ -3150,6 +3767,9 @@ mod tests {
             archive_path: None,
             backend: Box::new(backend),
             mode: crate::mount::MountMode::ReadOnly,
+            misses: MissCache::default(),
+            options: Default::default(),
+            mapped: Default::default(),
         };
         ctx.mount_checked(mount).unwrap();
     }
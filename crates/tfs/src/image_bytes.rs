@@ -0,0 +1,278 @@
+//! Image bytes a backend parses and serves in place: a read-only memory
+//! mapping of an archive file (or of a region of one) on unix, an owned
+//! buffer everywhere else and for copied in-memory mounts, or a caller's
+//! buffer lent to a borrowed in-memory mount.
+//!
+//! A mapped image costs no heap and no upfront read: resident memory
+//! tracks the pages a workload actually touches, and every process
+//! mounting the same runtime image shares one copy in the page cache.
+//! The mapping is `MAP_PRIVATE` + `PROT_READ`; like any file mapping it
+//! assumes the image is not truncated underneath the mount (a packaged
+//! runtime image never is — the same assumption the tar backend's
+//! positioned reads make).
+//!
+//! Whatever the variant, the bytes never move for the value's lifetime
+//! (a mapping is fixed, a Vec's heap block stays put when the Vec is
+//! moved, a lent buffer is the caller's): backends may hand the address
+//! to C readers that keep it.
+
+use std::fs::File;
+use std::ops::Deref;
+
+/// An image's bytes (see the module docs).
+pub enum ImageBytes {
+    /// An owned buffer (in-memory mounts; non-unix file mounts).
+    Owned(Vec<u8>),
+    /// A read-only mapping of a file region.
+    #[cfg(unix)]
+    Mapped(Mapping),
+    /// A caller's buffer, lent until this value drops (see
+    /// [`ImageBytes::borrowed`]).
+    Borrowed(Lent),
+}
+
+impl std::fmt::Debug for ImageBytes {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            ImageBytes::Owned(data) => write!(f, "ImageBytes::Owned({} bytes)", data.len()),
+            #[cfg(unix)]
+            ImageBytes::Mapped(map) => write!(f, "ImageBytes::Mapped({} bytes)", map.len),
+            ImageBytes::Borrowed(lent) => write!(f, "ImageBytes::Borrowed({} bytes)", lent.len),
+        }
+    }
+}
+
+impl ImageBytes {
+    /// The `length` bytes of `file` starting at `offset` (`EINVAL` when
+    /// the region runs past the end of the file, `EIO` on a failed map
+    /// or read).
+    pub fn map_file(file: &File, offset: u64, length: u64) -> Result<ImageBytes, i32> {
+        let size = file.metadata().map_err(|_| libc::EIO)?.len();
+        match offset.checked_add(length) {
+            Some(end) if end <= size => {}
+            _ => return Err(libc::EINVAL),
+        }
+        let length = usize::try_from(length).map_err(|_| libc::ENOMEM)?;
+        if length == 0 {
+            return Ok(ImageBytes::Owned(Vec::new())); // mmap refuses empty maps
+        }
+        Self::map_region(file, offset, length)
+    }
+
+    /// The `len` bytes at `ptr`, owned by the caller — no copy. `release`
+    /// runs exactly once, when the value drops: the moment nothing reads
+    /// the buffer any more (for a mount, at unmount — or at once when the
+    /// mount fails or its backend copies what it needs).
+    ///
+    /// # Safety
+    /// `ptr` must point to `len` readable bytes that stay valid and
+    /// unchanged until `release` runs (or, without one, until the value
+    /// drops).
+    pub unsafe fn borrowed(
+        ptr: *const u8,
+        len: usize,
+        release: Option<Box<dyn FnOnce() + Send + Sync>>,
+    ) -> ImageBytes {
+        ImageBytes::Borrowed(Lent { ptr, len, release })
+    }
+
+    /// Map `file` whole.
+    pub fn map_whole_file(file: &File) -> Result<ImageBytes, i32> {
+        let size = file.metadata().map_err(|_| libc::EIO)?.len();
+        Self::map_file(file, 0, size)
+    }
+
+    #[cfg(unix)]
+    fn map_region(file: &File, offset: u64, length: usize) -> Result<ImageBytes, i32> {
+        use std::os::unix::io::AsRawFd;
+        // SAFETY: sysconf has no preconditions.
+        let page = match unsafe { libc::sysconf(libc::_SC_PAGESIZE) } {
+            n if n > 0 => n as u64,
+            _ => 4096,
+        };
+        // mmap offsets must be page-aligned: map from the page holding
+        // `offset` and skip the leading bytes.
+        let skew = (offset % page) as usize;
+        let map_len = length.checked_add(skew).ok_or(libc::ENOMEM)?;
+        let map_offset = libc::off_t::try_from(offset - skew as u64).map_err(|_| libc::EINVAL)?;
+        // SAFETY: a fresh private read-only mapping of an open fd; the
+        // kernel validates every argument. The fd may close afterwards —
+        // the mapping keeps its own reference to the file.
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                map_len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                map_offset,
+            )
+        };
+        if base == libc::MAP_FAILED {
+            return Err(std::io::Error::last_os_error()
+                .raw_os_error()
+                .unwrap_or(libc::EIO));
+        }
+        Ok(ImageBytes::Mapped(Mapping {
+            base,
+            map_len,
+            skew,
+            len: length,
+        }))
+    }
+
+    #[cfg(not(unix))]
+    fn map_region(file: &File, offset: u64, length: usize) -> Result<ImageBytes, i32> {
+        use std::io::{Read, Seek, SeekFrom};
+        let mut file = file;
+        let mut data = vec![0u8; length];
+        file.seek(SeekFrom::Start(offset)).map_err(|_| libc::EIO)?;
+        file.read_exact(&mut data).map_err(|_| libc::EIO)?;
+        Ok(ImageBytes::Owned(data))
+    }
+
+    /// True when the bytes are a file mapping (not a heap copy).
+    pub fn is_mapped(&self) -> bool {
+        match self {
+            ImageBytes::Owned(_) | ImageBytes::Borrowed(_) => false,
+            #[cfg(unix)]
+            ImageBytes::Mapped(_) => true,
+        }
+    }
+
+    /// True when the bytes are a caller's lent buffer.
+    pub fn is_borrowed(&self) -> bool {
+        matches!(self, ImageBytes::Borrowed(_))
+    }
+}
+
+impl From<Vec<u8>> for ImageBytes {
+    fn from(data: Vec<u8>) -> ImageBytes {
+        ImageBytes::Owned(data)
+    }
+}
+
+impl Deref for ImageBytes {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        match self {
+            ImageBytes::Owned(data) => data,
+            #[cfg(unix)]
+            // SAFETY: the mapping is live for `self`'s lifetime, readable,
+            // and `skew + len == map_len`.
+            ImageBytes::Mapped(map) => unsafe {
+                std::slice::from_raw_parts(map.base.cast::<u8>().add(map.skew), map.len)
+            },
+            // SAFETY: `borrowed`'s contract — valid and unchanged until
+            // the value (and with it the release) drops.
+            ImageBytes::Borrowed(lent) => unsafe { std::slice::from_raw_parts(lent.ptr, lent.len) },
+        }
+    }
+}
+
+/// A live `mmap` region, unmapped on drop.
+#[cfg(unix)]
+pub struct Mapping {
+    base: *mut libc::c_void,
+    map_len: usize,
+    /// Bytes between the page-aligned base and the region start.
+    skew: usize,
+    len: usize,
+}
+
+// The mapping is read-only for its whole life: sharing it is sharing a
+// `&[u8]`.
+#[cfg(unix)]
+unsafe impl Send for Mapping {}
+#[cfg(unix)]
+unsafe impl Sync for Mapping {}
+
+#[cfg(unix)]
+impl Drop for Mapping {
+    fn drop(&mut self) {
+        // SAFETY: `base`/`map_len` are exactly what mmap returned.
+        unsafe { libc::munmap(self.base, self.map_len) };
+    }
+}
+
+/// A lent buffer and what to do when it is handed back.
+pub struct Lent {
+    ptr: *const u8,
+    len: usize,
+    release: Option<Box<dyn FnOnce() + Send + Sync>>,
+}
+
+// Read-only for its whole life, like a mapping.
+unsafe impl Send for Lent {}
+unsafe impl Sync for Lent {}
+
+impl Drop for Lent {
+    fn drop(&mut self) {
+        if let Some(release) = self.release.take() {
+            release();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Write as _;
+
+    #[test]
+    fn regions_at_unaligned_offsets_read_back_exactly() {
+        let mut tmp = tempfile::NamedTempFile::new().unwrap();
+        let data: Vec<u8> = (0..20_000u32).map(|i| (i % 251) as u8).collect();
+        tmp.write_all(&data).unwrap();
+        let file = tmp.reopen().unwrap();
+
+        let whole = ImageBytes::map_whole_file(&file).unwrap();
+        assert_eq!(&whole[..], &data[..]);
+        assert_eq!(whole.is_mapped(), cfg!(unix));
+
+        for (offset, length) in [(1usize, 100usize), (4095, 4097), (12_345, 7_655)] {
+            let region = ImageBytes::map_file(&file, offset as u64, length as u64).unwrap();
+            assert_eq!(
+                &region[..],
+                &data[offset..offset + length],
+                "{offset}+{length}"
+            );
+        }
+        assert!(ImageBytes::map_file(&file, 0, 0).unwrap().is_empty());
+        assert_eq!(
+            ImageBytes::map_file(&file, 19_999, 2).err(),
+            Some(libc::EINVAL),
+            "a region past EOF would fault on touch"
+        );
+    }
+
+    #[test]
+    fn lent_buffers_are_read_in_place_and_released_once() {
+        use std::sync::atomic::{AtomicUsize, Ordering};
+        use std::sync::Arc;
+
+        let data = vec![7u8; 1000];
+        let released = Arc::new(AtomicUsize::new(0));
+        let counter = Arc::clone(&released);
+        let bytes = unsafe {
+            ImageBytes::borrowed(
+                data.as_ptr(),
+                data.len(),
+                Some(Box::new(move || {
+                    counter.fetch_add(1, Ordering::SeqCst);
+                })),
+            )
+        };
+        assert_eq!(bytes.as_ptr(), data.as_ptr(), "no copy");
+        assert!(bytes.is_borrowed() && !bytes.is_mapped());
+        let moved = bytes;
+        assert_eq!(
+            released.load(Ordering::SeqCst),
+            0,
+            "a move is not a release"
+        );
+        drop(moved);
+        assert_eq!(released.load(Ordering::SeqCst), 1);
+    }
+}
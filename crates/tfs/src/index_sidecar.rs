@@ -0,0 +1,281 @@
+//! Persisted mount indexes: a backend whose mount pass is expensive (the
+//! tar backend's streaming index — for `tar.gz` a full inflate to place
+//! the checkpoints) saves what it built to a sidecar in the exec cache,
+//! and the next mount of the same image — typically a child process
+//! re-mounting through `TEBAKO_TFS_MOUNTS` — loads it instead of
+//! re-scanning.
+//!
+//! Location: `$TEBAKO_EXEC_CACHE/tebako-index/<kind>-<key>-<offset>-<length>.idx`.
+//! `<key>` is the driver's exec-cache image key (spec 22 §6): the
+//! image's `<path>.sha256` store sidecar when present, else a key of the
+//! path string. With no exec cache named there is no sidecar — nothing
+//! is left behind in a bare temp dir.
+//!
+//! A path key alone cannot see an image rewritten in place, so every
+//! sidecar carries a stamp of the bytes it indexes ([`file_stamp`]: the
+//! file's size and mtime, the region, and its first and last 4 KiB) and
+//! a trailing SHA-256 of itself. A sidecar whose stamp or digest does not
+//! match is ignored (and rewritten by the re-scan). Writes are atomic
+//! (temp file + rename) and best-effort: a read-only or full cache only
+//! costs the re-scan.
+//!
+//! The payload is the backend's own little-endian encoding, written with
+//! [`Encoder`] and read back with [`Decoder`].
+
+use std::fs::File;
+use std::path::{Path, PathBuf};
+
+use sha2::{Digest as _, Sha256};
+
+/// Sidecar magic (format version in the last byte).
+const MAGIC: &[u8; 8] = b"TBKIDX\x00\x01";
+/// Bytes of the region's head and tail folded into the stamp.
+const STAMP_SAMPLE: u64 = 4096;
+/// Directory under the exec cache.
+const DIR: &str = "tebako-index";
+
+/// Identity of the bytes an index was built from.
+pub type Stamp = [u8; 32];
+
+/// Lowercase hex (the exec-cache key idiom).
+pub fn hex(bytes: &[u8]) -> String {
+    const HEX: &[u8; 16] = b"0123456789abcdef";
+    let mut out = String::with_capacity(bytes.len() * 2);
+    for b in bytes {
+        out.push(HEX[(b >> 4) as usize] as char);
+        out.push(HEX[(b & 0xf) as usize] as char);
+    }
+    out
+}
+
+/// The 16-hex image key — the same derivation as the driver's
+/// `exec_cache::image_key` (layering keeps tfs from importing it).
+pub fn image_key(image: &Path) -> String {
+    let mut store = image.as_os_str().to_os_string();
+    store.push(".sha256");
+    if let Ok(text) = std::fs::read_to_string(PathBuf::from(store)) {
+        if let Some(token) = text.split_whitespace().next() {
+            if token.len() == 64 && token.bytes().all(|b| b.is_ascii_hexdigit()) {
+                return token[..16].to_string();
+            }
+        }
+    }
+    hex(&Sha256::digest(image.to_string_lossy().as_bytes()))[..16].to_string()
+}
+
+/// Where the `kind` index of `length` bytes at `offset` of `image` lives
+/// (`None` when no exec cache is named).
+pub fn path_for(image: &Path, kind: &str, offset: u64, length: u64) -> Option<PathBuf> {
+    let root = std::env::var_os("TEBAKO_EXEC_CACHE").filter(|v| !v.is_empty())?;
+    Some(PathBuf::from(root).join(DIR).join(format!(
+        "{kind}-{}-{offset:x}-{length:x}.idx",
+        image_key(image)
+    )))
+}
+
+/// Stamp the `length` bytes at `offset` of `file` (see the module docs).
+pub fn file_stamp(file: &File, offset: u64, length: u64) -> Result<Stamp, i32> {
+    let meta = file.metadata().map_err(|_| libc::EIO)?;
+    let mtime = meta
+        .modified()
+        .ok()
+        .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+        .map_or(0, |d| d.as_nanos());
+    let mut h = Sha256::new();
+    h.update(meta.len().to_le_bytes());
+    h.update(mtime.to_le_bytes());
+    h.update(offset.to_le_bytes());
+    h.update(length.to_le_bytes());
+    let head = length.min(STAMP_SAMPLE);
+    let mut buf = vec![0u8; head as usize];
+    read_exact_at(file, offset, &mut buf)?;
+    h.update(&buf);
+    read_exact_at(file, offset + length - head, &mut buf)?;
+    h.update(&buf);
+    Ok(h.finalize().into())
+}
+
+fn read_exact_at(file: &File, offset: u64, buf: &mut [u8]) -> Result<(), i32> {
+    #[cfg(unix)]
+    {
+        use std::os::unix::fs::FileExt as _;
+        file.read_exact_at(buf, offset).map_err(|_| libc::EIO)
+    }
+    #[cfg(not(unix))]
+    {
+        use std::io::{Read, Seek, SeekFrom};
+        let mut file = file.try_clone().map_err(|_| libc::EIO)?;
+        file.seek(SeekFrom::Start(offset)).map_err(|_| libc::EIO)?;
+        file.read_exact(buf).map_err(|_| libc::EIO)
+    }
+}
+
+/// The payload of the sidecar at `path` when it exists, is intact, and
+/// was written for `stamp`.
+pub fn load(path: &Path, stamp: &Stamp) -> Option<Vec<u8>> {
+    let mut data = std::fs::read(path).ok()?;
+    let body_len = data.len().checked_sub(32)?;
+    if body_len < MAGIC.len() + stamp.len()
+        || Sha256::digest(&data[..body_len])[..] != data[body_len..]
+        || &data[..MAGIC.len()] != MAGIC
+        || &data[MAGIC.len()..MAGIC.len() + stamp.len()] != stamp
+    {
+        return None;
+    }
+    data.truncate(body_len);
+    data.drain(..MAGIC.len() + stamp.len());
+    Some(data)
+}
+
+/// Save `payload` for `stamp` at `path` (best-effort; see the module docs).
+pub fn store(path: &Path, stamp: &Stamp, payload: &[u8]) {
+    let Some(dir) = path.parent() else {
+        return;
+    };
+    if std::fs::create_dir_all(dir).is_err() {
+        return;
+    }
+    let mut data = Vec::with_capacity(MAGIC.len() + stamp.len() + payload.len() + 32);
+    data.extend_from_slice(MAGIC);
+    data.extend_from_slice(stamp);
+    data.extend_from_slice(payload);
+    let digest = Sha256::digest(&data);
+    data.extend_from_slice(&digest);
+    // A per-process temp name: concurrent first mounts race to the same
+    // sidecar, and the last rename wins with identical bytes.
+    let tmp = path.with_extension(format!("tmp{}", std::process::id()));
+    if std::fs::write(&tmp, &data).is_ok() && std::fs::rename(&tmp, path).is_ok() {
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "index sidecar: wrote {} ({} bytes)",
+            path.display(),
+            data.len()
+        );
+    } else {
+        let _ = std::fs::remove_file(&tmp);
+    }
+}
+
+/// Little-endian payload writer.
+#[derive(Default)]
+pub struct Encoder(Vec<u8>);
+
+impl Encoder {
+    pub fn u8(&mut self, v: u8) {
+        self.0.push(v);
+    }
+
+    pub fn u32(&mut self, v: u32) {
+        self.0.extend_from_slice(&v.to_le_bytes());
+    }
+
+    pub fn u64(&mut self, v: u64) {
+        self.0.extend_from_slice(&v.to_le_bytes());
+    }
+
+    pub fn i64(&mut self, v: i64) {
+        self.0.extend_from_slice(&v.to_le_bytes());
+    }
+
+    /// Length-prefixed bytes.
+    pub fn bytes(&mut self, v: &[u8]) {
+        self.u64(v.len() as u64);
+        self.0.extend_from_slice(v);
+    }
+
+    pub fn str(&mut self, v: &str) {
+        self.bytes(v.as_bytes());
+    }
+
+    pub fn finish(self) -> Vec<u8> {
+        self.0
+    }
+}
+
+/// Little-endian payload reader: every read is `None` past the end, so a
+/// short or garbled payload fails the decode instead of panicking.
+pub struct Decoder<'a>(&'a [u8]);
+
+impl<'a> Decoder<'a> {
+    pub fn new(data: &'a [u8]) -> Self {
+        Decoder(data)
+    }
+
+    fn take(&mut self, n: usize) -> Option<&'a [u8]> {
+        if n > self.0.len() {
+            return None;
+        }
+        let (head, rest) = self.0.split_at(n);
+        self.0 = rest;
+        Some(head)
+    }
+
+    pub fn u8(&mut self) -> Option<u8> {
+        Some(self.take(1)?[0])
+    }
+
+    pub fn u32(&mut self) -> Option<u32> {
+        Some(u32::from_le_bytes(self.take(4)?.try_into().ok()?))
+    }
+
+    pub fn u64(&mut self) -> Option<u64> {
+        Some(u64::from_le_bytes(self.take(8)?.try_into().ok()?))
+    }
+
+    pub fn i64(&mut self) -> Option<i64> {
+        Some(i64::from_le_bytes(self.take(8)?.try_into().ok()?))
+    }
+
+    pub fn bytes(&mut self) -> Option<&'a [u8]> {
+        let n = usize::try_from(self.u64()?).ok()?;
+        self.take(n)
+    }
+
+    pub fn str(&mut self) -> Option<&'a str> {
+        std::str::from_utf8(self.bytes()?).ok()
+    }
+
+    /// True when every byte was consumed.
+    pub fn is_empty(&self) -> bool {
+        self.0.is_empty()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Write as _;
+
+    #[test]
+    fn stale_or_damaged_sidecars_are_ignored() {
+        let dir = tempfile::tempdir().unwrap();
+        let mut image = tempfile::NamedTempFile::new_in(dir.path()).unwrap();
+        image.write_all(&vec![7u8; 10_000]).unwrap();
+        let file = image.reopen().unwrap();
+        let stamp = file_stamp(&file, 100, 9_000).unwrap();
+        assert_ne!(
+            stamp,
+            file_stamp(&file, 0, 9_000).unwrap(),
+            "the region is stamped"
+        );
+
+        let path = dir.path().join("x/tar-k-0-0.idx");
+        let mut enc = Encoder::default();
+        enc.str("entry");
+        enc.u64(42);
+        store(&path, &stamp, &enc.finish());
+        let payload = load(&path, &stamp).expect("round trip");
+        let mut dec = Decoder::new(&payload);
+        assert_eq!(dec.str(), Some("entry"));
+        assert_eq!(dec.u64(), Some(42));
+        assert!(dec.is_empty());
+        assert_eq!(dec.u8(), None);
+
+        assert!(load(&path, &[0u8; 32]).is_none(), "another image's stamp");
+        let mut raw = std::fs::read(&path).unwrap();
+        raw[45] ^= 1;
+        std::fs::write(&path, &raw).unwrap();
+        assert!(load(&path, &stamp).is_none(), "a damaged payload");
+    }
+}
@@ -45,6 +45,24 @@
 //! `..._from_file_at_with_mode`, `..._from_memory_with_mode` taking
 //! `TEBAKO_MOUNT_RO` (0, default), `_COW` (1, HostDir overlay + whiteout
 //! journal) or `_RW` (2, ENOTSUP — no in-tree backend writes in place).
+//! Per-mount read tuning (additive): `tebako_fs_mount_from_file_opts`
+//! taking a `tebako_mount_opts` (cache budget, fill workers, readahead —
+//! a window cache over any format, `backends_cache`).
+//! Borrowed in-memory mounts (additive):
+//! `tebako_fs_mount_from_memory_borrowed` serves a lent buffer in place
+//! and hands it back through an optional release callback at unmount.
+//! Process-wide cache budget (opt-in, `TEBAKO_TFS_CACHE_MB`): every
+//! mount reads through one shared, byte-budgeted window pool with
+//! per-mount tallies ([`backends_cache::process_pool`]).
+//! Cross-process block sharing (opt-in, `TEBAKO_TFS_SHARED_CACHE_MB`
+//! with an exec cache named): file and region mounts publish decompressed
+//! blocks to a per-image shared segment ([`shared_blocks`]).
+//! Per-fd readahead: sequential reads on read-only mounts are served
+//! from windows a background worker prefetched ([`readahead`]);
+//! `tebako_fs_fadvise` takes `posix_fadvise` advice as a hint.
+//! Shared mmap sources (opt-in, `TEBAKO_TFS_MMAP_SHARED`): a memfs file
+//! the preload maps is materialized once per mount, into a sealed memfd
+//! or an exec-cache file other processes map too ([`mapped_files`]).
 //! The COW composite additionally carries the spec 24 §5 declarative
 //! write gate: a mount built with declared write areas
 //! ([`mount::Overlay::gated`], the Rust mount API) admits writes only
@@ -81,6 +99,7 @@
 //! slots already ordered after the strong magics).
 
 pub mod backend;
+pub mod backends_cache;
 pub mod backends_cow;
 #[cfg(feature = "vendored-dwarfs")]
 pub mod backends_dwarfs;
@@ -94,20 +113,29 @@ pub mod backends_squashfs;
 pub mod backends_tar;
 pub mod backends_union;
 pub mod backends_zip;
+pub mod bgzf;
+pub mod byte_lru;
 pub mod c_api;
 pub mod context;
 pub mod errno;
 pub mod exec_closure;
+pub mod image_bytes;
+pub mod index_sidecar;
 pub mod journal;
+pub mod mapped_files;
+pub mod miss_cache;
 pub mod mount;
 pub mod mount_spec;
 pub mod needs;
 pub mod overlay_spec;
 pub mod policy;
+pub mod readahead;
 #[cfg(feature = "enc")]
 pub mod secure_buf;
+pub mod shared_blocks;
 pub mod trace;
 pub mod tree_walk;
+pub mod zstd_seekable;
 
 pub use backend::{Backend, EntryType, RawDirEntry, RawStat, WritableBackend};
 #[cfg(feature = "enc")]
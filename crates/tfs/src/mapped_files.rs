@@ -0,0 +1,448 @@
+//! Shared-page sources for mmaps of memfs files (opt-in,
+//! `TEBAKO_TFS_MMAP_SHARED=1`).
+//!
+//! By default the preload serves each mmap of a memfs fd as a private
+//! anonymous mapping filled from the VFS. Every mapping of one jar then
+//! decompresses it again into pages of its own, and two processes that
+//! map it share nothing. With sharing on, the first mapping of a file on
+//! a read-only mount materializes the whole file once, into a host
+//! object that the real mmap maps:
+//!
+//! - With an exec cache named (`TEBAKO_EXEC_CACHE`), the object is a
+//!   file keyed by the image and the in-image path:
+//!   `$TEBAKO_EXEC_CACHE/tebako-mmap/<key>-<stamp>-<offset>-<length>-<path>.map`.
+//!   `<key>` and `<stamp>` are derived as in `shared_blocks`, so an
+//!   image rewritten in place gets fresh files. `<path>` is a hash of
+//!   the in-image path. The file is written once per machine and then
+//!   mapped from the page cache by every process that mounts the image.
+//!   Its bytes are served as the file's content, so, as for the
+//!   `shared_blocks` segment, only this user may write them: the
+//!   directory is created `0700` and the file `0600`, written and synced
+//!   under a temp name of its own before it is linked into place, and a
+//!   published file that is not a regular file of the expected size,
+//!   owned by the effective uid and unwritable by group and others, is
+//!   never mapped.
+//! - Otherwise, on linux, the object is a sealed memfd. Every mapping in
+//!   the process shares it.
+//!
+//! Either way the mappings are the kernel's own: demand-paged, shared
+//! between mappers and free to remap. The source stays open until
+//! unmount. A file that cannot be materialized keeps the private fill,
+//! so a source problem only costs the sharing. Causes include a full or
+//! read-only cache, or no memfd.
+
+use std::collections::HashMap;
+use std::fs::File;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+
+use sha2::{Digest as _, Sha256};
+
+use crate::index_sidecar;
+
+/// Directory under the exec cache.
+const DIR: &str = "tebako-mmap";
+/// Bytes moved from the backend per read while materializing.
+const CHUNK: usize = 256 * 1024;
+
+/// Where a mount's sources are materialized.
+#[derive(Debug)]
+enum Store {
+    /// Sealed, process-private memfds.
+    Memfd,
+    /// Files named `<prefix>-<path hash>.map` in the exec cache, falling
+    /// back to a memfd when the cache cannot take one.
+    ExecCache(PathBuf),
+}
+
+/// One mount's materialized mmap sources, by in-image path (see the
+/// module docs). The default shares nothing.
+#[derive(Debug, Default)]
+pub struct MappedFiles {
+    store: Option<Store>,
+    files: Mutex<HashMap<String, Arc<File>>>,
+}
+
+/// True when `TEBAKO_TFS_MMAP_SHARED` asks for shared mmap sources.
+fn enabled_from_env() -> bool {
+    std::env::var("TEBAKO_TFS_MMAP_SHARED").is_ok_and(|v| !v.is_empty() && v != "0")
+}
+
+impl MappedFiles {
+    /// Sources for a mount of the `length` bytes at `offset` of `image`
+    /// (open as `file`). Exec-cache files when a cache is named and the
+    /// image can be stamped; memfds otherwise.
+    pub fn for_image(image: &Path, file: &File, offset: u64, length: u64) -> MappedFiles {
+        if !enabled_from_env() {
+            return MappedFiles::default();
+        }
+        let cached = std::env::var_os("TEBAKO_EXEC_CACHE")
+            .filter(|v| !v.is_empty())
+            .filter(|_| length > 0)
+            .and_then(|root| {
+                let stamp = index_sidecar::file_stamp(file, offset, length).ok()?;
+                Some(PathBuf::from(root).join(DIR).join(format!(
+                    "{}-{}-{offset:x}-{length:x}",
+                    index_sidecar::image_key(image),
+                    &index_sidecar::hex(&stamp)[..16]
+                )))
+            });
+        MappedFiles {
+            store: Some(cached.map_or(Store::Memfd, Store::ExecCache)),
+            files: Mutex::default(),
+        }
+    }
+
+    /// Sources for an in-memory mount: process-private memfds, when
+    /// enabled (no image file names the bytes for other processes).
+    pub fn for_memory() -> MappedFiles {
+        MappedFiles {
+            store: enabled_from_env().then_some(Store::Memfd),
+            files: Mutex::default(),
+        }
+    }
+
+    /// True when mmaps on this mount are served from shared sources.
+    pub fn is_enabled(&self) -> bool {
+        self.store.is_some()
+    }
+
+    /// The source for the `size`-byte file at `rel`, and whether this
+    /// call opened it (false: the mount already held it). The first call
+    /// reads the file through `read_at` (a positioned read: buffer,
+    /// offset → bytes) unless another process already published it.
+    /// Concurrent first calls materialize the file once.
+    pub fn source(
+        &self,
+        rel: &str,
+        size: u64,
+        mut read_at: impl FnMut(&mut [u8], u64) -> Result<usize, i32>,
+    ) -> Result<(Arc<File>, bool), i32> {
+        let Some(store) = &self.store else {
+            return Err(libc::ENOTSUP);
+        };
+        let mut files = self.files.lock().unwrap_or_else(|e| e.into_inner());
+        if let Some(file) = files.get(rel) {
+            return Ok((Arc::clone(file), false));
+        }
+        let file = match store {
+            Store::ExecCache(prefix) => {
+                cache_file(prefix, rel, size, &mut read_at).or_else(|_| memfd(rel, size, read_at))
+            }
+            Store::Memfd => memfd(rel, size, read_at),
+        }?;
+        let file = Arc::new(file);
+        files.insert(rel.to_string(), Arc::clone(&file));
+        Ok((file, true))
+    }
+
+    /// Number of files materialized so far.
+    pub fn len(&self) -> usize {
+        self.files.lock().unwrap_or_else(|e| e.into_inner()).len()
+    }
+
+    /// True when nothing has been materialized.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+}
+
+/// Copy the file into `out` through `read_at`: exactly `size` bytes, or
+/// EIO when the backend ends early.
+fn fill(
+    out: &File,
+    size: u64,
+    read_at: &mut impl FnMut(&mut [u8], u64) -> Result<usize, i32>,
+) -> Result<(), i32> {
+    use std::io::Write as _;
+    let mut buf = vec![0u8; CHUNK.min(size as usize)];
+    let mut at = 0u64;
+    let mut out = out;
+    while at < size {
+        let want = CHUNK.min((size - at) as usize);
+        let n = read_at(&mut buf[..want], at)?;
+        if n == 0 {
+            return Err(libc::EIO);
+        }
+        out.write_all(&buf[..n]).map_err(|_| libc::EIO)?;
+        at += n as u64;
+    }
+    Ok(())
+}
+
+/// The exec-cache source: the published file when one this user alone
+/// can write, of the right size, exists (module docs); else one written
+/// and synced under a temp name of its own and linked into place. A
+/// concurrent writer that links first wins, and everyone maps its file.
+#[cfg(unix)]
+fn cache_file(
+    prefix: &Path,
+    rel: &str,
+    size: u64,
+    read_at: &mut impl FnMut(&mut [u8], u64) -> Result<usize, i32>,
+) -> Result<File, i32> {
+    use std::os::unix::fs::{DirBuilderExt as _, MetadataExt as _, OpenOptionsExt as _};
+    let mut name = prefix.as_os_str().to_os_string();
+    name.push(format!(
+        "-{}.map",
+        &index_sidecar::hex(&Sha256::digest(rel.as_bytes()))[..16]
+    ));
+    let path = PathBuf::from(name);
+    let published = |path: &Path| {
+        let file = std::fs::OpenOptions::new()
+            .read(true)
+            .custom_flags(libc::O_NOFOLLOW)
+            .open(path)
+            .ok()?;
+        let meta = file.metadata().ok()?;
+        // SAFETY: geteuid has no preconditions.
+        if meta.uid() != unsafe { libc::geteuid() } || meta.mode() & 0o022 != 0 {
+            tebako_log::log!(
+                tebako_log::Level::Warn,
+                "tfs",
+                "mmap source {} is not private to this user; not mapped",
+                path.display()
+            );
+            return None;
+        }
+        (meta.is_file() && meta.len() == size).then_some(file)
+    };
+    if let Some(file) = published(&path) {
+        return Ok(file);
+    }
+    let dir = path.parent().ok_or(libc::EINVAL)?;
+    std::fs::DirBuilder::new()
+        .recursive(true)
+        .mode(0o700)
+        .create(dir)
+        .map_err(|_| libc::EIO)?;
+    // Per process and per call: two mounts of one image may write at once.
+    static NONCE: AtomicU64 = AtomicU64::new(0);
+    let tmp = path.with_extension(format!(
+        "tmp{}-{}",
+        std::process::id(),
+        NONCE.fetch_add(1, Ordering::Relaxed)
+    ));
+    let written = std::fs::OpenOptions::new()
+        .write(true)
+        .create_new(true)
+        .mode(0o600)
+        .open(&tmp)
+        .map_err(|_| libc::EIO)
+        .and_then(|file| {
+            fill(&file, size, read_at)?;
+            // Durable before it is visible: a crash must not publish a
+            // file whose bytes never reached the disk.
+            file.sync_all().map_err(|_| libc::EIO)
+        });
+    if written.is_ok() {
+        let _ = std::fs::hard_link(&tmp, &path);
+    }
+    let _ = std::fs::remove_file(&tmp);
+    written?;
+    published(&path).ok_or(libc::EIO)
+}
+
+/// No exec-cache files off unix: memfds (or the private fill) only.
+#[cfg(not(unix))]
+fn cache_file(
+    _prefix: &Path,
+    _rel: &str,
+    _size: u64,
+    _read_at: &mut impl FnMut(&mut [u8], u64) -> Result<usize, i32>,
+) -> Result<File, i32> {
+    Err(libc::ENOTSUP)
+}
+
+/// The memfd source: the file's bytes in an anonymous, sealed file, so
+/// nothing can resize or rewrite what the mappings see.
+#[cfg(target_os = "linux")]
+fn memfd(
+    rel: &str,
+    size: u64,
+    mut read_at: impl FnMut(&mut [u8], u64) -> Result<usize, i32>,
+) -> Result<File, i32> {
+    use std::os::unix::io::{AsRawFd as _, FromRawFd as _};
+    // The name shows in /proc/<pid>/maps as "/memfd:tebako:<path>"; the
+    // kernel caps it at 249 bytes.
+    let mut name: String = format!("tebako:{rel}");
+    while name.len() > 249 {
+        name.pop();
+    }
+    let name = std::ffi::CString::new(name).map_err(|_| libc::EINVAL)?;
+    // SAFETY: a NUL-terminated name; the fd is owned by the File below.
+    let fd =
+        unsafe { libc::memfd_create(name.as_ptr(), libc::MFD_CLOEXEC | libc::MFD_ALLOW_SEALING) };
+    if fd < 0 {
+        return Err(std::io::Error::last_os_error()
+            .raw_os_error()
+            .unwrap_or(libc::ENOTSUP));
+    }
+    // SAFETY: a fresh fd nobody else owns.
+    let file = unsafe { File::from_raw_fd(fd) };
+    file.set_len(size).map_err(|_| libc::ENOSPC)?;
+    fill(&file, size, &mut read_at)?;
+    // FUTURE_WRITE rather than WRITE: both refuse every later write, but
+    // before linux 6.7 a WRITE-sealed memfd refuses even read-only
+    // MAP_SHARED mappings (libzip's CEN request).
+    let seals =
+        libc::F_SEAL_SHRINK | libc::F_SEAL_GROW | libc::F_SEAL_FUTURE_WRITE | libc::F_SEAL_SEAL;
+    // SAFETY: fcntl on an fd the File owns.
+    if unsafe { libc::fcntl(file.as_raw_fd(), libc::F_ADD_SEALS, seals) } != 0 {
+        return Err(libc::EIO);
+    }
+    Ok(file)
+}
+
+/// No memfd outside linux: only exec-cache files are shared there.
+#[cfg(not(target_os = "linux"))]
+fn memfd(
+    _rel: &str,
+    _size: u64,
+    _read_at: impl FnMut(&mut [u8], u64) -> Result<usize, i32>,
+) -> Result<File, i32> {
+    Err(libc::ENOTSUP)
+}
+
+#[cfg(all(test, unix))]
+mod tests {
+    use super::*;
+    use std::os::unix::fs::FileExt as _;
+
+    fn bytes(size: usize) -> Vec<u8> {
+        (0..size).map(|i| (i % 251) as u8).collect()
+    }
+
+    fn reader(data: &[u8]) -> impl FnMut(&mut [u8], u64) -> Result<usize, i32> + '_ {
+        move |buf, at| {
+            let at = at as usize;
+            let n = buf.len().min(data.len() - at);
+            buf[..n].copy_from_slice(&data[at..at + n]);
+            Ok(n)
+        }
+    }
+
+    fn contents(file: &File) -> Vec<u8> {
+        let mut out = vec![0u8; file.metadata().unwrap().len() as usize];
+        file.read_exact_at(&mut out, 0).unwrap();
+        out
+    }
+
+    #[test]
+    fn disabled_by_default() {
+        let files = MappedFiles::default();
+        assert!(!files.is_enabled());
+        assert_eq!(
+            files.source("a", 1, reader(b"a")).err(),
+            Some(libc::ENOTSUP)
+        );
+    }
+
+    #[cfg(target_os = "linux")]
+    #[test]
+    fn memfd_sources_are_sealed_and_materialized_once() {
+        let files = MappedFiles {
+            store: Some(Store::Memfd),
+            files: Mutex::default(),
+        };
+        let data = bytes(CHUNK * 2 + 17);
+        let mut reads = 0;
+        let (first, made) = files
+            .source("lib/big.jar", data.len() as u64, |buf, at| {
+                reads += 1;
+                reader(&data)(buf, at)
+            })
+            .unwrap();
+        assert!(made);
+        assert_eq!(reads, 3);
+        assert!(contents(&first) == data);
+        let (again, made) = files
+            .source("lib/big.jar", data.len() as u64, |_, _| panic!("re-read"))
+            .unwrap();
+        assert!(!made);
+        assert!(Arc::ptr_eq(&first, &again));
+        assert!(first.write_at(b"x", 0).is_err(), "sealed against writes");
+        assert!(first.set_len(1).is_err(), "sealed against shrinking");
+    }
+
+    #[test]
+    fn exec_cache_files_are_published_once_and_reused() {
+        let dir = std::env::temp_dir().join(format!("tfs-mapped-files-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let prefix = dir.join(DIR).join("key-stamp-0-10");
+        let data = bytes(5000);
+        let first = MappedFiles {
+            store: Some(Store::ExecCache(prefix.clone())),
+            files: Mutex::default(),
+        };
+        let (file, _) = first
+            .source("a/b.jar", data.len() as u64, reader(&data))
+            .unwrap();
+        assert!(contents(&file) == data);
+        let published: Vec<_> = std::fs::read_dir(dir.join(DIR))
+            .unwrap()
+            .map(|e| e.unwrap().file_name().into_string().unwrap())
+            .collect();
+        assert_eq!(published.len(), 1, "{published:?}");
+        assert!(published[0].starts_with("key-stamp-0-10-") && published[0].ends_with(".map"));
+
+        // Another process (a fresh table) maps the published file
+        // without reading the image.
+        let second = MappedFiles {
+            store: Some(Store::ExecCache(prefix)),
+            files: Mutex::default(),
+        };
+        let (file, made) = second
+            .source("a/b.jar", data.len() as u64, |_, _| panic!("re-read"))
+            .unwrap();
+        assert!(made);
+        assert!(contents(&file) == data);
+
+        // A backend that ends early publishes nothing.
+        assert!(second.source("short", 10, reader(b"abc")).is_err());
+        assert_eq!(std::fs::read_dir(dir.join(DIR)).unwrap().count(), 1);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn exec_cache_files_are_private_and_others_are_not_mapped() {
+        use std::os::unix::fs::PermissionsExt as _;
+        let mode = |p: &Path| std::fs::metadata(p).unwrap().permissions().mode() & 0o777;
+        let dir = std::env::temp_dir().join(format!("tfs-mapped-private-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let prefix = dir.join(DIR).join("key-stamp-0-10");
+        let data = bytes(3000);
+        let reads = std::cell::Cell::new(0);
+        let mut counted = |buf: &mut [u8], at: u64| {
+            reads.set(reads.get() + 1);
+            reader(&data)(buf, at)
+        };
+        let file = cache_file(&prefix, "a.jar", data.len() as u64, &mut counted).unwrap();
+        assert!(contents(&file) == data);
+        let published = std::fs::read_dir(dir.join(DIR))
+            .unwrap()
+            .next()
+            .unwrap()
+            .unwrap()
+            .path();
+        assert_eq!(mode(&dir.join(DIR)), 0o700);
+        assert_eq!(mode(&published), 0o600);
+
+        // Group-writable: rewritten rather than mapped. The rewrite loses
+        // the link race to the file already there, so nothing is mapped.
+        std::fs::set_permissions(&published, std::fs::Permissions::from_mode(0o620)).unwrap();
+        let before = reads.get();
+        assert!(cache_file(&prefix, "a.jar", data.len() as u64, &mut counted).is_err());
+        assert!(reads.get() > before, "the published file was not trusted");
+
+        // A symlink in its place is not followed.
+        std::fs::remove_file(&published).unwrap();
+        let elsewhere = dir.join("elsewhere");
+        std::fs::write(&elsewhere, &data).unwrap();
+        std::fs::set_permissions(&elsewhere, std::fs::Permissions::from_mode(0o600)).unwrap();
+        std::os::unix::fs::symlink(&elsewhere, &published).unwrap();
+        assert!(cache_file(&prefix, "a.jar", data.len() as u64, &mut counted).is_err());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,205 @@
+//! The per-mount negative-lookup cache: in-image paths a mount's backend
+//! answered ENOENT for, each with its memoized held/not-held verdict
+//! (the write gate's discriminator, see `FsContext::path_is_held`).
+//!
+//! Load-path probing (Ruby's `$LOAD_PATH`, a JVM classpath scan) asks
+//! for many names no image holds; without the cache every repeat re-runs
+//! the backend lookup and the held-ancestor walk before the host policy
+//! is even consulted. Images are immutable, so a miss on a read-only
+//! format mount never goes stale; a COW mount's write verbs flush its
+//! cache whole (a write can create the path or any of its parents, a
+//! remove can turn a held tree into host territory). Mounts whose
+//! namespace can change behind the context's back — a host directory
+//! mounted read-only — never consult it (see `FsContext::miss_cache`).
+//!
+//! Bounded: at most `TEBAKO_TFS_MISS_CACHE` entries per mount (default
+//! [`DEFAULT_CAPACITY`], `0` disables), evicted oldest-first. The hit and
+//! miss counters are the observable savings; the context logs them at
+//! Debug when the mount goes away.
+
+use std::collections::{HashMap, VecDeque};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+
+/// Entries per mount when `TEBAKO_TFS_MISS_CACHE` is unset.
+pub const DEFAULT_CAPACITY: usize = 4096;
+
+/// The hit/miss tallies of one mount's cache.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MissStats {
+    /// Lookups answered from the cache (no backend probe).
+    pub hits: u64,
+    /// Lookups the cache could not answer (the backend was probed).
+    pub misses: u64,
+    /// Entries currently held.
+    pub entries: usize,
+}
+
+/// One known-absent path: the held verdict is filled in lazily, the first
+/// time the write gate asks.
+#[derive(Clone, Copy)]
+struct Absent {
+    held: Option<bool>,
+}
+
+#[derive(Default)]
+struct Table {
+    entries: HashMap<String, Absent>,
+    /// Insertion order, for oldest-first eviction.
+    order: VecDeque<String>,
+}
+
+/// A bounded negative-lookup cache (see the module docs).
+pub struct MissCache {
+    capacity: usize,
+    table: Mutex<Table>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+}
+
+impl Default for MissCache {
+    fn default() -> Self {
+        let capacity = std::env::var("TEBAKO_TFS_MISS_CACHE")
+            .ok()
+            .and_then(|v| v.trim().parse().ok())
+            .unwrap_or(DEFAULT_CAPACITY);
+        MissCache::with_capacity(capacity)
+    }
+}
+
+impl MissCache {
+    /// A cache holding at most `capacity` paths (`0`: always empty).
+    pub fn with_capacity(capacity: usize) -> Self {
+        MissCache {
+            capacity,
+            table: Mutex::new(Table::default()),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        }
+    }
+
+    fn table(&self) -> std::sync::MutexGuard<'_, Table> {
+        self.table.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn count(&self, hit: bool) {
+        let counter = if hit { &self.hits } else { &self.misses };
+        counter.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// True when `rel` is a recorded miss (counted as a hit; false counts
+    /// a miss — the caller probes the backend next).
+    pub fn is_absent(&self, rel: &str) -> bool {
+        if self.capacity == 0 {
+            return false;
+        }
+        let hit = self.table().entries.contains_key(rel);
+        self.count(hit);
+        hit
+    }
+
+    /// Record that the backend answered ENOENT for `rel`.
+    pub fn record_absent(&self, rel: &str) {
+        self.record(rel, None);
+    }
+
+    /// The memoized held verdict for `rel`, when it is a recorded miss
+    /// whose verdict is known (counted like [`MissCache::is_absent`]).
+    pub fn held(&self, rel: &str) -> Option<bool> {
+        if self.capacity == 0 {
+            return None;
+        }
+        let held = self.table().entries.get(rel).and_then(|a| a.held);
+        self.count(held.is_some());
+        held
+    }
+
+    /// Record the held verdict for `rel`, which the backend does NOT hold
+    /// (the caller's own first probe said so).
+    pub fn record_held(&self, rel: &str, held: bool) {
+        self.record(rel, Some(held));
+    }
+
+    fn record(&self, rel: &str, held: Option<bool>) {
+        if self.capacity == 0 {
+            return;
+        }
+        let mut table = self.table();
+        if let Some(entry) = table.entries.get_mut(rel) {
+            if held.is_some() {
+                entry.held = held;
+            }
+            return;
+        }
+        while table.order.len() >= self.capacity {
+            let Some(oldest) = table.order.pop_front() else {
+                break;
+            };
+            table.entries.remove(&oldest);
+        }
+        table.entries.insert(rel.to_string(), Absent { held });
+        table.order.push_back(rel.to_string());
+    }
+
+    /// Forget every entry (a write changed the mount's namespace).
+    /// The counters survive: they describe the mount's lifetime.
+    pub fn clear(&self) {
+        let mut table = self.table();
+        table.entries.clear();
+        table.order.clear();
+    }
+
+    /// The current tallies.
+    pub fn stats(&self) -> MissStats {
+        MissStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            entries: self.table().entries.len(),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn records_answer_and_count() {
+        let cache = MissCache::with_capacity(8);
+        assert!(!cache.is_absent("lib/nope.rb"));
+        cache.record_absent("lib/nope.rb");
+        assert!(cache.is_absent("lib/nope.rb"));
+        assert_eq!(cache.held("lib/nope.rb"), None, "verdict not known yet");
+        cache.record_held("lib/nope.rb", true);
+        assert_eq!(cache.held("lib/nope.rb"), Some(true));
+        // A later plain miss record keeps the verdict.
+        cache.record_absent("lib/nope.rb");
+        assert_eq!(cache.held("lib/nope.rb"), Some(true));
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses, stats.entries), (3, 2, 1));
+    }
+
+    #[test]
+    fn bounded_oldest_first_and_clear_keeps_the_counters() {
+        let cache = MissCache::with_capacity(2);
+        cache.record_absent("a");
+        cache.record_absent("b");
+        cache.record_absent("c");
+        assert!(!cache.is_absent("a"), "the oldest entry was evicted");
+        assert!(cache.is_absent("b"));
+        assert!(cache.is_absent("c"));
+        cache.clear();
+        assert!(!cache.is_absent("c"));
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses, stats.entries), (2, 2, 0));
+    }
+
+    #[test]
+    fn zero_capacity_disables_and_counts_nothing() {
+        let cache = MissCache::with_capacity(0);
+        cache.record_absent("a");
+        assert!(!cache.is_absent("a"));
+        assert_eq!(cache.held("a"), None);
+        assert_eq!(cache.stats(), MissStats::default());
+    }
+}
@@ -6,20 +6,33 @@
 //!
 //! Mounts carry a mode (spec 11 §3): RO (default), COW (a HostDir overlay
 //! stacked over the image backend — spec 11 §4), RW (in-place; no in-tree
-//! format backend offers it → ENOTSUP).
+//! format backend offers it → ENOTSUP). The `_with_options` builders add
+//! per-mount read tuning ([`MountOptions`]: a window cache with its own
+//! budget and parallel fill workers, and the per-fd readahead window —
+//! spec 11 §2).
+//! File and region mounts also attach the host-wide block segment when it
+//! is enabled (`shared_blocks`): LimniFS shares its decompressed drops,
+//! every other format a window cache stacked for the purpose.
 
 use std::ffi::CString;
 use std::fs::File;
 use std::io::{Read, Seek, SeekFrom};
-#[cfg(feature = "vendored-dwarfs")]
 use std::path::Path;
+use std::sync::Arc;
 
 use crate::backend::{detect_format, Backend, ImageFormat};
+use crate::backends_cache::{process_pool, CachedBackend, PoolKey};
 use crate::backends_cow::CowBackend;
 use crate::backends_hostdir::{io_errno, HostDirBackend};
 use crate::backends_tar::{TarBackend, TarCompression};
 use crate::backends_zip::ZipBackend;
+use crate::byte_lru::ByteLru;
 use crate::context::Mount;
+use crate::image_bytes::ImageBytes;
+use crate::index_sidecar;
+use crate::mapped_files::MappedFiles;
+use crate::miss_cache::MissCache;
+use crate::shared_blocks::SharedBlocks;
 
 #[cfg(feature = "vendored-dwarfs")]
 use crate::backends_dwarfs::DwarfsBackend;
@@ -84,6 +97,102 @@ pub enum MountMode {
     ReadWrite,
 }
 
+/// Per-mount read tuning (the C ABI's `tebako_mount_opts`, the
+/// `TEBAKO_TFS_MOUNTS` `?cache=…` suffix — spec 07 §8). A non-zero
+/// budget or worker count stacks a [`CachedBackend`] read-window cache
+/// over the image (under the COW overlay, so writes never pass through
+/// it), a zero one taking the default below; `readahead` only sizes the
+/// per-fd prefetch window ([`crate::readahead`]). With
+/// `TEBAKO_TFS_CACHE_MB` set every mount gets that cache, drawing on the
+/// one process-wide budget unless it names its own; without it, a mount
+/// tuning neither gets the backend as it is. A LimniFS mount drawing on the process-wide
+/// pool keeps its drop cache there instead and gets no window cache,
+/// whatever else it tunes: windows stacked over it would hold every
+/// byte twice.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MountOptions {
+    /// Read-cache budget in bytes (0: the process pool when there is
+    /// one, else [`DEFAULT_CACHE_BYTES`]).
+    pub cache_bytes: u64,
+    /// Threads filling cache misses (0: 1, the reading thread).
+    pub workers: u32,
+    /// The per-fd readahead window in bytes (0:
+    /// `TEBAKO_TFS_READAHEAD_KB`).
+    pub readahead: u64,
+}
+
+/// Cache budget of a tuned mount that names no budget of its own.
+pub const DEFAULT_CACHE_BYTES: u64 = 32 * 1024 * 1024;
+
+impl MountOptions {
+    /// True when no field is set (the untuned mount).
+    pub fn is_default(&self) -> bool {
+        *self == MountOptions::default()
+    }
+
+    /// True when a field tuning the window cache is set.
+    fn tunes_cache(&self) -> bool {
+        self.cache_bytes != 0 || self.workers != 0
+    }
+
+    /// The process-wide pool this mount's caches draw on: the pool when
+    /// there is one and the mount names no budget of its own.
+    fn pool(&self) -> Option<Arc<ByteLru<PoolKey>>> {
+        match self.cache_bytes {
+            0 => process_pool(),
+            _ => None,
+        }
+    }
+
+    /// Stack the read cache these options describe over `backend` (a
+    /// `format` image), publishing to `shared` when given (a shared
+    /// segment alone stacks an untuned cache to serve it). A format
+    /// caching its own decoded units keeps them in the pool itself
+    /// ([`caches_natively`]) when the mount draws on one, so no window
+    /// cache stacks over it: its bytes would be held twice, once outside
+    /// the budget.
+    fn apply(
+        &self,
+        backend: Box<dyn Backend>,
+        format: ImageFormat,
+        shared: Option<Arc<SharedBlocks>>,
+    ) -> Box<dyn Backend> {
+        let pool = self.pool();
+        if caches_natively(format) && pool.is_some() {
+            return backend;
+        }
+        if !self.tunes_cache() && shared.is_none() && pool.is_none() {
+            return backend;
+        }
+        let budget = match (self.cache_bytes, &pool) {
+            (0, Some(pool)) => pool.budget() as u64,
+            (0, None) => DEFAULT_CACHE_BYTES,
+            (n, _) => n,
+        };
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "read cache over {}: {budget} bytes{}, {} workers",
+            backend.name().to_string_lossy(),
+            if pool.is_some() {
+                " (process pool)"
+            } else {
+                ""
+            },
+            self.workers.max(1)
+        );
+        let workers = self.workers.max(1) as usize;
+        let cache = match pool {
+            Some(pool) => CachedBackend::in_pool(backend, pool, workers),
+            None => CachedBackend::new(backend, budget, workers),
+        };
+        Box::new(match shared {
+            Some(shared) => cache.with_shared_blocks(shared),
+            None => cache,
+        })
+    }
+}
+
 /// The compression envelope matching a detected tar-family format.
 fn tar_compression(format: ImageFormat) -> TarCompression {
     match format {
@@ -94,6 +203,30 @@ fn tar_compression(format: ImageFormat) -> TarCompression {
     }
 }
 
+/// True for formats whose backend caches its own decoded units and
+/// draws that cache from the process pool (see [`MountOptions::apply`]).
+fn caches_natively(format: ImageFormat) -> bool {
+    format == ImageFormat::Limnifs
+}
+
+/// `backend` sharing its drops through `shared`, when given, and keeping
+/// them in the process pool when the mount draws on one.
+#[cfg(feature = "backend-limnifs")]
+fn share_drops(
+    backend: LimnifsBackend,
+    shared: Option<Arc<SharedBlocks>>,
+    options: &MountOptions,
+) -> LimnifsBackend {
+    let backend = match shared {
+        Some(shared) => backend.with_shared_blocks(shared),
+        None => backend,
+    };
+    match options.pool() {
+        Some(pool) => backend.in_pool(pool),
+        None => backend,
+    }
+}
+
 fn cstring(s: &str) -> Box<CString> {
     // Paths reaching this layer have already been NUL-validated.
     Box::new(CString::new(s).expect("path contains interior NUL"))
@@ -104,6 +237,8 @@ fn make_mount(
     archive_path: Option<&str>,
     backend: Box<dyn Backend>,
     mode: MountMode,
+    options: &MountOptions,
+    mapped: MappedFiles,
 ) -> Mount {
     Mount {
         handle: 0,
@@ -112,6 +247,9 @@ fn make_mount(
         archive_path: archive_path.map(cstring),
         backend,
         mode,
+        misses: MissCache::default(),
+        options: *options,
+        mapped,
     }
 }
 
@@ -165,17 +303,45 @@ pub fn build_from_file_with_mode(
     mount_point: &str,
     mode: MountMode,
     overlay: Option<&Overlay>,
+) -> Result<Mount, i32> {
+    build_from_file_with_options(
+        archive_path,
+        mount_point,
+        mode,
+        overlay,
+        &MountOptions::default(),
+    )
+}
+
+/// [`build_from_file_with_mode`] with per-mount read tuning.
+pub fn build_from_file_with_options(
+    archive_path: &str,
+    mount_point: &str,
+    mode: MountMode,
+    overlay: Option<&Overlay>,
+    options: &MountOptions,
 ) -> Result<Mount, i32> {
     let mut file = File::open(archive_path).map_err(open_error)?;
     let mut magic = [0u8; SNIFF_LEN];
     let n = file.read(&mut magic).map_err(|_| libc::EIO)?;
     file.seek(SeekFrom::Start(0)).map_err(|_| libc::EIO)?;
     let format = detect_format(&magic[..n]);
+    let file_len = file.metadata().map_err(|_| libc::EIO)?.len();
+    #[allow(unused_mut)] // taken by the LimniFS arm only
+    let mut shared = SharedBlocks::for_image(Path::new(archive_path), &file, 0, file_len);
+    let mapped = MappedFiles::for_image(Path::new(archive_path), &file, 0, file_len);
 
     let backend: Box<dyn Backend> = match format {
         ImageFormat::Zip => Box::new(ZipBackend::from_file(file)?),
         ImageFormat::Tar | ImageFormat::TarGz | ImageFormat::TarZst => {
-            Box::new(TarBackend::from_file(file, tar_compression(format))?)
+            let sidecar = index_sidecar::path_for(Path::new(archive_path), "tar", 0, file_len);
+            Box::new(TarBackend::from_file_at_indexed(
+                file,
+                0,
+                file_len,
+                tar_compression(format),
+                sidecar.as_deref(),
+            )?)
         }
         #[cfg(feature = "vendored-dwarfs")]
         ImageFormat::Dwarfs => Box::new(DwarfsBackend::from_file(Path::new(archive_path))?),
@@ -186,23 +352,34 @@ pub fn build_from_file_with_mode(
         #[cfg(not(feature = "vendored-squashfs"))]
         ImageFormat::Squashfs => return Err(libc::ENOTSUP),
         #[cfg(feature = "backend-limnifs")]
-        ImageFormat::Limnifs => Box::new(LimnifsBackend::from_image(
-            std::fs::read(archive_path).map_err(open_error)?,
-        )?),
+        ImageFormat::Limnifs => Box::new(share_drops(
+            LimnifsBackend::from_bytes(ImageBytes::map_whole_file(&file)?)?,
+            shared.take(),
+            options,
+        )),
         #[cfg(not(feature = "backend-limnifs"))]
         ImageFormat::Limnifs => return Err(libc::ENOTSUP),
         ImageFormat::Unknown => return Err(libc::EINVAL),
     };
-    let backend = apply_mode(backend, mode, overlay)?;
-    Ok(make_mount(mount_point, Some(archive_path), backend, mode))
+    let backend = apply_mode(options.apply(backend, format, shared), mode, overlay)?;
+    Ok(make_mount(
+        mount_point,
+        Some(archive_path),
+        backend,
+        mode,
+        options,
+        mapped,
+    ))
 }
 
 /// Mount `length` bytes starting at `offset` of an archive file
 /// (`offset == 0 && length == 0` mounts the whole file directly).
 ///
-/// DwarFS regions are opened in place (the reader handles image offsets
-/// natively); ZIP regions are read into memory owned by the backend,
-/// mirroring the C++ semantics.
+/// No region is copied: DwarFS regions are opened in place (the reader
+/// handles image offsets natively), tar regions are read with positioned
+/// reads, and ZIP, SquashFS and LimniFS regions are served from a
+/// read-only mapping bounded to the region ([`ImageBytes`] — an owned
+/// copy only where the platform cannot map).
 pub fn build_from_file_at(
     archive_path: &str,
     offset: u64,
@@ -227,9 +404,30 @@ pub fn build_from_file_at_with_mode(
     mount_point: &str,
     mode: MountMode,
     overlay: Option<&Overlay>,
+) -> Result<Mount, i32> {
+    build_from_file_at_with_options(
+        archive_path,
+        offset,
+        length,
+        mount_point,
+        mode,
+        overlay,
+        &MountOptions::default(),
+    )
+}
+
+/// [`build_from_file_at_with_mode`] with per-mount read tuning.
+pub fn build_from_file_at_with_options(
+    archive_path: &str,
+    offset: u64,
+    length: u64,
+    mount_point: &str,
+    mode: MountMode,
+    overlay: Option<&Overlay>,
+    options: &MountOptions,
 ) -> Result<Mount, i32> {
     if offset == 0 && length == 0 {
-        return build_from_file_with_mode(archive_path, mount_point, mode, overlay);
+        return build_from_file_with_options(archive_path, mount_point, mode, overlay, options);
     }
     let mut file = File::open(archive_path).map_err(open_error)?;
     let file_size = file.seek(SeekFrom::End(0)).map_err(|_| libc::EIO)?;
@@ -254,16 +452,26 @@ pub fn build_from_file_at_with_mode(
     file.seek(SeekFrom::Start(offset)).map_err(|_| libc::EIO)?;
     let n = file.read(&mut magic).map_err(|_| libc::EIO)?;
     let format = detect_format(&magic[..n]);
+    #[allow(unused_mut)] // taken by the LimniFS arm only
+    let mut shared = SharedBlocks::for_image(Path::new(archive_path), &file, offset, length);
+    let mapped = MappedFiles::for_image(Path::new(archive_path), &file, offset, length);
 
     let backend: Box<dyn Backend> = match format {
-        ImageFormat::Zip => Box::new(ZipBackend::from_memory(read_region(
-            &mut file, offset, length,
+        ImageFormat::Zip => Box::new(ZipBackend::from_bytes(ImageBytes::map_file(
+            &file, offset, length,
         )?)?),
         // Tar regions are read in place (positioned reads relative to the
         // region start; the index pass streams inside the region bounds).
-        ImageFormat::Tar | ImageFormat::TarGz | ImageFormat::TarZst => Box::new(
-            TarBackend::from_file_at(file, offset, length, tar_compression(format))?,
-        ),
+        ImageFormat::Tar | ImageFormat::TarGz | ImageFormat::TarZst => {
+            let sidecar = index_sidecar::path_for(Path::new(archive_path), "tar", offset, length);
+            Box::new(TarBackend::from_file_at_indexed(
+                file,
+                offset,
+                length,
+                tar_compression(format),
+                sidecar.as_deref(),
+            )?)
+        }
         #[cfg(feature = "vendored-dwarfs")]
         ImageFormat::Dwarfs => Box::new(DwarfsBackend::from_file_at(
             Path::new(archive_path),
@@ -273,35 +481,35 @@ pub fn build_from_file_at_with_mode(
         #[cfg(not(feature = "vendored-dwarfs"))]
         ImageFormat::Dwarfs => return Err(libc::ENOTSUP),
         #[cfg(feature = "vendored-squashfs")]
-        ImageFormat::Squashfs => Box::new(SquashfsBackend::from_memory(read_region(
-            &mut file, offset, length,
+        ImageFormat::Squashfs => Box::new(SquashfsBackend::from_bytes(ImageBytes::map_file(
+            &file, offset, length,
         )?)?),
         #[cfg(not(feature = "vendored-squashfs"))]
         ImageFormat::Squashfs => return Err(libc::ENOTSUP),
         #[cfg(feature = "backend-limnifs")]
-        ImageFormat::Limnifs => Box::new(LimnifsBackend::from_image(read_region(
-            &mut file, offset, length,
-        )?)?),
+        ImageFormat::Limnifs => Box::new(share_drops(
+            LimnifsBackend::from_bytes(ImageBytes::map_file(&file, offset, length)?)?,
+            shared.take(),
+            options,
+        )),
         #[cfg(not(feature = "backend-limnifs"))]
         ImageFormat::Limnifs => return Err(libc::ENOTSUP),
         ImageFormat::Unknown => return Err(libc::EINVAL),
     };
-    let backend = apply_mode(backend, mode, overlay)?;
-    Ok(make_mount(mount_point, Some(archive_path), backend, mode))
-}
-
-/// Read `[offset, offset+length)` of a file into memory (region mounts of
-/// seek-less backends, mirroring the C++ copy semantics).
-fn read_region(file: &mut File, offset: u64, length: u64) -> Result<Vec<u8>, i32> {
-    let mut data = vec![0u8; length as usize];
-    file.seek(SeekFrom::Start(offset)).map_err(|_| libc::EIO)?;
-    file.read_exact(&mut data).map_err(|_| libc::EIO)?;
-    Ok(data)
+    let backend = apply_mode(options.apply(backend, format, shared), mode, overlay)?;
+    Ok(make_mount(
+        mount_point,
+        Some(archive_path),
+        backend,
+        mode,
+        options,
+        mapped,
+    ))
 }
 
 /// Mount an archive residing in memory. The image is COPIED (stronger than
 /// the C contract, which only borrows until unmount) so no lifetime escapes
-/// the FFI layer.
+/// the FFI layer; [`build_from_bytes_with_options`] is the borrowing form.
 pub fn build_from_memory(data: &[u8], mount_point: &str) -> Result<Mount, i32> {
     build_from_memory_with_mode(data, mount_point, MountMode::ReadOnly, None)
 }
@@ -312,32 +520,83 @@ pub fn build_from_memory_with_mode(
     mount_point: &str,
     mode: MountMode,
     overlay: Option<&Overlay>,
+) -> Result<Mount, i32> {
+    build_from_memory_with_options(data, mount_point, mode, overlay, &MountOptions::default())
+}
+
+/// [`build_from_memory_with_mode`] with per-mount read tuning.
+pub fn build_from_memory_with_options(
+    data: &[u8],
+    mount_point: &str,
+    mode: MountMode,
+    overlay: Option<&Overlay>,
+    options: &MountOptions,
+) -> Result<Mount, i32> {
+    if data.is_empty() {
+        return Err(libc::EINVAL);
+    }
+    let format = detect_format(&data[..data.len().min(SNIFF_LEN)]);
+    let bytes = if format == ImageFormat::Dwarfs {
+        // dwarfs-rs copies the image while opening it: lend it ours for
+        // the call instead of copying it twice.
+        // SAFETY: `data` outlives this call, and the DwarFS arm drops the
+        // view before `build_from_bytes_with_options` returns.
+        unsafe { ImageBytes::borrowed(data.as_ptr(), data.len(), None) }
+    } else {
+        ImageBytes::from(data.to_vec())
+    };
+    build_from_bytes_with_options(bytes, mount_point, mode, overlay, options)
+}
+
+/// Mount the image held in `data` without copying it: the backend keeps
+/// `data` — an owned buffer or a caller's lent one
+/// ([`ImageBytes::borrowed`], released at unmount) — and serves from it
+/// in place. DwarFS is the exception: dwarfs-rs copies the image while
+/// opening it, so `data` is dropped (a lent buffer released) as soon as
+/// the mount is built.
+pub fn build_from_bytes_with_options(
+    data: ImageBytes,
+    mount_point: &str,
+    mode: MountMode,
+    overlay: Option<&Overlay>,
+    options: &MountOptions,
 ) -> Result<Mount, i32> {
     if data.is_empty() {
         return Err(libc::EINVAL);
     }
     let format = detect_format(&data[..data.len().min(SNIFF_LEN)]);
     let backend: Box<dyn Backend> = match format {
-        ImageFormat::Zip => Box::new(ZipBackend::from_memory(data.to_vec())?),
-        ImageFormat::Tar | ImageFormat::TarGz | ImageFormat::TarZst => Box::new(
-            TarBackend::from_memory(data.to_vec(), tar_compression(format))?,
-        ),
+        ImageFormat::Zip => Box::new(ZipBackend::from_bytes(data)?),
+        ImageFormat::Tar | ImageFormat::TarGz | ImageFormat::TarZst => {
+            Box::new(TarBackend::from_bytes(data, tar_compression(format))?)
+        }
         #[cfg(feature = "vendored-dwarfs")]
-        ImageFormat::Dwarfs => Box::new(DwarfsBackend::from_memory(data)?),
+        ImageFormat::Dwarfs => Box::new(DwarfsBackend::from_memory(&data)?),
         #[cfg(not(feature = "vendored-dwarfs"))]
         ImageFormat::Dwarfs => return Err(libc::ENOTSUP),
         #[cfg(feature = "vendored-squashfs")]
-        ImageFormat::Squashfs => Box::new(SquashfsBackend::from_memory(data.to_vec())?),
+        ImageFormat::Squashfs => Box::new(SquashfsBackend::from_bytes(data)?),
         #[cfg(not(feature = "vendored-squashfs"))]
         ImageFormat::Squashfs => return Err(libc::ENOTSUP),
         #[cfg(feature = "backend-limnifs")]
-        ImageFormat::Limnifs => Box::new(LimnifsBackend::from_image(data.to_vec())?),
+        ImageFormat::Limnifs => Box::new(share_drops(
+            LimnifsBackend::from_bytes(data)?,
+            None,
+            options,
+        )),
         #[cfg(not(feature = "backend-limnifs"))]
         ImageFormat::Limnifs => return Err(libc::ENOTSUP),
         ImageFormat::Unknown => return Err(libc::EINVAL),
     };
-    let backend = apply_mode(backend, mode, overlay)?;
-    Ok(make_mount(mount_point, None, backend, mode))
+    let backend = apply_mode(options.apply(backend, format, None), mode, overlay)?;
+    Ok(make_mount(
+        mount_point,
+        None,
+        backend,
+        mode,
+        options,
+        MappedFiles::for_memory(),
+    ))
 }
 
 // ---------------------------------------------------------------------
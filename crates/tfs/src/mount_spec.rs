@@ -4,11 +4,18 @@
 //! validates and re-serializes it for the exec'd child). One grammar,
 //! one parser, one serializer.
 //!
+//! An entry may carry per-mount read tuning after the mount point:
+//! `image:mount?cache=256M&workers=8&readahead=1M` (sizes in bytes with
+//! an optional `K`/`M`/`G` suffix; see [`MountOptions`]). A mount point
+//! therefore never contains '?'.
+//!
 //! Pure safe Rust; named errors on malformed input (spec 14 §3).
 
 use std::fmt;
 use std::path::Path;
 
+use crate::mount::MountOptions;
+
 /// One `image:mount` declaration.
 #[derive(Debug, Clone, PartialEq, Eq)]
 pub struct MountDecl {
@@ -16,6 +23,8 @@ pub struct MountDecl {
     pub image: String,
     /// Absolute virtual mount point (never `/` — see [`parse_mount_entry`]).
     pub mount: String,
+    /// Read tuning from the `?key=value&…` suffix (default when absent).
+    pub options: MountOptions,
 }
 
 /// A named, human-readable mount-spec parse error (the offending entry is
@@ -31,9 +40,74 @@ impl fmt::Display for MountSpecError {
 
 impl std::error::Error for MountSpecError {}
 
-/// Validate one `image:mount` pair (shared tail of the env and CLI forms).
+/// A size: decimal bytes with an optional `K`/`M`/`G` (binary) suffix.
+fn parse_size(value: &str) -> Option<u64> {
+    let (digits, unit) = match value.as_bytes().last()? {
+        b'K' | b'k' => (&value[..value.len() - 1], 1u64 << 10),
+        b'M' | b'm' => (&value[..value.len() - 1], 1 << 20),
+        b'G' | b'g' => (&value[..value.len() - 1], 1 << 30),
+        _ => (value, 1),
+    };
+    digits.parse::<u64>().ok()?.checked_mul(unit)
+}
+
+/// The shortest exact spelling of `bytes` [`parse_size`] reads back.
+fn format_size(bytes: u64) -> String {
+    for (unit, suffix) in [(1u64 << 30, 'G'), (1 << 20, 'M'), (1 << 10, 'K')] {
+        if bytes != 0 && bytes % unit == 0 {
+            return format!("{}{suffix}", bytes / unit);
+        }
+    }
+    bytes.to_string()
+}
+
+/// Parse the `key=value&…` option suffix of an entry.
+fn parse_options(query: &str, context: &str) -> Result<MountOptions, MountSpecError> {
+    let mut options = MountOptions::default();
+    for pair in query.split('&') {
+        let bad = || MountSpecError(format!("bad mount option {pair:?} in {context:?}"));
+        let (key, value) = pair.split_once('=').ok_or_else(bad)?;
+        match key {
+            "cache" => options.cache_bytes = parse_size(value).ok_or_else(bad)?,
+            "readahead" => options.readahead = parse_size(value).ok_or_else(bad)?,
+            "workers" => options.workers = value.parse().map_err(|_| bad())?,
+            _ => {
+                return Err(MountSpecError(format!(
+                    "unknown mount option {key:?} in {context:?}"
+                )))
+            }
+        }
+    }
+    Ok(options)
+}
+
+/// The `?key=value&…` suffix for `options` (empty for the defaults).
+fn options_suffix(options: &MountOptions) -> String {
+    let mut pairs = Vec::new();
+    if options.cache_bytes != 0 {
+        pairs.push(format!("cache={}", format_size(options.cache_bytes)));
+    }
+    if options.workers != 0 {
+        pairs.push(format!("workers={}", options.workers));
+    }
+    if options.readahead != 0 {
+        pairs.push(format!("readahead={}", format_size(options.readahead)));
+    }
+    if pairs.is_empty() {
+        String::new()
+    } else {
+        format!("?{}", pairs.join("&"))
+    }
+}
+
+/// Validate one `image:mount[?options]` pair (shared tail of the env and
+/// CLI forms).
 fn validate(image: &str, mount: &str, context: &str) -> Result<MountDecl, MountSpecError> {
     let err = |msg: &str| MountSpecError(format!("{msg} in {context:?}"));
+    let (mount, options) = match mount.split_once('?') {
+        Some((mount, query)) => (mount, parse_options(query, context)?),
+        None => (mount, MountOptions::default()),
+    };
     if image.is_empty() {
         return Err(err("empty image path"));
     }
@@ -52,11 +126,12 @@ fn validate(image: &str, mount: &str, context: &str) -> Result<MountDecl, MountS
     Ok(MountDecl {
         image: image.to_string(),
         mount: mount.to_string(),
+        options,
     })
 }
 
-/// Parse one `image:mount` entry. Split at the LAST ':' so image paths
-/// containing ':' survive.
+/// Parse one `image:mount[?options]` entry. Split at the LAST ':' so
+/// image paths containing ':' survive.
 pub fn parse_mount_entry(entry: &str) -> Result<MountDecl, MountSpecError> {
     if entry.is_empty() {
         return Err(MountSpecError("empty entry".to_string()));
@@ -91,13 +166,14 @@ pub fn parse_mounts(spec: &str) -> Result<Vec<MountDecl>, MountSpecError> {
 pub fn to_env_spec(decls: &[MountDecl]) -> String {
     decls
         .iter()
-        .map(|d| format!("{}:{}", d.image, d.mount))
+        .map(|d| format!("{}:{}{}", d.image, d.mount, options_suffix(&d.options)))
         .collect::<Vec<_>>()
         .join(",")
 }
 
-/// Parse the `tfs exec` CLI form of one image argument: `image[:mount]`,
-/// default mount `/mnt` (the tfs-cli convention). The ':' is a delimiter
+/// Parse the `tfs exec` CLI form of one image argument:
+/// `image[:mount[?options]]`, default mount `/mnt` (the tfs-cli
+/// convention). The ':' is a delimiter
 /// only when what follows it looks like a mount point (starts with '/'),
 /// so a bare image path containing ':' is still accepted.
 pub fn parse_cli_image_mount(token: &str) -> Result<MountDecl, MountSpecError> {
@@ -125,10 +201,12 @@ mod tests {
                 MountDecl {
                     image: "/a/img.zip".to_string(),
                     mount: "/tfs".to_string(),
+                    options: MountOptions::default(),
                 },
                 MountDecl {
                     image: "/b/other.zip".to_string(),
                     mount: "/data".to_string(),
+                    options: MountOptions::default(),
                 },
             ]
         );
@@ -140,6 +218,52 @@ mod tests {
         assert_eq!(to_env_spec(&parse_mounts(spec).unwrap()), spec);
     }
 
+    #[test]
+    fn entries_carry_read_tuning() {
+        let decls =
+            parse_mounts("/a/x:y.dwarfs:/tfs?cache=256M&workers=8&readahead=1536K,/b.zip:/data")
+                .unwrap();
+        assert_eq!(decls[0].image, "/a/x:y.dwarfs");
+        assert_eq!(decls[0].mount, "/tfs");
+        assert_eq!(
+            decls[0].options,
+            MountOptions {
+                cache_bytes: 256 << 20,
+                workers: 8,
+                readahead: 1536 << 10,
+            }
+        );
+        assert!(decls[1].options.is_default());
+        let spec = to_env_spec(&decls);
+        assert_eq!(
+            spec,
+            "/a/x:y.dwarfs:/tfs?cache=256M&workers=8&readahead=1536K,/b.zip:/data"
+        );
+        assert_eq!(parse_mounts(&spec).unwrap(), decls);
+        assert_eq!(
+            parse_cli_image_mount("/a.zip:/tfs?cache=1000")
+                .unwrap()
+                .options
+                .cache_bytes,
+            1000
+        );
+
+        for (spec, frag) in [
+            ("/a.zip:/tfs?", "bad mount option"),
+            ("/a.zip:/tfs?cache", "bad mount option"),
+            ("/a.zip:/tfs?cache=lots", "bad mount option"),
+            ("/a.zip:/tfs?workers=-1", "bad mount option"),
+            ("/a.zip:/tfs?cache=99999999999G", "bad mount option"),
+            ("/a.zip:/tfs?threads=4", "unknown mount option"),
+        ] {
+            let e = parse_mounts(spec).unwrap_err();
+            assert!(
+                e.0.contains(frag),
+                "spec {spec:?}: error {e:?} should mention {frag:?}"
+            );
+        }
+    }
+
     #[test]
     fn image_path_may_contain_colons() {
         let d = parse_mount_entry("/Volumes/a:b/img.zip:/tfs").unwrap();
@@ -19,6 +19,15 @@
 //! time and RE-CANONICALIZED on every check, so a symlink swapped in after
 //! the policy was installed resolves to its target and escapes fail.
 //!
+//! The grants compile into a component trie at bind (`GrantTrie`: one
+//! walk answers longest prefix, argument file and traverse at once), and
+//! verdicts are memoized per lexical path (`VerdictCache`) — a memo is
+//! served only while the dentry signal of the path's deepest existing
+//! ancestor (its parent directory's identity and change times, resolved
+//! through any symlinks) is unchanged, so a swap re-canonicalizes. A
+//! path that is itself a symlink is never memoized: it resolves outside
+//! its parent, whose signal cannot see a swap along the link's target.
+//!
 //! The policy is about HOST paths only; memfs mounts are unaffected. It is
 //! process state, not namespace state: `unmount()` does not reset it
 //! (fail-closed), and installing a new policy replaces the old one — the
@@ -28,8 +37,11 @@
 //!
 //! Pure safe Rust; errno values are the crate's error convention.
 
+use std::collections::BTreeMap;
+use std::ffi::OsString;
 use std::fmt;
 use std::path::{Component, Path, PathBuf};
+use std::sync::Mutex;
 
 /// Access mode: a mount's grant bit, and the level an IO route requests.
 ///
@@ -163,14 +175,17 @@ pub struct HostPolicy {
     /// `host:mount:ro|rw` grammar its windows spellings would break.
     floor_mounts: Vec<HostMount>,
     arg_files: Vec<PathBuf>,
-    /// The ancestor traverse set (spec 08 §2.1): the strict ancestors of
-    /// every bound grant (mounts + floor), checkable as EXACT-path reads
-    /// — never prefix, never write. Canonicalization walks are universal
-    /// (the JVM reads its cwd and each ancestor at VM init; without the
-    /// traverse grant the factory's jailed_exec leg died with "Could not
-    /// determine current working directory", PR #95 macOS, 2026-08-14).
-    /// Derived at bind, never authored, never serialized.
-    traverse: Vec<PathBuf>,
+    /// The compiled grant table: mounts, floor, argument files and the
+    /// ancestor traverse set (spec 08 §2.1 — the strict ancestors of
+    /// every bound grant, checkable as EXACT-path reads, never prefix,
+    /// never write; canonicalization walks are universal: the JVM reads
+    /// its cwd and each ancestor at VM init, and without the traverse
+    /// grant the factory's jailed_exec leg died with "Could not determine
+    /// current working directory", PR #95 macOS, 2026-08-14). Derived at
+    /// bind, never authored, never serialized.
+    grants: GrantTrie,
+    /// Memoized verdicts per lexical path (see [`VerdictCache`]).
+    verdicts: VerdictCache,
     /// Who installed the policy (`manifest`, `user`, `manifest+user`,
     /// `TEBAKO_JAIL`, …), recorded in the audit journal on every denial
     /// (spec 08 §2: violations are logged with path + syscall class).
@@ -192,7 +207,8 @@ impl HostPolicy {
             mounts: Vec::new(),
             floor_mounts: Vec::new(),
             arg_files: Vec::new(),
-            traverse: Vec::new(),
+            grants: GrantTrie::new(),
+            verdicts: VerdictCache::new(),
             source: String::new(),
         }
     }
@@ -297,18 +313,25 @@ impl HostPolicy {
         for f in &arg_files {
             bound_files.push(canonicalize(f)?);
         }
+        // Compile the grant table. Authored grants first: on an equal
+        // host the first grant inserted keeps the node (the authored one
+        // — supersede already dropped every floor entry it covers).
+        let mut grants = GrantTrie::new();
+        for m in bound_mounts.iter().chain(floor_mounts.iter()) {
+            grants.node_mut(&m.host).grant.get_or_insert(m.access);
+        }
+        for f in &bound_files {
+            grants.node_mut(f).arg_file = true;
+        }
         // The ancestor traverse set (spec 08 §2.1): every strict ancestor
         // of every bound grant is readable as an EXACT path — never
         // prefix (no sideways exposure), never write. Canonicalization
         // walks are universal (the JVM reads its cwd and each ancestor at
-        // VM init). Derived at bind, never authored, never serialized.
-        let mut traverse: Vec<PathBuf> = Vec::new();
+        // VM init).
         for m in bound_mounts.iter().chain(floor_mounts.iter()) {
             let mut anc = m.host.as_path();
             while let Some(parent) = anc.parent() {
-                if !traverse.iter().any(|t| t == parent) {
-                    traverse.push(parent.to_path_buf());
-                }
+                grants.node_mut(parent).traverse = true;
                 anc = parent;
             }
         }
@@ -317,7 +340,8 @@ impl HostPolicy {
             mounts: bound_mounts,
             floor_mounts,
             arg_files: bound_files,
-            traverse,
+            grants,
+            verdicts: VerdictCache::new(),
             source: String::new(),
         })
     }
@@ -338,34 +362,43 @@ impl HostPolicy {
             PolicyDefault::Record => return Ok(()),
             PolicyDefault::Open | PolicyDefault::Deny => {}
         }
-        // Re-validate realpath on each open: the target is canonicalized at
-        // check time, so symlink swaps after bind resolve to their target.
+        // The signal is taken BEFORE deciding: a change racing the
+        // decision leaves a memo whose signal is already stale.
+        let signal = dentry_signal(path);
+        if let Some(signal) = signal {
+            if let Some(verdict) = self.verdicts.get(path, signal, need) {
+                return verdict;
+            }
+        }
+        let verdict = self.decide(path, need);
+        if let Some(signal) = signal {
+            self.verdicts.put(path, signal, need, verdict);
+        }
+        verdict
+    }
+
+    /// [`check`](Self::check)'s decision, uncached.
+    fn decide(&self, path: &Path, need: HostAccess) -> Result<(), i32> {
+        // Re-validate realpath on each decision: the target is
+        // canonicalized at check time, so symlink swaps after bind resolve
+        // to their target.
         let canon = canonicalize_lenient(path);
+        let found = self.grants.lookup(&canon);
 
         // Argument files: exact (canonical) match, read grant only, even
         // under deny — "the input file you hand the command is allowed".
-        if need == HostAccess::Ro && self.arg_files.contains(&canon) {
+        if need == HostAccess::Ro && found.arg_file {
             return Ok(());
         }
 
         // Longest host-prefix match across authored grants AND the floor
         // (identical semantics; the lists are kept apart only so the env
-        // serialization stays authored-only); Path::starts_with matches
-        // on whole path components, so "/work" never matches "/workshop".
-        let mut best: Option<&HostMount> = None;
-        for m in self.mounts.iter().chain(self.floor_mounts.iter()) {
-            let longer = match best {
-                Some(b) => b.host.as_os_str().len() < m.host.as_os_str().len(),
-                None => true,
-            };
-            if longer && canon.starts_with(&m.host) {
-                best = Some(m);
-            }
-        }
-        if let Some(m) = best {
+        // serialization stays authored-only); the trie matches on whole
+        // path components, so "/work" never matches "/workshop".
+        if let Some(access) = found.grant {
             // A mount's grant bit applies even under an open default (an ro
             // bind is ro in an otherwise open namespace, docker-style).
-            if need == HostAccess::Rw && m.access == HostAccess::Ro {
+            if need == HostAccess::Rw && access == HostAccess::Ro {
                 return Err(libc::EROFS);
             }
             return Ok(());
@@ -374,7 +407,7 @@ impl HostPolicy {
         // The ancestor traverse set (spec 08 §2.1): exact-path read only.
         // Prefix grants are wider and matched above; a write against a
         // traverse path falls through to the default's denial.
-        if need == HostAccess::Ro && self.traverse.iter().any(|t| t == &canon) {
+        if need == HostAccess::Ro && found.traverse {
             return Ok(());
         }
 
@@ -547,6 +580,218 @@ impl JailSpec {
     }
 }
 
+/// The compiled grant table: a trie over canonical host-path components
+/// (`Path::components`, so matching keeps `Path::starts_with`'s whole-
+/// component semantics). A node carries the grant rooted at its path
+/// (covering it and everything below) and the two exact-path marks.
+#[derive(Debug, Clone, PartialEq, Eq)]
+struct GrantTrie {
+    grant: Option<HostAccess>,
+    arg_file: bool,
+    traverse: bool,
+    children: BTreeMap<OsString, GrantTrie>,
+}
+
+/// What one walk of the [`GrantTrie`] found for a canonical path.
+struct GrantMatch {
+    /// The deepest grant covering the path.
+    grant: Option<HostAccess>,
+    /// The path is exactly an argument file.
+    arg_file: bool,
+    /// The path is exactly a traverse ancestor.
+    traverse: bool,
+}
+
+impl GrantTrie {
+    const fn new() -> Self {
+        GrantTrie {
+            grant: None,
+            arg_file: false,
+            traverse: false,
+            children: BTreeMap::new(),
+        }
+    }
+
+    /// The node for `path`, created on demand.
+    fn node_mut(&mut self, path: &Path) -> &mut GrantTrie {
+        let mut node = self;
+        for comp in path.components() {
+            node = node
+                .children
+                .entry(comp.as_os_str().to_os_string())
+                .or_insert_with(GrantTrie::new);
+        }
+        node
+    }
+
+    fn lookup(&self, canon: &Path) -> GrantMatch {
+        let mut node = self;
+        let mut grant = node.grant;
+        for comp in canon.components() {
+            let Some(child) = node.children.get(comp.as_os_str()) else {
+                // Walked off the table: only a prefix grant can apply.
+                return GrantMatch {
+                    grant,
+                    arg_file: false,
+                    traverse: false,
+                };
+            };
+            node = child;
+            grant = node.grant.or(grant);
+        }
+        GrantMatch {
+            grant,
+            arg_file: node.arg_file,
+            traverse: node.traverse,
+        }
+    }
+}
+
+/// Memo bound: past this many lexical paths the table starts over.
+const VERDICT_CACHE_MAX: usize = 4096;
+
+/// How recent (seconds) a directory's last entry change may be before its
+/// signal is trusted. Filesystem timestamps come from a coarse clock: a
+/// swap in the same tick as the memo's own snapshot would leave the mtime
+/// unchanged, so a directory modified within the window is never memoized
+/// against (git's "racily clean" rule).
+const RACY_SECS: i64 = 2;
+
+/// The revalidation signal of one lexical path: the identity and change
+/// times of its deepest existing ancestor (the parent directory, when it
+/// exists), stat'ed THROUGH symlinks. A symlink swapped anywhere on the
+/// path changes either the directory the path resolves into (another
+/// inode) or that directory's entries (its mtime/ctime); either way the
+/// memo is dropped and the path re-canonicalized.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct DentrySignal {
+    /// How many components above the path the answering ancestor sits.
+    level: usize,
+    dev: u64,
+    ino: u64,
+    mtime: (i64, i64),
+    ctime: (i64, i64),
+}
+
+/// The path's [`DentrySignal`]; None when it cannot be trusted (relative
+/// path — the cwd may move; a symlink leaf — it resolves through
+/// directories the parent's signal does not cover; a racily recent
+/// change; no ancestor exists).
+#[cfg(unix)]
+fn dentry_signal(path: &Path) -> Option<DentrySignal> {
+    use std::os::unix::fs::MetadataExt;
+    if !path.is_absolute()
+        || std::fs::symlink_metadata(path).is_ok_and(|md| md.file_type().is_symlink())
+    {
+        return None;
+    }
+    let start = path.parent().unwrap_or(path);
+    for (level, anc) in start.ancestors().enumerate() {
+        let Ok(md) = std::fs::metadata(anc) else {
+            continue;
+        };
+        let now = std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .map_or(0, |d| d.as_secs() as i64);
+        if now - md.mtime() < RACY_SECS {
+            return None;
+        }
+        return Some(DentrySignal {
+            level,
+            dev: md.dev(),
+            ino: md.ino(),
+            mtime: (md.mtime(), md.mtime_nsec()),
+            ctime: (md.ctime(), md.ctime_nsec()),
+        });
+    }
+    None
+}
+
+/// Windows has no stable inode identity in std: every check decides.
+#[cfg(not(unix))]
+fn dentry_signal(_path: &Path) -> Option<DentrySignal> {
+    None
+}
+
+/// One lexical path's memoized verdicts, per access level.
+struct Memo {
+    signal: DentrySignal,
+    ro: Option<Result<(), i32>>,
+    rw: Option<Result<(), i32>>,
+}
+
+/// Verdicts per lexical path, valid while their [`DentrySignal`] holds.
+/// Process-local scratch state: a clone starts empty and equality
+/// ignores it (two policies are equal by their grants).
+struct VerdictCache(Mutex<BTreeMap<PathBuf, Memo>>);
+
+impl VerdictCache {
+    const fn new() -> Self {
+        VerdictCache(Mutex::new(BTreeMap::new()))
+    }
+
+    fn table(&self) -> std::sync::MutexGuard<'_, BTreeMap<PathBuf, Memo>> {
+        self.0.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn get(&self, path: &Path, signal: DentrySignal, need: HostAccess) -> Option<Result<(), i32>> {
+        let table = self.table();
+        let memo = table.get(path).filter(|m| m.signal == signal)?;
+        match need {
+            HostAccess::Ro => memo.ro,
+            HostAccess::Rw => memo.rw,
+        }
+    }
+
+    fn put(&self, path: &Path, signal: DentrySignal, need: HostAccess, verdict: Result<(), i32>) {
+        let mut table = self.table();
+        if table.len() >= VERDICT_CACHE_MAX && !table.contains_key(path) {
+            table.clear();
+        }
+        let memo = table.entry(path.to_path_buf()).or_insert(Memo {
+            signal,
+            ro: None,
+            rw: None,
+        });
+        if memo.signal != signal {
+            *memo = Memo {
+                signal,
+                ro: None,
+                rw: None,
+            };
+        }
+        match need {
+            HostAccess::Ro => memo.ro = Some(verdict),
+            HostAccess::Rw => memo.rw = Some(verdict),
+        }
+    }
+
+    #[cfg(test)]
+    fn len(&self) -> usize {
+        self.table().len()
+    }
+}
+
+impl Clone for VerdictCache {
+    fn clone(&self) -> Self {
+        VerdictCache::new()
+    }
+}
+
+impl PartialEq for VerdictCache {
+    fn eq(&self, _other: &Self) -> bool {
+        true
+    }
+}
+
+impl Eq for VerdictCache {}
+
+impl fmt::Debug for VerdictCache {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "VerdictCache({} paths)", self.table().len())
+    }
+}
+
 /// Canonicalize a bind-time path; the errno channel speaks raw OS errors.
 fn canonicalize(path: &Path) -> Result<PathBuf, i32> {
     std::fs::canonicalize(path).map_err(|e| e.raw_os_error().unwrap_or(libc::ENOENT))
@@ -978,6 +1223,91 @@ mod tests {
         );
     }
 
+    /// Backdate a directory's mtime past the racy window, so checks
+    /// under it may be memoized.
+    #[cfg(unix)]
+    fn age(dir: &Path) {
+        let past = std::time::SystemTime::now() - std::time::Duration::from_secs(60);
+        std::fs::File::open(dir)
+            .unwrap()
+            .set_modified(past)
+            .unwrap();
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn memoized_verdicts_revalidate_when_the_same_path_is_swapped() {
+        let tree = Tree::new("memo");
+        let data = tree.work.join("data");
+        std::fs::create_dir_all(&data).unwrap();
+        std::fs::write(data.join("f.txt"), b"f").unwrap();
+        std::fs::write(tree.sibling.join("f.txt"), b"s").unwrap();
+        age(&data);
+        age(&tree.work);
+        let p = HostPolicy::bind(
+            PolicyDefault::Deny,
+            vec![tree.spec(&tree.work, "/work", HostAccess::Rw)],
+            vec![],
+        )
+        .unwrap();
+        let f = data.join("f.txt");
+        assert_eq!(p.check(&f, HostAccess::Ro), Ok(()));
+        assert_eq!(p.check(&f, HostAccess::Ro), Ok(()));
+        assert_eq!(p.verdicts.len(), 1, "the verdict is memoized");
+        // A racily fresh directory is decided but never memoized.
+        assert_eq!(
+            p.check(&tree.sibling.join("f.txt"), HostAccess::Ro),
+            Err(libc::EPERM)
+        );
+        assert_eq!(p.verdicts.len(), 1);
+
+        // The SAME lexical path, its parent swapped for a symlink out of
+        // the grant: the resolved parent is another inode — re-decided.
+        std::fs::remove_dir_all(&data).unwrap();
+        std::os::unix::fs::symlink(&tree.sibling, &data).unwrap();
+        assert_eq!(p.check(&f, HostAccess::Ro), Err(libc::EPERM));
+
+        // A leaf swap changes the parent's entries (its mtime).
+        let leaf = tree.work.join("leaf.txt");
+        std::fs::write(&leaf, b"l").unwrap();
+        age(&tree.work);
+        assert_eq!(p.check(&leaf, HostAccess::Rw), Ok(()));
+        assert_eq!(p.check(&leaf, HostAccess::Rw), Ok(()));
+        std::fs::remove_file(&leaf).unwrap();
+        std::os::unix::fs::symlink(tree.sibling.join("secret.txt"), &leaf).unwrap();
+        assert_eq!(p.check(&leaf, HostAccess::Rw), Err(libc::EPERM));
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn a_symlink_leaf_is_never_memoized() {
+        let tree = Tree::new("memolink");
+        let deep = tree.work.join("d1").join("d2");
+        std::fs::create_dir_all(&deep).unwrap();
+        std::fs::write(deep.join("f"), b"f").unwrap();
+        std::fs::write(tree.sibling.join("f"), b"s").unwrap();
+        let link = tree.work.join("link");
+        std::os::unix::fs::symlink(deep.join("f"), &link).unwrap();
+        for dir in [&deep, &tree.work.join("d1"), &tree.work] {
+            age(dir);
+        }
+        let p = HostPolicy::bind(
+            PolicyDefault::Deny,
+            vec![tree.spec(&tree.work, "/work", HostAccess::Rw)],
+            vec![],
+        )
+        .unwrap();
+        assert_eq!(p.check(&link, HostAccess::Ro), Ok(()));
+        assert_eq!(p.check(&link, HostAccess::Ro), Ok(()));
+        assert_eq!(p.verdicts.len(), 0, "a symlink leaf is decided every time");
+
+        // Swapping d2 for a symlink out of the grant touches only d1; the
+        // link's parent (work) is unchanged, yet the link now escapes.
+        std::fs::remove_dir_all(&deep).unwrap();
+        std::os::unix::fs::symlink(&tree.sibling, &deep).unwrap();
+        assert_eq!(p.check(&link, HostAccess::Ro), Err(libc::EPERM));
+    }
+
     #[test]
     fn nonexistent_paths_resolve_through_existing_ancestors() {
         let tree = Tree::new("nonexistent");
@@ -0,0 +1,757 @@
+//! Per-fd sequential readahead: an fd whose reads keep continuing where
+//! the previous one ended has its next window read on a background
+//! worker, so a streaming reader finds the bytes already decompressed
+//! instead of paying the decode on every call.
+//!
+//! The detector is per fd ([`Readahead`], held by the fd entry): the
+//! third consecutive sequential read (`read` or `pread`, by offset) arms
+//! it, any other read disarms it. Armed, every read that leaves less
+//! than one window prefetched ahead of the reader schedules the next
+//! window — at most one in flight per fd, at most [`MAX_CHUNKS`] windows
+//! held, chunks behind the reader dropped; a read reaching the window in
+//! flight waits for it instead of decoding the same bytes beside the
+//! worker (which would also steal the backend's resumable decode
+//! state). `posix_fadvise` advice (and Linux `readahead`) are explicit
+//! hints: `SEQUENTIAL` arms at once, `RANDOM` disarms and drops the
+//! chunks, `WILLNEED` prefetches one window at the named offset,
+//! `DONTNEED` drops the chunks.
+//!
+//! This is the only engine fetching ahead. On a mount keeping a read
+//! cache (a window cache, a format's drop cache) the worker's read lands
+//! the window there, under that cache's budget, and the fd keeps only
+//! its extent: reads there are cache hits, and no byte is held twice.
+//! Elsewhere the fd holds the bytes, charged to one process-wide budget
+//! (`TEBAKO_TFS_READAHEAD_MAX_MB`, default [`DEFAULT_MAX_HELD_MB`]): a
+//! window that would overrun it is not scheduled.
+//!
+//! The window is the mount's `readahead` tuning when it names one, else
+//! `TEBAKO_TFS_READAHEAD_KB` (default [`DEFAULT_WINDOW_KB`]; `0` turns
+//! the automatic detector off — explicit hints still prefetch with the
+//! default window). Only read-only mounts prefetch: on a COW mount a
+//! path write could change bytes a chunk already holds, so its fds get
+//! [`Readahead::disabled`] (advice is still validated, then ignored).
+//!
+//! One worker thread per process serves every fd, started at the first
+//! prefetch; jobs are plain closures (the context schedules them). The
+//! worker does not survive a `fork`: an atfork child handler bumps the
+//! process generation, the child's first prefetch starts a worker of
+//! its own, and windows a parent-side worker had in flight are dropped
+//! at the child's next look instead of being waited for.
+
+use std::collections::VecDeque;
+use std::sync::atomic::{AtomicBool, AtomicI32, AtomicU32, AtomicU64, Ordering};
+use std::sync::mpsc::{self, Sender};
+use std::sync::{Condvar, Mutex, MutexGuard, OnceLock};
+use std::time::Duration;
+
+use crate::byte_lru::budget_from_env;
+
+/// The window when `TEBAKO_TFS_READAHEAD_KB` is unset (KiB).
+pub const DEFAULT_WINDOW_KB: u64 = 512;
+/// Prefetched windows held per fd.
+pub const MAX_CHUNKS: usize = 2;
+/// Sequential reads in a row that arm the detector.
+const ARM_AFTER: u32 = 2;
+/// Bytes every fd may hold or have in flight when
+/// `TEBAKO_TFS_READAHEAD_MAX_MB` is unset (MiB).
+pub const DEFAULT_MAX_HELD_MB: usize = 32;
+
+// `posix_fadvise` advice: the host's values where it has the call, the
+// Linux ones (what `tebako_fs_fadvise` documents) elsewhere.
+#[cfg(target_os = "linux")]
+pub use libc::{
+    POSIX_FADV_DONTNEED as FADV_DONTNEED, POSIX_FADV_NOREUSE as FADV_NOREUSE,
+    POSIX_FADV_NORMAL as FADV_NORMAL, POSIX_FADV_RANDOM as FADV_RANDOM,
+    POSIX_FADV_SEQUENTIAL as FADV_SEQUENTIAL, POSIX_FADV_WILLNEED as FADV_WILLNEED,
+};
+#[cfg(not(target_os = "linux"))]
+mod fadv {
+    pub const FADV_NORMAL: i32 = 0;
+    pub const FADV_RANDOM: i32 = 1;
+    pub const FADV_SEQUENTIAL: i32 = 2;
+    pub const FADV_WILLNEED: i32 = 3;
+    pub const FADV_DONTNEED: i32 = 4;
+    pub const FADV_NOREUSE: i32 = 5;
+}
+#[cfg(not(target_os = "linux"))]
+pub use fadv::*;
+
+/// The readahead window for mounts naming none (read once).
+pub fn window_from_env() -> u64 {
+    static WINDOW: OnceLock<u64> = OnceLock::new();
+    *WINDOW.get_or_init(|| {
+        std::env::var("TEBAKO_TFS_READAHEAD_KB")
+            .ok()
+            .and_then(|v| v.trim().parse::<u64>().ok())
+            .unwrap_or(DEFAULT_WINDOW_KB)
+            .saturating_mul(1024)
+    })
+}
+
+/// How long a read waits for the window in flight over its offset
+/// before reading the backend itself (a lost job must never wedge the
+/// fd; one lost to a `fork` is dropped without waiting, see
+/// [`GENERATION`]).
+const LANDING_WAIT: Duration = Duration::from_secs(1);
+
+/// The process generation: bumped in every `fork` child, where the
+/// worker and the jobs queued to it are gone. A window in flight, and
+/// the worker, belong to the generation that scheduled them.
+static GENERATION: AtomicU64 = AtomicU64::new(0);
+
+fn generation() -> u64 {
+    GENERATION.load(Ordering::Acquire)
+}
+
+/// The atfork CHILD handler: start a new generation. Runs on the forking
+/// thread, the only one the child has. `unsafe` only to coerce to the
+/// handler slot some libc bindings declare.
+#[cfg(unix)]
+unsafe extern "C" fn forked() {
+    GENERATION.fetch_add(1, Ordering::AcqRel);
+}
+
+/// Register [`forked`] once per process (at the first fd's state, so a
+/// window can never be in flight before it is watched). A registration
+/// failure (ENOMEM) leaves fork children the [`LANDING_WAIT`] fallback.
+fn watch_forks() {
+    #[cfg(unix)]
+    {
+        static WATCH: std::sync::Once = std::sync::Once::new();
+        WATCH.call_once(|| {
+            // SAFETY: plain libc call; the handler is a valid extern "C" fn.
+            let rc = unsafe { libc::pthread_atfork(None, None, Some(forked)) };
+            if rc != 0 {
+                tebako_log::log!(
+                tebako_log::Level::Warn,
+                "tfs",
+                "readahead: pthread_atfork failed (rc={rc}); fork children wait out lost windows"
+            );
+            }
+        });
+    }
+}
+
+/// The bytes prefetched chunks hold, and windows in flight will, across
+/// the fds charged to it.
+pub struct Budget {
+    held: AtomicU64,
+    max: u64,
+}
+
+impl Budget {
+    const fn new(max: u64) -> Budget {
+        Budget {
+            held: AtomicU64::new(0),
+            max,
+        }
+    }
+
+    /// The budget every fd of the process is charged to (read once).
+    pub fn process() -> &'static Budget {
+        static PROCESS: OnceLock<Budget> = OnceLock::new();
+        PROCESS.get_or_init(|| {
+            let max = budget_from_env("TEBAKO_TFS_READAHEAD_MAX_MB", DEFAULT_MAX_HELD_MB);
+            Budget::new(max as u64)
+        })
+    }
+
+    /// Bytes charged now.
+    pub fn held(&self) -> u64 {
+        self.held.load(Ordering::Acquire)
+    }
+
+    /// Charge `n` bytes when they fit.
+    fn reserve(&self, n: u64) -> bool {
+        self.held
+            .fetch_update(Ordering::AcqRel, Ordering::Acquire, |held| {
+                held.checked_add(n).filter(|&total| total <= self.max)
+            })
+            .is_ok()
+    }
+
+    fn charge(&self, n: u64) {
+        self.held.fetch_add(n, Ordering::AcqRel);
+    }
+
+    fn release(&self, n: u64) {
+        self.held.fetch_sub(n, Ordering::AcqRel);
+    }
+}
+
+struct Chunk {
+    offset: u64,
+    len: u64,
+    /// The bytes; empty when the mount's read cache holds them.
+    data: Vec<u8>,
+}
+
+impl Chunk {
+    fn end(&self) -> u64 {
+        self.offset + self.len
+    }
+}
+
+struct Held {
+    chunks: VecDeque<Chunk>,
+    /// The window being read (`offset`, `len`), if any.
+    inflight: Option<(u64, u64)>,
+    /// The [`GENERATION`] that scheduled `inflight`.
+    generation: u64,
+    /// What the chunks and the window in flight are charged to.
+    budget: &'static Budget,
+}
+
+impl Held {
+    fn covering(&self, at: u64) -> Option<&Chunk> {
+        self.chunks.iter().find(|c| c.offset <= at && at < c.end())
+    }
+
+    /// Schedule `window` on this generation's worker; false when it does
+    /// not fit the budget.
+    fn schedule(&mut self, window: (u64, u64)) -> bool {
+        if !self.budget.reserve(window.1) {
+            return false;
+        }
+        self.inflight = Some(window);
+        self.generation = generation();
+        true
+    }
+
+    /// Clear the window in flight, giving back its charge.
+    fn land(&mut self) {
+        if let Some((_, len)) = self.inflight.take() {
+            self.budget.release(len);
+        }
+    }
+
+    /// Hold `chunk` (charging its bytes: the window in flight reserved
+    /// them), dropping the oldest past [`MAX_CHUNKS`].
+    fn hold(&mut self, chunk: Chunk) {
+        self.budget.charge(chunk.data.len() as u64);
+        self.chunks.push_back(chunk);
+        while self.chunks.len() > MAX_CHUNKS {
+            if let Some(oldest) = self.chunks.pop_front() {
+                self.budget.release(oldest.data.len() as u64);
+            }
+        }
+    }
+
+    /// Drop the chunks `keep` rejects.
+    fn retain(&mut self, keep: impl Fn(&Chunk) -> bool) {
+        let budget = self.budget;
+        self.chunks.retain(|c| {
+            let kept = keep(c);
+            if !kept {
+                budget.release(c.data.len() as u64);
+            }
+            kept
+        });
+    }
+
+    fn in_flight_at(&self, at: u64) -> bool {
+        self.inflight
+            .is_some_and(|(from, len)| from <= at && at < from + len)
+    }
+}
+
+impl Drop for Held {
+    fn drop(&mut self) {
+        self.retain(|_| false);
+        self.land();
+    }
+}
+
+/// One fd's readahead state (see the module docs).
+pub struct Readahead {
+    /// Automatic window (0: the detector is off).
+    window: u64,
+    /// Advice is honoured (false: validated and ignored).
+    hints: bool,
+    /// Where the last read ended.
+    next: AtomicU64,
+    /// Sequential reads in a row.
+    streak: AtomicU32,
+    /// The fd's `posix_fadvise` advice (`FADV_*`).
+    advice: AtomicI32,
+    held: Mutex<Held>,
+    /// Signalled when the window in flight lands (or is abandoned).
+    landed: Condvar,
+    /// Chunks held or a window in flight (lets `serve` skip the lock).
+    busy: AtomicBool,
+    /// Bytes prefetched, and bytes reads took from the chunks.
+    prefetched: AtomicU64,
+    served: AtomicU64,
+}
+
+impl Readahead {
+    /// State for a new fd with an automatic window of `window` bytes.
+    pub fn new(window: u64) -> Readahead {
+        Readahead::charged_to(window, Budget::process())
+    }
+
+    /// [`Readahead::new`], charging what it holds to `budget`.
+    fn charged_to(window: u64, budget: &'static Budget) -> Readahead {
+        watch_forks();
+        Readahead {
+            window,
+            hints: true,
+            next: AtomicU64::new(u64::MAX),
+            streak: AtomicU32::new(0),
+            advice: AtomicI32::new(FADV_NORMAL),
+            held: Mutex::new(Held {
+                chunks: VecDeque::new(),
+                inflight: None,
+                generation: 0,
+                budget,
+            }),
+            landed: Condvar::new(),
+            busy: AtomicBool::new(false),
+            prefetched: AtomicU64::new(0),
+            served: AtomicU64::new(0),
+        }
+    }
+
+    /// State for an fd that never prefetches.
+    pub fn disabled() -> Readahead {
+        Readahead {
+            hints: false,
+            ..Readahead::new(0)
+        }
+    }
+
+    /// The held state, less a window in flight on a worker an earlier
+    /// generation started (one that did not survive a `fork`).
+    fn held(&self) -> MutexGuard<'_, Held> {
+        let mut held = self.held.lock().unwrap_or_else(|e| e.into_inner());
+        if held.inflight.is_some() && held.generation != generation() {
+            held.land();
+            self.settle(&held);
+        }
+        held
+    }
+
+    fn settle(&self, held: &Held) {
+        self.busy.store(
+            !held.chunks.is_empty() || held.inflight.is_some(),
+            Ordering::Release,
+        );
+    }
+
+    /// The window hints prefetch with (the automatic one, or the default
+    /// when the detector is off).
+    fn hint_window(&self) -> u64 {
+        match self.window {
+            0 => DEFAULT_WINDOW_KB * 1024,
+            n => n,
+        }
+    }
+
+    /// Copy prefetched bytes at `offset` into `buf`; the count copied (0
+    /// when no chunk holds `offset`, or the mount's cache does). A read
+    /// reaching the window in flight waits for it rather than decoding
+    /// the same bytes again beside the worker.
+    pub fn serve(&self, offset: u64, buf: &mut [u8]) -> usize {
+        if !self.busy.load(Ordering::Acquire) || buf.is_empty() {
+            return 0;
+        }
+        let mut held = self.held();
+        let mut copied = 0;
+        let mut at = offset;
+        while copied < buf.len() {
+            if let Some(chunk) = held.covering(at) {
+                if chunk.data.is_empty() {
+                    break;
+                }
+                let start = (at - chunk.offset) as usize;
+                let n = (chunk.data.len() - start).min(buf.len() - copied);
+                buf[copied..copied + n].copy_from_slice(&chunk.data[start..start + n]);
+                copied += n;
+                at += n as u64;
+                continue;
+            }
+            if !held.in_flight_at(at) {
+                break;
+            }
+            let (guard, wait) = self
+                .landed
+                .wait_timeout_while(held, LANDING_WAIT, |h| h.in_flight_at(at))
+                .unwrap_or_else(|e| e.into_inner());
+            held = guard;
+            if wait.timed_out() {
+                break;
+            }
+        }
+        self.served.fetch_add(copied as u64, Ordering::Relaxed);
+        copied
+    }
+
+    /// Record a read of `n` bytes at `offset` of a `size`-byte file; the
+    /// window to prefetch, when one is due.
+    pub fn observe(&self, offset: u64, n: usize, size: u64) -> Option<(u64, u64)> {
+        let end = offset + n as u64;
+        let streak = if self.next.swap(end, Ordering::AcqRel) == offset && n > 0 {
+            self.streak.fetch_add(1, Ordering::AcqRel) + 1
+        } else {
+            self.streak.store(0, Ordering::Release);
+            0
+        };
+        match self.advice.load(Ordering::Acquire) {
+            FADV_RANDOM => None,
+            FADV_SEQUENTIAL => self.plan(end, size, self.hint_window()),
+            _ if self.window == 0 || streak < ARM_AFTER => None,
+            _ => self.plan(end, size, self.window),
+        }
+    }
+
+    /// Apply `posix_fadvise` advice for `len` bytes at `offset` (`len`
+    /// 0: to the end) of a `size`-byte file read up to `pos`; the window
+    /// to prefetch, when one is due. `EINVAL` for unknown advice.
+    pub fn advise(
+        &self,
+        advice: i32,
+        offset: u64,
+        len: u64,
+        pos: u64,
+        size: u64,
+    ) -> Result<Option<(u64, u64)>, i32> {
+        match advice {
+            FADV_NORMAL | FADV_RANDOM | FADV_SEQUENTIAL | FADV_WILLNEED | FADV_DONTNEED
+            | FADV_NOREUSE
+                if !self.hints =>
+            {
+                Ok(None)
+            }
+            FADV_NORMAL => {
+                self.advice.store(advice, Ordering::Release);
+                Ok(None)
+            }
+            FADV_NOREUSE => Ok(None),
+            FADV_SEQUENTIAL => {
+                self.advice.store(advice, Ordering::Release);
+                Ok(self.plan(pos, size, self.hint_window()))
+            }
+            FADV_RANDOM => {
+                self.advice.store(advice, Ordering::Release);
+                self.drop_chunks();
+                Ok(None)
+            }
+            FADV_DONTNEED => {
+                self.drop_chunks();
+                Ok(None)
+            }
+            FADV_WILLNEED => {
+                let mut held = self.held();
+                if offset >= size || held.inflight.is_some() || held.covering(offset).is_some() {
+                    return Ok(None);
+                }
+                let want = match len {
+                    0 => size - offset,
+                    n => n.min(size - offset),
+                };
+                let window = (offset, want.min(self.hint_window()));
+                if !held.schedule(window) {
+                    return Ok(None);
+                }
+                self.settle(&held);
+                Ok(Some(window))
+            }
+            _ => Err(libc::EINVAL),
+        }
+    }
+
+    /// The next window past what is held contiguously from `pos`, when
+    /// less than `window` bytes are held, none is in flight and the
+    /// budget has room for it.
+    fn plan(&self, pos: u64, size: u64, window: u64) -> Option<(u64, u64)> {
+        let mut held = self.held();
+        held.retain(|c| c.end() > pos);
+        let mut ahead = pos;
+        while let Some(chunk) = held.covering(ahead) {
+            ahead = chunk.end();
+        }
+        let due = held.inflight.is_none()
+            && ahead < size
+            && ahead - pos < window
+            && held.schedule((ahead, window.min(size - ahead)));
+        self.settle(&held);
+        held.inflight.filter(|_| due)
+    }
+
+    /// Hold `data`, read at `offset` for the window in flight.
+    pub fn fill(&self, offset: u64, data: Vec<u8>) {
+        let len = data.len() as u64;
+        self.land(Chunk { offset, len, data });
+    }
+
+    /// The window in flight, `len` bytes at `offset`, was read into the
+    /// mount's own read cache: keep its extent, not its bytes, so the
+    /// reads there go to the cache and the next window is planned past
+    /// it.
+    pub fn warmed(&self, offset: u64, len: u64) {
+        self.land(Chunk {
+            offset,
+            len,
+            data: Vec::new(),
+        });
+    }
+
+    fn land(&self, chunk: Chunk) {
+        let mut held = self.held();
+        if chunk.len > 0 {
+            self.prefetched.fetch_add(chunk.len, Ordering::Relaxed);
+            held.hold(chunk);
+        }
+        held.land();
+        self.settle(&held);
+        self.landed.notify_all();
+    }
+
+    /// Give up the window in flight (the fd went away, or the worker
+    /// could not read it).
+    pub fn abandon(&self) {
+        let mut held = self.held();
+        held.land();
+        self.settle(&held);
+        self.landed.notify_all();
+    }
+
+    fn drop_chunks(&self) {
+        let mut held = self.held();
+        held.retain(|_| false);
+        self.settle(&held);
+    }
+
+    /// (bytes prefetched, bytes served from prefetched chunks).
+    pub fn stats(&self) -> (u64, u64) {
+        (
+            self.prefetched.load(Ordering::Relaxed),
+            self.served.load(Ordering::Relaxed),
+        )
+    }
+}
+
+/// A worker job.
+pub type Job = Box<dyn FnOnce() + Send>;
+
+static RUN: OnceLock<fn(Job)> = OnceLock::new();
+
+/// Run every worker job through `run` (the first call wins). The preload
+/// shim marks the worker as inside the engine this way, so the engine's
+/// own host IO there passes straight to libc.
+pub fn run_jobs_through(run: fn(Job)) {
+    let _ = RUN.set(run);
+}
+
+fn spawn_worker() -> Option<Sender<Job>> {
+    let (tx, rx) = mpsc::channel::<Job>();
+    std::thread::Builder::new()
+        .name("tebako-readahead".to_string())
+        .spawn(move || {
+            for job in rx {
+                match RUN.get() {
+                    Some(run) => run(job),
+                    None => job(),
+                }
+            }
+        })
+        .ok()
+        .map(|_| tx)
+}
+
+/// Run `job` on the readahead worker (started on first use in each
+/// [`GENERATION`], so a `fork` child gets its own). False when the
+/// worker cannot be started — the caller then abandons the window.
+pub fn submit(job: Job) -> bool {
+    /// The worker's generation and sender (`None`: it could not start).
+    static WORKER: Mutex<Option<(u64, Option<Sender<Job>>)>> = Mutex::new(None);
+    let now = generation();
+    let mut worker = WORKER.lock().unwrap_or_else(|e| e.into_inner());
+    if worker.as_ref().map_or(true, |(started, _)| *started != now) {
+        // A parent's sender is dropped here: its worker never ran in
+        // this process, so nothing else holds the channel.
+        *worker = Some((now, spawn_worker()));
+    }
+    match worker.as_ref().and_then(|(_, tx)| tx.as_ref()) {
+        Some(tx) => tx.send(job).is_ok(),
+        None => false,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const W: u64 = 1000;
+
+    #[test]
+    fn the_third_sequential_read_schedules_the_next_window() {
+        let ra = Readahead::new(W);
+        assert_eq!(ra.observe(0, 100, 10_000), None);
+        assert_eq!(ra.observe(100, 100, 10_000), None);
+        assert_eq!(ra.observe(200, 100, 10_000), Some((300, W)));
+        assert_eq!(ra.observe(300, 100, 10_000), None, "one in flight");
+        ra.fill(300, vec![7; W as usize]);
+
+        let mut buf = [0u8; 150];
+        assert_eq!(ra.serve(400, &mut buf), 150);
+        assert_eq!(buf, [7; 150]);
+        // Reading inside the chunk leaves less than a window ahead: the
+        // following window is due.
+        assert_eq!(ra.observe(400, 150, 10_000), Some((1300, W)));
+        ra.fill(1300, vec![8; W as usize]);
+        let mut span = [0u8; 200];
+        assert_eq!(ra.serve(1200, &mut span), 200, "across both chunks");
+        assert_eq!((span[99], span[100]), (7, 8));
+        assert_eq!(ra.stats(), (2 * W, 350));
+
+        // A jump disarms; the window is clamped at the end of the file.
+        assert_eq!(ra.observe(5000, 100, 10_000), None);
+        let near_end = Readahead::new(W);
+        for at in [9000, 9100] {
+            near_end.observe(at, 100, 9_500);
+        }
+        assert_eq!(near_end.observe(9200, 100, 9_500), Some((9300, 200)));
+    }
+
+    #[test]
+    fn advice_is_an_explicit_hint() {
+        let ra = Readahead::new(0); // detector off
+        assert_eq!(ra.observe(0, 10, 1 << 20), None);
+        assert_eq!(ra.observe(10, 10, 1 << 20), None);
+        assert_eq!(ra.observe(20, 10, 1 << 20), None);
+
+        let willneed = ra.advise(FADV_WILLNEED, 4096, 100, 0, 1 << 20);
+        assert_eq!(willneed, Ok(Some((4096, 100))));
+        ra.fill(4096, vec![1; 100]);
+        let seq = ra.advise(FADV_SEQUENTIAL, 0, 0, 30, 1 << 20);
+        assert_eq!(seq, Ok(Some((30, DEFAULT_WINDOW_KB * 1024))));
+        ra.abandon();
+
+        assert_eq!(ra.advise(FADV_RANDOM, 0, 0, 30, 1 << 20), Ok(None));
+        assert_eq!(ra.serve(4096, &mut [0u8; 10]), 0, "RANDOM drops the chunks");
+        for at in [30, 40, 50, 60] {
+            assert_eq!(ra.observe(at, 10, 1 << 20), None);
+        }
+        assert_eq!(ra.advise(12345, 0, 0, 0, 1), Err(libc::EINVAL));
+
+        let off = Readahead::disabled();
+        assert_eq!(off.advise(FADV_WILLNEED, 0, 0, 0, 1 << 20), Ok(None));
+        assert_eq!(off.advise(FADV_SEQUENTIAL, 0, 0, 0, 1 << 20), Ok(None));
+        assert_eq!(off.observe(0, 10, 1 << 20), None);
+        assert_eq!(off.advise(12345, 0, 0, 0, 1), Err(libc::EINVAL));
+    }
+
+    #[test]
+    fn a_read_into_the_window_in_flight_waits_for_it() {
+        let ra = std::sync::Arc::new(Readahead::new(W));
+        let willneed = ra.advise(FADV_WILLNEED, 0, 0, 0, 10_000);
+        assert_eq!(willneed, Ok(Some((0, W))));
+        let filler = std::sync::Arc::clone(&ra);
+        let worker = std::thread::spawn(move || {
+            std::thread::sleep(Duration::from_millis(20));
+            filler.fill(0, vec![9; W as usize]);
+        });
+        let mut buf = [0u8; 10];
+        assert_eq!(ra.serve(500, &mut buf), 10);
+        assert_eq!(buf, [9; 10]);
+        worker.join().unwrap();
+        assert_eq!(ra.serve(W, &mut buf), 0, "past the chunk, none in flight");
+    }
+
+    /// A real `fork` with a window in flight on the parent's worker: the
+    /// child's read does not wait out [`LANDING_WAIT`] for it, and the
+    /// child's own prefetch runs on a worker of its own. The child
+    /// reports through its exit code; the parent's state is untouched.
+    #[test]
+    fn a_fork_child_drops_the_parents_window_and_starts_its_own_worker() {
+        let ra = Readahead::new(W);
+        assert_eq!(ra.advise(FADV_WILLNEED, 0, 0, 0, 10_000), Ok(Some((0, W))));
+        // SAFETY: plain fork; the child only touches this test's state,
+        // spawns its worker and leaves through _exit.
+        let pid = unsafe { libc::fork() };
+        assert!(pid >= 0, "fork failed: {}", std::io::Error::last_os_error());
+        if pid == 0 {
+            let started = std::time::Instant::now();
+            let mut rc = 0;
+            if ra.serve(0, &mut [0u8; 10]) != 0 || started.elapsed() >= LANDING_WAIT / 2 {
+                rc = 41;
+            }
+            let (tx, rx) = mpsc::channel();
+            let ran = submit(Box::new(move || {
+                let _ = tx.send(());
+            }));
+            if !ran || rx.recv_timeout(Duration::from_secs(5)).is_err() {
+                rc = 42;
+            }
+            // SAFETY: plain libc call; never returns.
+            unsafe { libc::_exit(rc) };
+        }
+        let mut status = 0;
+        // SAFETY: pid is our child; status is a writable out-parameter.
+        assert_eq!(unsafe { libc::waitpid(pid, &mut status, 0) }, pid);
+        assert!(libc::WIFEXITED(status), "child did not exit normally");
+        assert_eq!(libc::WEXITSTATUS(status), 0, "fork child verdict");
+        let held = ra.held();
+        assert_eq!(held.inflight, Some((0, W)), "the parent's window stands");
+    }
+
+    #[test]
+    fn held_bytes_are_bounded_across_fds() {
+        let budget: &'static Budget = Box::leak(Box::new(Budget::new(2 * W)));
+        let first = Readahead::charged_to(W, budget);
+        let second = Readahead::charged_to(W, budget);
+        let third = Readahead::charged_to(W, budget);
+        assert_eq!(
+            first.advise(FADV_WILLNEED, 0, W, 0, 10_000),
+            Ok(Some((0, W)))
+        );
+        assert_eq!(
+            second.advise(FADV_WILLNEED, 0, W, 0, 10_000),
+            Ok(Some((0, W)))
+        );
+        assert_eq!(
+            third.advise(FADV_WILLNEED, 0, W, 0, 10_000),
+            Ok(None),
+            "over the budget"
+        );
+        first.fill(0, vec![1; 600]);
+        assert_eq!(budget.held(), W + 600, "a short window gives back the rest");
+        second.warmed(0, W);
+        assert_eq!(
+            budget.held(),
+            600,
+            "bytes in the mount's cache cost nothing"
+        );
+        assert_eq!(
+            third.advise(FADV_WILLNEED, 0, W, 0, 10_000),
+            Ok(Some((0, W)))
+        );
+        drop(first);
+        third.abandon();
+        assert_eq!(budget.held(), 0);
+    }
+
+    #[test]
+    fn a_warmed_window_is_read_from_the_cache_and_planned_past() {
+        let ra = Readahead::new(W);
+        for at in [0, 100] {
+            ra.observe(at, 100, 10_000);
+        }
+        assert_eq!(ra.observe(200, 100, 10_000), Some((300, W)));
+        ra.warmed(300, W);
+        assert_eq!(ra.serve(300, &mut [0u8; 10]), 0, "no bytes held");
+        assert_eq!(ra.observe(300, 500, 10_000), Some((1300, W)));
+        assert_eq!(ra.stats(), (W, 0));
+    }
+
+    #[test]
+    fn jobs_run_on_the_worker() {
+        let (tx, rx) = mpsc::channel();
+        assert!(submit(Box::new(move || {
+            tx.send(std::thread::current().name().map(str::to_string))
+                .unwrap();
+        })));
+        assert_eq!(rx.recv().unwrap().as_deref(), Some("tebako-readahead"));
+    }
+}
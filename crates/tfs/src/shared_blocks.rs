@@ -0,0 +1,582 @@
+//! A decompressed-block cache shared by every process on the host that
+//! mounts the same image (opt-in): dozens of workers started from one
+//! runtime image decompress each hot block once per machine instead of
+//! once per process, and hold one copy of it in the page cache instead
+//! of one per private heap.
+//!
+//! The cache is a file-backed segment in the exec-cache namespace,
+//! mapped shared by each attaching process:
+//! `$TEBAKO_EXEC_CACHE/tebako-blocks/<key>-<stamp>-<offset>-<length>.blk`.
+//! `<key>` is the exec-cache image key and `<stamp>` the region stamp of
+//! the persisted indexes (see `index_sidecar`), so an image rewritten in
+//! place gets a fresh segment and never serves a stale block. With no
+//! exec cache named, or `TEBAKO_TFS_SHARED_CACHE_MB` unset or `0` (the
+//! default), there is no segment and every backend keeps its private
+//! caches alone.
+//!
+//! ## Layout and concurrency
+//!
+//! ```text
+//! [header 64 B][slot table: slots × 64 B][arena: budget bytes]
+//! ```
+//!
+//! The segment is append-only: a block is published once and never
+//! rewritten, so a reader needs no lock. A slot is claimed with one
+//! compare-and-swap (`EMPTY` → `WRITING`), its arena range with one
+//! `fetch_add` on the header cursor; the bytes, length and key are then
+//! written and the slot released as `READY`. A lookup probes linearly
+//! from the key's home slot, reads only `READY` slots (acquire ordering
+//! pairs with the publishing release), and stops at the first `EMPTY`
+//! one. A process killed mid-publish leaves a `WRITING` slot that every
+//! lookup steps over.
+//!
+//! ## Trust
+//!
+//! Published blocks are served as file content, so a segment is only
+//! attached when this user alone can write it: the directory is created
+//! `0700` and the segment `0600`, and a segment not owned by the
+//! effective uid, or writable by group or others, is refused. Its size
+//! must match the header's table and arena exactly, or a short file
+//! would fault the reader. Every slot also carries a digest of its key
+//! and bytes, checked the first time this process serves the slot; a
+//! block that fails it is treated as a miss.
+//!
+//! A full arena or probe window only stops publishing: later blocks are
+//! cached privately, as without the segment. Nothing is ever evicted —
+//! the budget is the segment's size, sparse on disk until written.
+//! Blocks are keyed by a 32-byte [`BlockKey`] the backend chooses (a
+//! LimniFS drop id, a [`block_key`] of path and window for the read
+//! cache).
+
+use std::fs::File;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use std::sync::Arc;
+
+use sha2::{Digest as _, Sha256};
+
+use crate::byte_lru::{budget_from_env, LruStats};
+use crate::index_sidecar;
+
+/// Segment magic (format version in the last byte).
+const MAGIC: &[u8; 8] = b"TBKBLK\x00\x02";
+/// Directory under the exec cache.
+const DIR: &str = "tebako-blocks";
+/// Header bytes: magic, slot count, arena length, arena cursor.
+const HEADER: usize = 64;
+/// Bytes per slot-table entry (one [`Slot`]).
+const SLOT: usize = 64;
+/// Arena bytes per slot: the table is sized for blocks of this mean size.
+const BYTES_PER_SLOT: usize = 16 * 1024;
+/// Slots a lookup or publish probes past the key's home slot.
+const MAX_PROBE: usize = 32;
+
+const EMPTY: u32 = 0;
+const WRITING: u32 = 1;
+const READY: u32 = 2;
+/// Claimed, but the arena was full: never readable, stepped over.
+const DEAD: u32 = 3;
+
+/// A block's identity inside one segment.
+pub type BlockKey = [u8; 32];
+
+/// A [`BlockKey`] for a block named by several parts (length-prefixed,
+/// so `("ab", "c")` and `("a", "bc")` differ).
+pub fn block_key(parts: &[&[u8]]) -> BlockKey {
+    let mut h = Sha256::new();
+    for part in parts {
+        h.update((part.len() as u64).to_le_bytes());
+        h.update(part);
+    }
+    h.finalize().into()
+}
+
+/// The integrity digest a slot carries: SHA-256 over the key and the
+/// block bytes, truncated to 64 bits.
+fn digest(key: &BlockKey, value: &[u8]) -> u64 {
+    let mut h = Sha256::new();
+    h.update(key);
+    h.update(value);
+    u64::from_le_bytes(h.finalize()[..8].try_into().unwrap())
+}
+
+/// One slot-table entry, in the segment.
+#[repr(C)]
+struct Slot {
+    state: AtomicU32,
+    _pad: u32,
+    /// Arena offset and length of the block (valid once `READY`).
+    offset: u64,
+    len: u64,
+    key: BlockKey,
+    /// [`digest`] of the key and block (valid once `READY`).
+    digest: u64,
+}
+
+const _: () = assert!(std::mem::size_of::<Slot>() == SLOT);
+
+/// An attached segment (see the module docs).
+pub struct SharedBlocks {
+    base: *mut u8,
+    map_len: usize,
+    slots: usize,
+    arena_len: usize,
+    path: PathBuf,
+    /// One bit per slot: its digest was checked by this process.
+    verified: Vec<AtomicU64>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    published: AtomicU64,
+}
+
+// The segment is only ever touched through atomics and through block
+// bytes that are immutable once published.
+unsafe impl Send for SharedBlocks {}
+unsafe impl Sync for SharedBlocks {}
+
+impl std::fmt::Debug for SharedBlocks {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("SharedBlocks")
+            .field("path", &self.path)
+            .field("slots", &self.slots)
+            .field("arena_len", &self.arena_len)
+            .finish_non_exhaustive()
+    }
+}
+
+impl SharedBlocks {
+    /// The segment for the `length` bytes at `offset` of `image` (open
+    /// as `file`), when the shared cache is enabled and the segment can
+    /// be attached (see the module docs).
+    pub fn for_image(
+        image: &Path,
+        file: &File,
+        offset: u64,
+        length: u64,
+    ) -> Option<Arc<SharedBlocks>> {
+        let budget = budget_from_env("TEBAKO_TFS_SHARED_CACHE_MB", 0);
+        if budget == 0 || length == 0 {
+            return None;
+        }
+        let root = std::env::var_os("TEBAKO_EXEC_CACHE").filter(|v| !v.is_empty())?;
+        let stamp = index_sidecar::file_stamp(file, offset, length).ok()?;
+        let path = PathBuf::from(root).join(DIR).join(format!(
+            "{}-{}-{offset:x}-{length:x}.blk",
+            index_sidecar::image_key(image),
+            &index_sidecar::hex(&stamp)[..16]
+        ));
+        SharedBlocks::open(&path, budget).map(Arc::new)
+    }
+
+    /// Attach the segment at `path`, creating it with an arena of
+    /// `budget` bytes first when it does not exist. `None` when it
+    /// cannot be created or mapped, is not a segment, or is not this
+    /// user's alone (a cache problem only costs the sharing).
+    #[cfg(unix)]
+    pub fn open(path: &Path, budget: usize) -> Option<SharedBlocks> {
+        use std::os::unix::fs::{MetadataExt as _, OpenOptionsExt as _};
+        use std::os::unix::io::AsRawFd;
+        if !path.exists() {
+            create(path, budget);
+        }
+        let file = std::fs::OpenOptions::new()
+            .read(true)
+            .write(true)
+            .custom_flags(libc::O_NOFOLLOW)
+            .open(path)
+            .ok()?;
+        let meta = file.metadata().ok()?;
+        // SAFETY: geteuid has no preconditions.
+        if meta.uid() != unsafe { libc::geteuid() } || meta.mode() & 0o022 != 0 {
+            tebako_log::log!(
+                tebako_log::Level::Warn,
+                "tfs",
+                "shared block cache: {} is not private to this user; not attached",
+                path.display()
+            );
+            return None;
+        }
+        let map_len = usize::try_from(meta.len()).ok()?;
+        if map_len < HEADER {
+            return None;
+        }
+        // SAFETY: a fresh shared mapping of an open fd; the kernel
+        // validates every argument and the mapping outlives the fd.
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                map_len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if base == libc::MAP_FAILED {
+            return None;
+        }
+        let mut blocks = SharedBlocks {
+            base: base.cast(),
+            map_len,
+            slots: 0,
+            arena_len: 0,
+            path: path.to_path_buf(),
+            verified: Vec::new(),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            published: AtomicU64::new(0),
+        };
+        // SAFETY: the header lies inside the mapping (map_len >= HEADER).
+        let header = unsafe { std::slice::from_raw_parts(blocks.base, HEADER) };
+        let field = |at: usize| u64::from_le_bytes(header[at..at + 8].try_into().unwrap());
+        let (slots, arena_len) = (field(8) as usize, field(16) as usize);
+        let fits = slots
+            .checked_mul(SLOT)
+            .and_then(|table| table.checked_add(HEADER))
+            .and_then(|n| n.checked_add(arena_len))
+            == Some(map_len);
+        if &header[..8] != MAGIC || !slots.is_power_of_two() || !fits {
+            return None; // dropped: unmapped
+        }
+        blocks.slots = slots;
+        blocks.arena_len = arena_len;
+        blocks.verified = (0..slots.div_ceil(64)).map(|_| AtomicU64::new(0)).collect();
+        tebako_log::log!(
+            tebako_log::Level::Debug,
+            "tfs",
+            "shared block cache: attached {} ({slots} slots, {arena_len} arena bytes)",
+            path.display()
+        );
+        Some(blocks)
+    }
+
+    /// Shared mappings need `mmap`: elsewhere there is no segment.
+    #[cfg(not(unix))]
+    pub fn open(_path: &Path, _budget: usize) -> Option<SharedBlocks> {
+        None
+    }
+
+    /// The published block for `key`, read in place (counted as a hit or
+    /// miss).
+    pub fn get(&self, key: &BlockKey) -> Option<&[u8]> {
+        let found = self.find(key);
+        let counter = if found.is_some() {
+            &self.hits
+        } else {
+            &self.misses
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+        found
+    }
+
+    /// True when a block for `key` is published (not counted: the probe
+    /// of a readahead).
+    pub fn contains(&self, key: &BlockKey) -> bool {
+        self.find(key).is_some()
+    }
+
+    fn find(&self, key: &BlockKey) -> Option<&[u8]> {
+        for index in self.probe(key) {
+            let slot = self.slot(index);
+            // SAFETY: `slot` points into the mapping; its state is atomic.
+            match unsafe { &(*slot).state }.load(Ordering::Acquire) {
+                EMPTY => break,
+                // SAFETY: a READY slot's fields were written before the
+                // release store the load above acquired, and never change.
+                READY if unsafe { std::ptr::addr_of!((*slot).key).read() } == *key => {
+                    let (offset, len) = unsafe {
+                        (
+                            std::ptr::addr_of!((*slot).offset).read() as usize,
+                            std::ptr::addr_of!((*slot).len).read() as usize,
+                        )
+                    };
+                    if offset.checked_add(len)? > self.arena_len {
+                        break; // a foreign writer's garbage: not ours to serve
+                    }
+                    // SAFETY: in bounds (checked), published, immutable.
+                    let block =
+                        unsafe { std::slice::from_raw_parts(self.arena().add(offset), len) };
+                    return self.verify(index, slot, key, block).then_some(block);
+                }
+                _ => {}
+            }
+        }
+        None
+    }
+
+    /// Publish `value` as the block for `key`. True when the block is in
+    /// the segment afterwards (now, or already); false when the arena or
+    /// the probe window is full.
+    pub fn insert(&self, key: &BlockKey, value: &[u8]) -> bool {
+        if value.len() > self.arena_len {
+            return false;
+        }
+        for index in self.probe(key) {
+            let slot = self.slot(index);
+            // SAFETY: as in `get`.
+            let state = unsafe { &(*slot).state };
+            match state.compare_exchange(EMPTY, WRITING, Ordering::AcqRel, Ordering::Acquire) {
+                Ok(_) => return self.publish(slot, key, value),
+                Err(READY) if unsafe { std::ptr::addr_of!((*slot).key).read() } == *key => {
+                    return true;
+                }
+                Err(_) => {}
+            }
+        }
+        false
+    }
+
+    /// True when the block in slot `index` matches the slot's digest;
+    /// checked once per process (a block never changes once published).
+    fn verify(&self, index: usize, slot: *const Slot, key: &BlockKey, block: &[u8]) -> bool {
+        let (word, bit) = (&self.verified[index / 64], 1u64 << (index % 64));
+        if word.load(Ordering::Relaxed) & bit != 0 {
+            return true;
+        }
+        // SAFETY: as in `find` (a READY slot's fields never change).
+        let stored = unsafe { std::ptr::addr_of!((*slot).digest).read() };
+        if stored != digest(key, block) {
+            tebako_log::log!(
+                tebako_log::Level::Warn,
+                "tfs",
+                "shared block cache: {} slot {index} fails its digest; not served",
+                self.path.display()
+            );
+            return false;
+        }
+        word.fetch_or(bit, Ordering::Relaxed);
+        true
+    }
+
+    /// Fill a claimed (`WRITING`) slot with `value` and release it.
+    fn publish(&self, slot: *mut Slot, key: &BlockKey, value: &[u8]) -> bool {
+        // Arena ranges stay 8-byte aligned.
+        let need = (value.len() as u64 + 7) & !7;
+        let offset = self.cursor().fetch_add(need, Ordering::Relaxed);
+        // SAFETY: `slot` is ours alone while WRITING; the arena range
+        // [offset, offset + len) is ours alone once the cursor moved past
+        // it, and is checked to lie inside the arena.
+        unsafe {
+            if offset.saturating_add(value.len() as u64) > self.arena_len as u64 {
+                (*slot).state.store(DEAD, Ordering::Release);
+                return false;
+            }
+            std::ptr::copy_nonoverlapping(
+                value.as_ptr(),
+                self.arena().add(offset as usize),
+                value.len(),
+            );
+            std::ptr::addr_of_mut!((*slot).offset).write(offset);
+            std::ptr::addr_of_mut!((*slot).len).write(value.len() as u64);
+            std::ptr::addr_of_mut!((*slot).key).write(*key);
+            std::ptr::addr_of_mut!((*slot).digest).write(digest(key, value));
+            (*slot).state.store(READY, Ordering::Release);
+        }
+        self.published.fetch_add(1, Ordering::Relaxed);
+        true
+    }
+
+    /// This process's tallies: `entries` counts the blocks it published,
+    /// `bytes` the arena bytes every process has used so far.
+    pub fn stats(&self) -> LruStats {
+        LruStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: 0,
+            entries: self.published.load(Ordering::Relaxed) as usize,
+            bytes: (self.cursor().load(Ordering::Relaxed) as usize).min(self.arena_len),
+        }
+    }
+
+    /// The slot indexes a lookup of `key` visits, home slot first.
+    fn probe(&self, key: &BlockKey) -> impl Iterator<Item = usize> {
+        let home = u64::from_le_bytes(key[..8].try_into().unwrap()) as usize;
+        let mask = self.slots - 1;
+        (0..MAX_PROBE.min(self.slots)).map(move |i| (home + i) & mask)
+    }
+
+    fn slot(&self, index: usize) -> *mut Slot {
+        // SAFETY: index < slots, so the slot lies inside the table.
+        unsafe { self.base.add(HEADER + index * SLOT).cast() }
+    }
+
+    fn cursor(&self) -> &AtomicU64 {
+        // SAFETY: the cursor is the 8-aligned header word at 24.
+        unsafe { &*self.base.add(24).cast::<AtomicU64>() }
+    }
+
+    fn arena(&self) -> *mut u8 {
+        // SAFETY: the arena follows the table inside the mapping.
+        unsafe { self.base.add(HEADER + self.slots * SLOT) }
+    }
+}
+
+impl Drop for SharedBlocks {
+    fn drop(&mut self) {
+        let s = self.stats();
+        if s.hits + s.misses > 0 {
+            tebako_log::log!(
+                tebako_log::Level::Debug,
+                "tfs",
+                "shared block cache ({}): {} hits, {} misses ({:.1}% hit), {} blocks published, {} of {} arena bytes used",
+                self.path.display(),
+                s.hits,
+                s.misses,
+                s.hit_percent(),
+                s.entries,
+                s.bytes,
+                self.arena_len
+            );
+        }
+        #[cfg(unix)]
+        // SAFETY: `base`/`map_len` are exactly what mmap returned.
+        unsafe {
+            libc::munmap(self.base.cast(), self.map_len)
+        };
+    }
+}
+
+/// Create the segment at `path` (best-effort): initialized under a
+/// temp name of its own, then linked into place — a concurrent creator
+/// that links first wins, and everyone attaches to its segment. The
+/// directory is created `0700` and the segment `0600` (module docs).
+#[cfg(unix)]
+fn create(path: &Path, budget: usize) {
+    use std::os::unix::fs::{DirBuilderExt as _, OpenOptionsExt as _};
+    let Some(dir) = path.parent() else {
+        return;
+    };
+    if std::fs::DirBuilder::new()
+        .recursive(true)
+        .mode(0o700)
+        .create(dir)
+        .is_err()
+    {
+        return;
+    }
+    let slots = (budget / BYTES_PER_SLOT).max(64).next_power_of_two();
+    let Some(total) = slots
+        .checked_mul(SLOT)
+        .and_then(|table| table.checked_add(HEADER + budget))
+    else {
+        return;
+    };
+    let mut header = [0u8; HEADER];
+    header[..8].copy_from_slice(MAGIC);
+    header[8..16].copy_from_slice(&(slots as u64).to_le_bytes());
+    header[16..24].copy_from_slice(&(budget as u64).to_le_bytes());
+    // Per process and per call: two mounts of one image may create at once.
+    static NONCE: AtomicU64 = AtomicU64::new(0);
+    let tmp = path.with_extension(format!(
+        "tmp{}-{}",
+        std::process::id(),
+        NONCE.fetch_add(1, Ordering::Relaxed)
+    ));
+    let written = std::fs::OpenOptions::new()
+        .write(true)
+        .create_new(true)
+        .mode(0o600)
+        .open(&tmp)
+        .and_then(|file| {
+            use std::io::Write as _;
+            // Sparse: only the pages blocks land on are ever allocated.
+            file.set_len(total as u64)?;
+            (&file).write_all(&header)
+        });
+    if written.is_ok() {
+        let _ = std::fs::hard_link(&tmp, path);
+    }
+    let _ = std::fs::remove_file(&tmp);
+}
+
+#[cfg(all(test, unix))]
+mod tests {
+    use super::*;
+
+    fn key(n: u8) -> BlockKey {
+        block_key(&[b"test", &[n]])
+    }
+
+    #[test]
+    fn blocks_published_by_one_attachment_are_read_by_another() {
+        let tmp = tempfile::tempdir().unwrap();
+        let path = tmp.path().join("blocks").join("img.blk");
+        let a = SharedBlocks::open(&path, 1 << 20).expect("create and attach");
+        let b = SharedBlocks::open(&path, 4 << 20).expect("attach the existing segment");
+        assert_eq!(b.arena_len, 1 << 20, "the creator's size wins");
+
+        assert!(b.get(&key(1)).is_none());
+        assert!(a.insert(&key(1), b"one"));
+        assert!(a.insert(&key(2), &[7u8; 5000]));
+        assert_eq!(b.get(&key(1)), Some(&b"one"[..]));
+        assert_eq!(b.get(&key(2)).map(<[u8]>::len), Some(5000));
+        assert!(b.insert(&key(1), b"one"), "already published");
+        assert_eq!(a.stats().entries, 2);
+        assert_eq!(b.stats().entries, 0);
+        assert_eq!(b.stats().hits, 2);
+        assert_eq!(b.stats().misses, 1);
+    }
+
+    #[test]
+    fn a_full_arena_stops_publishing_but_keeps_serving() {
+        let tmp = tempfile::tempdir().unwrap();
+        let path = tmp.path().join("small.blk");
+        let blocks = SharedBlocks::open(&path, 4096).unwrap();
+        assert!(blocks.insert(&key(1), &[1u8; 3000]));
+        assert!(!blocks.insert(&key(2), &[2u8; 3000]), "arena full");
+        assert!(
+            !blocks.insert(&key(3), &[3u8; 5000]),
+            "larger than the arena"
+        );
+        assert!(blocks.get(&key(2)).is_none());
+        assert_eq!(blocks.get(&key(1)), Some(&[1u8; 3000][..]));
+    }
+
+    #[test]
+    fn foreign_files_are_not_attached() {
+        use std::os::unix::fs::PermissionsExt as _;
+        let tmp = tempfile::tempdir().unwrap();
+        let path = tmp.path().join("junk.blk");
+        std::fs::write(&path, vec![0xAB; 8192]).unwrap();
+        std::fs::set_permissions(&path, std::fs::Permissions::from_mode(0o600)).unwrap();
+        assert!(SharedBlocks::open(&path, 1 << 20).is_none());
+        assert!(block_key(&[b"ab", b"c"]) != block_key(&[b"a", b"bc"]));
+
+        // A real segment cut short, or writable by others, is refused.
+        let path = tmp.path().join("cache").join("img.blk");
+        drop(SharedBlocks::open(&path, 1 << 20).expect("segment"));
+        let mode = |p: &Path| std::fs::metadata(p).unwrap().permissions().mode() & 0o777;
+        assert_eq!(mode(path.parent().unwrap()), 0o700);
+        assert_eq!(mode(&path), 0o600);
+        let full = std::fs::metadata(&path).unwrap().len();
+        let file = std::fs::OpenOptions::new().write(true).open(&path).unwrap();
+        file.set_len(full - 4096).unwrap();
+        assert!(SharedBlocks::open(&path, 1 << 20).is_none(), "truncated");
+        file.set_len(full).unwrap();
+        assert!(SharedBlocks::open(&path, 1 << 20).is_some());
+        std::fs::set_permissions(&path, std::fs::Permissions::from_mode(0o666)).unwrap();
+        assert!(
+            SharedBlocks::open(&path, 1 << 20).is_none(),
+            "world-writable"
+        );
+    }
+
+    #[test]
+    fn a_block_that_fails_its_digest_is_a_miss() {
+        use std::os::unix::fs::FileExt as _;
+        let tmp = tempfile::tempdir().unwrap();
+        let path = tmp.path().join("img.blk");
+        let writer = SharedBlocks::open(&path, 1 << 20).unwrap();
+        assert!(writer.insert(&key(1), b"genuine"));
+        assert!(writer.insert(&key(2), b"untouched"));
+        assert_eq!(writer.get(&key(1)), Some(&b"genuine"[..]));
+
+        // Another writer rewrites the first block's bytes in the arena.
+        let arena = (HEADER + writer.slots * SLOT) as u64;
+        let file = std::fs::OpenOptions::new().write(true).open(&path).unwrap();
+        file.write_all_at(b"forged!", arena).unwrap();
+        let reader = SharedBlocks::open(&path, 1 << 20).unwrap();
+        assert!(reader.get(&key(1)).is_none());
+        assert_eq!(reader.get(&key(2)), Some(&b"untouched"[..]));
+    }
+}
@@ -0,0 +1,247 @@
+//! The zstd seekable format (zstd `contrib/seekable_format`): a stream of
+//! independent zstd frames followed by a seek table in a skippable frame,
+//! so a reader can decode just the frame holding a given offset. Any
+//! zstd decoder still reads the stream front to back (skippable frames
+//! are ignored), so a seekable `.tar.zst` stays an ordinary `.tar.zst`.
+//!
+//! ```text
+//! [frame 0][frame 1]…[frame N-1]
+//! [0x184D2A5E][table size u32]                  skippable frame header
+//!   N × [compressed u32][decompressed u32]([checksum u32])
+//!   [N u32][descriptor u8][0x8F92EAB1]          footer (9 bytes)
+//! ```
+//!
+//! All integers little-endian. Only descriptor bit 7 (per-entry checksum
+//! present) is defined; the reserved bits 2–6 must be zero. Entry
+//! checksums (the low 32 bits of XXH64 over the decompressed frame) are
+//! parsed past, not verified: each frame's own zstd checksum already
+//! guards the decode. The writer here emits none.
+//!
+//! Read side: [`parse_seek_table`] (the tar backend's `tar.zst` mount).
+//! Write side: [`write_seekable`] (`tfs mkimage --format tar.zst`).
+
+use std::io::{self, Read, Write};
+
+/// Skippable-frame magic carrying the seek table.
+const SKIPPABLE_MAGIC: u32 = 0x184D_2A5E;
+/// Magic closing the seek table footer.
+const SEEKABLE_MAGIC: u32 = 0x8F92_EAB1;
+/// Footer: frame count, descriptor, magic.
+const FOOTER_LEN: u64 = 9;
+/// Skippable frame header: magic, frame size.
+const SKIPPABLE_HEADER_LEN: u64 = 8;
+/// Descriptor bit 7: every entry carries a checksum.
+const CHECKSUM_FLAG: u8 = 0x80;
+/// Descriptor bits that must be zero.
+const RESERVED_BITS: u8 = 0x7C;
+/// The format's per-frame decompressed size ceiling (1 GiB).
+pub const MAX_FRAME_SIZE: usize = 1 << 30;
+/// Uncompressed bytes per frame the writer emits by default: small
+/// enough that a cold random read decodes little, large enough that the
+/// per-frame header and lost cross-frame matches cost ≈ 1 %.
+pub const DEFAULT_FRAME_SIZE: usize = 1024 * 1024;
+
+/// One frame of a seekable stream, located in both address spaces.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SeekFrame {
+    /// Offset of the frame in the compressed stream.
+    pub c_offset: u64,
+    /// Compressed frame length.
+    pub c_len: u64,
+    /// Offset of the frame's first byte in the decompressed stream.
+    pub u_offset: u64,
+    /// Decompressed frame length.
+    pub u_len: u64,
+}
+
+/// Parse the seek table at the end of a `len`-byte stream through the
+/// positioned reader `read_at`. `Ok(None)`: no seek table (a plain zstd
+/// stream); `Err(EINVAL)`: a seek table that does not describe the
+/// stream in front of it.
+pub fn parse_seek_table(
+    len: u64,
+    read_at: impl Fn(u64, &mut [u8]) -> Result<(), i32>,
+) -> Result<Option<Vec<SeekFrame>>, i32> {
+    if len < SKIPPABLE_HEADER_LEN + FOOTER_LEN {
+        return Ok(None);
+    }
+    let mut footer = [0u8; FOOTER_LEN as usize];
+    read_at(len - FOOTER_LEN, &mut footer)?;
+    if u32_at(&footer, 5) != SEEKABLE_MAGIC {
+        return Ok(None);
+    }
+    let count = u64::from(u32_at(&footer, 0));
+    let descriptor = footer[4];
+    if descriptor & RESERVED_BITS != 0 {
+        return Err(libc::EINVAL);
+    }
+    let entry_len: u64 = if descriptor & CHECKSUM_FLAG != 0 {
+        12
+    } else {
+        8
+    };
+    let table_len = count * entry_len + FOOTER_LEN;
+    let frame_len = table_len + SKIPPABLE_HEADER_LEN;
+    if frame_len > len {
+        return Err(libc::EINVAL);
+    }
+    let table_start = len - frame_len;
+    let mut table = vec![0u8; frame_len as usize];
+    read_at(table_start, &mut table)?;
+    if u32_at(&table, 0) != SKIPPABLE_MAGIC || u64::from(u32_at(&table, 4)) != table_len {
+        return Err(libc::EINVAL);
+    }
+    let mut frames = Vec::with_capacity(count as usize);
+    let (mut c_offset, mut u_offset) = (0u64, 0u64);
+    for entry in table[SKIPPABLE_HEADER_LEN as usize..]
+        .chunks_exact(entry_len as usize)
+        .take(count as usize)
+    {
+        let c_len = u64::from(u32_at(entry, 0));
+        let u_len = u64::from(u32_at(entry, 4));
+        if u_len > MAX_FRAME_SIZE as u64 {
+            return Err(libc::EINVAL);
+        }
+        frames.push(SeekFrame {
+            c_offset,
+            c_len,
+            u_offset,
+            u_len,
+        });
+        c_offset += c_len;
+        u_offset += u_len;
+    }
+    // The frames must tile the stream exactly up to the seek table.
+    if c_offset != table_start {
+        return Err(libc::EINVAL);
+    }
+    Ok(Some(frames))
+}
+
+fn u32_at(bytes: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes(bytes[at..at + 4].try_into().expect("4 bytes"))
+}
+
+/// The index of the frame holding decompressed offset `u` (frames are
+/// sorted by `u_offset`; `None` past the end).
+pub fn frame_at(frames: &[SeekFrame], u: u64) -> Option<usize> {
+    let i = frames.partition_point(|f| f.u_offset + f.u_len <= u);
+    (i < frames.len()).then_some(i)
+}
+
+/// Compress `input` into `out` as a seekable zstd stream of independent
+/// frames of `frame_size` uncompressed bytes (the last may be shorter),
+/// then append the seek table. Returns the frame count.
+pub fn write_seekable<R: Read, W: Write>(
+    mut input: R,
+    mut out: W,
+    frame_size: usize,
+) -> io::Result<usize> {
+    if frame_size == 0 || frame_size > MAX_FRAME_SIZE {
+        return Err(io::Error::new(
+            io::ErrorKind::InvalidInput,
+            format!("seekable zstd frame size must be 1..={MAX_FRAME_SIZE} bytes"),
+        ));
+    }
+    let mut entries: Vec<(u32, u32)> = Vec::new();
+    let mut chunk = vec![0u8; frame_size];
+    loop {
+        let mut filled = 0;
+        while filled < frame_size {
+            match input.read(&mut chunk[filled..]) {
+                Ok(0) => break,
+                Ok(n) => filled += n,
+                Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                Err(e) => return Err(e),
+            }
+        }
+        if filled == 0 {
+            break;
+        }
+        let frame = ruzstd::encoding::compress_to_vec(
+            &chunk[..filled],
+            ruzstd::encoding::CompressionLevel::Fastest,
+        );
+        let c_len = u32::try_from(frame.len()).map_err(|_| {
+            io::Error::new(io::ErrorKind::InvalidData, "compressed frame exceeds 4 GiB")
+        })?;
+        out.write_all(&frame)?;
+        entries.push((c_len, filled as u32));
+        if filled < frame_size {
+            break;
+        }
+    }
+    let count = u32::try_from(entries.len())
+        .map_err(|_| io::Error::new(io::ErrorKind::InvalidData, "too many frames"))?;
+    let table_len = entries.len() as u64 * 8 + FOOTER_LEN;
+    let mut table = Vec::with_capacity((table_len + SKIPPABLE_HEADER_LEN) as usize);
+    table.extend_from_slice(&SKIPPABLE_MAGIC.to_le_bytes());
+    table.extend_from_slice(&(table_len as u32).to_le_bytes());
+    for (c_len, u_len) in &entries {
+        table.extend_from_slice(&c_len.to_le_bytes());
+        table.extend_from_slice(&u_len.to_le_bytes());
+    }
+    table.extend_from_slice(&count.to_le_bytes());
+    table.push(0); // descriptor: no checksums
+    table.extend_from_slice(&SEEKABLE_MAGIC.to_le_bytes());
+    out.write_all(&table)?;
+    Ok(entries.len())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn parse(stream: &[u8]) -> Result<Option<Vec<SeekFrame>>, i32> {
+        parse_seek_table(stream.len() as u64, |at, buf| {
+            let at = at as usize;
+            buf.copy_from_slice(&stream[at..at + buf.len()]);
+            Ok(())
+        })
+    }
+
+    #[test]
+    fn written_tables_parse_back_and_locate_offsets() {
+        let data: Vec<u8> = (0..10_000u32).map(|i| (i % 97) as u8).collect();
+        let mut stream = Vec::new();
+        assert_eq!(write_seekable(&data[..], &mut stream, 4096).unwrap(), 3);
+        let frames = parse(&stream).unwrap().expect("a seek table");
+        let u: Vec<(u64, u64)> = frames.iter().map(|f| (f.u_offset, f.u_len)).collect();
+        assert_eq!(u, [(0, 4096), (4096, 4096), (8192, 1808)]);
+        assert_eq!(frame_at(&frames, 0), Some(0));
+        assert_eq!(frame_at(&frames, 4095), Some(0));
+        assert_eq!(frame_at(&frames, 4096), Some(1));
+        assert_eq!(frame_at(&frames, 9999), Some(2));
+        assert_eq!(frame_at(&frames, 10_000), None);
+
+        // Frame 1 decodes alone to its slice of the input.
+        let f = frames[1];
+        let frame = &stream[f.c_offset as usize..(f.c_offset + f.c_len) as usize];
+        let mut plain = Vec::new();
+        ruzstd::StreamingDecoder::new(frame)
+            .unwrap()
+            .read_to_end(&mut plain)
+            .unwrap();
+        assert_eq!(plain, &data[4096..8192]);
+    }
+
+    #[test]
+    fn plain_streams_have_no_table_and_broken_tables_are_einval() {
+        let data = vec![7u8; 5000];
+        let plain = ruzstd::encoding::compress_to_vec(
+            &data[..],
+            ruzstd::encoding::CompressionLevel::Fastest,
+        );
+        assert_eq!(parse(&plain).unwrap(), None);
+        assert_eq!(parse(&[0u8; 4]).unwrap(), None);
+
+        let mut stream = Vec::new();
+        write_seekable(&data[..], &mut stream, 1024).unwrap();
+        let mut shifted = vec![0u8];
+        shifted.extend_from_slice(&stream); // frames no longer tile
+        assert_eq!(parse(&shifted).err(), Some(libc::EINVAL));
+        let n = stream.len();
+        stream[n - 5] = 0x04; // a reserved descriptor bit
+        assert_eq!(parse(&stream).err(), Some(libc::EINVAL));
+    }
+}
@@ -154,9 +154,9 @@ int tebako_fs_init_from_file(const char* archive_path, const char* mount_point);
  *
  * @note Only one filesystem can be mounted at a time
  * @note Calling this while already mounted returns -1 with errno=EEXIST
- * @note offset == 0 && length == 0 mounts the whole file directly (zero-copy);
- *       any other region is read into memory owned by libtfs until
- *       tebako_fs_unmount()
+ * @note offset == 0 && length == 0 mounts the whole file directly; any
+ *       other region is served in place too (positioned reads or a
+ *       read-only mapping of just the region — never a heap copy on POSIX)
  * @note Returns -1 with errno=ENOENT if the file does not exist, errno=EINVAL
  *       if offset is past end of file or offset+length exceeds the file size
  *
@@ -279,13 +279,61 @@ int tebako_fs_mount_from_file(const char* archive_path, const char* mount_point,
  *       NULL or empty mount_point, NULL out_handle, offset past end of
  *       file, offset+length exceeding the file size)
  * @note Returns -1 with errno=ENOENT if the file does not exist
- * @note offset == 0 && length == 0 mounts the whole file directly
- *       (zero-copy); any other region is read into memory owned by libtfs
- *       until the mount is unmounted
+ * @note offset == 0 && length == 0 mounts the whole file directly; any
+ *       other region is served in place too (positioned reads or a
+ *       read-only mapping of just the region — never a heap copy on POSIX)
  */
 int tebako_fs_mount_from_file_at(const char* archive_path, uint64_t offset, uint64_t length, const char* mount_point,
                                  tebako_mount_t* out_handle);
 
+/**
+ * @brief Per-mount read tuning for tebako_fs_mount_from_file_opts()
+ *
+ * A zero field keeps its default; all zero is the untuned mount. A
+ * non-zero `cache_bytes` or `workers` stacks a read cache of aligned
+ * 64 KiB windows over the image backend (any format — DwarFS, SquashFS,
+ * ZIP, tar, LimniFS); `readahead` sizes the per-fd readahead window.
+ */
+struct tebako_mount_opts {
+    uint64_t cache_bytes; /**< Read-cache budget in bytes (0: 32 MiB) */
+    uint64_t readahead;   /**< Per-fd readahead window (0: TEBAKO_TFS_READAHEAD_KB) */
+    uint32_t workers;     /**< Threads filling cache misses (0: the reading thread) */
+    uint32_t reserved;    /**< Must be 0 */
+};                        /* sizeof 24 (the Rust side asserts it) */
+
+/**
+ * @brief Mount a region of a file with per-mount read tuning
+ *
+ * tebako_fs_mount_from_file_at() plus a tebako_mount_opts: the cache
+ * budget, fill workers and readahead of this mount alone. Misses that
+ * span several windows are decoded in parallel on up to `workers`
+ * threads; an fd reading sequentially prefetches `readahead` bytes at a
+ * time (see tebako_fs_fadvise()).
+ *
+ * @param archive_path Path to the file containing the archive
+ * @param offset Byte offset of the archive start within the file
+ * @param length Length of the archive in bytes; 0 means "to end of file"
+ * @param mount_point Virtual mount point; must be non-empty and not
+ *                    already mounted
+ * @param opts Read tuning; NULL mounts untuned (as tebako_fs_mount_from_file_at())
+ * @param out_handle Receives the mount handle on success
+ * @return 0 on success, -1 on error (check errno via tebako_get_errno())
+ *
+ * @note Returns -1 with errno=EINVAL for a non-zero `reserved` field, plus
+ *       every error of tebako_fs_mount_from_file_at()
+ * @note The same tuning is available to preloaded processes through the
+ *       TEBAKO_TFS_MOUNTS entry suffix `?cache=256M&workers=8&readahead=1M`
+ *
+ * @example
+ * @code
+ * struct tebako_mount_opts opts = { 512ull << 20, 1 << 20, 16, 0 };
+ * tebako_mount_t h;
+ * tebako_fs_mount_from_file_opts("/app/runtime.dwarfs", 0, 0, "/__tebako__", &opts, &h);
+ * @endcode
+ */
+int tebako_fs_mount_from_file_opts(const char* archive_path, uint64_t offset, uint64_t length, const char* mount_point,
+                                   const struct tebako_mount_opts* opts, tebako_mount_t* out_handle);
+
 /**
  * @brief Mount an archive from memory, returning a mount handle
  *
@@ -307,6 +355,45 @@ int tebako_fs_mount_from_file_at(const char* archive_path, uint64_t offset, uint
  */
 int tebako_fs_mount_from_memory(const void* data, size_t size, const char* mount_point, tebako_mount_t* out_handle);
 
+/**
+ * @brief Called once when libtfs no longer reads a lent image buffer
+ *
+ * May run on any thread (the one unmounting).
+ */
+typedef void (*tebako_release_fn)(void* ctx);
+
+/**
+ * @brief Mount an archive from memory WITHOUT copying it
+ *
+ * Like tebako_fs_mount_from_memory(), but the buffer is lent, not copied:
+ * the image exists once, wherever the embedder holds it (a static
+ * section, an mmap, a refcounted allocation). When libtfs is done with
+ * the buffer it calls `release(release_ctx)` exactly once: at unmount
+ * (tebako_fs_unmount_handle() or tebako_fs_unmount()), or before this call
+ * returns when the mount fails. Pass a release function that drops a
+ * reference to hand libtfs a refcounted buffer; pass NULL to simply keep
+ * the buffer alive until unmount.
+ *
+ * @param data Pointer to archive data; must stay valid and unchanged
+ *             until `release` is called (or, with NULL `release`, until
+ *             unmount)
+ * @param size Size of archive in bytes
+ * @param mount_point Virtual mount point; must be non-empty and not
+ *                    already mounted
+ * @param release Optional release callback (may be NULL)
+ * @param release_ctx Passed to `release`
+ * @param out_handle Receives the mount handle on success
+ * @return 0 on success, -1 on error
+ *
+ * @note DwarFS images are copied by the DwarFS reader itself; for them
+ *       the buffer is released as soon as the mount is built
+ * @note Returns -1 with errno=EINVAL for the same bad arguments as
+ *       tebako_fs_mount_from_memory()
+ */
+int tebako_fs_mount_from_memory_borrowed(const void* data, size_t size, const char* mount_point,
+                                         tebako_release_fn release, void* release_ctx,
+                                         tebako_mount_t* out_handle);
+
 /**
  * @brief Unmount a single mount by handle
  *
@@ -383,6 +470,45 @@ ssize_t tebako_fs_read(int fd, void* buf, size_t count);
  */
 ssize_t tebako_fs_pread(int fd, void* buf, size_t nbyte, off_t offset);
 
+/**
+ * @brief Scatter buffer for tebako_fs_preadv()
+ *
+ * On POSIX this is the platform's own `struct iovec`; Windows (whose CRT
+ * declares none) gets the same two-field layout pinned here.
+ */
+#if defined(_WIN32)
+struct tebako_iovec {
+    void*  iov_base;
+    size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#define tebako_iovec iovec
+#endif
+
+/** @brief Most iovecs one tebako_fs_preadv() call takes (POSIX IOV_MAX) */
+#define TEBAKO_IOV_MAX 1024
+
+/**
+ * @brief Read from embedded file into several buffers at a given offset
+ *
+ * Behaves like POSIX preadv(2): fills `iov[0]`, then `iov[1]`, ... from
+ * byte `offset`, under one descriptor lookup; the file position of `fd` is
+ * NOT modified. The count is short only at end of file. Buffers may
+ * overlap: each is then filled in turn, the later one's bytes winning.
+ *
+ * @param fd File descriptor from tebako_fs_open()
+ * @param iov Array of `iovcnt` buffers
+ * @param iovcnt Number of buffers (0 to TEBAKO_IOV_MAX)
+ * @param offset Byte offset from the beginning of the file
+ * @return Total bytes read, 0 at EOF, -1 on error
+ *
+ * @note Returns -1 with errno=EBADF if fd is not a valid libtfs FD
+ * @note Returns -1 with errno=EINVAL if offset is negative, iovcnt is out
+ *       of range, or iov (or a non-empty buffer in it) is NULL
+ */
+ssize_t tebako_fs_preadv(int fd, const struct tebako_iovec* iov, int iovcnt, off_t offset);
+
 /**
  * @brief Seek within embedded file
  *
@@ -408,6 +534,34 @@ ssize_t tebako_fs_pread(int fd, void* buf, size_t nbyte, off_t offset);
  */
 off_t tebako_fs_lseek(int fd, off_t offset, int whence);
 
+/**
+ * @brief Advise on the access pattern of an embedded file
+ *
+ * Behaves like posix_fadvise(2), as a hint to libtfs's per-fd readahead:
+ * POSIX_FADV_SEQUENTIAL prefetches ahead of every read from now on,
+ * POSIX_FADV_WILLNEED prefetches one window at `offset`, POSIX_FADV_RANDOM
+ * stops prefetching, POSIX_FADV_DONTNEED drops what was prefetched, and
+ * POSIX_FADV_NORMAL returns to detecting sequential reads. Advice values
+ * are Linux's (NORMAL 0, RANDOM 1, SEQUENTIAL 2, WILLNEED 3, DONTNEED 4,
+ * NOREUSE 5) on every platform.
+ *
+ * The window is the mount's tebako_mount_opts.readahead when set, else
+ * TEBAKO_TFS_READAHEAD_KB (default 512; 0 turns sequential detection
+ * off, explicit advice still prefetches). Only read-only mounts prefetch.
+ *
+ * @param fd File descriptor from tebako_fs_open()
+ * @param offset Start of the advised range
+ * @param len Length of the advised range (0: to the end of the file)
+ * @param advice One of the POSIX_FADV_* values above
+ * @return 0 on success, -1 on error
+ *
+ * @note Returns -1 with errno=EBADF if fd is not a valid libtfs FD
+ * @note Returns -1 with errno=EINVAL for a negative offset or len, or an
+ *       unknown advice value
+ * @note Unlike posix_fadvise(), the error is reported through errno
+ */
+int tebako_fs_fadvise(int fd, int64_t offset, int64_t len, int advice);
+
 /**
  * @brief Close embedded file
  *
@@ -1,5 +1,5 @@
 //! IO-surface contract cases: directory positioning (telldir/seekdir/
-//! rewinddir/dir_is_embedded), pread semantics, dlmap2file, extract_all,
+//! rewinddir/dir_is_embedded), pread/preadv semantics, dlmap2file, extract_all,
 //! and the ABI version export — ports of the corresponding C++ `CApiTest`
 //! cases (libtfs `tests/test_c_api.cpp`) plus the ABI-version test.
 
@@ -635,6 +635,117 @@ fn pread_negative_offset() {
     assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
 }
 
+// ===================================================================
+// preadv (the vectored pread)
+// ===================================================================
+
+fn iov(buf: &mut [u8]) -> tfs::c_api::TebakoIovec {
+    tfs::c_api::TebakoIovec {
+        iov_base: buf.as_mut_ptr().cast(),
+        iov_len: buf.len(),
+    }
+}
+
+#[test]
+fn preadv_scatters_in_order_and_leaves_position_intact() {
+    let f = setup();
+    f.init();
+    let fd = open_hello(&f);
+    assert!(fd > 0);
+
+    // "Hello, World!" from offset 2: "llo" | ", " | "World!" (EOF short).
+    let (mut a, mut b, mut c) = ([0u8; 3], [0u8; 2], [0u8; 10]);
+    let vecs = [iov(&mut a), iov(&mut b), iov(&mut c)];
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_preadv(fd, vecs.as_ptr(), 3, 2) },
+        11
+    );
+    assert_eq!((&a, &b, &c[..6]), (b"llo", b", ", &b"World!"[..]));
+
+    let mut full = [0u8; 32];
+    let n = unsafe { tfs::c_api::tebako_fs_read(fd, full.as_mut_ptr().cast(), 31) };
+    assert_eq!(n, 13, "position untouched");
+
+    // Zero iovecs and reads at EOF are 0.
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_preadv(fd, std::ptr::null(), 0, 0) },
+        0
+    );
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_preadv(fd, vecs.as_ptr(), 3, 13) },
+        0
+    );
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+}
+
+/// Overlapping iovecs are legal: each is filled in turn, the later one's
+/// bytes winning where they share memory.
+#[test]
+fn preadv_fills_overlapping_buffers_in_order() {
+    let f = setup();
+    f.init();
+    let fd = open_hello(&f);
+    assert!(fd > 0);
+    let mut buf = [0u8; 8];
+    let base = buf.as_mut_ptr();
+    let vecs = [
+        tfs::c_api::TebakoIovec {
+            iov_base: base.cast(),
+            iov_len: 5,
+        },
+        tfs::c_api::TebakoIovec {
+            // SAFETY: in bounds of `buf`.
+            iov_base: unsafe { base.add(3) }.cast(),
+            iov_len: 5,
+        },
+    ];
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_preadv(fd, vecs.as_ptr(), 2, 0) },
+        10
+    );
+    assert_eq!(&buf, b"Hel, Wor", "\"Hello\", then \", Wor\" over its tail");
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+}
+
+#[test]
+fn preadv_rejects_bad_arguments() {
+    let f = setup();
+    f.init();
+    let fd = open_hello(&f);
+    assert!(fd > 0);
+    let mut a = [0u8; 4];
+    let vecs = [iov(&mut a)];
+    for (fd, iov, iovcnt, offset, want) in [
+        (fd, vecs.as_ptr(), 1, -1, libc::EINVAL),
+        (fd, vecs.as_ptr(), -1, 0, libc::EINVAL),
+        (
+            fd,
+            vecs.as_ptr(),
+            tfs::c_api::TEBAKO_IOV_MAX + 1,
+            0,
+            libc::EINVAL,
+        ),
+        (fd, std::ptr::null(), 1, 0, libc::EINVAL),
+        (999, vecs.as_ptr(), 1, 0, libc::EBADF),
+    ] {
+        assert_eq!(
+            unsafe { tfs::c_api::tebako_fs_preadv(fd, iov, iovcnt, offset) },
+            -1
+        );
+        assert_eq!(unsafe { errno() }, want);
+    }
+    let null_buf = [tfs::c_api::TebakoIovec {
+        iov_base: std::ptr::null_mut(),
+        iov_len: 4,
+    }];
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_preadv(fd, null_buf.as_ptr(), 1, 0) },
+        -1
+    );
+    assert_eq!(unsafe { errno() }, libc::EINVAL);
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+}
+
 // ===================================================================
 // extract_all (single mount: tree directly into dest)
 // ===================================================================
@@ -0,0 +1,205 @@
+//! Per-mount read tuning through `tebako_fs_mount_from_file_opts`: the
+//! tuned mount serves the same bytes as the untuned one, the opts struct
+//! is validated, and a cache sized to the working set pays off.
+//!
+//! The throughput case is a benchmark as much as a test: it prints the
+//! random-read rate per cache budget (`--nocapture` to see it) and
+//! asserts only correctness — the curve is the reader's call on a quiet
+//! machine, never a CI gate. TFS_MOUNT_OPTS_MIB resizes the fixture file
+//! (default 1) and TFS_MOUNT_OPTS_READS the reads per pass (default 256).
+
+use std::ffi::CString;
+use std::path::PathBuf;
+use std::sync::{Mutex, MutexGuard};
+use std::time::Instant;
+
+use tebako_contract_tests::{build_zip, TempDir};
+use tfs::c_api::TebakoMountOpts;
+
+static LOCK: Mutex<()> = Mutex::new(());
+
+const MOUNT_POINT: &str = "/__tebako_opts__";
+const READ: usize = 4096;
+
+struct F {
+    _guard: MutexGuard<'static, ()>,
+    _tmp: TempDir,
+    archive_path: PathBuf,
+    size: usize,
+}
+
+/// 4-byte little-endian words, each holding its own byte offset.
+fn offset_words(size: usize) -> Vec<u8> {
+    (0..size / 4)
+        .flat_map(|w| ((w * 4) as u32).to_le_bytes())
+        .collect()
+}
+
+fn setup() -> F {
+    let guard = LOCK.lock().unwrap_or_else(|e| e.into_inner());
+    unsafe { tfs::c_api::tebako_fs_unmount() };
+
+    let mib: usize = std::env::var("TFS_MOUNT_OPTS_MIB")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(1);
+    let size = mib.max(1) << 20;
+    let tmp = TempDir::new("mount-opts");
+    let archive_path = tmp.0.join("big.zip");
+    build_zip(
+        &archive_path,
+        &["data/"],
+        &[("data/words.bin", offset_words(size).as_slice())],
+    );
+    F {
+        _guard: guard,
+        _tmp: tmp,
+        archive_path,
+        size,
+    }
+}
+
+impl Drop for F {
+    fn drop(&mut self) {
+        unsafe { tfs::c_api::tebako_fs_unmount() };
+    }
+}
+
+fn c(s: &str) -> CString {
+    CString::new(s).unwrap()
+}
+
+fn opts(cache_bytes: u64, workers: u32, readahead: u64) -> TebakoMountOpts {
+    TebakoMountOpts {
+        cache_bytes,
+        readahead,
+        workers,
+        reserved: 0,
+    }
+}
+
+/// Mount the fixture with `opts` (NULL when `None`); the rc and handle.
+fn mount(f: &F, opts: Option<&TebakoMountOpts>) -> (i32, i32) {
+    let mut h = -1;
+    let rc = unsafe {
+        tfs::c_api::tebako_fs_mount_from_file_opts(
+            c(f.archive_path.to_str().unwrap()).as_ptr(),
+            0,
+            0,
+            c(MOUNT_POINT).as_ptr(),
+            opts.map_or(std::ptr::null(), |o| o as *const TebakoMountOpts),
+            &mut h,
+        )
+    };
+    (rc, h)
+}
+
+/// `count` reads of READ bytes at pseudo-random word-aligned offsets of a
+/// `size`-byte file (a fixed LCG: every run reads the same offsets).
+fn offsets(size: usize, count: usize) -> Vec<usize> {
+    let mut x: u64 = 0x2545_f491_4f6c_dd1d;
+    (0..count)
+        .map(|_| {
+            x = x
+                .wrapping_mul(6_364_136_223_846_793_005)
+                .wrapping_add(1_442_695_040_888_963_407);
+            ((x >> 33) as usize % (size - READ)) & !3
+        })
+        .collect()
+}
+
+/// Read the fixture at every offset, checking each word; MiB/s.
+fn random_reads(offsets: &[usize]) -> f64 {
+    let path = c(&format!("{MOUNT_POINT}/data/words.bin"));
+    let fd = unsafe { tfs::c_api::tebako_fs_open(path.as_ptr(), libc::O_RDONLY) };
+    assert!(fd >= 0, "open failed");
+    let mut buf = vec![0u8; READ];
+    let start = Instant::now();
+    for &at in offsets {
+        let n = unsafe { tfs::c_api::tebako_fs_pread(fd, buf.as_mut_ptr().cast(), READ, at as _) };
+        assert_eq!(n, READ as isize);
+        for (i, word) in buf.chunks_exact(4).enumerate() {
+            assert_eq!(
+                u32::from_le_bytes(word.try_into().unwrap()),
+                (at + i * 4) as u32
+            );
+        }
+    }
+    let secs = start.elapsed().as_secs_f64().max(1e-9);
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+    (offsets.len() * READ) as f64 / (1024.0 * 1024.0) / secs
+}
+
+#[test]
+fn tuned_mounts_read_like_untuned_ones() {
+    let f = setup();
+    let probe = offsets(f.size, 64);
+    for o in [
+        None,
+        Some(opts(0, 0, 0)),
+        Some(opts(1 << 20, 4, 256 << 10)),
+        Some(opts(0, 2, 0)),
+    ] {
+        let (rc, h) = mount(&f, o.as_ref());
+        assert_eq!(rc, 0, "mount with {:?}", o.map(|o| o.cache_bytes));
+        random_reads(&probe);
+        assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(h) }, 0);
+    }
+}
+
+#[test]
+fn mount_opts_are_validated() {
+    let f = setup();
+    let mut bad = opts(1 << 20, 1, 0);
+    bad.reserved = 1;
+    assert_eq!(mount(&f, Some(&bad)).0, -1);
+    assert_eq!(unsafe { tfs::c_api::tebako_get_errno() }, libc::EINVAL);
+    let rc = unsafe {
+        tfs::c_api::tebako_fs_mount_from_file_opts(
+            c(f.archive_path.to_str().unwrap()).as_ptr(),
+            0,
+            0,
+            c(MOUNT_POINT).as_ptr(),
+            std::ptr::null(),
+            std::ptr::null_mut(),
+        )
+    };
+    assert_eq!(rc, -1);
+    assert_eq!(unsafe { tfs::c_api::tebako_get_errno() }, libc::EINVAL);
+}
+
+#[test]
+fn random_read_throughput_versus_cache_size() {
+    let f = setup();
+    let count: usize = std::env::var("TFS_MOUNT_OPTS_READS")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(256);
+    let reads = offsets(f.size, count.max(1));
+    let size = f.size as u64;
+    let mut rows = Vec::new();
+    for (label, o) in [
+        ("untuned", None),
+        ("1/16", Some(opts(size / 16, 0, 0))),
+        ("1/4", Some(opts(size / 4, 0, 0))),
+        ("1/1", Some(opts(size + (1 << 20), 0, 0))),
+    ] {
+        let (rc, h) = mount(&f, o.as_ref());
+        assert_eq!(rc, 0);
+        // Two passes over the same offsets: the second shows what the
+        // budget kept.
+        let cold = random_reads(&reads);
+        let warm = random_reads(&reads);
+        assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(h) }, 0);
+        rows.push(format!(
+            "{label:>8}: cold {cold:8.1} MiB/s, warm {warm:8.1} MiB/s"
+        ));
+    }
+    eprintln!(
+        "[mount-opts] {} MiB deflated, {} random {READ}-byte reads per pass, cache budget as a \
+         share of the file:\n{}",
+        f.size >> 20,
+        reads.len(),
+        rows.join("\n")
+    );
+}
@@ -819,3 +819,72 @@ fn dlmap2file_multi_mount_distinct_extractions() {
         libc::free(host_b.cast());
     }
 }
+
+static RELEASED: std::sync::atomic::AtomicUsize = std::sync::atomic::AtomicUsize::new(0);
+
+unsafe extern "C" fn count_release(ctx: *mut std::ffi::c_void) {
+    assert_eq!(ctx as usize, 0x7eba);
+    RELEASED.fetch_add(1, std::sync::atomic::Ordering::SeqCst);
+}
+
+fn released() -> usize {
+    RELEASED.load(std::sync::atomic::Ordering::SeqCst)
+}
+
+#[test]
+fn borrowed_memory_mount_is_released_once_at_unmount() {
+    let f = setup();
+    let before = released();
+    let mut h: i32 = -1;
+    let rc = unsafe {
+        tfs::c_api::tebako_fs_mount_from_memory_borrowed(
+            f.archive_a.as_ptr().cast(),
+            f.archive_a.len(),
+            c("/__mm_lent__").as_ptr(),
+            Some(count_release),
+            0x7eba as *mut std::ffi::c_void,
+            &mut h,
+        )
+    };
+    assert_eq!(rc, 0);
+    assert_eq!(
+        unsafe { read_file_via_api("/__mm_lent__/content/alpha.txt") },
+        "alpha-content"
+    );
+    assert_eq!(released(), before, "the buffer is held while mounted");
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(h) }, 0);
+    assert_eq!(released(), before + 1);
+
+    // A buffer that is not an image is handed back before the call fails.
+    let junk = [0u8; 64];
+    let rc = unsafe {
+        tfs::c_api::tebako_fs_mount_from_memory_borrowed(
+            junk.as_ptr().cast(),
+            junk.len(),
+            c("/__mm_lent__").as_ptr(),
+            Some(count_release),
+            0x7eba as *mut std::ffi::c_void,
+            &mut h,
+        )
+    };
+    assert_eq!(rc, -1);
+    assert_eq!(released(), before + 2);
+
+    // Without a release function the buffer is simply lent until unmount.
+    let rc = unsafe {
+        tfs::c_api::tebako_fs_mount_from_memory_borrowed(
+            f.archive_a.as_ptr().cast(),
+            f.archive_a.len(),
+            c("/__mm_lent__").as_ptr(),
+            None,
+            std::ptr::null_mut(),
+            &mut h,
+        )
+    };
+    assert_eq!(rc, 0);
+    assert_eq!(
+        unsafe { read_file_via_api("/__mm_lent__/nested/beta.txt") },
+        "from-A"
+    );
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(h) }, 0);
+}
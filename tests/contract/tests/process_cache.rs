@@ -0,0 +1,86 @@
+//! The process-wide cache budget (`TEBAKO_TFS_CACHE_MB`): with it set,
+//! every mount — file or memory, tuned or not — reads through the one
+//! shared window pool, and mounts thrashing a pool smaller than their
+//! combined working set still read exactly their own bytes.
+//!
+//! One case per binary: the pool reads the variable once, at the first
+//! mount of the process.
+
+use std::ffi::CString;
+
+use tebako_contract_tests::{build_zip, TempDir};
+
+fn c(s: &str) -> CString {
+    CString::new(s).unwrap()
+}
+
+/// `len` bytes that differ per `seed` and per 64 KiB window.
+fn payload(seed: u8, len: usize) -> Vec<u8> {
+    (0..len)
+        .map(|i| (i % 253) as u8 ^ (i >> 16) as u8 ^ seed)
+        .collect()
+}
+
+fn read_at(path: &str, offset: usize, len: usize) -> Vec<u8> {
+    let fd = unsafe { tfs::c_api::tebako_fs_open(c(path).as_ptr(), libc::O_RDONLY) };
+    assert!(fd >= 0, "open {path}");
+    let mut buf = vec![0u8; len];
+    let n = unsafe { tfs::c_api::tebako_fs_pread(fd, buf.as_mut_ptr().cast(), len, offset as _) };
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+    buf.truncate(n.max(0) as usize);
+    buf
+}
+
+#[test]
+fn every_mount_reads_through_one_budgeted_pool() {
+    std::env::set_var("TEBAKO_TFS_CACHE_MB", "1");
+    let tmp = TempDir::new("process-cache");
+    let len = 1 << 20;
+    let (a, b) = (payload(0x11, len), payload(0x22, len));
+    let path_a = tmp.0.join("a.zip");
+    let path_b = tmp.0.join("b.zip");
+    build_zip(&path_a, &[], &[("blob", a.as_slice())]);
+    build_zip(&path_b, &[], &[("blob", b.as_slice())]);
+    let image_b = std::fs::read(&path_b).unwrap();
+
+    let (mut ha, mut hb) = (-1, -1);
+    let p = c(path_a.to_str().unwrap());
+    assert_eq!(
+        unsafe {
+            tfs::c_api::tebako_fs_mount_from_file(p.as_ptr(), c("/__pc_a__").as_ptr(), &mut ha)
+        },
+        0
+    );
+    assert_eq!(
+        unsafe {
+            tfs::c_api::tebako_fs_mount_from_memory(
+                image_b.as_ptr().cast(),
+                image_b.len(),
+                c("/__pc_b__").as_ptr(),
+                &mut hb,
+            )
+        },
+        0
+    );
+
+    // Two 1 MiB files through a 1 MiB pool, interleaved: every window is
+    // evicted and refetched along the way, never confused across mounts.
+    for round in 0..3 {
+        for at in (0..len).step_by(96 * 1024) {
+            let n = 4096.min(len - at);
+            assert_eq!(
+                read_at("/__pc_a__/blob", at, n),
+                &a[at..at + n],
+                "round {round}"
+            );
+            assert_eq!(
+                read_at("/__pc_b__/blob", at, n),
+                &b[at..at + n],
+                "round {round}"
+            );
+        }
+    }
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(ha) }, 0);
+    assert_eq!(read_at("/__pc_b__/blob", len - 10, 64), &b[len - 10..]);
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(hb) }, 0);
+}
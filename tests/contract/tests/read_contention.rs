@@ -0,0 +1,234 @@
+//! Read-path contention cases: many threads reading memfs fds through the
+//! `tebako_fs_*` ABI at once. The read family (`read`/`pread`/`lseek`/
+//! `fstat`) runs under the SHARED context lock with an atomic per-fd
+//! position, so readers on different fds never serialize on the global
+//! guard, and readers sharing ONE fd each consume a distinct byte range.
+//!
+//! The throughput case is a benchmark as much as a test: it prints the
+//! single-thread vs N-thread aggregate rate (`--nocapture` to see it) and
+//! asserts only correctness — wall-clock scaling is the reader's call on
+//! a quiet machine, never a CI gate. TFS_CONTENTION_KIB resizes the
+//! fixture file (default 256).
+
+use std::ffi::CString;
+use std::path::PathBuf;
+use std::sync::{Mutex, MutexGuard};
+use std::time::Instant;
+
+use tebako_contract_tests::{build_zip, TempDir};
+
+static LOCK: Mutex<()> = Mutex::new(());
+
+const MOUNT_POINT: &str = "/__tebako_contention__";
+const CHUNK: usize = 8192;
+
+struct F {
+    _guard: MutexGuard<'static, ()>,
+    _tmp: TempDir,
+    archive_path: PathBuf,
+    size: usize,
+}
+
+/// The fixture's content: 4-byte little-endian words, each holding its
+/// own byte offset — any chunk names the offset it was served from.
+fn offset_words(size: usize) -> Vec<u8> {
+    (0..size / 4)
+        .flat_map(|w| ((w * 4) as u32).to_le_bytes())
+        .collect()
+}
+
+fn setup() -> F {
+    let guard = LOCK.lock().unwrap_or_else(|e| e.into_inner());
+    unsafe { tfs::c_api::tebako_fs_unmount() };
+
+    let kib: usize = std::env::var("TFS_CONTENTION_KIB")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(256);
+    let size = kib.max(1) * 1024;
+    let tmp = TempDir::new("contention");
+    let archive_path = tmp.0.join("big.zip");
+    build_zip(
+        &archive_path,
+        &["data/"],
+        &[("data/words.bin", offset_words(size).as_slice())],
+    );
+    let rc = unsafe {
+        tfs::c_api::tebako_fs_init_from_file(
+            c(archive_path.to_str().unwrap()).as_ptr(),
+            c(MOUNT_POINT).as_ptr(),
+        )
+    };
+    assert_eq!(rc, 0);
+    F {
+        _guard: guard,
+        _tmp: tmp,
+        archive_path,
+        size,
+    }
+}
+
+impl Drop for F {
+    fn drop(&mut self) {
+        unsafe { tfs::c_api::tebako_fs_unmount() };
+    }
+}
+
+fn c(s: &str) -> CString {
+    CString::new(s).unwrap()
+}
+
+fn open_words() -> i32 {
+    let path = c(&format!("{MOUNT_POINT}/data/words.bin"));
+    let fd = unsafe { tfs::c_api::tebako_fs_open(path.as_ptr(), libc::O_RDONLY) };
+    assert!(fd >= 0, "open failed");
+    fd
+}
+
+/// Sequentially read a whole fd in CHUNK reads; returns the bytes read
+/// after checking every word against its offset.
+fn drain_and_verify(fd: i32) -> usize {
+    let mut buf = vec![0u8; CHUNK];
+    let mut total = 0usize;
+    loop {
+        let n = unsafe { tfs::c_api::tebako_fs_read(fd, buf.as_mut_ptr().cast(), buf.len()) };
+        assert!(n >= 0, "read failed");
+        let n = n as usize;
+        if n == 0 {
+            return total;
+        }
+        for (i, word) in buf[..n].chunks_exact(4).enumerate() {
+            let want = (total + i * 4) as u32;
+            assert_eq!(u32::from_le_bytes(word.try_into().unwrap()), want);
+        }
+        total += n;
+    }
+}
+
+/// Aggregate MiB/s of `threads` readers, each draining its OWN fd.
+fn aggregate_rate(threads: usize, size: usize) -> f64 {
+    let fds: Vec<i32> = (0..threads).map(|_| open_words()).collect();
+    let start = Instant::now();
+    std::thread::scope(|s| {
+        for &fd in &fds {
+            s.spawn(move || assert_eq!(drain_and_verify(fd), size));
+        }
+    });
+    let secs = start.elapsed().as_secs_f64().max(1e-9);
+    for fd in fds {
+        assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+    }
+    (threads * size) as f64 / (1024.0 * 1024.0) / secs
+}
+
+#[test]
+fn parallel_readers_on_separate_fds_all_see_their_own_stream() {
+    let f = setup();
+    let threads = std::thread::available_parallelism()
+        .map(|n| n.get())
+        .unwrap_or(4)
+        .clamp(2, 8);
+    let single = aggregate_rate(1, f.size);
+    let parallel = aggregate_rate(threads, f.size);
+    eprintln!(
+        "[contention] {} KiB x {threads} threads: 1 thread {single:.1} MiB/s, \
+         {threads} threads {parallel:.1} MiB/s aggregate ({:.2}x) — {}",
+        f.size / 1024,
+        parallel / single,
+        f.archive_path.display()
+    );
+}
+
+#[test]
+fn readers_sharing_one_fd_consume_disjoint_ranges() {
+    let f = setup();
+    let fd = open_words();
+    let threads = 4;
+    let offsets = Mutex::new(Vec::new());
+    std::thread::scope(|s| {
+        for _ in 0..threads {
+            s.spawn(|| {
+                let mut buf = vec![0u8; CHUNK];
+                loop {
+                    let n = unsafe {
+                        tfs::c_api::tebako_fs_read(fd, buf.as_mut_ptr().cast(), buf.len())
+                    };
+                    assert!(n >= 0, "read failed");
+                    let n = n as usize;
+                    if n == 0 {
+                        break;
+                    }
+                    // The chunk names the offset it came from; the words
+                    // within it must be contiguous from there.
+                    let first = u32::from_le_bytes(buf[..4].try_into().unwrap()) as usize;
+                    for (i, word) in buf[..n].chunks_exact(4).enumerate() {
+                        let want = (first + i * 4) as u32;
+                        assert_eq!(u32::from_le_bytes(word.try_into().unwrap()), want);
+                    }
+                    offsets.lock().unwrap().push((first, n));
+                }
+            });
+        }
+    });
+    let mut ranges = offsets.into_inner().unwrap();
+    ranges.sort_unstable();
+    // Every byte served exactly once: the ranges tile [0, size).
+    let mut next = 0usize;
+    for (start, len) in ranges {
+        assert_eq!(start, next, "overlapping or missing range at {start}");
+        next = start + len;
+    }
+    assert_eq!(next, f.size);
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+}
+
+#[test]
+fn lseek_and_fstat_run_alongside_readers() {
+    let f = setup();
+    let fd = open_words();
+    std::thread::scope(|s| {
+        s.spawn(|| {
+            let mut buf = vec![0u8; CHUNK];
+            for _ in 0..64 {
+                let off = ((f.size / 2) & !3) as libc::off_t;
+                let n = unsafe {
+                    tfs::c_api::tebako_fs_pread(fd, buf.as_mut_ptr().cast(), buf.len(), off)
+                };
+                assert!(n > 0);
+                assert_eq!(
+                    u32::from_le_bytes(buf[..4].try_into().unwrap()) as libc::off_t,
+                    off
+                );
+            }
+        });
+        s.spawn(|| {
+            for _ in 0..64 {
+                let pos = unsafe { tfs::c_api::tebako_fs_lseek(fd, 0, libc::SEEK_END) };
+                assert_eq!(pos as usize, f.size);
+                let pos = unsafe { tfs::c_api::tebako_fs_lseek(fd, 0, libc::SEEK_SET) };
+                assert_eq!(pos, 0);
+            }
+        });
+        s.spawn(|| {
+            for _ in 0..64 {
+                let mut st: libc::stat = unsafe { std::mem::zeroed() };
+                assert_eq!(unsafe { tfs::c_api::tebako_fs_fstat(fd, &mut st) }, 0);
+                assert_eq!(st.st_size as usize, f.size);
+            }
+        });
+    });
+    // An out-of-range seek leaves the position where it was.
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_lseek(fd, 4, libc::SEEK_SET) },
+        4
+    );
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_lseek(fd, -8, libc::SEEK_CUR) },
+        -1
+    );
+    assert_eq!(
+        unsafe { tfs::c_api::tebako_fs_lseek(fd, 0, libc::SEEK_CUR) },
+        4
+    );
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+}
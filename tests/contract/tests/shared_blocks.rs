@@ -0,0 +1,99 @@
+//! Host-wide block sharing (`TEBAKO_TFS_SHARED_CACHE_MB` with an exec
+//! cache named): a second PROCESS mounting the same image reads the
+//! blocks the first one published instead of decompressing them again.
+//!
+//! The second process is this test binary re-run on the
+//! `child_reads_the_image` case; the evidence is the segment's arena
+//! cursor (header word at byte 24), which only a publish moves.
+
+use std::ffi::CString;
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+use tebako_contract_tests::{build_zip, TempDir};
+
+const MOUNT_POINT: &str = "/__tebako_shared__";
+const CHILD: &str = "TFS_SHARED_BLOCKS_CHILD";
+
+fn payload() -> Vec<u8> {
+    (0..300_000u32)
+        .flat_map(|i| (i / 7).to_le_bytes())
+        .collect()
+}
+
+/// Mount `image`, read `data/big.bin` whole, unmount; the bytes.
+fn read_through_mount(image: &Path) -> Vec<u8> {
+    let image = CString::new(image.to_str().unwrap()).unwrap();
+    let mp = CString::new(MOUNT_POINT).unwrap();
+    let mut h = -1;
+    let rc = unsafe { tfs::c_api::tebako_fs_mount_from_file(image.as_ptr(), mp.as_ptr(), &mut h) };
+    assert_eq!(rc, 0, "mount");
+    let path = CString::new(format!("{MOUNT_POINT}/data/big.bin")).unwrap();
+    let fd = unsafe { tfs::c_api::tebako_fs_open(path.as_ptr(), libc::O_RDONLY) };
+    assert!(fd >= 0);
+    let mut out = Vec::new();
+    let mut buf = vec![0u8; 16 * 1024];
+    loop {
+        let n = unsafe { tfs::c_api::tebako_fs_read(fd, buf.as_mut_ptr().cast(), buf.len()) };
+        assert!(n >= 0);
+        if n == 0 {
+            break;
+        }
+        out.extend_from_slice(&buf[..n as usize]);
+    }
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_close(fd) }, 0);
+    assert_eq!(unsafe { tfs::c_api::tebako_fs_unmount_handle(h) }, 0);
+    out
+}
+
+/// The one segment under `cache`, and its arena cursor.
+fn segment(cache: &Path) -> (PathBuf, u64) {
+    let dir = cache.join("tebako-blocks");
+    let mut segments: Vec<PathBuf> = std::fs::read_dir(&dir)
+        .expect("segment directory")
+        .map(|e| e.unwrap().path())
+        .filter(|p| p.extension().is_some_and(|x| x == "blk"))
+        .collect();
+    assert_eq!(segments.len(), 1, "{segments:?}");
+    let path = segments.pop().unwrap();
+    let bytes = std::fs::read(&path).unwrap();
+    (path, u64::from_le_bytes(bytes[24..32].try_into().unwrap()))
+}
+
+#[cfg(unix)]
+#[test]
+fn a_second_process_reads_the_published_blocks() {
+    let tmp = TempDir::new("shared-blocks");
+    let image = tmp.0.join("app.zip");
+    build_zip(
+        &image,
+        &["data/"],
+        &[("data/big.bin", payload().as_slice())],
+    );
+    let cache = tmp.0.join("exec-cache");
+    std::env::set_var("TEBAKO_EXEC_CACHE", &cache);
+    std::env::set_var("TEBAKO_TFS_SHARED_CACHE_MB", "16");
+
+    assert_eq!(read_through_mount(&image), payload());
+    let (path, published) = segment(&cache);
+    assert!(published > 0, "the first mount published its windows");
+
+    let status = Command::new(std::env::current_exe().unwrap())
+        .args(["--exact", "child_reads_the_image", "--test-threads=1"])
+        .env(CHILD, &image)
+        .status()
+        .unwrap();
+    assert!(status.success(), "child process");
+    let (again, cursor) = segment(&cache);
+    assert_eq!(again, path);
+    assert_eq!(cursor, published, "the child decompressed nothing new");
+}
+
+/// The second process of the case above (a no-op when run directly).
+#[test]
+fn child_reads_the_image() {
+    let Some(image) = std::env::var_os(CHILD) else {
+        return;
+    };
+    assert_eq!(read_through_mount(Path::new(&image)), payload());
+}
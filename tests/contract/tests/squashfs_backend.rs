@@ -310,6 +310,37 @@ fn multiple_fds_read_independently() {
     }
 }
 
+#[test]
+fn parallel_readers_each_get_their_own_reader() {
+    let f = setup();
+    init_file(&f, &fixture("nested.sqfs"));
+    let files = [
+        ("/dir1/file1.txt", "File 1\n"),
+        ("/dir1/subdir/file2.txt", "File 2\n"),
+        ("/dir2/file3.txt", "File 3\n"),
+    ];
+    // More threads than parked readers would ever be needed: the pool
+    // grows on demand and every read sees its own file's bytes.
+    std::thread::scope(|s| {
+        for t in 0..8 {
+            let (suffix, want) = files[t % files.len()];
+            let f = &f;
+            s.spawn(move || {
+                for _ in 0..200 {
+                    assert_eq!(read_file(f, suffix), want);
+                    assert_eq!(stat(f, suffix).st_size as usize, want.len());
+                }
+            });
+        }
+    });
+    let mut names: Vec<String> = readdir_names(&f, "/dir1")
+        .into_iter()
+        .map(|(n, _)| n)
+        .collect();
+    names.sort();
+    assert_eq!(names, ["file1.txt", "subdir"]);
+}
+
 // ===================================================================
 // stat / metadata (ports FileSizeCorrect, ModificationTimeNonZero,
 // PermissionsPreservedCorrectly, FileSizeInvalidFileReturnsError)